@@ -9,6 +9,20 @@ import pandas as pd
 from typing import List, Tuple
 
 
+LEGACY_PRECISION = "high"   # files recorded before the precision column
+
+
+def check_precision(df: pd.DataFrame) -> pd.DataFrame:
+    """Raw counts scale with the integration time: refuse a dataset mixing precisions."""
+    if "precision" not in df.columns:
+        df["precision"] = LEGACY_PRECISION
+    df["precision"] = df["precision"].fillna(LEGACY_PRECISION).astype(str).str.strip().str.lower()
+    precs = sorted(df["precision"].unique())
+    if len(precs) > 1:
+        raise ValueError(f"Dataset mixes sensor precisions {precs}, counts are not comparable.")
+    return df
+
+
 def load_all_csvs(data_dir: Path) -> pd.DataFrame:
     """Read all csv under data_dir recursively, add metadata like your notebook."""
     data_dir = Path(data_dir)
@@ -24,7 +38,7 @@ def load_all_csvs(data_dir: Path) -> pd.DataFrame:
 
     if not frames:
         raise ValueError(f"No CSV files found under: {data_dir}")
-    return pd.concat(frames, ignore_index=True)
+    return check_precision(pd.concat(frames, ignore_index=True))
 
 
 def add_labels(df: pd.DataFrame) -> pd.DataFrame:
@@ -85,7 +99,7 @@ def load_concentration_data(data_dir: Path):
         df["cuvette_id"] = Path(p).stem
         frames.append(df)
 
-    df = pd.concat(frames, ignore_index=True)
+    df = check_precision(pd.concat(frames, ignore_index=True))
 
     # extract juice_base (apple1 -> apple)
     df["juice_base"] = df["juice_type"].str.extract(r"^([a-zA-Z]+)", expand=False)
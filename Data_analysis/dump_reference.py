@@ -0,0 +1,83 @@
+# dump_reference.py
+from __future__ import annotations
+
+import argparse
+from pathlib import Path
+import numpy as np
+import pandas as pd
+from joblib import load
+
+from dataset import load_juice_Xy, load_concentration_data
+from preprocess_spec import bundle_spec, apply_spec
+
+
+N_CHANNELS = 12
+MAX_CLASSES = 8  # SPECTRO_MODEL_MAX_CLASSES in spectro_model.h
+
+
+def proba_or_scores(model, X: np.ndarray) -> np.ndarray:
+    if hasattr(model, "predict_proba"):
+        return model.predict_proba(X)
+    scores = np.asarray(model.decision_function(X), dtype=float)
+    if scores.ndim == 1:
+        scores = np.stack([np.zeros_like(scores), scores], axis=1)
+    return scores
+
+
+def build_table(role: str, X_raw: np.ndarray, context: list[str], X: np.ndarray, model) -> pd.DataFrame:
+    pred = np.asarray(model.predict(X), dtype=int)
+    proba = proba_or_scores(model, X)
+    if proba.shape[1] > MAX_CLASSES:
+        raise ValueError(f"{role}: {proba.shape[1]} classes exceed the firmware limit")
+
+    df = pd.DataFrame({"role": role, "context": context, "pred": pred})
+    for i in range(N_CHANNELS):
+        df[f"ch{i}"] = X_raw[:, i]
+    for c in range(MAX_CLASSES):
+        df[f"p{c}"] = proba[:, c] if c < proba.shape[1] else 0.0
+    return df
+
+
+def dump_reference(data_dir: Path, juice_model: str | None, conc_model: str | None, out: Path) -> list[pd.DataFrame]:
+    tables = []
+
+    if juice_model:
+        jb = load(juice_model)
+        X_raw, _, _, _ = load_juice_Xy(data_dir)
+        X = apply_spec(bundle_spec(jb, default="l1"), X_raw)
+        tables.append(build_table("juice", X_raw, ["-"] * len(X_raw), X, jb["model"]))
+
+    if conc_model:
+        cb = load(conc_model)
+        X_raw, _, juice_base, _, _ = load_concentration_data(data_dir)
+        X = apply_spec(bundle_spec(cb, default="mean"), X_raw, juice_base)
+        tables.append(build_table("conc", X_raw, [str(j) for j in juice_base], X, cb["model"]))
+
+    if not tables:
+        raise ValueError("Nothing to dump")
+
+    out.parent.mkdir(parents=True, exist_ok=True)
+    pd.concat(tables, ignore_index=True).to_csv(out, index=False, float_format="%.17g")
+    return tables
+
+
+def main():
+    ap = argparse.ArgumentParser("Dump sklearn reference predictions for the firmware model harness")
+    ap.add_argument("--data_dir", type=str, default="../Data")
+    ap.add_argument("--juice_model", type=str, default="models/best_juice_model.joblib")
+    ap.add_argument("--conc_model", type=str, default="models/best_concentration_model.joblib")
+    ap.add_argument("--out", type=str, default="models/reference_predictions.csv")
+    args = ap.parse_args()
+
+    out = Path(args.out)
+    tables = dump_reference(Path(args.data_dir), args.juice_model, args.conc_model, out)
+
+    print("=" * 70)
+    for t in tables:
+        print(f"{t['role'].iloc[0]:6s} | rows={len(t)}")
+    print("Saved reference predictions:", out.resolve())
+    print("=" * 70)
+
+
+if __name__ == "__main__":
+    main()
@@ -16,6 +16,7 @@ from sklearn.ensemble import RandomForestClassifier, HistGradientBoostingClassif
 from sklearn.preprocessing import OneHotEncoder, LabelEncoder
 
 from dataset import load_concentration_data
+from train_concentration import make_features
 
 
 def get_model(name: str, seed: int):
@@ -33,22 +34,6 @@ def get_model(name: str, seed: int):
     raise ValueError(f"Unknown model name: {name}")
 
 
-def make_raw_features(X_raw: np.ndarray, preprocess: str) -> np.ndarray:
-    preprocess = str(preprocess).strip().lower()
-    X_raw = X_raw.astype(float)
-    if preprocess == "raw":
-        return X_raw
-    if preprocess == "mean":
-        return X_raw.mean(axis=1, keepdims=True)
-    raise ValueError(f"Unknown preprocess: {preprocess}. Use 'raw' or 'mean'.")
-
-
-def make_features(X_raw: np.ndarray, juice_base: np.ndarray, juice_enc: OneHotEncoder, preprocess: str) -> np.ndarray:
-    X_feat = make_raw_features(X_raw, preprocess=preprocess)
-    juice_oh = juice_enc.transform(juice_base.reshape(-1, 1))
-    return np.hstack([X_feat, juice_oh])
-
-
 def plot_confusion(cm: np.ndarray, class_names: list[str], title: str, out_path: Path, normalised: bool):
     if normalised:
         cm_plot = cm.astype(float)
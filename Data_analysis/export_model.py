@@ -0,0 +1,218 @@
+# export_model.py
+from __future__ import annotations
+
+import argparse
+import struct
+import subprocess
+import zlib
+from pathlib import Path
+import numpy as np
+from joblib import load
+
+from sklearn.ensemble import RandomForestClassifier
+from sklearn.linear_model import LogisticRegression
+from sklearn.svm import LinearSVC
+
+from dump_reference import dump_reference
+from preprocess_spec import MAX_OPS, bundle_spec, spec_bytes, spec_width, spec_text
+
+
+# Must match Firmware/lib/ML/spectro_model.h
+MAGIC = 0x4C444D53          # "SMDL"
+FORMAT_VERSION = 2
+HEADER_SIZE = 64
+LABEL_LEN = 12
+MAX_CLASSES = 8
+MAX_CONTEXT = 4
+MAX_INPUTS = 32
+
+ROLE = {"juice": 0, "conc": 1}
+TYPE_LINEAR, TYPE_FOREST = 0, 1
+FLAG_SOFTMAX = 0x01
+SHORT_NAME = {"RandomForestClassifier": "RF", "LogisticRegression": "LR", "LinearSVC": "LSVM"}
+
+
+def pack_labels(labels, n_max: int) -> bytes:
+    if len(labels) > n_max:
+        raise ValueError(f"Too many labels ({len(labels)} > {n_max})")
+    out = b""
+    for lab in labels:
+        raw = str(lab).encode("utf-8")
+        if len(raw) >= LABEL_LEN:
+            raise ValueError(f"Label too long for the firmware: {lab!r}")
+        out += raw.ljust(LABEL_LEN, b"\0")
+    return out.ljust(n_max * LABEL_LEN, b"\0")
+
+
+def float32_floor(t: float) -> np.float32:
+    """Largest float32 <= t, so that (float32 x <= result) == (x <= t)."""
+    f = np.float32(t)
+    if float(f) > t:
+        f = np.nextafter(f, np.float32(-np.inf), dtype=np.float32)
+    return f
+
+
+def forest_body(model: RandomForestClassifier, n_classes: int) -> bytes:
+    roots, nodes = [], []
+    leaf_index: dict[bytes, int] = {}
+    leaves: list[bytes] = []
+
+    for est in model.estimators_:
+        tree = est.tree_
+        base = len(nodes)
+        roots.append(base)
+
+        # pre-order so that the left child always follows its parent
+        order, stack = [], [0]
+        while stack:
+            n = stack.pop()
+            order.append(n)
+            if tree.children_left[n] != -1:
+                stack.append(tree.children_right[n])
+                stack.append(tree.children_left[n])
+        new_id = {old: base + i for i, old in enumerate(order)}
+
+        for old in order:
+            if tree.children_left[old] == -1:
+                dist = tree.value[old][0].astype(float)
+                total = dist.sum()
+                dist = dist / (total if total != 0 else 1.0)
+                key = np.asarray(dist, dtype="<f4").tobytes()
+                if key not in leaf_index:
+                    leaf_index[key] = len(leaves)
+                    leaves.append(key)
+                nodes.append(struct.pack("<hHI", -1, 0, leaf_index[key]))
+            else:
+                right = new_id[tree.children_right[old]] - new_id[old]
+                if right > 0xFFFF:
+                    raise ValueError("Tree too large for 16-bit child offsets")
+                thr = float32_floor(float(tree.threshold[old]))
+                nodes.append(struct.pack("<hHf", int(tree.feature[old]), right, thr))
+
+    body = struct.pack("<III", len(roots), len(nodes), len(leaves))
+    body += struct.pack(f"<{len(roots)}I", *roots)
+    body += b"".join(nodes)
+    body += b"".join(leaves)
+    assert all(len(k) == 4 * n_classes for k in leaves)
+    return body
+
+
+def linear_body(model, n_classes: int) -> tuple[bytes, int]:
+    W = np.asarray(model.coef_, dtype=float)
+    b = np.atleast_1d(np.asarray(model.intercept_, dtype=float))
+    if W.shape[0] == 1 and n_classes == 2:
+        # binary: argmax / softmax over [0, z] == sign / sigmoid of z
+        W = np.vstack([np.zeros_like(W[0]), W[0]])
+        b = np.array([0.0, b[0]])
+    flags = FLAG_SOFTMAX if isinstance(model, LogisticRegression) else 0
+    body = np.asarray(W, dtype="<f4").tobytes() + np.asarray(b, dtype="<f4").tobytes()
+    return body, flags
+
+
+def section(role: str, model, spec: dict, class_labels) -> bytes:
+    n_classes = len(class_labels)
+    n_context = len(spec["context"])
+    n_inputs = spec_width(spec)
+    if n_classes > MAX_CLASSES or n_context > MAX_CONTEXT or n_inputs > MAX_INPUTS:
+        raise ValueError("Model exceeds firmware limits")
+    if model.n_features_in_ != n_inputs:
+        raise ValueError(f"{role}: model expects {model.n_features_in_} inputs, spec gives {n_inputs}")
+
+    flags = 0
+    if isinstance(model, RandomForestClassifier):
+        mtype, body = TYPE_FOREST, forest_body(model, n_classes)
+    elif isinstance(model, (LogisticRegression, LinearSVC)):
+        mtype = TYPE_LINEAR
+        body, flags = linear_body(model, n_classes)
+    else:
+        raise ValueError(f"{role}: model type {type(model).__name__} is not supported on the device")
+
+    # spec ops padded to MAX_OPS, hash over the used ops + context labels (preprocess_spec.py)
+    ops = spec_bytes(spec)[:4 * len(spec["ops"])].ljust(4 * MAX_OPS, b"\0")
+    meta = (pack_labels(class_labels, MAX_CLASSES) + pack_labels(spec["context"], MAX_CONTEXT) +
+            ops + struct.pack("<I", spec["hash"]))
+
+    head_fixed = struct.calcsize("<I8B")
+    size = head_fixed + len(meta) + len(body)
+    body += b"\0" * ((-size) % 4)
+    size = head_fixed + len(meta) + len(body)
+
+    head = struct.pack("<I8B", size, ROLE[role], mtype, len(spec["ops"]), flags,
+                       n_classes, n_context, n_inputs, 0)
+    return head + meta + body
+
+
+def build_package(sections: list[bytes], version: int, name: str) -> bytes:
+    payload = b"".join(sections)
+    raw_name = name.encode("utf-8")[:31].ljust(32, b"\0")
+    head = struct.pack("<IHHIIII", MAGIC, FORMAT_VERSION, HEADER_SIZE, version, len(sections),
+                       len(payload), zlib.crc32(payload) & 0xFFFFFFFF)
+    head += raw_name + struct.pack("<I", 0)
+    head += struct.pack("<I", zlib.crc32(head) & 0xFFFFFFFF)
+    assert len(head) == HEADER_SIZE
+    return head + payload
+
+
+def main():
+    ap = argparse.ArgumentParser("Export the best juice/concentration models as a firmware model package")
+    ap.add_argument("--juice_model", type=str, default="models/best_juice_model.joblib")
+    ap.add_argument("--conc_model", type=str, default="models/best_concentration_model.joblib")
+    ap.add_argument("--out", type=str, default="models/model_package.bin")
+    ap.add_argument("--version", type=int, default=1, help="package version reported by the device")
+    ap.add_argument("--data_dir", type=str, default="../Data")
+    ap.add_argument("--harness", type=str, default="../Firmware/host/build/model_harness",
+                    help="host build of Firmware/host (cmake -S ../Firmware/host -B ../Firmware/host/build)")
+    ap.add_argument("--max_disagree", type=float, default=0.0, help="allowed fraction of label mismatches")
+    ap.add_argument("--prob_tol", type=float, default=1e-5, help="allowed |probability| error")
+    ap.add_argument("--skip_verify", action="store_true", help="export without the harness check")
+    args = ap.parse_args()
+
+    sections, names = [], []
+
+    if args.juice_model:
+        jb = load(args.juice_model)
+        spec = bundle_spec(jb, default="l1")
+        sections.append(section("juice", jb["model"], spec, [str(c) for c in jb["label_encoder"].classes_]))
+        names.append("juice:" + SHORT_NAME[type(jb["model"]).__name__])
+        print(f"juice spec: {spec_text(spec)} (hash {spec['hash']:08X})")
+
+    if args.conc_model:
+        cb = load(args.conc_model)
+        spec = bundle_spec(cb, default="mean")
+        sections.append(section("conc", cb["model"], spec, [str(c) for c in cb["label_encoder"].classes_]))
+        names.append("conc:" + SHORT_NAME[type(cb["model"]).__name__])
+        print(f"conc  spec: {spec_text(spec)} (hash {spec['hash']:08X})")
+
+    if not sections:
+        raise ValueError("Nothing to export")
+
+    pkg = build_package(sections, args.version, " ".join(names))
+    out = Path(args.out)
+    out.parent.mkdir(parents=True, exist_ok=True)
+
+    # The package only replaces the previous one if the firmware engine
+    # reproduces sklearn on every dataset row
+    candidate = out.with_suffix(".candidate.bin")
+    candidate.write_bytes(pkg)
+    if not args.skip_verify:
+        reference = out.with_name("reference_predictions.csv")
+        dump_reference(Path(args.data_dir), args.juice_model, args.conc_model, reference)
+        if not Path(args.harness).exists():
+            candidate.unlink()
+            raise SystemExit(f"Harness not found: {args.harness} (build Firmware/host or pass --skip_verify)")
+        res = subprocess.run([args.harness, str(candidate), str(reference),
+                              str(args.max_disagree), str(args.prob_tol)])
+        if res.returncode != 0:
+            candidate.unlink()
+            raise SystemExit("Firmware engine does not match sklearn, package NOT exported")
+    candidate.replace(out)
+
+    print("=" * 70)
+    print(f"Package: {out.resolve()}")
+    print(f"Version: {args.version} | Sections: {len(sections)} | Size: {len(pkg)} bytes")
+    print(f"CRC-32: {zlib.crc32(pkg) & 0xFFFFFFFF:08X}")
+    print("=" * 70)
+
+
+if __name__ == "__main__":
+    main()
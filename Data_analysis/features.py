@@ -3,20 +3,16 @@ from __future__ import annotations
 import numpy as np
 from sklearn.preprocessing import OneHotEncoder
 
-def l1_normalise(X: np.ndarray, eps: float = 1e-12) -> np.ndarray:
-    X = np.asarray(X, dtype=float)
-    s = np.sum(X, axis=1, keepdims=True)
-    s = np.where(s == 0, eps, s)
-    return X / s
+from preprocess_spec import make_spec, apply_spec
+
+
+def l1_normalise(X: np.ndarray) -> np.ndarray:
+    return apply_spec(make_spec("l1"), X)
 
 
 def make_features(X: np.ndarray, preprocess: str = "l1") -> np.ndarray:
-    X = np.asarray(X, dtype=float)
-    if preprocess == "raw":
-        return X
-    if preprocess == "l1":
-        return l1_normalise(X)
-    raise ValueError("preprocess must be 'raw' or 'l1'")
+    """Juice features; preprocess is a spec text, e.g. 'l1' or 'l1+ratio:6/3' (see preprocess_spec.py)."""
+    return apply_spec(make_spec(preprocess), X)
 
 
 def make_concentration_features(X_raw, juice_base):
@@ -0,0 +1,169 @@
+# preprocess_spec.py
+"""
+Single source of the channel preprocessing.
+
+A spec is a list of feature ops applied to the 12 raw channels, stored in
+every model bundle as bundle["preprocess_spec"]. The same spec is packed
+into the firmware model package (export_model.py) and executed there by
+spectro_model_features(), so training, PC inference and the device all
+compute features from one description.
+
+Ops (text form, joined with '+', e.g. "l1+ratio:6/3+onehot"):
+  raw            12 channels as-is
+  l1             channels / sum(channels)
+  mean           1 value: mean of the channels
+  absorbance     12 values: -log10(max(channel, 1))
+  ratio:a/b      1 value: channel a / channel b (0-based)
+  onehot         one-hot of the context label (e.g. juice type)
+
+The spec hash is a CRC-32 over the firmware encoding of the ops and the
+context labels. It is checked when a bundle is loaded and again by the
+firmware when a package is validated, so a spec that no longer matches
+its model fails loudly at load time.
+"""
+from __future__ import annotations
+
+import struct
+import zlib
+import numpy as np
+
+
+# Must match Firmware/lib/ML/spectro_model.h
+N_CHANNELS = 12
+MAX_OPS = 8
+LABEL_LEN = 12
+OPS = {"raw": 0, "l1": 1, "mean": 2, "absorbance": 3, "ratio": 4, "onehot": 5}
+L1_EPS = 1e-12
+
+
+def parse_ops(text: str) -> list[dict]:
+    """'l1+ratio:6/3+onehot' -> [{'op': 'l1'}, {'op': 'ratio', 'a': 6, 'b': 3}, {'op': 'onehot'}]"""
+    ops = []
+    for item in str(text).strip().lower().split("+"):
+        name, _, arg = item.strip().partition(":")
+        if name not in OPS:
+            raise ValueError(f"Unknown preprocessing op: {item!r}")
+        op = {"op": name}
+        if name == "ratio":
+            a, b = arg.split("/")
+            op["a"], op["b"] = int(a), int(b)
+            if not (0 <= op["a"] < N_CHANNELS and 0 <= op["b"] < N_CHANNELS):
+                raise ValueError(f"Ratio channel out of range: {item!r}")
+        ops.append(op)
+    return ops
+
+
+def make_spec(ops: str | list[dict], context: list[str] | None = None) -> dict:
+    """Build a spec; an 'onehot' op is appended if context labels are given without one."""
+    ops = parse_ops(ops) if isinstance(ops, str) else [dict(o) for o in ops]
+    context = [str(c) for c in (context or [])]
+    if context and not any(o["op"] == "onehot" for o in ops):
+        ops.append({"op": "onehot"})
+    if any(o["op"] == "onehot" for o in ops) and not context:
+        raise ValueError("onehot op needs context labels")
+    if len(ops) > MAX_OPS:
+        raise ValueError(f"Too many ops ({len(ops)} > {MAX_OPS})")
+
+    spec = {"ops": ops, "context": context}
+    spec["hash"] = spec_hash(spec)
+    return spec
+
+
+def spec_bytes(spec: dict) -> bytes:
+    """Firmware encoding: 4 bytes per op {op, a, b, 0}, then the context labels."""
+    out = b""
+    for o in spec["ops"]:
+        out += struct.pack("<4B", OPS[o["op"]], o.get("a", 0), o.get("b", 0), 0)
+    for lab in spec["context"]:
+        raw = lab.encode("utf-8")
+        if len(raw) >= LABEL_LEN:
+            raise ValueError(f"Context label too long for the firmware: {lab!r}")
+        out += raw.ljust(LABEL_LEN, b"\0")
+    return out
+
+
+def spec_hash(spec: dict) -> int:
+    return zlib.crc32(spec_bytes(spec)) & 0xFFFFFFFF
+
+
+def spec_width(spec: dict) -> int:
+    width = {"raw": N_CHANNELS, "l1": N_CHANNELS, "mean": 1, "absorbance": N_CHANNELS, "ratio": 1,
+             "onehot": len(spec["context"])}
+    return sum(width[o["op"]] for o in spec["ops"])
+
+
+def spec_text(spec: dict) -> str:
+    return "+".join(f"ratio:{o['a']}/{o['b']}" if o["op"] == "ratio" else o["op"] for o in spec["ops"])
+
+
+def apply_spec(spec: dict, X_raw: np.ndarray, context=None) -> np.ndarray:
+    """
+    Features for a batch of raw channel rows.
+    Sum / log are computed once per row and shared by all ops, in float64
+    with numpy's reduction order, exactly like the firmware kernel.
+    """
+    X_raw = np.asarray(X_raw, dtype=float)
+    if X_raw.ndim == 1:
+        X_raw = X_raw.reshape(1, -1)
+    if X_raw.shape[1] != N_CHANNELS:
+        raise ValueError(f"Expected {N_CHANNELS} channels, got {X_raw.shape[1]}")
+
+    names = {o["op"] for o in spec["ops"]}
+    s = np.sum(X_raw, axis=1, keepdims=True) if names & {"l1", "mean"} else None
+    absorb = -np.log10(np.maximum(X_raw, 1.0)) if "absorbance" in names else None
+
+    cols = []
+    for o in spec["ops"]:
+        op = o["op"]
+        if op == "raw":
+            cols.append(X_raw)
+        elif op == "l1":
+            cols.append(X_raw / np.where(s == 0, L1_EPS, s))
+        elif op == "mean":
+            cols.append(s / N_CHANNELS)
+        elif op == "absorbance":
+            cols.append(absorb)
+        elif op == "ratio":
+            den = X_raw[:, [o["b"]]]
+            cols.append(X_raw[:, [o["a"]]] / np.where(den == 0, L1_EPS, den))
+        elif op == "onehot":
+            if context is None:
+                raise ValueError("Spec has a onehot op but no context was given")
+            ctx = np.asarray(context, dtype=object).reshape(-1)
+            if len(ctx) == 1 and len(X_raw) > 1:
+                ctx = np.repeat(ctx, len(X_raw))
+            # unknown labels -> all zeros, like OneHotEncoder(handle_unknown="ignore")
+            cols.append(np.stack([(ctx == c).astype(float) for c in spec["context"]], axis=1))
+    return np.hstack(cols)
+
+
+def legacy_spec(bundle: dict, default: str) -> dict:
+    """Spec of a bundle trained before specs were stored (preprocess string + juice_encoder)."""
+    context = None
+    if "juice_encoder" in bundle:
+        context = [str(c) for c in bundle["juice_encoder"].categories_[0]]
+    return make_spec(str(bundle.get("preprocess", default)), context)
+
+
+def bundle_spec(bundle: dict, default: str = "raw") -> dict:
+    """
+    Spec of a loaded model bundle, verified against the model.
+    Raises ValueError on any mismatch instead of silently mis-featurising.
+    """
+    spec = bundle.get("preprocess_spec")
+    if spec is None:
+        spec = legacy_spec(bundle, default)
+
+    if spec_hash(spec) != spec.get("hash"):
+        raise ValueError("Preprocessing spec hash mismatch: spec edited or encoding changed since training")
+
+    model = bundle["model"]
+    n_in = getattr(model, "n_features_in_", None)
+    if n_in is not None and n_in != spec_width(spec):
+        raise ValueError(f"Spec '{spec_text(spec)}' gives {spec_width(spec)} features, model expects {n_in}")
+
+    if "juice_encoder" in bundle:
+        enc = [str(c) for c in bundle["juice_encoder"].categories_[0]]
+        if enc != spec["context"]:
+            raise ValueError(f"Spec context {spec['context']} does not match the juice encoder {enc}")
+    return spec
@@ -16,6 +16,7 @@ from sklearn.svm import LinearSVC, SVC
 from sklearn.ensemble import RandomForestClassifier, HistGradientBoostingClassifier
 
 from dataset import load_concentration_data
+from preprocess_spec import make_spec, apply_spec
 
 
 def get_models(seed: int):
@@ -28,23 +29,13 @@ def get_models(seed: int):
     }
 
 
-def make_raw_features(X_raw: np.ndarray, preprocess: str) -> np.ndarray:
-    preprocess = str(preprocess).strip().lower()
-    X_raw = X_raw.astype(float)
-
-    if preprocess == "raw":
-        return X_raw
-    if preprocess == "mean":
-        # one value per sample
-        return X_raw.mean(axis=1, keepdims=True)
-
-    raise ValueError(f"Unknown preprocess: {preprocess}. Use 'raw' or 'mean'.")
+def make_spec_for(preprocess: str, juice_enc: OneHotEncoder) -> dict:
+    """Spectral ops (e.g. 'mean', 'absorbance') + juice one-hot over the encoder categories."""
+    return make_spec(preprocess, context=[str(c) for c in juice_enc.categories_[0]])
 
 
 def make_features(X_raw: np.ndarray, juice_base: np.ndarray, juice_enc: OneHotEncoder, preprocess: str) -> np.ndarray:
-    X_feat = make_raw_features(X_raw, preprocess=preprocess)
-    juice_oh = juice_enc.transform(juice_base.reshape(-1, 1))
-    return np.hstack([X_feat, juice_oh])
+    return apply_spec(make_spec_for(preprocess, juice_enc), X_raw, juice_base)
 
 
 def cv_score_with_encoder(
@@ -77,7 +68,7 @@ def main():
     ap = argparse.ArgumentParser("Concentration - Train(CV on TRAIN split) + hold-out TEST + save best model")
     ap.add_argument("--data_dir", type=str, default="../Data")
     ap.add_argument("--models_dir", type=str, default="models")
-    ap.add_argument("--preprocess", choices=["raw", "mean"], default="mean")
+    ap.add_argument("--preprocess", type=str, default="mean", help="spec text, see preprocess_spec.py")
     ap.add_argument("--folds", type=int, default=5)
     ap.add_argument("--seed", type=int, default=42)
     ap.add_argument("--test_size", type=float, default=0.2)
@@ -169,6 +160,7 @@ def main():
         "label_encoder": le,
         "juice_encoder": juice_enc,
         "preprocess": args.preprocess,
+        "preprocess_spec": make_spec_for(args.preprocess, juice_enc),
         "folds": args.folds,
         "seed": args.seed,
         "test_size": args.test_size,
@@ -0,0 +1,296 @@
+# train_concentration_regression.py
+from __future__ import annotations
+
+import argparse
+from pathlib import Path
+import numpy as np
+import pandas as pd
+from joblib import dump
+
+from sklearn.model_selection import train_test_split, GridSearchCV, KFold
+from sklearn.linear_model import Ridge
+from sklearn.preprocessing import StandardScaler
+from sklearn.metrics import mean_absolute_error, mean_squared_error
+
+from dataset import load_concentration_data
+from preprocess_spec import make_spec, apply_spec, spec_width, spec_text
+
+
+N_BANDS = 12
+
+
+def parse_levels(text: str) -> dict[str, float]:
+    """'low=25,medium=50,high=100' -> {'low': 25.0, ...}"""
+    levels = {}
+    for item in text.split(","):
+        name, value = item.split("=")
+        levels[name.strip().lower()] = float(value)
+    return levels
+
+
+# Beer-Lambert feature per band: -log10(I). The unknown blank I0 only adds a
+# constant per band, which the intercept absorbs. Computed through the shared
+# spec, so the firmware runs the same kernel (spectro_model_spec_features).
+DEFAULT_SPEC = "absorbance"
+VARIANCE_OPS = {"absorbance", "raw"}  # ops spectro_conc_feature_variance() propagates
+
+
+def parse_alphas(text: str) -> list[float]:
+    """'0.001,0.01,0.1' -> [0.001, 0.01, 0.1]"""
+    return [float(a) for a in text.split(",")]
+
+
+def pick_bands(F: np.ndarray, y: np.ndarray, n_bands: int) -> list[int]:
+    """Bands with the largest |correlation| between absorbance and concentration (all if n_bands <= 0)."""
+    if n_bands <= 0 or n_bands >= F.shape[1]:
+        return list(range(F.shape[1]))
+    corr = []
+    for b in range(F.shape[1]):
+        if np.std(F[:, b]) == 0 or np.std(y) == 0:
+            corr.append(0.0)
+        else:
+            corr.append(abs(float(np.corrcoef(F[:, b], y)[0, 1])))
+    return sorted(np.argsort(corr)[::-1][:n_bands].tolist())
+
+
+def fit_ridge_cv(X: np.ndarray, y: np.ndarray, alphas: list[float], seed: int) -> Ridge:
+    """Ridge with alpha picked by 5-fold CV MAE on the training rows only."""
+    cv = KFold(n_splits=5, shuffle=True, random_state=seed)
+    search = GridSearchCV(Ridge(), {"alpha": alphas}, cv=cv, scoring="neg_mean_absolute_error")
+    return search.fit(X, y).best_estimator_
+
+
+MAX_JUICES = 4  # SPECTRO_CONC_MAX_JUICES in spectro_conc_reg.h
+
+
+def c_float(v: float) -> str:
+    text = f"{float(v):.9g}"
+    if not any(ch in text for ch in ".en"):
+        text += ".0"
+    return text + "f"
+
+
+def c_floats(values) -> str:
+    return ", ".join(c_float(v) for v in values)
+
+
+def write_header(path: Path, spec: dict, juices: list[str], linear: dict, ridge: dict | None, levels: dict,
+                 metrics: dict, prefer_ridge: bool):
+    lines = []
+    lines.append("/********************************************************")
+    lines.append(" * @file        \tspectro_conc_model.h")
+    lines.append(" * @brief       \tConcentration regression coefficients")
+    lines.append(" *")
+    lines.append(" * @details")
+    lines.append(" *  - GENERATED by Data_analysis/train_concentration_regression.py")
+    lines.append(" *  - Do not edit by hand, re-run the script instead")
+    lines.append(f" *  - Preprocessing spec: {spec_text(spec)} (checked against its hash at startup)")
+    lines.append(" *  - Targets: " + ", ".join(f"{k}={v:g}%" for k, v in levels.items()))
+    for name, m in metrics.items():
+        lines.append(f" *  - Hold-out {name}: MAE={m['mae']:.2f}%  RMSE={m['rmse']:.2f}%")
+    lines.append(" *")
+    lines.append(" * SPDX-License-Identifier: MIT")
+    lines.append(" ********************************************************/")
+    lines.append("")
+    lines.append("#ifndef SPECTRO_CONC_MODEL_H")
+    lines.append("#define SPECTRO_CONC_MODEL_H")
+    lines.append("")
+    lines.append('#include "spectro_conc_reg.h"')
+    lines.append("")
+    lines.append(f"#define SPECTRO_CONC_MODEL_NUM_JUICES   {len(juices)}")
+    lines.append(f"#define SPECTRO_CONC_MODEL_HAS_RIDGE    {1 if ridge is not None else 0}")
+    lines.append(f"#define SPECTRO_CONC_MODEL_PREFER_RIDGE {1 if prefer_ridge else 0}   // lower hold-out MAE")
+    lines.append(f"#define SPECTRO_CONC_MODEL_NUM_OPS      {len(spec['ops'])}")
+    lines.append(f"#define SPECTRO_CONC_MODEL_SPEC_HASH    0x{spec['hash']:08X}UL")
+    lines.append("")
+    lines.append("static const SpectroModelFeatureOp_t spectro_conc_model_ops[SPECTRO_CONC_MODEL_NUM_OPS] =")
+    lines.append("{")
+    for o in spec["ops"]:
+        lines.append(f"    {{ SPECTRO_MODEL_OP_{o['op'].upper()}, {o.get('a', 0)}, {o.get('b', 0)}, 0 }},")
+    lines.append("};")
+    lines.append("")
+    lines.append("static const SpectroModelSpec_t spectro_conc_model_spec =")
+    lines.append("{")
+    lines.append("    spectro_conc_model_ops, SPECTRO_CONC_MODEL_NUM_OPS, 0, NULL, SPECTRO_CONC_MODEL_SPEC_HASH")
+    lines.append("};")
+    lines.append("")
+    lines.append("static const char *const spectro_conc_model_juices[SPECTRO_CONC_MODEL_NUM_JUICES] =")
+    lines.append("{")
+    lines.append("    " + ", ".join(f'"{j}"' for j in juices))
+    lines.append("};")
+    lines.append("")
+    lines.append("// Per-juice Beer-Lambert ridge fit, penalised on standardised features and folded back to")
+    lines.append("// the raw absorbance scale (bands differ by ~0.01 between samples, hence the large values),")
+    lines.append("// zero coefficient = band not selected")
+    lines.append("static const SpectroConcLinear_t spectro_conc_model_linear[SPECTRO_CONC_MODEL_NUM_JUICES] =")
+    lines.append("{")
+    for j in juices:
+        lin = linear[j]
+        lines.append(f"    {{ {c_float(lin['intercept'])}, {{ {c_floats(lin['coef'])} }} }}, // {j}, alpha {lin['alpha']:g}, bands {lin['bands']}")
+    lines.append("};")
+    if ridge is not None:
+        lines.append("")
+        lines.append(f"// Ridge over all bands + juice one-hot, alpha = {ridge['alpha']:g}")
+        lines.append("static const SpectroConcRidge_t spectro_conc_model_ridge =")
+        lines.append("{")
+        lines.append(f"    {c_float(ridge['intercept'])},")
+        lines.append(f"    {{ {c_floats(ridge['mean'])} }},")
+        lines.append(f"    {{ {c_floats(ridge['inv_std'])} }},")
+        lines.append(f"    {{ {c_floats(ridge['coef'])} }},")
+        lines.append(f"    {{ {c_floats(ridge['juice_coef'])} }}")
+        lines.append("};")
+    lines.append("")
+    lines.append("#endif // SPECTRO_CONC_MODEL_H")
+    lines.append("")
+    path.write_text("\n".join(lines), encoding="utf-8")
+
+
+def main():
+    ap = argparse.ArgumentParser("Concentration - Beer-Lambert / ridge regression + firmware export")
+    ap.add_argument("--data_dir", type=str, default="../Data")
+    ap.add_argument("--models_dir", type=str, default="models")
+    ap.add_argument("--levels", type=str, default="low=25,medium=50,high=100",
+                    help="juice percentage of each concentration class")
+    ap.add_argument("--preprocess", type=str, default=DEFAULT_SPEC,
+                    help="preprocessing spec, one value per band: absorbance or raw")
+    ap.add_argument("--n_bands", type=int, default=0, help="bands per juice for the Beer-Lambert fit, 0 = all")
+    ap.add_argument("--alphas", type=str, default="0.001,0.003,0.01,0.03,0.1,0.3,1,3,10,30,100",
+                    help="ridge penalties searched by cross-validation on the training split")
+    ap.add_argument("--no_ridge", action="store_true", help="skip the ridge over all bands + juice one-hot")
+    ap.add_argument("--max_mae", type=float, default=10.0,
+                    help="refuse to export a model whose hold-out MAE (%%) is above this")
+    ap.add_argument("--seed", type=int, default=42)
+    ap.add_argument("--test_size", type=float, default=0.2)
+    ap.add_argument("--header", type=str, default="../Firmware/lib/ML/spectro_conc_model.h")
+    args = ap.parse_args()
+
+    MODELS_DIR = Path(args.models_dir)
+    MODELS_DIR.mkdir(parents=True, exist_ok=True)
+    levels = parse_levels(args.levels)
+    alphas = parse_alphas(args.alphas)
+
+    X_raw_all, y_conc_str, juice_base_all, feat_cols, df = load_concentration_data(Path(args.data_dir))
+    if X_raw_all.shape[1] != N_BANDS:
+        raise ValueError(f"Expected {N_BANDS} channels, got {X_raw_all.shape[1]}")
+
+    y_str = np.array([str(c).strip().lower() for c in y_conc_str])
+    unknown = sorted(set(y_str) - set(levels))
+    if unknown:
+        raise ValueError(f"No --levels value for: {unknown}")
+    y_all = np.array([levels[c] for c in y_str], dtype=float)
+    juice_all = np.array([str(j).strip().lower() for j in juice_base_all])
+    juices = sorted(set(juice_all))
+    if len(juices) > MAX_JUICES:
+        raise ValueError(f"Firmware supports at most {MAX_JUICES} juices, got {juices}")
+
+    # same split protocol as train_concentration.py
+    all_idx = np.arange(len(y_all))
+    tr_idx, te_idx = train_test_split(all_idx, test_size=args.test_size, random_state=args.seed, stratify=y_str)
+
+    spec = make_spec(args.preprocess)
+    if spec_width(spec) != N_BANDS or len(spec["ops"]) != 1 or spec["ops"][0]["op"] not in VARIANCE_OPS:
+        raise ValueError(f"Spec '{spec_text(spec)}' is not one value per band from {sorted(VARIANCE_OPS)}")
+    F_all = apply_spec(spec, X_raw_all)
+
+    print("=" * 70)
+    print("CONCENTRATION REGRESSION: per-juice Beer-Lambert ridge fit + optional global ridge")
+    print("=" * 70)
+    print(f"All: {len(y_all)} | Train: {len(tr_idx)} | Test: {len(te_idx)}")
+    print(f"Juices: {juices} | Levels: {levels} | Spec: {spec_text(spec)} (0x{spec['hash']:08X})")
+    print("-" * 70)
+
+    # ---- per-juice Beer-Lambert fit on selected bands ----
+    # Ridge on standardised features (an unpenalised fit gives coefficients in
+    # the thousands on ~20 rows per juice), folded back to the raw feature scale
+    # so the firmware keeps evaluating intercept + sum coef_i * f_i.
+    linear = {}
+    pred_lin = np.zeros(len(te_idx))
+    for j in juices:
+        tr_j = tr_idx[juice_all[tr_idx] == j]
+        bands = pick_bands(F_all[tr_j], y_all[tr_j], args.n_bands)
+        scaler = StandardScaler().fit(F_all[tr_j][:, bands])
+        scale = np.where(scaler.scale_ == 0, 1.0, scaler.scale_)
+        reg = fit_ridge_cv((F_all[tr_j][:, bands] - scaler.mean_) / scale, y_all[tr_j], alphas, args.seed)
+
+        coef = np.zeros(N_BANDS)
+        coef[bands] = reg.coef_ / scale
+        intercept = float(reg.intercept_ - np.sum(coef[bands] * scaler.mean_))
+        linear[j] = {"intercept": intercept, "coef": coef, "bands": bands, "alpha": float(reg.alpha)}
+
+        te_mask = juice_all[te_idx] == j
+        pred_lin[te_mask] = intercept + F_all[te_idx[te_mask]] @ coef
+        print(f"{j:8s} | alpha={reg.alpha:g} | bands={bands} | train n={len(tr_j)}")
+
+    metrics = {
+        "beer-lambert": {
+            "mae": mean_absolute_error(y_all[te_idx], pred_lin),
+            "rmse": float(np.sqrt(mean_squared_error(y_all[te_idx], pred_lin))),
+        }
+    }
+
+    # ---- ridge over all bands + juice one-hot ----
+    ridge = None
+    if not args.no_ridge:
+        scaler = StandardScaler().fit(F_all[tr_idx])
+        onehot = np.stack([(juice_all == j).astype(float) for j in juices], axis=1)
+
+        def ridge_X(idx):
+            return np.hstack([scaler.transform(F_all[idx]), onehot[idx]])
+
+        model = fit_ridge_cv(ridge_X(tr_idx), y_all[tr_idx], alphas, args.seed)
+        pred_ridge = model.predict(ridge_X(te_idx))
+        metrics["ridge"] = {
+            "mae": mean_absolute_error(y_all[te_idx], pred_ridge),
+            "rmse": float(np.sqrt(mean_squared_error(y_all[te_idx], pred_ridge))),
+        }
+        ridge = {
+            "alpha": float(model.alpha),
+            "intercept": float(model.intercept_),
+            "mean": scaler.mean_,
+            "inv_std": 1.0 / np.where(scaler.scale_ == 0, 1.0, scaler.scale_),
+            "coef": model.coef_[:N_BANDS],
+            "juice_coef": model.coef_[N_BANDS:],
+        }
+
+    print("-" * 70)
+    for name, m in metrics.items():
+        print(f"{name:13s} | test MAE={m['mae']:.2f}% | test RMSE={m['rmse']:.2f}%")
+
+    # Hold-out gate: the per-juice fit is always exported, the ridge is optional.
+    if metrics["beer-lambert"]["mae"] > args.max_mae:
+        raise SystemExit(f"Refusing to export: beer-lambert hold-out MAE "
+                         f"{metrics['beer-lambert']['mae']:.2f}% > --max_mae {args.max_mae:g}%")
+    if ridge is not None and metrics["ridge"]["mae"] > args.max_mae:
+        print(f"Ridge not exported: hold-out MAE {metrics['ridge']['mae']:.2f}% > --max_mae {args.max_mae:g}%")
+        ridge = None
+    prefer_ridge = ridge is not None and metrics["ridge"]["mae"] < metrics["beer-lambert"]["mae"]
+
+    bundle = {
+        "preprocess_spec": spec,
+        "levels": levels,
+        "juices": juices,
+        "linear": linear,
+        "ridge": ridge,
+        "prefer_ridge": prefer_ridge,
+        "metrics": metrics,
+        "max_mae": args.max_mae,
+        "seed": args.seed,
+        "test_size": args.test_size,
+        "train_indices": tr_idx,
+        "test_indices": te_idx,
+    }
+    bundle_path = MODELS_DIR / "concentration_regression.joblib"
+    dump(bundle, bundle_path)
+    pd.DataFrame([{"model": k, **v} for k, v in metrics.items()]).to_csv(
+        MODELS_DIR / "concentration_regression_summary.csv", index=False)
+
+    header_path = Path(args.header)
+    write_header(header_path, spec, juices, linear, ridge, levels, metrics, prefer_ridge)
+
+    print("Saved regression bundle:", bundle_path.resolve())
+    print("Exported firmware header:", header_path.resolve())
+    print("=" * 70)
+
+
+if __name__ == "__main__":
+    main()
@@ -17,6 +17,7 @@ from sklearn.ensemble import RandomForestClassifier, HistGradientBoostingClassif
 
 from dataset import load_juice_Xy
 from features import make_features
+from preprocess_spec import make_spec
 
 
 def get_models(seed: int):
@@ -42,7 +43,7 @@ def cv_score(model, X: np.ndarray, y: np.ndarray, cv: StratifiedKFold):
 def main():
     ap = argparse.ArgumentParser("Juice classification - Train(CV) + Hold-out Test + save best model bundle")
     ap.add_argument("--data_dir", type=str, default="../Data")
-    ap.add_argument("--preprocess", choices=["raw", "l1"], default="l1")
+    ap.add_argument("--preprocess", type=str, default="l1", help="spec text, see preprocess_spec.py")
     ap.add_argument("--folds", type=int, default=5)
     ap.add_argument("--seed", type=int, default=42)
     ap.add_argument("--models_dir", type=str, default="models")
@@ -117,6 +118,7 @@ def main():
         "label_encoder": le,
         "feature_cols": feat_cols,
         "preprocess": args.preprocess,
+        "preprocess_spec": make_spec(args.preprocess),
         "folds": args.folds,
         "seed": args.seed,
         "test_size": args.test_size,
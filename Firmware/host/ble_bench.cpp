@@ -0,0 +1,248 @@
+/********************************************************
+ * @file        	ble_bench.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Host benchmark of the BLE notification packing / scheduling
+ *
+ * @details
+ *  - Runs spectro_ble_link against a simulated GATT link:
+ *      * the stack buffers perEvent notifications and sends them at
+ *        connection events, every interval at a phase the scheduler
+ *        does not know
+ *      * the firmware polls the link every SIM_POLL_US
+ *  - The device writes one binary measurement frame (12 channels,
+ *    spectro_frame_encode_meas, as on USB) every frame period
+ *  - The receiver concatenates the notifications, splits the frames
+ *    at the COBS delimiters and decodes them; every frame must arrive
+ *    once, in order and intact
+ *  - Reports per MTU and interval, packed vs one notification per
+ *    frame (flush after every write): notifications per second,
+ *    bytes per notification, frames lost to a full buffer and the
+ *    write-to-delivery latency
+ *
+ *  Usage: ble_bench [frame period us] [seconds]
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "spectro_ble_link.h"
+#include "spectro_frame.h"
+
+//==================== Internal definitions ====================//
+
+#define SIM_CHANNELS     12
+#define SIM_MASK         ((uint16_t)((1U << SIM_CHANNELS) - 1))
+#define SIM_POLL_US      1000U      // idle callback rate of the firmware
+#define SIM_MAX_FRAMES   100000
+#define SIM_RX_MAX       256
+
+typedef struct
+{
+    // stack: notifications waiting for the next connection event
+    uint8_t  queued[SPECTRO_BLE_DEFAULT_PER_EVENT * 4][SPECTRO_BLE_MAX_PAYLOAD];
+    size_t   queuedLen[SPECTRO_BLE_DEFAULT_PER_EVENT * 4];
+    int      count;
+    int      buffers;
+
+    // receiver
+    uint8_t  rx[SIM_RX_MAX];
+    size_t   rxLen;
+    long     nextSeq;            // next frame expected
+    long     received;
+    long     errors;
+    double   latencySumUs;
+    uint32_t latencyMaxUs;
+} SimLink_t;
+
+static uint32_t s_writeUs[SIM_MAX_FRAMES];   // write time per frame, by sequence number
+static bool s_sent[SIM_MAX_FRAMES];
+static uint32_t s_seed = 12345;
+
+//==================== Internal helpers ====================//
+
+static uint32_t sim_rand(void)
+{
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return s_seed >> 8;
+}
+
+static bool sim_notify(void *ctx, const uint8_t *data, size_t len)
+{
+    SimLink_t *sim = (SimLink_t *)ctx;
+
+    if (sim->count >= sim->buffers)
+        return false;
+    memcpy(sim->queued[sim->count], data, len);
+    sim->queuedLen[sim->count] = len;
+    sim->count++;
+    return true;
+}
+
+/**
+ * @brief One frame between delimiters arrived at nowUs
+ */
+static void sim_receive_frame(SimLink_t *sim, uint32_t nowUs)
+{
+    SpectroFrameHeader_t hdr;
+    SpectroFrameMeas_t meas;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.channelMask = SIM_MASK;
+    if (!spectro_frame_decode_meas(sim->rx, sim->rxLen, &hdr, &meas))
+    {
+        sim->errors++;
+        return;
+    }
+
+    // frames refused by a full buffer never left the device
+    while ((sim->nextSeq < SIM_MAX_FRAMES) && !s_sent[sim->nextSeq])
+        sim->nextSeq++;
+    if ((long)meas.seq != (sim->nextSeq & 0xFFFF) || (meas.channels[0] != (uint16_t)sim->nextSeq))
+    {
+        sim->errors++;
+        return;
+    }
+
+    uint32_t latency = nowUs - s_writeUs[sim->nextSeq];
+    sim->latencySumUs += latency;
+    if (latency > sim->latencyMaxUs)
+        sim->latencyMaxUs = latency;
+    sim->received++;
+    sim->nextSeq++;
+}
+
+/**
+ * @brief Connection event: the stack sends its queued notifications
+ */
+static void sim_event(SimLink_t *sim, uint32_t nowUs)
+{
+    for (int i = 0; i < sim->count; i++)
+    {
+        for (size_t k = 0; k < sim->queuedLen[i]; k++)
+        {
+            uint8_t b = sim->queued[i][k];
+            if (b != 0)
+            {
+                if (sim->rxLen < SIM_RX_MAX)
+                    sim->rx[sim->rxLen++] = b;
+                continue;
+            }
+            if (sim->rxLen > 0)
+                sim_receive_frame(sim, nowUs);
+            sim->rxLen = 0;
+        }
+    }
+    sim->count = 0;
+}
+
+/**
+ * @brief One run; immediate = flush after every frame
+ * @return false if a frame was lost or damaged on the link
+ */
+static bool sim_run(uint16_t mtu, uint32_t intervalUs, uint32_t periodUs, uint32_t seconds, bool immediate)
+{
+    static SimLink_t sim;
+    SpectroBleLink_t link;
+    SpectroBleLinkIo_t io = { sim_notify, &sim };
+    uint8_t frame[SPECTRO_FRAME_MAX_ENCODED];
+
+    memset(&sim, 0, sizeof(sim));
+    memset(s_sent, 0, sizeof(s_sent));
+    sim.buffers = SPECTRO_BLE_DEFAULT_PER_EVENT;
+
+    uint32_t endUs = seconds * 1000000U;
+    uint32_t phaseUs = sim_rand() % intervalUs;   // true event phase, unknown to the link
+    uint32_t nextEventUs = phaseUs;
+    uint32_t nextFrameUs = periodUs;
+    long frames = 0, lost = 0;
+
+    spectro_ble_link_init(&link, &io);
+    spectro_ble_link_connect(&link, 0, mtu, intervalUs, SPECTRO_BLE_DEFAULT_PER_EVENT);
+
+    for (uint32_t t = 0; t < endUs; t += SIM_POLL_US)
+    {
+        while (nextEventUs <= t)
+        {
+            sim_event(&sim, nextEventUs);
+            nextEventUs += intervalUs;
+        }
+
+        if ((t >= nextFrameUs) && (frames < SIM_MAX_FRAMES))
+        {
+            SpectroFrameMeas_t m;
+            memset(&m, 0, sizeof(m));
+            m.seq = (uint16_t)frames;
+            m.timestampUs = t;
+            m.channelMask = SIM_MASK;
+            for (int i = 0; i < SIM_CHANNELS; i++)
+                m.channels[i] = (uint16_t)(i == 0 ? frames : 1000 + (sim_rand() & 0x3FF));
+
+            size_t len = spectro_frame_encode_meas(&m, frame, sizeof(frame));
+            s_writeUs[frames] = t;
+            s_sent[frames] = spectro_ble_link_write(&link, frame, len);
+            if (!s_sent[frames])
+                lost++;
+            frames++;
+            nextFrameUs += periodUs;
+
+            if (immediate)
+                spectro_ble_link_flush(&link, t);
+        }
+        spectro_ble_link_poll(&link, t);
+    }
+
+    const SpectroBleLinkStats_t *st = &link.stats;
+    double secs = (double)seconds;
+    printf("%4u %8.1f %-6s %8ld %8ld %9.1f %9.1f %7.1f %9.1f %9.1f\n", mtu, intervalUs / 1000.0,
+           immediate ? "frame" : "packed", frames, lost, st->notifications / secs,
+           st->notifications ? (double)st->bytes / st->notifications : 0.0,
+           st->notifications ? 100.0 * st->fullNotifications / st->notifications : 0.0,
+           sim.received ? sim.latencySumUs / sim.received / 1000.0 : 0.0, sim.latencyMaxUs / 1000.0);
+
+    // everything written either arrived or is still in the buffer / stack
+    long inFlight = frames - lost - sim.received;
+    if ((sim.errors > 0) || (inFlight < 0) || (inFlight > 2 + SPECTRO_BLE_LINK_BUFFER / 40))
+    {
+        fprintf(stderr, "mtu %u interval %u: %ld errors, %ld frames unaccounted\n", mtu, intervalUs, sim.errors,
+                inFlight);
+        return false;
+    }
+    return true;
+}
+
+//==================== Entry point ====================//
+
+int main(int argc, char **argv)
+{
+    static const uint16_t mtus[] = { 23, 185, 247 };
+    static const uint32_t intervals[] = { 7500, 15000, 30000, 50000 };
+
+    uint32_t periodUs = (argc > 1) ? (uint32_t)atol(argv[1]) : 21000U;
+    uint32_t seconds = (argc > 2) ? (uint32_t)atol(argv[2]) : 60U;
+
+    if ((periodUs < SIM_POLL_US) || (seconds < 1) || ((uint64_t)seconds * 1000000U / periodUs >= SIM_MAX_FRAMES))
+    {
+        fprintf(stderr, "usage: ble_bench [frame period us >= %u] [seconds], < %d frames\n", SIM_POLL_US,
+                SIM_MAX_FRAMES);
+        return 1;
+    }
+
+    printf("frame every %.1f ms, %d channels, %d notifications per event\n", periodUs / 1000.0, SIM_CHANNELS,
+           SPECTRO_BLE_DEFAULT_PER_EVENT);
+    printf("%4s %8s %-6s %8s %8s %9s %9s %7s %9s %9s\n", "mtu", "int ms", "mode", "frames", "lost", "notif/s",
+           "B/notif", "full %", "lat ms", "max ms");
+
+    for (size_t m = 0; m < sizeof(mtus) / sizeof(mtus[0]); m++)
+        for (size_t i = 0; i < sizeof(intervals) / sizeof(intervals[0]); i++)
+            for (int immediate = 1; immediate >= 0; immediate--)
+                if (!sim_run(mtus[m], intervals[i], periodUs, seconds, immediate != 0))
+                    return 1;
+
+    printf("all frames delivered in order and intact\n");
+    return 0;
+}
@@ -0,0 +1,206 @@
+/********************************************************
+ * @file        	delta_bench.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Host benchmark of the FORMAT delta frame compression
+ *
+ * @details
+ *  - Encodes synthetic DATA_LOG streams (12 channels, counts of a real
+ *    juice spectrum at MEDIUM precision) with spectro_delta:
+ *      * steady : fixed sample, shot noise (sigma = sqrt(counts))
+ *      * drift  : as steady, plus a slow lamp warm-up drift
+ *      * swap   : a different sample every 200 frames
+ *      * noisy  : 10x shot noise, little left to gain
+ *  - Reports bytes per frame as plain binary frames and as delta
+ *    stream, the compression ratio and ns per encoded frame
+ *  - Decodes every stream again and checks it is lossless, and that
+ *    a lost frame is detected and recovered at the next keyframe
+ *
+ *  Usage: delta_bench [frames] [key interval]
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "spectro_delta.h"
+
+//==================== Internal definitions ====================//
+
+#define BENCH_CHANNELS     12
+#define BENCH_MASK         ((uint16_t)((1U << BENCH_CHANNELS) - 1))
+#define BENCH_PERIOD_US    21000U    // MEDIUM precision frame time
+#define BENCH_SWAP_FRAMES  200
+
+typedef enum
+{
+    BENCH_STEADY = 0,
+    BENCH_DRIFT,
+    BENCH_SWAP,
+    BENCH_NOISY,
+    BENCH_NUM_SCENARIOS
+} BenchScenario_t;
+
+static const char *const s_names[BENCH_NUM_SCENARIOS] = { "steady", "drift", "swap", "noisy" };
+
+// mean counts of two samples in Data/dataset1.csv, scaled to MEDIUM precision
+static const double s_spectra[2][BENCH_CHANNELS] =
+{
+    {  190, 2970, 5550, 2370, 6894, 3410, 13480, 13774, 11312, 5290,  700,  714 },
+    {   50,  570, 1050,  510, 1270,  730,  3926,  5338,  5910, 3270,  470,  378 },
+};
+
+static uint32_t s_seed = 12345;
+
+//==================== Internal helpers ====================//
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static double bench_uniform(void)
+{
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return ((double)(s_seed >> 8) + 0.5) / 16777216.0;
+}
+
+static double bench_gauss(void)
+{
+    return sqrt(-2.0 * log(bench_uniform())) * cos(6.283185307179586 * bench_uniform());
+}
+
+/**
+ * @brief Frame f of a scenario
+ */
+static void bench_frame(BenchScenario_t sc, long f, SpectroFrameMeas_t *m)
+{
+    const double *base = s_spectra[(sc == BENCH_SWAP) ? (f / BENCH_SWAP_FRAMES) % 2 : 0];
+    double gain = (sc == BENCH_DRIFT) ? 1.0 + 0.05 * (1.0 - exp(-(double)f / 2000.0)) : 1.0;
+    double noise = (sc == BENCH_NOISY) ? 10.0 : 1.0;
+
+    memset(m, 0, sizeof(*m));
+    m->seq = (uint16_t)f;
+    m->timestampUs = (uint32_t)(1000000U + (uint32_t)f * BENCH_PERIOD_US + (uint32_t)(bench_uniform() * 50));
+    m->channelMask = BENCH_MASK;
+
+    for (int i = 0; i < BENCH_CHANNELS; i++)
+    {
+        double v = base[i] * gain;
+        v += noise * sqrt(v) * bench_gauss();
+        m->channels[i] = (uint16_t)((v < 0) ? 0 : ((v > 65535) ? 65535 : v + 0.5));
+    }
+}
+
+/**
+ * @brief Encode and decode one scenario
+ * @return false if the decoded stream differs
+ */
+static bool bench_scenario(BenchScenario_t sc, long frames, uint8_t keyInterval)
+{
+    SpectroDelta_t enc, dec;
+    SpectroFrameHeader_t hdr;
+    uint8_t buf[SPECTRO_FRAME_MAX_ENCODED];
+    double encodeS = 0.0;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.channelMask = BENCH_MASK;
+    spectro_delta_init(&enc, keyInterval);
+    spectro_delta_init(&dec, keyInterval);
+
+    for (long f = 0; f < frames; f++)
+    {
+        SpectroFrameMeas_t in, out;
+        bench_frame(sc, f, &in);
+        memset(&out, 0, sizeof(out));   // padding, compared below
+
+        double t0 = bench_now();
+        size_t len = spectro_delta_encode(&enc, &in, buf, sizeof(buf));
+        encodeS += bench_now() - t0;
+
+        if ((len < 2) || !spectro_delta_decode(&dec, &buf[1], len - 2, &hdr, &out) ||
+            (memcmp(&in, &out, sizeof(in)) != 0))
+        {
+            fprintf(stderr, "%s: frame %ld does not round-trip\n", s_names[sc], f);
+            return false;
+        }
+    }
+
+    const SpectroDeltaStats_t *st = &enc.stats;
+    printf("%-8s %8ld %9lu %10.1f %10.1f %7.2f %9.0f\n", s_names[sc], frames, (unsigned long)st->keyframes,
+           (double)st->rawBytes / (double)st->frames, (double)st->codedBytes / (double)st->frames,
+           (double)st->rawBytes / (double)st->codedBytes, 1e9 * encodeS / (double)frames);
+    return true;
+}
+
+/**
+ * @brief A frame lost on the wire: the next delta frames are rejected,
+ *        decoding resumes correctly at the keyframe
+ */
+static bool bench_check_loss(uint8_t keyInterval)
+{
+    SpectroDelta_t enc, dec;
+    SpectroFrameHeader_t hdr;
+    uint8_t buf[SPECTRO_FRAME_MAX_ENCODED];
+    const long lost = 5;
+    long rejected = 0;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.channelMask = BENCH_MASK;
+    spectro_delta_init(&enc, keyInterval);
+    spectro_delta_init(&dec, keyInterval);
+
+    for (long f = 0; f < 3L * keyInterval; f++)
+    {
+        SpectroFrameMeas_t in, out;
+        bench_frame(BENCH_STEADY, f, &in);
+        memset(&out, 0, sizeof(out));
+        size_t len = spectro_delta_encode(&enc, &in, buf, sizeof(buf));
+        if (f == lost)
+            continue;
+
+        if (!spectro_delta_decode(&dec, &buf[1], len - 2, &hdr, &out))
+            rejected++;
+        else if (memcmp(&in, &out, sizeof(in)) != 0)
+            return false;
+    }
+    // everything from the lost frame up to the next keyframe
+    return (keyInterval <= lost) || (rejected == keyInterval - lost - 1);
+}
+
+//==================== Entry point ====================//
+
+int main(int argc, char **argv)
+{
+    long frames = (argc > 1) ? atol(argv[1]) : 100000;
+    int key = (argc > 2) ? atoi(argv[2]) : SPECTRO_DELTA_KEY_INTERVAL;
+
+    if ((frames < 1) || (key < 1) || (key > 255))
+    {
+        fprintf(stderr, "usage: delta_bench [frames] [key interval 1..255]\n");
+        return 1;
+    }
+
+    printf("key interval %d, %d channels\n", key, BENCH_CHANNELS);
+    printf("%-8s %8s %9s %10s %10s %7s %9s\n", "stream", "frames", "keyframes", "plain B/f", "delta B/f",
+           "ratio", "ns/frame");
+
+    for (int sc = 0; sc < BENCH_NUM_SCENARIOS; sc++)
+        if (!bench_scenario((BenchScenario_t)sc, frames, (uint8_t)key))
+            return 1;
+
+    if (!bench_check_loss((uint8_t)key))
+    {
+        fprintf(stderr, "lost frame not recovered at the keyframe\n");
+        return 1;
+    }
+    printf("round trip lossless, lost frame recovered at the next keyframe\n");
+    return 0;
+}
@@ -0,0 +1,219 @@
+/********************************************************
+ * @file        	format_bench.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Host microbenchmark of the text frame formatter
+ *
+ * @details
+ *  - Renders the DATA_LOG line "SORTED(405-855nm): c0,...,c11\r\n" with:
+ *      * print   : one virtual Print-style call per value and comma,
+ *                  divide-by-10 conversion (what Serial.print() does)
+ *      * snprintf: one snprintf per value into a line buffer
+ *      * line    : spectro_format.h, one line, digit-pair conversion
+ *  - Reports ns per frame and checks that all three produce identical
+ *    bytes, and that spectro_fmt_u16/u32 match printf on every value
+ *    tested
+ *  - Host ns do not transfer to the Cortex-M4, the ratios roughly do
+ *
+ *  Usage: format_bench [frames]
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "spectro_format.h"
+
+//==================== Internal definitions ====================//
+
+#define BENCH_CHANNELS     12
+#define BENCH_SETS         256     // distinct frames cycled through
+#define BENCH_PREFIX       "SORTED(405-855nm): "
+
+/**
+ * @brief Minimal stand-in for Arduino's Print: virtual write per call
+ */
+class BenchPrint
+{
+public:
+    char   buf[SPECTRO_LINE_MAX];
+    size_t len = 0;
+
+    virtual ~BenchPrint() {}
+    virtual size_t write(const uint8_t *data, size_t n)
+    {
+        if (n > sizeof(buf) - len)
+            n = sizeof(buf) - len;
+        memcpy(&buf[len], data, n);
+        len += n;
+        return n;
+    }
+
+    size_t print(const char *s) { return write((const uint8_t *)s, strlen(s)); }
+    size_t print(char c) { return write((const uint8_t *)&c, 1); }
+
+    // Print::printNumber(): divide by 10 into a scratch buffer
+    size_t print(unsigned v)
+    {
+        char tmp[11];
+        char *p = &tmp[sizeof(tmp) - 1];
+        *p = '\0';
+        do
+        {
+            *--p = (char)('0' + v % 10);
+            v /= 10;
+        }
+        while (v != 0);
+        return print(p);
+    }
+
+    size_t println() { return print("\r\n"); }
+};
+
+static uint16_t s_frames[BENCH_SETS][BENCH_CHANNELS];
+
+//==================== Internal helpers ====================//
+
+static double bench_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static size_t bench_print(const uint16_t *ch, char *out)
+{
+    BenchPrint serial;
+    BenchPrint *print = &serial;   // force virtual dispatch like Serial
+
+    print->print(BENCH_PREFIX);
+    for (int i = 0; i < BENCH_CHANNELS; i++)
+    {
+        print->print((unsigned)ch[i]);
+        if (i < BENCH_CHANNELS - 1)
+            print->print(',');
+    }
+    print->println();
+
+    memcpy(out, serial.buf, serial.len);
+    return serial.len;
+}
+
+static size_t bench_snprintf(const uint16_t *ch, char *out)
+{
+    int n = snprintf(out, SPECTRO_LINE_MAX, "%s", BENCH_PREFIX);
+    for (int i = 0; i < BENCH_CHANNELS; i++)
+        n += snprintf(&out[n], SPECTRO_LINE_MAX - n, (i < BENCH_CHANNELS - 1) ? "%u," : "%u\r\n", (unsigned)ch[i]);
+    return (size_t)n;
+}
+
+static size_t bench_line(const uint16_t *ch, char *out)
+{
+    SpectroLine_t line;
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, BENCH_PREFIX);
+    spectro_line_u16_list(&line, ch, BENCH_CHANNELS, ',');
+    spectro_line_end(&line);
+
+    memcpy(out, line.buf, line.len);
+    return line.len;
+}
+
+static bool bench_check_conversion(void)
+{
+    char a[16], b[16];
+
+    for (uint32_t v = 0; v <= 0xFFFF; v++)
+    {
+        *spectro_fmt_u16(a, (uint16_t)v) = '\0';
+        snprintf(b, sizeof(b), "%u", (unsigned)v);
+        if (strcmp(a, b) != 0)
+        {
+            fprintf(stderr, "u16 mismatch at %u: %s\n", (unsigned)v, a);
+            return false;
+        }
+    }
+
+    uint32_t v = 1;
+    for (int i = 0; i < 1000000; i++)
+    {
+        v = v * 1664525u + 1013904223u;
+        uint32_t x = v >> (v & 31);
+        *spectro_fmt_u32(a, x) = '\0';
+        snprintf(b, sizeof(b), "%u", (unsigned)x);
+        if (strcmp(a, b) != 0)
+        {
+            fprintf(stderr, "u32 mismatch at %u: %s\n", (unsigned)x, a);
+            return false;
+        }
+    }
+    *spectro_fmt_u32(a, 0xFFFFFFFFu) = '\0';
+    return strcmp(a, "4294967295") == 0;
+}
+
+/*******************************************************
+ * @brief  ns per frame of one formatter
+ *******************************************************/
+static double bench_run(size_t (*fmt)(const uint16_t *, char *), long frames, size_t *bytes)
+{
+    static char out[SPECTRO_LINE_MAX];
+    volatile size_t sink = 0;
+    double t0 = bench_now();
+
+    for (long f = 0; f < frames; f++)
+        sink += fmt(s_frames[f % BENCH_SETS], out) + (size_t)out[3];
+
+    double dt = bench_now() - t0;
+    *bytes = sink;
+    return 1e9 * dt / (double)frames;
+}
+
+//==================== Entry point ====================//
+
+int main(int argc, char **argv)
+{
+    long frames = (argc > 1) ? atol(argv[1]) : 2000000;
+
+    // channel values spread over 1..5 digits, like real gain-dependent counts
+    uint32_t seed = 12345;
+    for (int f = 0; f < BENCH_SETS; f++)
+    {
+        for (int i = 0; i < BENCH_CHANNELS; i++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            s_frames[f][i] = (uint16_t)((seed >> 16) >> ((seed >> 8) % 13));
+        }
+    }
+
+    if (!bench_check_conversion())
+        return 1;
+
+    for (int f = 0; f < BENCH_SETS; f++)
+    {
+        char a[SPECTRO_LINE_MAX], b[SPECTRO_LINE_MAX], c[SPECTRO_LINE_MAX];
+        size_t na = bench_print(s_frames[f], a);
+        size_t nb = bench_snprintf(s_frames[f], b);
+        size_t nc = bench_line(s_frames[f], c);
+        if ((na != nb) || (na != nc) || (memcmp(a, b, na) != 0) || (memcmp(a, c, na) != 0))
+        {
+            fprintf(stderr, "ERROR: formatters disagree on frame %d\n", f);
+            return 1;
+        }
+    }
+
+    size_t sink;
+    double tPrint = bench_run(bench_print, frames, &sink);
+    double tSnprintf = bench_run(bench_snprintf, frames, &sink);
+    double tLine = bench_run(bench_line, frames, &sink);
+
+    printf("%-9s %10s %8s %7s\n", "method", "ns/frame", "speedup", "writes");
+    printf("%-9s %10.1f %7.2fx %7d\n", "print", tPrint, 1.0, 2 * BENCH_CHANNELS + 1);
+    printf("%-9s %10.1f %7.2fx %7d\n", "snprintf", tSnprintf, tPrint / tSnprintf, 1);
+    printf("%-9s %10.1f %7.2fx %7d\n", "line", tLine, tPrint / tLine, 1);
+    return 0;
+}
@@ -0,0 +1,276 @@
+/********************************************************
+ * @file        	model_harness.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Host replay of a model package against sklearn outputs
+ *
+ * @details
+ *  - Builds the firmware inference engine (lib/ML) natively
+ *  - Replays every row dumped by Data_analysis/dump_reference.py
+ *    through the package written by Data_analysis/export_model.py
+ *  - Reports per model: label disagreements, largest probability
+ *    error, bit-exact probability rows and inferences per second
+ *  - Exit code 0 only if every model is within the limits, so it can
+ *    gate a model export
+ *
+ *  Usage: model_harness <package.bin> <reference.csv> [max_disagree] [prob_tol]
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+#include "spectro_model.h"
+
+//==================== Internal definitions ====================//
+
+#define HARNESS_MAX_ROWS         4096
+#define HARNESS_LINE_MAX         1024
+#define HARNESS_BENCH_SECONDS    0.5
+#define HARNESS_NUM_ROLES        2
+
+typedef struct
+{
+    int      role;      // SpectroModelRole_t
+    char     context[SPECTRO_MODEL_LABEL_LEN];
+    int      pred;      // sklearn class index
+    double   channels[SPECTRO_MODEL_NUM_CHANNELS];
+    double   proba[SPECTRO_MODEL_MAX_CLASSES];
+} HarnessRow_t;
+
+typedef struct
+{
+    uint32_t rows;
+    uint32_t disagree;        // predicted label differs
+    uint32_t exact;           // all probabilities bit-identical after float rounding
+    double   maxProbErr;
+    double   inferPerSec;
+} HarnessStats_t;
+
+static HarnessRow_t s_rows[HARNESS_MAX_ROWS];
+static uint32_t s_numRows = 0;
+
+static const char *const s_roleName[HARNESS_NUM_ROLES] = { "juice", "conc" };
+
+//==================== Internal helpers ====================//
+
+static double harness_now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+static uint8_t *harness_read_file(const char *path, uint32_t *size)
+{
+    FILE *f = fopen(path, "rb");
+    if (f == NULL)
+        return NULL;
+
+    fseek(f, 0, SEEK_END);
+    long len = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    // malloc is 4-byte aligned, as the package requires
+    uint8_t *buf = (len > 0) ? (uint8_t *)malloc((size_t)len) : NULL;
+    if ((buf != NULL) && (fread(buf, 1, (size_t)len, f) != (size_t)len))
+    {
+        free(buf);
+        buf = NULL;
+    }
+    fclose(f);
+
+    *size = (uint32_t)len;
+    return buf;
+}
+
+/**
+ * @brief Parse "role,context,pred,ch0..ch11,p0..p7" (header of dump_reference.py).
+ */
+static bool harness_parse_row(char *line, HarnessRow_t *row)
+{
+    char *field[3 + SPECTRO_MODEL_NUM_CHANNELS + SPECTRO_MODEL_MAX_CLASSES];
+    const int numFields = (int)(sizeof(field) / sizeof(field[0]));
+    int n = 0;
+
+    for (char *tok = strtok(line, ",\r\n"); (tok != NULL) && (n < numFields); tok = strtok(NULL, ",\r\n"))
+        field[n++] = tok;
+    if (n != numFields)
+        return false;
+
+    row->role = -1;
+    for (int r = 0; r < HARNESS_NUM_ROLES; r++)
+    {
+        if (strcmp(field[0], s_roleName[r]) == 0)
+            row->role = r;
+    }
+    if (row->role < 0)
+        return false;
+
+    snprintf(row->context, sizeof(row->context), "%s", field[1]);
+    row->pred = atoi(field[2]);
+    for (int i = 0; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+        row->channels[i] = strtod(field[3 + i], NULL);
+    for (int c = 0; c < SPECTRO_MODEL_MAX_CLASSES; c++)
+        row->proba[c] = strtod(field[3 + SPECTRO_MODEL_NUM_CHANNELS + c], NULL);
+    return true;
+}
+
+static bool harness_load_reference(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (f == NULL)
+        return false;
+
+    char line[HARNESS_LINE_MAX];
+    bool header = true;
+
+    while (fgets(line, sizeof(line), f) != NULL)
+    {
+        if (header)
+        {
+            header = false;
+            continue;
+        }
+        if (s_numRows >= HARNESS_MAX_ROWS)
+            break;
+        if (harness_parse_row(line, &s_rows[s_numRows]))
+            s_numRows++;
+    }
+    fclose(f);
+    return (s_numRows > 0);
+}
+
+static int harness_infer(const SpectroModelSection_t *sec, const HarnessRow_t *row, float *proba)
+{
+    float x[SPECTRO_MODEL_MAX_INPUTS];
+    int context = spectro_model_context_index(sec, row->context);
+
+    spectro_model_features(sec, row->channels, context, x);
+    return spectro_model_predict(sec, x, proba);
+}
+
+/*******************************************************
+ * @brief  Compare one model against its reference rows
+ *******************************************************/
+static void harness_compare(const SpectroModelSection_t *sec, int role, HarnessStats_t *st)
+{
+    memset(st, 0, sizeof(*st));
+
+    for (uint32_t r = 0; r < s_numRows; r++)
+    {
+        const HarnessRow_t *row = &s_rows[r];
+        if (row->role != role)
+            continue;
+
+        float proba[SPECTRO_MODEL_MAX_CLASSES];
+        int pred = harness_infer(sec, row, proba);
+        bool exact = true;
+
+        for (int c = 0; c < sec->numClasses; c++)
+        {
+            double err = fabs((double)proba[c] - row->proba[c]);
+            if (err > st->maxProbErr)
+                st->maxProbErr = err;
+            if (proba[c] != (float)row->proba[c])
+                exact = false;
+        }
+
+        st->rows++;
+        st->disagree += (pred != row->pred) ? 1 : 0;
+        st->exact += exact ? 1 : 0;
+    }
+}
+
+/*******************************************************
+ * @brief  Inferences per second (features + predict)
+ *******************************************************/
+static void harness_benchmark(const SpectroModelSection_t *sec, int role, HarnessStats_t *st)
+{
+    volatile int sink = 0;
+    uint64_t count = 0;
+    double t0 = harness_now();
+    double elapsed = 0.0;
+
+    do
+    {
+        for (uint32_t r = 0; r < s_numRows; r++)
+        {
+            if (s_rows[r].role != role)
+                continue;
+
+            float proba[SPECTRO_MODEL_MAX_CLASSES];
+            sink += harness_infer(sec, &s_rows[r], proba);
+            count++;
+        }
+        elapsed = harness_now() - t0;
+    }
+    while (elapsed < HARNESS_BENCH_SECONDS);
+
+    (void)sink;
+    st->inferPerSec = (double)count / elapsed;
+}
+
+//==================== Entry point ====================//
+
+int main(int argc, char **argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <package.bin> <reference.csv> [max_disagree] [prob_tol]\n", argv[0]);
+        return 2;
+    }
+
+    double maxDisagree = (argc > 3) ? strtod(argv[3], NULL) : 0.0;   // fraction of rows
+    double probTol = (argc > 4) ? strtod(argv[4], NULL) : 1e-5;
+
+    uint32_t size = 0;
+    uint8_t *image = harness_read_file(argv[1], &size);
+    if ((image == NULL) || !spectro_model_validate(image, size))
+    {
+        fprintf(stderr, "ERROR: %s is not a valid model package\n", argv[1]);
+        return 1;
+    }
+    if (!harness_load_reference(argv[2]))
+    {
+        fprintf(stderr, "ERROR: no reference rows in %s\n", argv[2]);
+        return 1;
+    }
+
+    const SpectroModelHeader_t *hdr = spectro_model_header(image);
+    printf("Package: %s | version %u | %u bytes\n", hdr->name, (unsigned)hdr->packageVersion, (unsigned)size);
+    printf("%-6s %6s %9s %7s %12s %14s\n", "model", "rows", "disagree", "exact", "max|dp|", "infer/s");
+
+    bool pass = true;
+    for (int role = 0; role < HARNESS_NUM_ROLES; role++)
+    {
+        const SpectroModelSection_t *sec = spectro_model_find(image, (SpectroModelRole_t)role);
+        if (sec == NULL)
+            continue;
+
+        HarnessStats_t st;
+        harness_compare(sec, role, &st);
+        if (st.rows == 0)
+        {
+            printf("%-6s no reference rows\n", s_roleName[role]);
+            pass = false;
+            continue;
+        }
+        harness_benchmark(sec, role, &st);
+
+        double rate = (double)st.disagree / (double)st.rows;
+        bool ok = (rate <= maxDisagree) && (st.maxProbErr <= probTol);
+        pass = pass && ok;
+
+        printf("%-6s %6u %8.2f%% %7u %12.3g %14.0f  %s\n", s_roleName[role], (unsigned)st.rows, 100.0 * rate,
+               (unsigned)st.exact, st.maxProbErr, st.inferPerSec, ok ? "OK" : "FAIL");
+    }
+
+    free(image);
+    return pass ? 0 : 1;
+}
@@ -0,0 +1,472 @@
+/********************************************************
+ * @file        	oled_bench.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Host benchmark of the background OLED flush
+ *
+ * @details
+ *  - Runs oled_dma against a simulated SPI peripheral and SSD1306:
+ *      * a transfer takes 1 us per byte (8 MHz) plus SIM_TRANSFER_US
+ *        and writes the controller GDDRAM (page or horizontal
+ *        addressing, column / page windows) when it completes, from
+ *        the buffer the engine handed over, so a back buffer changed
+ *        too early shows up on the panel
+ *      * "block": start() returns after the transfer (SPI library
+ *        path), the CPU waits for the bus
+ *      * "dma": start() returns at once, the completion interrupt
+ *        continues the list (SPIM EasyDMA path)
+ *  - The firmware loop: integration (the idle callback polls the
+ *    display every SIM_POLL_US), then the result screen is drawn
+ *    with the 16 px font and flushed; every SIM_MODE_EVERY frames a
+ *    full mode screen
+ *  - Every finished flush must leave the panel equal to the
+ *    framebuffer at its start, and the panel must equal the
+ *    framebuffer at the end
+ *  - Reports per integration time: frame rate, flushes and deferred
+ *    flushes, display CPU time per frame (block: bus time; dma:
+ *    SIM_TRANSFER_US per transfer + copying at SIM_COPY_B_PER_US,
+ *    both modelled) and the draw-to-panel latency
+ *  - Then the bus cost of the same flushes with horizontal addressing
+ *    windows (sent) and with the page addressing commands of the
+ *    former driver (3 address bytes and a burst per dirty page,
+ *    counted from the dirty ranges), and of a full screen
+ *
+ *  Usage: oled_bench [frames]
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "oled_framebuffer.h"
+#include "oled_dma.h"
+#include "oled_font_picture.h"
+
+//==================== Internal definitions ====================//
+
+#define SIM_BYTE_US          1U       // 8 MHz SPI
+#define SIM_TRANSFER_US      2U       // per transfer: END interrupt or call, DC, next START
+#define SIM_COPY_B_PER_US    32U      // back buffer copy at 64 MHz
+#define SIM_POLL_US          200U     // idle callback rate while integrating
+#define SIM_PROCESS_US       300U     // frame processing before drawing
+#define SIM_MODE_EVERY       100
+#define SIM_COMPARE_US       2000U    // run whose flushes the addressing table shows
+
+typedef struct
+{
+    bool     async;
+    uint64_t nowUs;
+
+    // bus
+    const uint8_t *data;
+    uint16_t len;
+    uint8_t  dc;
+    bool     pending;
+    uint64_t endUs;
+    bool     selected;
+
+    // controller
+    uint8_t  gddram[OLED_FB_PAGES][OLED_FB_COLUMNS];
+    uint8_t  mode;            // 0x20 argument: 0 horizontal, 2 page
+    uint8_t  page, pageLo, pageHi;
+    uint8_t  col, colLo, colHi;
+    uint8_t  cmd;             // command waiting for arguments
+    uint8_t  args[2];
+    uint8_t  argCount;
+    uint8_t  argsLeft;
+
+    // checks and counters
+    uint8_t  expect[OLED_FB_PAGES][OLED_FB_COLUMNS];   // framebuffer when the flush started
+    uint64_t cpuUs;
+    uint64_t drawUs;          // oldest drawing the running flush carries
+    uint64_t latSumUs;
+    uint64_t latMaxUs;
+    long     flushesDone;
+    long     transfers;
+    long     errors;
+    long     flushes;
+    uint64_t bytes;
+    uint64_t pageBytes;       // the same flushes in page addressing
+    long     pageTransfers;
+    OledDma_t *dma;
+} SimSpi_t;
+
+static OledFb_t s_fb;
+static OledDma_t s_dma;
+static SimSpi_t s_sim;
+static uint32_t s_seed = 12345;
+
+static const char *const s_labels[] = { "Apple Juice", "Orange", "Water", "Cola", "Unknown", "Milk" };
+static const char *const s_status[] = { "Stable", "Refining", "Unstable", "Preview" };
+
+//==================== Internal helpers ====================//
+
+static uint32_t sim_rand(void)
+{
+    s_seed = s_seed * 1664525u + 1013904223u;
+    return s_seed >> 8;
+}
+
+static void sim_command(SimSpi_t *sim, uint8_t b)
+{
+    if (sim->argsLeft > 0)
+    {
+        sim->args[sim->argCount++] = b;
+        if (--sim->argsLeft > 0)
+            return;
+
+        if (sim->cmd == 0x20)
+            sim->mode = (uint8_t)(sim->args[0] & 0x03);
+        else if (sim->cmd == 0x21)
+        {
+            sim->colLo = sim->col = (uint8_t)(sim->args[0] & 0x7F);
+            sim->colHi = (uint8_t)(sim->args[1] & 0x7F);
+        }
+        else
+        {
+            sim->pageLo = sim->page = (uint8_t)(sim->args[0] & 0x07);
+            sim->pageHi = (uint8_t)(sim->args[1] & 0x07);
+        }
+        return;
+    }
+
+    if ((b == 0x20) || (b == 0x21) || (b == 0x22))
+    {
+        sim->cmd = b;
+        sim->argCount = 0;
+        sim->argsLeft = (b == 0x20) ? 1 : 2;
+    }
+    else if (sim->mode != 2)
+        return;   // the position commands below only act in page addressing
+    else if ((b >= 0xB0) && (b < 0xB0 + OLED_FB_PAGES))
+        sim->page = (uint8_t)(b - 0xB0);
+    else if (b < 0x10)
+        sim->col = (uint8_t)((sim->col & 0xF0) | b);
+    else if (b < 0x20)
+        sim->col = (uint8_t)(((b & 0x07) << 4) | (sim->col & 0x0F));
+}
+
+/**
+ * @brief The controller receives one transfer
+ */
+static void sim_apply(SimSpi_t *sim, const uint8_t *data, uint16_t len, uint8_t dc)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (!dc)
+        {
+            sim_command(sim, data[i]);
+            continue;
+        }
+
+        sim->gddram[sim->page][sim->col] = data[i];
+        if (sim->col != sim->colHi)
+            sim->col = (uint8_t)((sim->col + 1) % OLED_FB_COLUMNS);
+        else
+        {
+            sim->col = sim->colLo;
+            if (sim->mode == 0)
+                sim->page = (sim->page == sim->pageHi) ? sim->pageLo : (uint8_t)(sim->page + 1);
+        }
+    }
+}
+
+/**
+ * @brief Controller state after reset, then the addressing mode the
+ *        driver's init table selects
+ */
+static void sim_reset(SimSpi_t *sim)
+{
+    static const uint8_t init[] = { 0x20, 0x00 };
+
+    sim->mode = 2;
+    sim->page = sim->pageLo = 0;
+    sim->pageHi = OLED_FB_PAGES - 1;
+    sim->col = sim->colLo = 0;
+    sim->colHi = OLED_FB_COLUMNS - 1;
+    sim->argsLeft = 0;
+    sim_apply(sim, init, sizeof(init), 0);
+}
+
+static void sim_begin(void *ctx)
+{
+    SimSpi_t *sim = (SimSpi_t *)ctx;
+
+    if (sim->selected)
+        sim->errors++;
+    sim->selected = true;
+    memcpy(sim->expect, s_fb.buf, sizeof(sim->expect));   // take_span only marks clean
+}
+
+static void sim_start(void *ctx, const uint8_t *data, uint16_t len, uint8_t dc)
+{
+    SimSpi_t *sim = (SimSpi_t *)ctx;
+
+    if (!sim->selected || sim->pending)
+        sim->errors++;
+    sim->transfers++;
+
+    if (!sim->async)
+    {
+        sim_apply(sim, data, len, dc);
+        sim->nowUs += len * SIM_BYTE_US + SIM_TRANSFER_US;
+        sim->cpuUs += len * SIM_BYTE_US + SIM_TRANSFER_US;
+        oled_dma_complete(sim->dma);
+        return;
+    }
+
+    sim->data = data;
+    sim->len = len;
+    sim->dc = dc;
+    sim->pending = true;
+    sim->endUs = sim->nowUs + len * SIM_BYTE_US;
+}
+
+static void sim_done(void *ctx)
+{
+    SimSpi_t *sim = (SimSpi_t *)ctx;
+    uint64_t latUs = sim->nowUs - sim->drawUs;
+
+    sim->selected = false;
+    sim->flushesDone++;
+    sim->latSumUs += latUs;
+    if (latUs > sim->latMaxUs)
+        sim->latMaxUs = latUs;
+    if (memcmp(sim->gddram, sim->expect, sizeof(sim->gddram)) != 0)
+        sim->errors++;
+}
+
+/**
+ * @brief Let time pass to toUs: completions, each followed by the
+ *        interrupt starting the next transfer
+ */
+static void sim_advance(SimSpi_t *sim, uint64_t toUs)
+{
+    while (sim->pending && (sim->endUs <= toUs))
+    {
+        sim->nowUs = sim->endUs;
+        sim->pending = false;
+        sim_apply(sim, sim->data, sim->len, sim->dc);
+
+        sim->nowUs += SIM_TRANSFER_US;
+        sim->cpuUs += SIM_TRANSFER_US;
+        oled_dma_complete(sim->dma);
+    }
+    if (toUs > sim->nowUs)
+        sim->nowUs = toUs;
+}
+
+/**
+ * @brief oled_flush() if the bus is free, counting the page
+ *        addressing cost of the same spans first
+ */
+static void sim_flush(SimSpi_t *sim, uint64_t drawUs)
+{
+    if (oled_dma_busy(&s_dma) || !oled_fb_dirty(&s_fb))
+        return;
+
+    for (uint8_t p = 0; p < OLED_FB_PAGES; p++)
+    {
+        if (s_fb.dirtyHi[p] >= s_fb.dirtyLo[p])
+        {
+            sim->pageBytes += 3 + s_fb.dirtyHi[p] - s_fb.dirtyLo[p] + 1;
+            sim->pageTransfers += 2;
+        }
+    }
+
+    sim->drawUs = drawUs;
+    uint16_t n = oled_dma_start(&s_dma, &s_fb);
+    sim->bytes += n;
+    sim->flushes++;
+    if (sim->async)
+        sim->cpuUs += n / SIM_COPY_B_PER_US;
+}
+
+static void sim_text(uint8_t x, uint8_t page, const char *s, bool large)
+{
+    uint8_t col = (uint8_t)(x | 0x01);   // as oled_column()
+
+    for (; *s; s++)
+    {
+        uint8_t c = (uint8_t)(*s - ' ');
+        if (large)
+        {
+            oled_fb_write(&s_fb, page, col, &asc2_1608[c][0], 8);
+            oled_fb_write(&s_fb, (uint8_t)(page + 1), col, &asc2_1608[c][8], 8);
+            col = (uint8_t)(col + 8);
+        }
+        else
+        {
+            oled_fb_write(&s_fb, page, col, asc2_0806[c], 6);
+            col = (uint8_t)(col + 6);
+        }
+    }
+}
+
+static void sim_draw(long frame)
+{
+    static int label = 0;
+
+    if (frame % SIM_MODE_EVERY == 0)
+    {
+        oled_fb_fill(&s_fb, 0, OLED_FB_PAGES, 0);
+        sim_text(45, 0, "Mode", true);
+        sim_text((frame / SIM_MODE_EVERY) % 2 ? 30 : 35, 2, (frame / SIM_MODE_EVERY) % 2 ? "Progressive" : "Data Log",
+                 true);
+    }
+    if (sim_rand() % 8 == 0)
+        label = (int)(sim_rand() % (sizeof(s_labels) / sizeof(s_labels[0])));
+
+    oled_fb_fill(&s_fb, 4, OLED_FB_PAGES, 0);
+    sim_text(20, 4, s_labels[label], true);
+    sim_text(20, 7, s_status[sim_rand() % (sizeof(s_status) / sizeof(s_status[0]))], false);
+}
+
+/**
+ * @brief One run of the firmware loop
+ * @return false if the panel ever differed from the framebuffer
+ */
+static bool sim_run(uint32_t integrationUs, long frames, bool async)
+{
+    OledDmaIo_t io = { sim_begin, sim_start, sim_done, &s_sim };
+    long deferred = 0;
+    uint64_t unsentUs = 0;    // oldest drawing not on the bus yet
+    bool unsent = false;
+
+    memset(&s_sim, 0, sizeof(s_sim));
+    s_sim.async = async;
+    s_sim.dma = &s_dma;
+    sim_reset(&s_sim);
+    s_seed = 12345;
+    oled_fb_init(&s_fb);
+    oled_dma_init(&s_dma, &io);
+
+    for (long f = 0; f < frames; f++)
+    {
+        uint64_t endUs = s_sim.nowUs + integrationUs;
+        while (s_sim.nowUs < endUs)
+        {
+            sim_advance(&s_sim, s_sim.nowUs + SIM_POLL_US < endUs ? s_sim.nowUs + SIM_POLL_US : endUs);
+            if (unsent && !oled_dma_busy(&s_dma))   // oled_poll()
+            {
+                unsent = false;
+                sim_flush(&s_sim, unsentUs);
+            }
+        }
+
+        sim_advance(&s_sim, s_sim.nowUs + SIM_PROCESS_US);
+        sim_draw(f);
+        if (!unsent)
+        {
+            unsentUs = s_sim.nowUs;
+            unsent = true;
+        }
+
+        if (oled_dma_busy(&s_dma))   // oled_flush()
+        {
+            deferred++;
+            continue;
+        }
+        unsent = false;
+        sim_flush(&s_sim, unsentUs);
+    }
+
+    // settle: deferred changes go out, then the panel shows the last frame
+    while (oled_dma_busy(&s_dma) || oled_fb_dirty(&s_fb))
+    {
+        sim_advance(&s_sim, s_sim.nowUs + SIM_POLL_US);
+        sim_flush(&s_sim, unsentUs);
+    }
+    if (memcmp(s_sim.gddram, s_fb.buf, sizeof(s_fb.buf)) != 0)
+        s_sim.errors++;
+
+    printf("%8u %-6s %9.1f %8ld %8ld %9.1f %9.1f %9.2f %9.2f\n", integrationUs, async ? "dma" : "block",
+           frames * 1e6 / (double)s_sim.nowUs, s_sim.flushes, deferred,
+           s_sim.flushes ? (double)s_sim.bytes / s_sim.flushes : 0.0, (double)s_sim.cpuUs / frames,
+           s_sim.flushesDone ? s_sim.latSumUs / 1000.0 / s_sim.flushesDone : 0.0, s_sim.latMaxUs / 1000.0);
+
+    if (s_sim.errors > 0)
+    {
+        fprintf(stderr, "integration %u us, %s: %ld errors\n", integrationUs, async ? "dma" : "block", s_sim.errors);
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Bus time of the flushes of the last run, window vs page addressing
+ */
+static void sim_print_addressing(const char *name, const SimSpi_t *sim)
+{
+    double n = sim->flushes ? (double)sim->flushes : 1.0;
+    double pageUs = (sim->pageBytes * SIM_BYTE_US + sim->pageTransfers * SIM_TRANSFER_US) / n;
+    double winUs = (sim->bytes * SIM_BYTE_US + sim->transfers * SIM_TRANSFER_US) / n;
+
+    printf("%-12s %9.1f %9.1f %9.1f %9.1f %9.1f %9.1f %8.2fx\n", name, sim->pageBytes / n, sim->pageTransfers / n,
+           pageUs, sim->bytes / n, sim->transfers / n, winUs, pageUs / winUs);
+}
+
+/**
+ * @brief One flush of a full random screen
+ */
+static bool sim_full_screen(void)
+{
+    OledDmaIo_t io = { sim_begin, sim_start, sim_done, &s_sim };
+
+    memset(&s_sim, 0, sizeof(s_sim));
+    s_sim.dma = &s_dma;
+    sim_reset(&s_sim);
+    oled_dma_init(&s_dma, &io);
+    for (uint8_t p = 0; p < OLED_FB_PAGES; p++)
+        for (uint8_t c = 0; c < OLED_FB_COLUMNS; c++)
+            s_fb.buf[p][c] = (uint8_t)sim_rand();
+    oled_fb_invalidate(&s_fb);
+
+    sim_flush(&s_sim, 0);
+    sim_print_addressing("full screen", &s_sim);
+    return (s_sim.errors == 0) && (memcmp(s_sim.gddram, s_fb.buf, sizeof(s_fb.buf)) == 0);
+}
+
+//==================== Entry point ====================//
+
+int main(int argc, char **argv)
+{
+    static const uint32_t integrations[] = { 100, 500, 2000, 10000, 100000 };
+
+    long frames = (argc > 1) ? atol(argv[1]) : 2000;
+    if (frames < 1)
+    {
+        fprintf(stderr, "usage: oled_bench [frames]\n");
+        return 1;
+    }
+
+    printf("%ld frames, result screen per frame, mode screen every %d\n", frames, SIM_MODE_EVERY);
+    printf("%8s %-6s %9s %8s %8s %9s %9s %9s %9s\n", "int us", "mode", "frames/s", "flushes", "deferred",
+           "B/flush", "cpu us/f", "lat ms", "max ms");
+
+    static SimSpi_t screens;
+    for (size_t i = 0; i < sizeof(integrations) / sizeof(integrations[0]); i++)
+        for (int async = 0; async <= 1; async++)
+        {
+            if (!sim_run(integrations[i], frames, async != 0))
+                return 1;
+            if (async && (integrations[i] == SIM_COMPARE_US))
+                screens = s_sim;
+        }
+
+    printf("\nbus per flush: page addressing (former) vs horizontal windows\n");
+    printf("%-12s %9s %9s %9s %9s %9s %9s %9s\n", "", "page B", "transfers", "bus us", "window B", "transfers",
+           "bus us", "speedup");
+    sim_print_addressing("screens", &screens);
+    if (!sim_full_screen())
+    {
+        fprintf(stderr, "full screen: panel differs\n");
+        return 1;
+    }
+
+    printf("panel matched the framebuffer after every flush\n");
+    return 0;
+}
@@ -13,17 +13,221 @@
  ********************************************************/
 
 #include "spectro_app.h"
+#include "spectro_cmd.h"
+#include "spectro_out.h"
+#include "spectro_mux.h"
+#include "spectro_ble.h"
+#include "spectro_centroid.h"
+#include "spectro_unmix.h"
+#include "spectro_conc_reg.h"
+#include "spectro_conc_model.h"
+#include "spectro_model.h"
+#include "spectro_storage.h"
+#include "spectro_model_slot.h"
+#include "spectro_frame.h"
+#include "spectro_delta.h"
+#include "spectro_format.h"
+#include "spectro_pc.h"
+#include "spectro_script.h"
+#include "oled_ssd1306.h"
+
+static_assert(SPECTRO_CENTROID_NUM_FEATURES == AS7343_NUM_SORTED_CHANNELS,
+              "centroid features must match the sorted channel count");
+static_assert(SPECTRO_UNMIX_NUM_BANDS == AS7343_NUM_SORTED_CHANNELS,
+              "unmixing bands must match the sorted channel count");
+static_assert(SPECTRO_CONC_NUM_BANDS == AS7343_NUM_SORTED_CHANNELS,
+              "regression bands must match the sorted channel count");
+static_assert(SPECTRO_CONC_MODEL_NUM_JUICES <= SPECTRO_CONC_MAX_JUICES,
+              "exported regression model has too many juices");
+static_assert(SPECTRO_MODEL_NUM_CHANNELS == AS7343_NUM_SORTED_CHANNELS,
+              "model package channels must match the sorted channel count");
+static_assert(SPECTRO_BATCH_NUM_CHANNELS == AS7343_NUM_SORTED_CHANNELS,
+              "batch channels must match the sorted channel count");
+
+#define SPECTRO_APP_CAPTURE_NONE    (-2)
+#define SPECTRO_APP_CAPTURE_BLANK   (-1)
+#define SPECTRO_APP_JUICE_AUTO      (-1)
+#define SPECTRO_APP_PC_RESULT_LEN   64
+#define SPECTRO_APP_ALL_CHANNELS    ((uint16_t)((1U << AS7343_NUM_SORTED_CHANNELS) - 1))
+#define SPECTRO_APP_HEADER_HISTORY  (SPECTRO_QUEUE_DEPTH + 1)   // epochs of queued frames + current
+
+#if SPECTRO_CONC_MODEL_HAS_RIDGE && SPECTRO_CONC_MODEL_PREFER_RIDGE
+#define SPECTRO_CONC_MODEL_DEFAULT  SPECTRO_CONC_MODEL_RIDGE    // lower hold-out error at export
+#else
+#define SPECTRO_CONC_MODEL_DEFAULT  SPECTRO_CONC_MODEL_LINEAR
+#endif
+
+/**
+ * @brief Sensor configuration per precision mode (gain as set by AS7343_init)
+ */
+static const AS7343_Config_t s_precConfig[] =
+{
+    { 0x00,   999, AS7343_GAIN_16X,  50 },   // LOW:    ~2.8 ms per cycle
+    { 0x01, 20000, AS7343_GAIN_16X, 500 },   // MEDIUM
+    { 0x00, 65534, AS7343_GAIN_16X, 800 },   // HIGH
+};
+
+/**
+ * @brief Command names, indexed by SpectroAppMode_t / SpectroPrecisionMode_t / AS7343_Gain_t
+ */
+static const char *const s_modeNames[] =
+{
+    "log", "local", "pc", "unmix", "conc", "model", "progressive"
+};
+
+static const char *const s_precNames[] = { "low", "medium", "high" };
+
+static const char *const s_formatNames[] = { "text", "binary", "delta" };
+
+static const uint16_t s_wavelengthsNm[AS7343_NUM_SORTED_CHANNELS] = AS7343_SORTED_WAVELENGTHS_NM;
+
+static const char *const s_gainNames[] =
+{
+    "0.5x", "1x", "2x", "4x", "8x", "16x", "32x", "64x", "128x", "256x", "512x", "1024x", "2048x"
+};
+
+/**
+ * @brief Progressive measurement phase
+ */
+typedef enum
+{
+    SPECTRO_PROG_PREVIEW = 0,   ///< next frame is the low-precision preview
+    SPECTRO_PROG_REFINE         ///< averaging frames at the selected precision
+} SpectroProgPhase_t;
 
 //==================== Static state ====================//
 
 static SpectroAppMode_t s_appMode = SPECTRO_APP_MODE_DATA_LOG;
 static SpectroPrecisionMode_t s_precMode = SPECTRO_PRECISION_MEDIUM;
+static SpectroOutputFormat_t s_outputFormat = SPECTRO_OUTPUT_TEXT;
+static int8_t s_gain = SPECTRO_APP_GAIN_AUTO;
+static uint8_t s_average = 1;
+static uint16_t s_channelMask = SPECTRO_APP_ALL_CHANNELS;
+static bool s_running = true;
+
+static SpectroAppConfig_t s_pendingConfig;     // requested over serial, applied between frames
+static volatile bool s_configPending = false;
+
+static uint32_t s_avgSum[AS7343_NUM_SORTED_CHANNELS];
+static uint8_t s_avgCount = 0;
+static uint16_t s_frameSeq = 0;                // sequence number of binary frames and PC requests
+static SpectroQueue_t s_outQueue;              // DATA_LOG frames waiting for room on the port
+static SpectroDelta_t s_delta;                 // FORMAT delta encoder
+
+static uint8_t s_sensorId = SPECTRO_FRAME_UNKNOWN8;
+static uint8_t s_sensorRevision = SPECTRO_FRAME_UNKNOWN8;
+static SpectroFrameHeader_t s_headers[SPECTRO_APP_HEADER_HISTORY];   // indexed by epoch
+static uint16_t s_epoch = 0;                   // epoch of the current settings
+static bool s_epochValid = false;
+static uint16_t s_headerSentEpoch = 0;         // last header on the DATA channel
+static bool s_headerSent = false;
+static bool s_headerResend = false;
+static bool s_hostConnected = false;           // DTR seen at the last check
+static bool s_bleConnected = false;            // BLE central streaming at the last check
+
+static SpectroCentroidModel_t s_centroid;
+static char s_learnLabel[SPECTRO_CENTROID_LABEL_LEN];
+static uint16_t s_learnRemaining = 0;
+static bool s_learnSavePending = false;   // saved between frames, not in the frame path
+static bool s_learnSaveReport = false;    // a finished LEARN waits for its SAVED line
+
+static SpectroUnmixLibrary_t s_unmixLib;
+static SpectroUnmixSolver_t s_unmixSolver;
+static int8_t s_unmixCapture = SPECTRO_APP_CAPTURE_NONE;   // blank or endmember index
+static bool s_unmixSavePending = false;   // saved between frames, not in the frame path
+
+static SpectroConcStats_t s_concStats;
+static SpectroConcModel_t s_concModel = SPECTRO_CONC_MODEL_DEFAULT;
+static int8_t s_concJuice = SPECTRO_APP_JUICE_AUTO;   // index into spectro_conc_model_juices
+static bool s_concSpecOk = false;                     // exported spec matches its hash
+
+static const uint8_t *s_modelImage = NULL;   // active package, executed from flash
+
+static SpectroProgPhase_t s_progPhase = SPECTRO_PROG_PREVIEW;
+static uint32_t s_progStartMs = 0;
+static uint16_t s_progFrames = 0;
+static uint16_t s_progAgree = 0;              // consecutive frames with the same refined label
+static int s_progLabel = -1;
+static double s_progSum[AS7343_NUM_SORTED_CHANNELS];
+
+static SpectroPcPipeline_t s_pc;
+static uint16_t s_pcResultSeq = 0;           // latest PC result
+static char s_pcResult[SPECTRO_APP_PC_RESULT_LEN];
+
+static SpectroBatch_t s_batch;
+static bool s_batchPending = false;          // MEASURE requested, runs before the next frame
+static bool s_batchRunning = false;
+static uint8_t s_batchFrames = 0;
+static SpectroPrecisionMode_t s_batchPrec = SPECTRO_PRECISION_MEDIUM;
+static SpectroBatchAgg_t s_batchAgg = SPECTRO_BATCH_MEAN;
+static char s_batchLabel[SPECTRO_APP_MEASURE_LABEL_LEN];
+
+static uint8_t s_script[SPECTRO_SCRIPT_MAX_SIZE];
+static uint16_t s_scriptSize = 0;             // announced by SCRIPT BEGIN
+static uint16_t s_scriptLoaded = 0;           // bytes received so far
+static bool s_scriptPending = false;          // SCRIPT RUN requested, runs before the next frame
+static bool s_scriptRunning = false;
+static bool s_scriptAbort = false;
+
+static SpectroStandby_t s_standby = SPECTRO_STANDBY_OFF;
+static bool s_standbyArmed = false;           // sensor set up for the standby mode
+static bool s_standbyLeft = false;            // left HOT: SP_EN back on before the next frame
+static bool s_trigPending = false;
+static bool s_trigActive = false;             // measuring the result of a trigger
+static SpectroTrigger_t s_trigSource = SPECTRO_TRIGGER_COMMAND;
+static uint32_t s_trigUs = 0;
+static volatile bool s_buttonPending = false; // set by the button ISR
+static volatile uint32_t s_buttonUs = 0;      // micros() of the last accepted edge
+static int8_t s_thrChannel = -1;              // threshold trigger, -1 = off
+static uint16_t s_thrLow = 0;
+static uint16_t s_thrHigh = 0;
+static bool s_thrInside = false;              // channel was inside the window last frame
+static uint32_t s_trigCount = 0;
+static uint32_t s_trigIgnored = 0;
+static uint32_t s_trigLastUs = 0;
+static uint32_t s_trigMinUs = 0;
+static uint32_t s_trigMaxUs = 0;
+static uint64_t s_trigSumUs = 0;
 
 //==================== Internal helpers (forward decl.) ====================//
 
 static void spectro_app_handle_data_log(const SpectroMeasurement_t *meas);
+static void spectro_app_fill_frame(SpectroFrameMeas_t *frame, const SpectroMeasurement_t *meas);
+static uint16_t spectro_app_epoch(void);
+static bool spectro_app_header_for(uint16_t epoch);
+static bool spectro_app_send_header(const SpectroFrameHeader_t *hdr);
+static void spectro_app_check_connect(void);
+static void spectro_app_send_frame(const SpectroFrameMeas_t *frame);
+static void spectro_app_send_line(const SpectroFrameMeas_t *frame);
+static void spectro_app_drain_queue(void);
+static bool spectro_app_configure_sensor(SpectroPrecisionMode_t prec);
+static void spectro_app_line_hex(SpectroLine_t *line, uint16_t value, int digits);
+static void spectro_app_apply_config(void);
+static bool spectro_app_average(SpectroMeasurement_t *meas);
+static void spectro_app_idle(void);
 static void spectro_app_handle_infer_local(const SpectroMeasurement_t *meas);
 static void spectro_app_handle_infer_pc(const SpectroMeasurement_t *meas);
+static void spectro_app_handle_unmix(const SpectroMeasurement_t *meas);
+static void spectro_app_unmix_capture_step(const SpectroMeasurement_t *meas);
+static void spectro_app_handle_conc_reg(const SpectroMeasurement_t *meas);
+static int spectro_app_conc_juice_index(const SpectroMeasurement_t *meas);
+static void spectro_app_handle_infer_model(const SpectroMeasurement_t *meas);
+static void spectro_app_handle_progressive(const SpectroMeasurement_t *meas);
+static void spectro_app_prog_restart(void);
+static int spectro_app_classify_juice(const double *channels, const char **label, float *conf);
+static void spectro_app_learn_step(const SpectroMeasurement_t *meas);
+static bool spectro_app_learn_save(void);
+static void spectro_app_save_pending(void);
+static bool spectro_app_model_validate(const uint8_t *image, uint32_t size);
+static void spectro_app_run_batch(void);
+static void spectro_app_print_batch(const SpectroBatchResult_t *res);
+static void spectro_app_restore_sensor(void);
+static void spectro_app_run_script(void);
+static void spectro_app_process(const SpectroMeasurement_t *meas);
+static void spectro_app_run_standby(void);
+static void spectro_app_check_threshold(const SpectroMeasurement_t *meas);
+static void spectro_app_print_trigger(uint32_t dataUs, uint32_t latencyUs);
+static void spectro_app_button_isr(void);
 
 //==================== Public API implementation ====================//
 
@@ -32,11 +236,94 @@ void spectro_app_init(void)
     s_appMode = SPECTRO_APP_MODE_DATA_LOG;
     s_precMode = SPECTRO_PRECISION_MEDIUM;
     spectro_app_set_precision_mode(s_precMode);
+
+    spectro_cmd_init();
+    spectro_out_init();
+    spectro_mux_init();
+    if (!spectro_ble_init())
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: BLE unavailable, USB only."));
+    AS7343_i2c_set_log(&spectro_mux_print(SPECTRO_MUX_LOG));
+    spectro_queue_init(&s_outQueue, SPECTRO_QUEUE_DROP_OLDEST);
+    spectro_delta_init(&s_delta, SPECTRO_DELTA_KEY_INTERVAL);
+
+    // stream header: identity once, settings per epoch
+    if (!AS7343_read_id(&s_sensorId, &s_sensorRevision))
+    {
+        s_sensorId = SPECTRO_FRAME_UNKNOWN8;
+        s_sensorRevision = SPECTRO_FRAME_UNKNOWN8;
+    }
+    s_epochValid = false;
+    s_headerSent = false;
+    s_headerResend = false;
+    s_hostConnected = (bool)Serial;   // already open: setup() sends READY
+    spectro_pc_init(&s_pc, SPECTRO_PC_DEFAULT_WINDOW, SPECTRO_PC_DEFAULT_TIMEOUT);
+    s_pcResult[0] = '\0';
+    s_batchPending = false;
+    s_batchRunning = false;
+    s_scriptSize = 0;
+    s_scriptLoaded = 0;
+    s_scriptPending = false;
+    s_scriptRunning = false;
+    s_standby = SPECTRO_STANDBY_OFF;
+    s_standbyLeft = false;
+    s_trigPending = false;
+    s_trigActive = false;
+    s_thrChannel = -1;
+
+#if SPECTRO_APP_TRIGGER_PIN >= 0
+    pinMode(SPECTRO_APP_TRIGGER_PIN, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(SPECTRO_APP_TRIGGER_PIN), spectro_app_button_isr, FALLING);
+#endif
+
+    // Restore the enrolled classes, start empty if nothing valid is stored
+    s_learnRemaining = 0;
+    s_learnSavePending = false;
+    s_learnSaveReport = false;
+    s_unmixSavePending = false;
+    if (!spectro_storage_init())
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Flash storage unavailable."));
+
+    if (!spectro_storage_load(SPECTRO_STORE_CENTROID, &s_centroid, sizeof(s_centroid)) ||
+        !spectro_centroid_is_valid(&s_centroid))
+    {
+        spectro_centroid_reset(&s_centroid);
+    }
+
+    s_unmixCapture = SPECTRO_APP_CAPTURE_NONE;
+    if (!spectro_storage_load(SPECTRO_STORE_UNMIX, &s_unmixLib, sizeof(s_unmixLib)) ||
+        !spectro_unmix_is_valid(&s_unmixLib))
+    {
+        spectro_unmix_reset(&s_unmixLib);
+    }
+    spectro_unmix_prepare(&s_unmixLib, &s_unmixSolver);
+
+    spectro_conc_stats_reset(&s_concStats);
+    s_concModel = SPECTRO_CONC_MODEL_DEFAULT;
+    s_concJuice = SPECTRO_APP_JUICE_AUTO;
+    s_concSpecOk = spectro_conc_spec_valid(&spectro_conc_model_spec);
+    if (!s_concSpecOk)
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Concentration model spec mismatch, re-export it."));
+
+    // Newest valid model package, if any was uploaded
+    spectro_slot_init(spectro_app_model_validate);
+    s_modelImage = spectro_slot_active(NULL, NULL);
+
+    spectro_app_set_mode(s_appMode);
 }
 
 void spectro_app_set_mode(SpectroAppMode_t mode)
 {
     s_appMode = mode;
+
+    // Keep serving commands (e.g. model uploads), PC replies and output
+    // deadlines while the sensor integrates
+    AS7343_set_idle_callback(spectro_app_idle);
+
+    // PROGRESSIVE switches precision itself, every other mode runs at s_precMode
+    if (mode == SPECTRO_APP_MODE_PROGRESSIVE)
+        spectro_app_prog_restart();
+    else
+        spectro_app_set_precision_mode(s_precMode);
 }
 
 SpectroAppMode_t spectro_app_get_mode(void)
@@ -46,28 +333,21 @@ SpectroAppMode_t spectro_app_get_mode(void)
 
 void spectro_app_set_precision_mode(SpectroPrecisionMode_t prec)
 {
+    if (prec > SPECTRO_PRECISION_HIGH)
+        prec = SPECTRO_PRECISION_HIGH;
+
     s_precMode = prec;
 
-    switch (prec)
+    // PROGRESSIVE uses it as refinement precision from its next cycle on
+    if (s_appMode == SPECTRO_APP_MODE_PROGRESSIVE)
     {
-    case SPECTRO_PRECISION_LOW:
-        // Short integration time
-        // ATIME=0, ASTEP=999 → ~2.8ms per cycle
-        AS7343_set_integration_time(0x00, 999);
-        AS7343_set_data_ready_timeout(50);   // 50ms
-        break;
-
-    case SPECTRO_PRECISION_MEDIUM:
-        AS7343_set_integration_time(0x01, 20000);
-        AS7343_set_data_ready_timeout(500);  
-        break;
-
-    case SPECTRO_PRECISION_HIGH:
-    default:
-        AS7343_set_integration_time(0x00, 65534);
-        AS7343_set_data_ready_timeout(800);  
-        break;
+        spectro_app_prog_restart();
+        return;
     }
+
+    // one coalesced register update (only changed registers are written)
+    if (!spectro_app_configure_sensor(prec))
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
 }
 
 SpectroPrecisionMode_t spectro_app_get_precision_mode(void)
@@ -76,6 +356,223 @@ SpectroPrecisionMode_t spectro_app_get_precision_mode(void)
 }
 
 
+void spectro_app_set_output_format(SpectroOutputFormat_t format)
+{
+    s_outputFormat = format;
+    s_headerResend = true;   // the host switches decoders, repeat the header in the new form
+}
+
+void spectro_app_resend_header(void)
+{
+    s_headerResend = true;
+}
+
+void spectro_app_print_header(void)
+{
+    uint16_t epoch = spectro_app_epoch();
+
+    spectro_mux_poll();
+    if (spectro_app_send_header(&s_headers[epoch % SPECTRO_APP_HEADER_HISTORY]))
+    {
+        s_headerSentEpoch = epoch;
+        s_headerSent = true;
+        s_headerResend = false;
+        spectro_delta_reset(&s_delta);   // a reader starting here needs a keyframe
+    }
+}
+
+void spectro_app_set_queue_policy(SpectroQueuePolicy_t policy)
+{
+    spectro_queue_set_policy(&s_outQueue, policy);
+}
+
+SpectroQueuePolicy_t spectro_app_get_queue_policy(void)
+{
+    return s_outQueue.policy;
+}
+
+void spectro_app_queue_stats(void)
+{
+    const SpectroQueueStats_t *st = &s_outQueue.stats;
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "QUEUE,");
+    spectro_line_str(&line, spectro_queue_policy_name(s_outQueue.policy));
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, spectro_queue_count(&s_outQueue));
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, st->maxCount);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->pushed);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->dropped);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->merged);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+void spectro_app_set_key_interval(uint8_t frames)
+{
+    s_delta.keyInterval = (frames > 0) ? frames : 1;
+}
+
+void spectro_app_delta_stats(void)
+{
+    const SpectroDeltaStats_t *st = &s_delta.stats;
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "DELTA,");
+    spectro_line_u16(&line, s_delta.keyInterval);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->frames);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->keyframes);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->rawBytes);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->codedBytes);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, (st->codedBytes > 0) ? (float)st->rawBytes / (float)st->codedBytes : 0.0f, 2);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+SpectroOutputFormat_t spectro_app_get_output_format(void)
+{
+    return s_outputFormat;
+}
+
+void spectro_app_print_ready(void)
+{
+    SpectroAppConfig_t cfg;
+    spectro_app_get_config(&cfg);
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "READY,");
+    spectro_line_u16(&line, SPECTRO_APP_FW_MAJOR);
+    spectro_line_char(&line, '.');
+    spectro_line_u16(&line, SPECTRO_APP_FW_MINOR);
+    spectro_line_char(&line, '.');
+    spectro_line_u16(&line, SPECTRO_APP_FW_PATCH);
+    spectro_line_str(&line, ",0x");
+    spectro_app_line_hex(&line, s_sensorId, 2);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_sensorRevision);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, millis());
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, s_modeNames[cfg.mode]);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, s_precNames[cfg.precision]);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, spectro_app_gain_name(cfg.gain));
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, cfg.average);
+    spectro_line_str(&line, ",0x");
+    spectro_app_line_hex(&line, cfg.channelMask, 3);
+    spectro_line_str(&line, cfg.running ? ",RUN," : ",STOP,");
+    spectro_line_str(&line, s_formatNames[s_outputFormat]);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+void spectro_app_get_config(SpectroAppConfig_t *cfg)
+{
+    if (s_configPending)
+    {
+        *cfg = s_pendingConfig;
+        return;
+    }
+
+    cfg->mode = s_appMode;
+    cfg->precision = s_precMode;
+    cfg->gain = s_gain;
+    cfg->average = s_average;
+    cfg->channelMask = s_channelMask;
+    cfg->running = s_running;
+}
+
+bool spectro_app_request_config(const SpectroAppConfig_t *cfg)
+{
+    if ((cfg == NULL) ||
+        (cfg->mode > SPECTRO_APP_MODE_PROGRESSIVE) ||
+        (cfg->precision > SPECTRO_PRECISION_HIGH) ||
+        (spectro_app_gain_name(cfg->gain) == NULL) ||
+        (cfg->average < 1) || (cfg->average > SPECTRO_APP_MAX_AVERAGE) ||
+        (cfg->channelMask == 0) || ((cfg->channelMask & ~SPECTRO_APP_ALL_CHANNELS) != 0))
+        return false;
+
+    s_pendingConfig = *cfg;
+    s_configPending = true;
+    return true;
+}
+
+void spectro_app_print_config(void)
+{
+    SpectroAppConfig_t cfg;
+    spectro_app_get_config(&cfg);
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "CONFIG,");
+    spectro_line_str(&line, s_modeNames[cfg.mode]);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, s_precNames[cfg.precision]);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, spectro_app_gain_name(cfg.gain));
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, cfg.average);
+    spectro_line_str(&line, ",0x");
+    spectro_app_line_hex(&line, cfg.channelMask, 3);
+    spectro_line_str(&line, cfg.running ? ",RUN," : ",STOP,");
+    spectro_line_str(&line, s_formatNames[s_outputFormat]);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, spectro_out_get_latency());
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, spectro_queue_policy_name(s_outQueue.policy));
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+const char *spectro_app_mode_name(SpectroAppMode_t mode)
+{
+    return ((unsigned)mode < sizeof(s_modeNames) / sizeof(s_modeNames[0])) ? s_modeNames[mode] : NULL;
+}
+
+const char *spectro_app_gain_name(int8_t gain)
+{
+    if (gain == SPECTRO_APP_GAIN_AUTO)
+        return "auto";
+    return ((gain >= 0) && (gain < (int8_t)(sizeof(s_gainNames) / sizeof(s_gainNames[0])))) ? s_gainNames[gain] : NULL;
+}
+
+bool spectro_app_mode_from_name(const char *name, SpectroAppMode_t *mode)
+{
+    const int numModes = (int)(sizeof(s_modeNames) / sizeof(s_modeNames[0]));
+
+    for (int m = 0; m < numModes; m++)
+    {
+        if (strcmp(name, s_modeNames[m]) == 0)
+        {
+            *mode = (SpectroAppMode_t)m;
+            return true;
+        }
+    }
+
+    // numeric form, as in the SpectroAppMode_t enum
+    char *end = NULL;
+    long m = strtol(name, &end, 10);
+    if ((end == name) || (*end != '\0') || (m < 0) || (m >= numModes))
+        return false;
+
+    *mode = (SpectroAppMode_t)m;
+    return true;
+}
+
 bool spectro_app_acquire(SpectroMeasurement_t *meas)
 {
     if (meas == NULL)
@@ -89,6 +586,8 @@ bool spectro_app_acquire(SpectroMeasurement_t *meas)
     if (!AS7343_get_sorted_spectral_channels(meas->sorted))
         return false;
 
+    // 3) end of the integration the sorted channels come from
+    meas->timestampUs = AS7343_data_ready_us();
     return true;
 }
 
@@ -96,35 +595,109 @@ void spectro_app_run_once(void)
 {
     SpectroMeasurement_t meas;
 
+    // flash saves stall the CPU, never inside the frame path
+    spectro_app_save_pending();
+
+    spectro_cmd_poll();
+    spectro_app_check_connect();
+    spectro_mux_poll();
+
+    // settings requested during the last frame take effect here
+    spectro_app_apply_config();
+
+    // leaving HOT standby: the free-running loop expects SP_EN on
+    if (s_standbyLeft)
+    {
+        s_standbyLeft = false;
+        if ((s_standby == SPECTRO_STANDBY_OFF) && !AS7343_set_measurement(true))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
+    }
+
+    // a MEASURE batch replaces this frame, also while stopped
+    if (s_batchPending)
+    {
+        spectro_app_run_batch();
+        return;
+    }
+
+    if (s_scriptPending)
+    {
+        spectro_app_run_script();
+        return;
+    }
+
+    if (s_standby != SPECTRO_STANDBY_OFF)
+    {
+        spectro_app_run_standby();
+        return;
+    }
+
+    if (!s_running)
+        return;
+
     if (!spectro_app_acquire(&meas))
     {
-        Serial.println(F("[spectro_app] ERROR: Failed to acquire measurement."));
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to acquire measurement."));
         return;
     }
 
+    if (!spectro_app_average(&meas))
+        return;
+
+    spectro_app_process(&meas);
+}
+
+//==================== Internal helpers ====================//
+
+/*******************************************************
+ * @brief  One (averaged) measurement through LEARN / BLANK captures
+ *         and the mode's handler
+ *******************************************************/
+static void spectro_app_process(const SpectroMeasurement_t *meas)
+{
+    if (s_learnRemaining > 0)
+        spectro_app_learn_step(meas);
+
+    if (s_unmixCapture != SPECTRO_APP_CAPTURE_NONE)
+        spectro_app_unmix_capture_step(meas);
+
     switch (s_appMode)
     {
     case SPECTRO_APP_MODE_DATA_LOG:
-        spectro_app_handle_data_log(&meas);
+        spectro_app_handle_data_log(meas);
         break;
 
     case SPECTRO_APP_MODE_INFER_LOCAL:
-        spectro_app_handle_infer_local(&meas);
+        spectro_app_handle_infer_local(meas);
         break;
 
     case SPECTRO_APP_MODE_INFER_PC:
-        spectro_app_handle_infer_pc(&meas);
+        spectro_app_handle_infer_pc(meas);
+        break;
+
+    case SPECTRO_APP_MODE_UNMIX:
+        spectro_app_handle_unmix(meas);
+        break;
+
+    case SPECTRO_APP_MODE_CONC_REG:
+        spectro_app_handle_conc_reg(meas);
+        break;
+
+    case SPECTRO_APP_MODE_INFER_MODEL:
+        spectro_app_handle_infer_model(meas);
+        break;
+
+    case SPECTRO_APP_MODE_PROGRESSIVE:
+        spectro_app_handle_progressive(meas);
         break;
 
     default:
         // Fallback: treat as data logging
-        spectro_app_handle_data_log(&meas);
+        spectro_app_handle_data_log(meas);
         break;
     }
 }
 
-//==================== Internal helpers ====================//
-
 /*******************************************************
  * @brief  Mode 0: simple data logging over Serial
  *******************************************************/
@@ -133,91 +706,1764 @@ static void spectro_app_handle_data_log(const SpectroMeasurement_t *meas)
     if (meas == NULL)
         return;
 
-    Serial.print(F("SORTED(405-855nm): "));
-    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; ++i)
-    {
-        Serial.print(meas->sorted[i]);
-        if (i < AS7343_NUM_SORTED_CHANNELS - 1)
-            Serial.print(',');
-    }
-    Serial.println();
+    // queued, not written: a slow host costs frames, never loop time
+    SpectroFrameMeas_t frame;
+    spectro_app_fill_frame(&frame, meas);
+    spectro_queue_push(&s_outQueue, &frame);
+    spectro_app_drain_queue();
 
     // 如需调试 raw 通道，也可以顺带打印：
     /*
-    Serial.print(F("RAW: "));
-    for (int i = 0; i < AS7343_NUM_CHANNELS; ++i)
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "RAW: ");
+    spectro_line_u16_list(&line, meas->raw, AS7343_NUM_CHANNELS, ',');
+    spectro_mux_line(SPECTRO_MUX_DATA, &line);
+    */
+}
+
+/*******************************************************
+ * @brief  Send queued DATA_LOG frames while the output has room
+ *
+ * @details
+ *  - Called after every frame and from the idle callback, so the
+ *    queue empties while the sensor integrates
+ *  - Stops while the DATA channel is full; it empties at the pace of
+ *    the host, after higher-priority channels
+ *  - Each frame is preceded by its epoch's header when that is not
+ *    the last header sent; with the queue empty, a changed or
+ *    requested header goes out at once (streaming modes only)
+ *******************************************************/
+static void spectro_app_drain_queue(void)
+{
+    SpectroFrameMeas_t frame;
+
+    spectro_mux_poll();
+    for (;;)
     {
-        Serial.print(meas->raw[i]);
-        if (i < AS7343_NUM_CHANNELS - 1)
-            Serial.print(',');
+        const SpectroFrameMeas_t *next = spectro_queue_peek(&s_outQueue);
+
+        if ((next == NULL) &&
+            (s_appMode != SPECTRO_APP_MODE_DATA_LOG) && (s_appMode != SPECTRO_APP_MODE_INFER_PC))
+            break;
+        if (!spectro_app_header_for((next != NULL) ? next->epoch : spectro_app_epoch()))
+            break;
+        if ((next == NULL) || (spectro_mux_space(SPECTRO_MUX_DATA) < SPECTRO_LINE_MAX))
+            break;
+
+        spectro_queue_pop(&s_outQueue, &frame);
+        if (s_outputFormat != SPECTRO_OUTPUT_TEXT)
+            spectro_app_send_frame(&frame);
+        else
+            spectro_app_send_line(&frame);
     }
-    Serial.println();
-    */
 }
 
 /*******************************************************
- * @brief  Mode 1: local ML inference (on-board)
+ * @brief  Make sure the last header sent is the one of an epoch
  *
- * @note   这里先放一个占位实现，后续你可以在此调用
- *         Arduino Nano 33 BLE Sense 上部署的模型 API。
+ * @details
+ *  - Sends it if another epoch's header went out last, or a resend
+ *    was requested; text or binary like the data
+ *  - False while it cannot be sent (DATA full or not subscribed),
+ *    the frames of the epoch then wait
  *******************************************************/
-static void spectro_app_handle_infer_local(const SpectroMeasurement_t *meas)
+static bool spectro_app_header_for(uint16_t epoch)
 {
-    if (meas == NULL)
-        return;
+    if (s_headerSent && (s_headerSentEpoch == epoch) && !s_headerResend)
+        return true;
+    if ((spectro_mux_subscribed() & (1U << SPECTRO_MUX_DATA)) == 0)
+        return false;
+    if (spectro_mux_space(SPECTRO_MUX_DATA) < SPECTRO_LINE_MAX)
+        return false;
+    if (!spectro_app_send_header(&s_headers[epoch % SPECTRO_APP_HEADER_HISTORY]))
+        return false;
+
+    s_headerSentEpoch = epoch;
+    s_headerSent = true;
+    s_headerResend = false;
+    spectro_delta_reset(&s_delta);   // a reader starting here needs a keyframe
+    return true;
+}
 
-    // TODO: 在这里接你的本地模型：
-    //  1. 将 meas->sorted (12 维) 归一化 / 转 float
-    //  2. 塞进你的 inference 函数
-    //  3. 输出分类 / 浓度等结果到串口或 OLED
+/*******************************************************
+ * @brief  One header on the DATA channel, in the output format
+ *******************************************************/
+static bool spectro_app_send_header(const SpectroFrameHeader_t *hdr)
+{
+    if (s_outputFormat != SPECTRO_OUTPUT_TEXT)
+    {
+        uint8_t buf[SPECTRO_FRAME_MAX_ENCODED];
+        size_t len = spectro_frame_encode_header(hdr, buf, sizeof(buf));
+        return (len > 0) && spectro_mux_write(SPECTRO_MUX_DATA, buf, len);
+    }
 
-    Serial.print(F("[spectro_app] Local inference stub. Inputs: "));
-    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; ++i)
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "HDR,");
+    spectro_line_u16(&line, hdr->epoch);
+    for (int i = 0; i < 3; i++)
     {
-        Serial.print(meas->sorted[i]);
-        if (i < AS7343_NUM_SORTED_CHANNELS - 1)
-            Serial.print(',');
+        spectro_line_char(&line, (i == 0) ? ',' : '.');
+        spectro_line_u16(&line, hdr->fwVersion[i]);
     }
-    Serial.println();
+    spectro_line_str(&line, ",0x");
+    spectro_app_line_hex(&line, hdr->sensorId, 2);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, hdr->sensorRevision);
+    spectro_line_str(&line, ",counts,");
+    spectro_line_str(&line, s_precNames[hdr->precision]);
+    spectro_line_char(&line, ',');
+    const char *gain = (hdr->gain == SPECTRO_FRAME_UNKNOWN8) ? NULL : spectro_app_gain_name((int8_t)hdr->gain);
+    spectro_line_str(&line, (gain != NULL) ? gain : "?");
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, hdr->atime);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, hdr->astep);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, hdr->average);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, hdr->integrationUs);
+    spectro_line_str(&line, ",0x");
+    spectro_app_line_hex(&line, hdr->channelMask, 3);
+    spectro_line_char(&line, ',');
+    spectro_line_u16_list(&line, hdr->wavelengthNm, hdr->numWavelengths, ';');
+    return spectro_mux_line(SPECTRO_MUX_DATA, &line);
 }
 
 /*******************************************************
- * @brief  Mode 2: remote ML inference via PC
+ * @brief  Epoch of the current settings
  *
  * @details
- *  - 当前简单协议（建议）：
- *      * 发送一行 CSV："MEAS,v0,v1,...,v11\r\n"
- *      * PC 端解析后跑模型
- *      * PC 再返回一条结果行："RES,<whatever>\r\n"
+ *  - Compares a snapshot of everything the header describes with the
+ *    current epoch's header and starts a new epoch if it differs, so
+ *    each settings change (also PROGRESSIVE's precision switches)
+ *    gets exactly one epoch, whatever path changed it
+ *  - Sensor settings come from the driver's configuration shadow;
+ *    unknown ones are 0xFF / 0xFFFF
+ *  - INFER_PC always sends all channels, DATA_LOG the MASK channels
+ *******************************************************/
+static uint16_t spectro_app_epoch(void)
+{
+    static_assert(AS7343_NUM_SORTED_CHANNELS <= SPECTRO_FRAME_MAX_CHANNELS,
+                  "sorted channels must fit in a frame");
+
+    SpectroFrameHeader_t hdr;
+    AS7343_Config_t cfg;
+
+    memset(&hdr, 0, sizeof(hdr));
+    hdr.fwVersion[0] = SPECTRO_APP_FW_MAJOR;
+    hdr.fwVersion[1] = SPECTRO_APP_FW_MINOR;
+    hdr.fwVersion[2] = SPECTRO_APP_FW_PATCH;
+    hdr.sensorId = s_sensorId;
+    hdr.sensorRevision = s_sensorRevision;
+    hdr.units = SPECTRO_UNITS_COUNTS;
+    hdr.precision = (uint8_t)s_precMode;
+    hdr.average = s_average;
+    hdr.channelMask = (s_appMode == SPECTRO_APP_MODE_INFER_PC) ? SPECTRO_APP_ALL_CHANNELS : s_channelMask;
+    hdr.numWavelengths = AS7343_NUM_SORTED_CHANNELS;
+    memcpy(hdr.wavelengthNm, s_wavelengthsNm, sizeof(s_wavelengthsNm));
+
+    if (AS7343_get_config(&cfg))
+    {
+        hdr.gain = (uint8_t)cfg.gain;
+        hdr.atime = cfg.atime;
+        hdr.astep = cfg.astep;
+        // (ATIME + 1) * (ASTEP + 1) * 2.78 us
+        hdr.integrationUs = (uint32_t)(((uint64_t)(cfg.atime + 1) * (cfg.astep + 1U) * 278U) / 100U);
+    }
+    else
+    {
+        hdr.gain = SPECTRO_FRAME_UNKNOWN8;
+        hdr.atime = SPECTRO_FRAME_UNKNOWN8;
+        hdr.astep = SPECTRO_FRAME_UNKNOWN16;
+    }
+
+    SpectroFrameHeader_t *cur = &s_headers[s_epoch % SPECTRO_APP_HEADER_HISTORY];
+    hdr.epoch = s_epoch;
+    if (s_epochValid && (memcmp(&hdr, cur, sizeof(hdr)) == 0))
+        return s_epoch;
+
+    if (s_epochValid)
+        s_epoch++;
+    s_epochValid = true;
+    hdr.epoch = s_epoch;
+    memcpy(&s_headers[s_epoch % SPECTRO_APP_HEADER_HISTORY], &hdr, sizeof(hdr));
+    return s_epoch;
+}
+
+/*******************************************************
+ * @brief  A host opening the port (DTR) or subscribing over BLE
+ *         gets READY and the header again
+ *******************************************************/
+static void spectro_app_check_connect(void)
+{
+    bool connected = (bool)Serial;
+    bool ble = spectro_ble_active();
+
+    if ((connected && !s_hostConnected) || (ble && !s_bleConnected))
+    {
+        s_headerResend = true;
+        spectro_app_print_ready();
+    }
+    s_hostConnected = connected;
+    s_bleConnected = ble;
+}
+
+/*******************************************************
+ * @brief  One DATA_LOG frame as a text line
  *
- *  - 这里先实现发送端 + 简单回显，后续你可以根据
- *    实际协议改写。
+ * @details
+ *  - "SORTED(405-855nm): v0,...,v11;t=<us>", only the masked
+ *    channels, t = end of the integration (micros(), see SYNC)
+ *  - Followed by ";merged=<n>;dropped=<n>" if the queue overflowed
  *******************************************************/
-static void spectro_app_handle_infer_pc(const SpectroMeasurement_t *meas)
+static void spectro_app_send_line(const SpectroFrameMeas_t *frame)
 {
-    if (meas == NULL)
-        return;
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "SORTED(405-855nm): ");
+    if (frame->channelMask == SPECTRO_APP_ALL_CHANNELS)
+    {
+        spectro_line_u16_list(&line, frame->channels, AS7343_NUM_SORTED_CHANNELS, ',');
+    }
+    else
+    {
+        // only the masked channels, in wavelength order
+        bool first = true;
+        for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+        {
+            if ((frame->channelMask & (1U << i)) == 0)
+                continue;
+            if (!first)
+                spectro_line_char(&line, ',');
+            spectro_line_u16(&line, frame->channels[i]);
+            first = false;
+        }
+    }
+    spectro_line_str(&line, ";t=");
+    spectro_line_u32(&line, frame->timestampUs);
 
-    // 1) 通过串口发送数据到 PC
-    Serial.print(F("MEAS,"));
-    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; ++i)
+    if ((frame->merged > 0) || (frame->dropped > 0))
     {
-        Serial.print(meas->sorted[i]);
-        if (i < AS7343_NUM_SORTED_CHANNELS - 1)
-            Serial.print(',');
+        spectro_line_str(&line, ";merged=");
+        spectro_line_u16(&line, frame->merged);
+        spectro_line_str(&line, ";dropped=");
+        spectro_line_u16(&line, frame->dropped);
     }
-    Serial.println();
+    spectro_mux_line(SPECTRO_MUX_DATA, &line);
+}
+
+/*******************************************************
+ * @brief  Upper-case hex with a fixed number of digits
+ *******************************************************/
+static void spectro_app_line_hex(SpectroLine_t *line, uint16_t value, int digits)
+{
+    for (int shift = 4 * (digits - 1); shift >= 0; shift -= 4)
+        spectro_line_char(line, "0123456789ABCDEF"[(value >> shift) & 0x0F]);
+}
+
+/*******************************************************
+ * @brief  Sensor configuration of a precision mode
+ *
+ * @details
+ *  - Integration settings from s_precConfig, gain from the GAIN
+ *    command unless it is "auto"
+ *******************************************************/
+static bool spectro_app_configure_sensor(SpectroPrecisionMode_t prec)
+{
+    AS7343_Config_t cfg = s_precConfig[prec];
+
+    if (s_gain != SPECTRO_APP_GAIN_AUTO)
+        cfg.gain = (AS7343_Gain_t)s_gain;
+    return AS7343_apply_config(&cfg);
+}
 
-    // 2) 可选：等待 PC 返回一行结果
-    //    这里暂时只做 echo，占位方便以后扩展协议
-    if (Serial.available())
+/*******************************************************
+ * @brief  Apply settings requested over serial
+ *
+ * @details
+ *  - Runs at the start of a frame, never from the idle callback, so
+ *    the sensor is not reconfigured in the middle of an integration
+ *  - A mode change also redraws the OLED mode screen (once the
+ *    start screen is over)
+ *  - Any change restarts the frame averaging
+ *******************************************************/
+static void spectro_app_apply_config(void)
+{
+    if (!s_configPending)
+        return;
+
+    SpectroAppConfig_t cfg = s_pendingConfig;
+    s_configPending = false;
+
+    bool modeChanged = (cfg.mode != s_appMode);
+    bool sensorChanged = (cfg.precision != s_precMode) || (cfg.gain != s_gain);
+
+    s_gain = cfg.gain;
+    s_average = cfg.average;
+    s_channelMask = cfg.channelMask;
+    s_running = cfg.running;
+    s_avgCount = 0;
+    memset(s_avgSum, 0, sizeof(s_avgSum));
+    s_standbyArmed = false;   // a new config restarts SP_EN
+
+    if (modeChanged)
     {
-        String line = Serial.readStringUntil('\n');
-        line.trim();
-        if (line.length() > 0)
+        s_precMode = cfg.precision;
+        spectro_app_set_mode(cfg.mode);
+        if (!oled_start_go_active())   // otherwise drawn when the start screen ends
         {
-            Serial.print(F("[spectro_app] PC response: "));
-            Serial.println(line);
+            oled_clear();
+            oled_show_mode();
         }
     }
+    else if (sensorChanged)
+    {
+        spectro_app_set_precision_mode(cfg.precision);
+    }
+
+    spectro_app_print_config();
+}
+
+/*******************************************************
+ * @brief  Average AVG consecutive frames into one
+ *
+ * @details
+ *  - Sorted channels are summed in 32 bits and rounded, raw
+ *    channels keep the last frame
+ *  - Returns false until AVG frames have been collected
+ *  - The PROGRESSIVE preview frame is passed through: it is shown
+ *    at once, AVG only applies to the refinement frames
+ *******************************************************/
+static bool spectro_app_average(SpectroMeasurement_t *meas)
+{
+    if (s_average <= 1)
+        return true;
+
+    if ((s_appMode == SPECTRO_APP_MODE_PROGRESSIVE) && (s_progPhase == SPECTRO_PROG_PREVIEW))
+        return true;
+
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+        s_avgSum[i] += meas->sorted[i];
+    if (++s_avgCount < s_average)
+        return false;
+
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+    {
+        meas->sorted[i] = (uint16_t)((s_avgSum[i] + s_avgCount / 2) / s_avgCount);
+        s_avgSum[i] = 0;
+    }
+    s_avgCount = 0;
+    return true;
+}
+
+/*******************************************************
+ * @brief  AS7343 idle callback: commands, output deadlines, queue,
+ *         display changes deferred by a busy bus
+ *******************************************************/
+static void spectro_app_idle(void)
+{
+    spectro_cmd_poll();
+    spectro_app_check_connect();
+    spectro_app_drain_queue();
+    oled_poll();
+}
+
+/*******************************************************
+ * @brief  Frame of one measurement
+ *
+ * @details
+ *  - Takes the next sequence number, so frames lost to the output
+ *    queue also show up as gaps
+ *  - Timestamp = end of the integration, not the time of sending
+ *  - Settings are not copied: the frame refers to the header of the
+ *    current epoch, whose mask selects the channels sent
+ *******************************************************/
+static void spectro_app_fill_frame(SpectroFrameMeas_t *frame, const SpectroMeasurement_t *meas)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->seq = s_frameSeq++;
+    frame->timestampUs = meas->timestampUs;
+    frame->epoch = spectro_app_epoch();
+    frame->channelMask = s_headers[frame->epoch % SPECTRO_APP_HEADER_HISTORY].channelMask;
+
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+        frame->channels[i] = meas->sorted[i];
+}
+
+/*******************************************************
+ * @brief  Send one frame in binary form
+ *
+ * @details
+ *  - 43 bytes for the 12 channels (the text line is ~60-80 bytes)
+ *  - FORMAT delta: keyframe or delta frame, about 30 bytes
+ *    for a steady sample
+ *  - A delta frame the host never gets would break its chain, so a
+ *    refused write restarts with a keyframe
+ *******************************************************/
+static void spectro_app_send_frame(const SpectroFrameMeas_t *frame)
+{
+    uint8_t buf[SPECTRO_FRAME_MAX_ENCODED];
+    size_t len;
+
+    if (s_outputFormat == SPECTRO_OUTPUT_DELTA)
+        len = spectro_delta_encode(&s_delta, frame, buf, sizeof(buf));
+    else
+        len = spectro_frame_encode_meas(frame, buf, sizeof(buf));
+
+    if ((len > 0) && !spectro_mux_write(SPECTRO_MUX_DATA, buf, len))
+        spectro_delta_reset(&s_delta);
+}
+
+/*******************************************************
+ * @brief  Mode 1: local inference with the centroid model
+ *
+ * @details
+ *  - Output line: "LOCAL,<label>,<score>"
+ *  - "LOCAL,NONE" while no class has been enrolled
+ *******************************************************/
+static void spectro_app_handle_infer_local(const SpectroMeasurement_t *meas)
+{
+    if (meas == NULL)
+        return;
+
+    float x[SPECTRO_CENTROID_NUM_FEATURES];
+    float score = 0.0f;
+
+    spectro_centroid_features(meas->sorted, x);
+    int idx = spectro_centroid_classify(&s_centroid, x, &score);
+
+    if (idx < 0)
+    {
+        spectro_mux_print(SPECTRO_MUX_RESULT).println(F("LOCAL,NONE"));
+        return;
+    }
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "LOCAL,");
+    spectro_line_str(&line, s_centroid.cls[idx].label);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, score, 3);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+}
+
+/*******************************************************
+ * @brief  Mode 2: remote ML inference via PC
+ *
+ * @details
+ *  - Request: "MEAS,<seq>,v0,...,v11" (or a binary frame, which
+ *    carries the same sequence number)
+ *  - The PC answers "RES,<seq>,<result>" at its own pace; replies are
+ *    read by the command parser between and during frames and handed
+ *    to spectro_app_pc_response(), nothing here waits for them
+ *  - Up to PC WINDOW requests are outstanding; while the window is
+ *    full the frame is skipped, so the loop never stalls on the PC
+ *******************************************************/
+static void spectro_app_handle_infer_pc(const SpectroMeasurement_t *meas)
+{
+    if (meas == NULL)
+        return;
+
+    if (!spectro_pc_try_send(&s_pc, millis()))
+        return;
+
+    // the PC needs the header of this epoch first
+    spectro_mux_poll();
+    if (!spectro_app_header_for(spectro_app_epoch()))
+        return;
+
+    SpectroFrameMeas_t frame;
+    spectro_app_fill_frame(&frame, meas);
+
+    if (s_outputFormat != SPECTRO_OUTPUT_TEXT)
+    {
+        spectro_app_send_frame(&frame);
+    }
+    else
+    {
+        SpectroLine_t line;
+        spectro_line_init(&line);
+        spectro_line_str(&line, "MEAS,");
+        spectro_line_u16(&line, frame.seq);
+        spectro_line_char(&line, ',');
+        spectro_line_u16_list(&line, meas->sorted, AS7343_NUM_SORTED_CHANNELS, ',');
+        spectro_mux_line(SPECTRO_MUX_DATA, &line);
+    }
+    spectro_mux_flush();   // the PC is waiting for this frame
+
+    spectro_pc_sent(&s_pc, frame.seq, millis());
+}
+
+/*******************************************************
+ * @brief  Mode 3: blend proportions by spectral unmixing
+ *
+ * @details
+ *  - Output line:
+ *      "UNMIX,<apple>,<grape>,<orange>,<water>,<iterations>,<residual>"
+ *  - "UNMIX,NOREF" until a blank and one endmember are recorded
+ *******************************************************/
+static void spectro_app_handle_unmix(const SpectroMeasurement_t *meas)
+{
+    if (meas == NULL)
+        return;
+
+    if (!s_unmixSolver.ready || !spectro_unmix_has_blank(&s_unmixLib))
+    {
+        spectro_mux_print(SPECTRO_MUX_RESULT).println(F("UNMIX,NOREF"));
+        return;
+    }
+
+    float a[SPECTRO_UNMIX_NUM_BANDS];
+    SpectroUnmixResult_t res;
+
+    spectro_unmix_absorbance(meas->sorted, s_unmixLib.blank, a);
+    spectro_unmix_solve(&s_unmixLib, &s_unmixSolver, a, &res);
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "UNMIX,");
+    for (int k = 0; k < SPECTRO_UNMIX_NUM_ENDMEMBERS; ++k)
+    {
+        spectro_line_fixed(&line, res.proportion[k], 3);
+        spectro_line_char(&line, ',');
+    }
+    spectro_line_u16(&line, res.iterations);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, res.residual, 4);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+}
+
+/*******************************************************
+ * @brief  Mode 4: continuous concentration regression
+ *
+ * @details
+ *  - Output line: "CONC,<juice>,<percent>,<sigma>,<compute us>"
+ *  - sigma comes from the running frame variance, so it is 0 on
+ *    the first frame and settles after a few frames
+ *  - "CONC,NOJUICE" if the juice type cannot be determined
+ *  - "CONC,NOMODEL" if the exported preprocessing spec failed its
+ *    check at startup
+ *******************************************************/
+static void spectro_app_handle_conc_reg(const SpectroMeasurement_t *meas)
+{
+    if (meas == NULL)
+        return;
+
+    if (!s_concSpecOk)
+    {
+        spectro_mux_print(SPECTRO_MUX_RESULT).println(F("CONC,NOMODEL"));
+        return;
+    }
+
+    int juice = spectro_app_conc_juice_index(meas);
+    if (juice < 0)
+    {
+        spectro_mux_print(SPECTRO_MUX_RESULT).println(F("CONC,NOJUICE"));
+        return;
+    }
+
+    uint32_t t0 = micros();
+
+    float f[SPECTRO_CONC_NUM_BANDS];
+    float fvar[SPECTRO_CONC_NUM_BANDS];
+    SpectroConcResult_t res;
+
+    spectro_conc_stats_update(&s_concStats, meas->sorted);
+    spectro_conc_features(&spectro_conc_model_spec, meas->sorted, f);
+    spectro_conc_feature_variance(&spectro_conc_model_spec, &s_concStats, meas->sorted, fvar);
+
+#if SPECTRO_CONC_MODEL_HAS_RIDGE
+    if (s_concModel == SPECTRO_CONC_MODEL_RIDGE)
+        spectro_conc_predict_ridge(&spectro_conc_model_ridge, juice, f, fvar, &res);
+    else
+#endif
+        spectro_conc_predict_linear(&spectro_conc_model_linear[juice], f, fvar, &res);
+
+    uint32_t elapsed = micros() - t0;
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "CONC,");
+    spectro_line_str(&line, spectro_conc_model_juices[juice]);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, res.percent, 1);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, res.sigma, 2);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, elapsed);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+}
+
+/*******************************************************
+ * @brief  Mode 5: juice + concentration from the model package
+ *
+ * @details
+ *  - Output line:
+ *      "INFER,<juice>,<p juice>,<conc>,<p conc>,<compute us>"
+ *  - The juice prediction is the context of the concentration
+ *    model, like the one-hot input of train_concentration.py
+ *  - "INFER,NOMODEL" until a package has been uploaded
+ *******************************************************/
+static void spectro_app_handle_infer_model(const SpectroMeasurement_t *meas)
+{
+    if (meas == NULL)
+        return;
+
+    const SpectroModelSection_t *juiceSec = spectro_model_find(s_modelImage, SPECTRO_MODEL_ROLE_JUICE);
+    const SpectroModelSection_t *concSec = spectro_model_find(s_modelImage, SPECTRO_MODEL_ROLE_CONC);
+    if ((juiceSec == NULL) && (concSec == NULL))
+    {
+        spectro_mux_print(SPECTRO_MUX_RESULT).println(F("INFER,NOMODEL"));
+        return;
+    }
+
+    uint32_t t0 = micros();
+
+    double ch[SPECTRO_MODEL_NUM_CHANNELS];
+    float x[SPECTRO_MODEL_MAX_INPUTS];
+    float proba[SPECTRO_MODEL_MAX_CLASSES];
+
+    for (int i = 0; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+        ch[i] = meas->sorted[i];
+
+    const char *juice = "-";
+    float juiceP = 0.0f;
+    if (juiceSec != NULL)
+    {
+        spectro_model_features(juiceSec, ch, -1, x);
+        int j = spectro_model_predict(juiceSec, x, proba);
+        juice = juiceSec->classLabels[j];
+        juiceP = proba[j];
+    }
+
+    const char *conc = "-";
+    float concP = 0.0f;
+    if (concSec != NULL)
+    {
+        spectro_model_features(concSec, ch, spectro_model_context_index(concSec, juice), x);
+        int c = spectro_model_predict(concSec, x, proba);
+        conc = concSec->classLabels[c];
+        concP = proba[c];
+    }
+
+    uint32_t elapsed = micros() - t0;
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "INFER,");
+    spectro_line_str(&line, juice);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, juiceP, 3);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, conc);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, concP, 3);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, elapsed);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+}
+
+/*******************************************************
+ * @brief  Mode 6: progressive refinement
+ *
+ * @details
+ *  - First frame at LOW precision (tens of ms), shown at once:
+ *      "PROG,PREVIEW,<label>,<conf>,<ms>"
+ *  - Then the sensor switches to the selected precision and the
+ *    channels of every frame are averaged and re-classified:
+ *      "PROG,REFINE,<label>,<conf>,<frames>,<ms>"
+ *  - Once the label is unchanged for SPECTRO_APP_PROG_STABLE_FRAMES
+ *    frames: "PROG,STABLE,..." ("PROG,UNSTABLE,..." after
+ *    SPECTRO_APP_PROG_MAX_FRAMES), then a new cycle starts
+ *  - Only the juice classifier runs here: L1 features do not depend
+ *    on the integration time, so LOW and HIGH frames are comparable
+ *  - <ms> counts from the start of the cycle
+ *******************************************************/
+static void spectro_app_handle_progressive(const SpectroMeasurement_t *meas)
+{
+    if (meas == NULL)
+        return;
+
+    const char *label = NULL;
+    float conf = 0.0f;
+    uint32_t elapsed = millis() - s_progStartMs;
+
+    if (s_progPhase == SPECTRO_PROG_PREVIEW)
+    {
+        double ch[AS7343_NUM_SORTED_CHANNELS];
+        for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+            ch[i] = meas->sorted[i];
+
+        if (spectro_app_classify_juice(ch, &label, &conf) < 0)
+        {
+            spectro_mux_print(SPECTRO_MUX_RESULT).println(F("PROG,NOMODEL"));
+            spectro_app_prog_restart();
+            return;
+        }
+
+        SpectroLine_t line;
+        spectro_line_init(&line);
+        spectro_line_str(&line, "PROG,PREVIEW,");
+        spectro_line_str(&line, label);
+        spectro_line_char(&line, ',');
+        spectro_line_fixed(&line, conf, 3);
+        spectro_line_char(&line, ',');
+        spectro_line_u32(&line, elapsed);
+        spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+        oled_show_result(label, "Preview");
+
+        // switch to the refinement precision for the following frames
+        s_progPhase = SPECTRO_PROG_REFINE;
+        if (!spectro_app_configure_sensor(s_precMode))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
+        return;
+    }
+
+    double mean[AS7343_NUM_SORTED_CHANNELS];
+    s_progFrames++;
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+    {
+        s_progSum[i] += meas->sorted[i];
+        mean[i] = s_progSum[i] / (double)s_progFrames;
+    }
+
+    int idx = spectro_app_classify_juice(mean, &label, &conf);
+    if (idx < 0)
+    {
+        spectro_mux_print(SPECTRO_MUX_RESULT).println(F("PROG,NOMODEL"));
+        spectro_app_prog_restart();
+        return;
+    }
+
+    s_progAgree = (idx == s_progLabel) ? (uint16_t)(s_progAgree + 1) : 1;
+    s_progLabel = idx;
+
+    bool stable = (s_progAgree >= SPECTRO_APP_PROG_STABLE_FRAMES);
+    bool done = stable || (s_progFrames >= SPECTRO_APP_PROG_MAX_FRAMES);
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, !done ? "PROG,REFINE," : (stable ? "PROG,STABLE," : "PROG,UNSTABLE,"));
+    spectro_line_str(&line, label);
+    spectro_line_char(&line, ',');
+    spectro_line_fixed(&line, conf, 3);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_progFrames);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, elapsed);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+
+    oled_show_result(label, stable ? "Stable" : (done ? "Unstable" : "Refining"));
+
+    if (done)
+        spectro_app_prog_restart();
+}
+
+/*******************************************************
+ * @brief  Start a new progressive cycle with a LOW frame
+ *******************************************************/
+static void spectro_app_prog_restart(void)
+{
+    s_progPhase = SPECTRO_PROG_PREVIEW;
+    s_progStartMs = millis();
+    s_progFrames = 0;
+    s_progAgree = 0;
+    s_progLabel = -1;
+    memset(s_progSum, 0, sizeof(s_progSum));
+
+    if (!spectro_app_configure_sensor(SPECTRO_PRECISION_LOW))
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
+}
+
+/*******************************************************
+ * @brief  Juice label of a spectrum
+ *
+ * @details
+ *  - Juice model of the uploaded package if there is one,
+ *    conf = class probability
+ *  - Otherwise the enrolled centroid classes, conf = score
+ *  - Returns the class index, -1 if no classifier is available
+ *******************************************************/
+static int spectro_app_classify_juice(const double *channels, const char **label, float *conf)
+{
+    const SpectroModelSection_t *sec = spectro_model_find(s_modelImage, SPECTRO_MODEL_ROLE_JUICE);
+    if (sec != NULL)
+    {
+        float x[SPECTRO_MODEL_MAX_INPUTS];
+        float proba[SPECTRO_MODEL_MAX_CLASSES];
+
+        spectro_model_features(sec, channels, -1, x);
+        int j = spectro_model_predict(sec, x, proba);
+        *label = sec->classLabels[j];
+        *conf = proba[j];
+        return j;
+    }
+
+    uint16_t sorted[AS7343_NUM_SORTED_CHANNELS];
+    float x[SPECTRO_CENTROID_NUM_FEATURES];
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+        sorted[i] = (uint16_t)(channels[i] + 0.5);
+
+    spectro_centroid_features(sorted, x);
+    int idx = spectro_centroid_classify(&s_centroid, x, conf);
+    if (idx >= 0)
+        *label = s_centroid.cls[idx].label;
+    return idx;
+}
+
+/*******************************************************
+ * @brief  Juice index for the regression model
+ *
+ * @details
+ *  - Fixed by the JUICE command, or
+ *  - "auto": centroid class label with trailing digits removed
+ *    ("apple2" -> "apple"), like juice_base in dataset.py
+ *******************************************************/
+static int spectro_app_conc_juice_index(const SpectroMeasurement_t *meas)
+{
+    if (s_concJuice != SPECTRO_APP_JUICE_AUTO)
+        return s_concJuice;
+
+    float x[SPECTRO_CENTROID_NUM_FEATURES];
+    spectro_centroid_features(meas->sorted, x);
+
+    int idx = spectro_centroid_classify(&s_centroid, x, NULL);
+    if (idx < 0)
+        return -1;
+
+    const char *label = s_centroid.cls[idx].label;
+    size_t baseLen = strlen(label);
+    while ((baseLen > 0) && (label[baseLen - 1] >= '0') && (label[baseLen - 1] <= '9'))
+        baseLen--;
+
+    for (int j = 0; j < SPECTRO_CONC_MODEL_NUM_JUICES; j++)
+    {
+        const char *name = spectro_conc_model_juices[j];
+        if ((strlen(name) == baseLen) && (strncmp(name, label, baseLen) == 0))
+            return j;
+    }
+    return -1;
+}
+
+//==================== On-device learning ====================//
+
+bool spectro_app_learn_start(const char *label, uint16_t frames)
+{
+    if ((label == NULL) || (frames == 0) || (frames > SPECTRO_APP_LEARN_MAX_FRAMES))
+        return false;
+
+    size_t len = strlen(label);
+    if ((len == 0) || (len >= SPECTRO_CENTROID_LABEL_LEN))
+        return false;
+
+    // A new class needs a free slot
+    if ((spectro_centroid_find(&s_centroid, label) < 0) &&
+        (s_centroid.numClasses >= SPECTRO_CENTROID_MAX_CLASSES))
+        return false;
+
+    memcpy(s_learnLabel, label, len + 1);
+    s_learnRemaining = frames;
+    return true;
+}
+
+bool spectro_app_learn_forget(const char *label)
+{
+    if (!spectro_centroid_forget(&s_centroid, label))
+        return false;
+
+    // may run in the sensor idle callback: saved between frames
+    s_learnSavePending = true;
+    return true;
+}
+
+void spectro_app_learn_list(void)
+{
+    Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+
+    out.print(F("CLASSES,"));
+    out.println(s_centroid.numClasses);
+
+    for (uint32_t c = 0; c < s_centroid.numClasses; c++)
+    {
+        out.print(F("CLASS,"));
+        out.print(s_centroid.cls[c].label);
+        out.print(',');
+        out.println(s_centroid.cls[c].count);
+    }
+}
+
+/*******************************************************
+ * @brief  Enrol one frame while a LEARN is armed
+ *
+ * @details
+ *  - Progress line: "LEARN,<label>,<frames in class>"
+ *  - After the last armed frame the model is saved before the next
+ *    frame (spectro_app_save_pending())
+ *******************************************************/
+static void spectro_app_learn_step(const SpectroMeasurement_t *meas)
+{
+    float x[SPECTRO_CENTROID_NUM_FEATURES];
+
+    spectro_centroid_features(meas->sorted, x);
+    int idx = spectro_centroid_update(&s_centroid, s_learnLabel, x);
+
+    if (idx < 0)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Centroid model full."));
+        s_learnRemaining = 0;
+        return;
+    }
+
+    Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+    out.print(F("LEARN,"));
+    out.print(s_learnLabel);
+    out.print(',');
+    out.println(s_centroid.cls[idx].count);
+
+    if (--s_learnRemaining == 0)
+    {
+        s_learnSavePending = true;
+        s_learnSaveReport = true;
+    }
+}
+
+/*******************************************************
+ * @brief  Flash saves requested by the frame path or by commands,
+ *         run between frames
+ *
+ * @details
+ *  - First thing of spectro_app_run_once(), before commands can
+ *    change the label or start the next frame
+ *  - A finished LEARN reports "LEARN,<label>,SAVED", FORGET saves
+ *    silently
+ *  - A captured blank or endmember saves the unmixing library
+ *  - A model upload gets its next flash page erased, so MODEL DATA
+ *    (also handled in the sensor idle callback) only programs
+ *******************************************************/
+static void spectro_app_save_pending(void)
+{
+    if (s_learnSavePending)
+    {
+        s_learnSavePending = false;
+        bool report = s_learnSaveReport;
+        s_learnSaveReport = false;
+        if (spectro_app_learn_save() && report)
+        {
+            Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+            out.print(F("LEARN,"));
+            out.print(s_learnLabel);
+            out.println(F(",SAVED"));
+        }
+    }
+
+    if (s_unmixSavePending)
+    {
+        s_unmixSavePending = false;
+        if (!spectro_storage_save(SPECTRO_STORE_UNMIX, &s_unmixLib, sizeof(s_unmixLib)))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to save unmixing library."));
+    }
+
+    spectro_slot_prepare();
+}
+
+static bool spectro_app_learn_save(void)
+{
+    if (spectro_storage_save(SPECTRO_STORE_CENTROID, &s_centroid, sizeof(s_centroid)))
+        return true;
+
+    spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to save centroid model."));
+    return false;
+}
+
+//==================== Spectral unmixing ====================//
+
+void spectro_app_unmix_capture_blank(void)
+{
+    s_unmixCapture = SPECTRO_APP_CAPTURE_BLANK;
+}
+
+bool spectro_app_unmix_capture_endmember(const char *name)
+{
+    int k = spectro_unmix_find(name);
+    if ((k < 0) || !spectro_unmix_has_blank(&s_unmixLib))
+        return false;
+
+    s_unmixCapture = (int8_t)k;
+    return true;
+}
+
+/*******************************************************
+ * @brief  Store the frame as blank or endmember
+ *
+ * @details
+ *  - The library is saved before the next frame
+ *    (spectro_app_save_pending())
+ *
+ * @note   A new blank invalidates the endmembers recorded
+ *         against the previous one.
+ *******************************************************/
+static void spectro_app_unmix_capture_step(const SpectroMeasurement_t *meas)
+{
+    if (s_unmixCapture == SPECTRO_APP_CAPTURE_BLANK)
+    {
+        memcpy(s_unmixLib.blank, meas->sorted, sizeof(s_unmixLib.blank));
+        s_unmixLib.validMask = 0;
+        spectro_mux_print(SPECTRO_MUX_CONTROL).println(F("BLANK,OK"));
+    }
+    else
+    {
+        int k = s_unmixCapture;
+        spectro_unmix_absorbance(meas->sorted, s_unmixLib.blank, s_unmixLib.endmember[k]);
+        s_unmixLib.validMask |= (1UL << k);
+        Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+        out.print(F("ENDMEMBER,"));
+        out.println(spectro_unmix_name(k));
+    }
+
+    s_unmixCapture = SPECTRO_APP_CAPTURE_NONE;
+    spectro_unmix_prepare(&s_unmixLib, &s_unmixSolver);
+    s_unmixSavePending = true;
+}
+
+//==================== Concentration regression ====================//
+
+bool spectro_app_conc_set_juice(const char *name)
+{
+    if (name == NULL)
+        return false;
+
+    if (strcmp(name, "auto") == 0)
+    {
+        s_concJuice = SPECTRO_APP_JUICE_AUTO;
+        spectro_conc_stats_reset(&s_concStats);
+        return true;
+    }
+
+    for (int j = 0; j < SPECTRO_CONC_MODEL_NUM_JUICES; j++)
+    {
+        if (strcmp(name, spectro_conc_model_juices[j]) == 0)
+        {
+            s_concJuice = (int8_t)j;
+            spectro_conc_stats_reset(&s_concStats);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool spectro_app_conc_set_model(SpectroConcModel_t model)
+{
+#if !SPECTRO_CONC_MODEL_HAS_RIDGE
+    if (model == SPECTRO_CONC_MODEL_RIDGE)
+        return false;
+#endif
+    s_concModel = model;
+    return true;
+}
+
+//==================== Model package hot-swap ====================//
+
+static bool spectro_app_model_validate(const uint8_t *image, uint32_t size)
+{
+    return spectro_model_validate(image, size);
+}
+
+bool spectro_app_model_begin(uint32_t size, uint32_t crc)
+{
+    return spectro_slot_begin(size, crc);
+}
+
+bool spectro_app_model_data(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    return spectro_slot_write(offset, data, len);
+}
+
+bool spectro_app_model_ready(uint32_t offset, uint32_t len)
+{
+    return spectro_slot_erased(offset, len);
+}
+
+bool spectro_app_model_commit(void)
+{
+    if (!spectro_slot_commit(spectro_app_model_validate))
+        return false;
+
+    // single pointer store: the next frame runs the new package
+    s_modelImage = spectro_slot_active(NULL, NULL);
+    return true;
+}
+
+void spectro_app_model_abort(void)
+{
+    spectro_slot_abort();
+}
+
+uint32_t spectro_app_model_next_offset(void)
+{
+    return spectro_slot_next_offset();
+}
+
+/*******************************************************
+ * @brief  Print the active package
+ *
+ * @details
+ *  - "MODEL,INFO,<version>,<generation>,<size>,<name>"
+ *  - "MODEL,NONE" if no package is stored
+ *******************************************************/
+void spectro_app_model_info(void)
+{
+    uint32_t size = 0;
+    uint32_t generation = 0;
+
+    if ((s_modelImage == NULL) || (spectro_slot_active(&size, &generation) == NULL))
+    {
+        spectro_mux_print(SPECTRO_MUX_CONTROL).println(F("MODEL,NONE"));
+        return;
+    }
+
+    const SpectroModelHeader_t *hdr = spectro_model_header(s_modelImage);
+
+    Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+    out.print(F("MODEL,INFO,"));
+    out.print(hdr->packageVersion);
+    out.print(',');
+    out.print(generation);
+    out.print(',');
+    out.print(size);
+    out.print(',');
+    out.println(hdr->name);
+}
+
+//==================== PC inference pipeline ====================//
+
+bool spectro_app_pc_response(const char *text)
+{
+    char *end = NULL;
+    unsigned long seq = strtoul(text, &end, 10);
+
+    if ((end == text) || ((*end != ',') && (*end != '\0')) || (seq > 0xFFFF))
+        return false;
+    const char *result = (*end == ',') ? end + 1 : end;
+
+    int32_t rtt = spectro_pc_reply(&s_pc, (uint16_t)seq, millis());
+    if (rtt < 0)
+        return true;   // late or duplicate: counted, the newer result stays
+
+    s_pcResultSeq = (uint16_t)seq;
+    snprintf(s_pcResult, sizeof(s_pcResult), "%s", result);
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "PCRES,");
+    spectro_line_u16(&line, s_pcResultSeq);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, (uint32_t)rtt);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, s_pcResult);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+
+    // "JUICE=<label>;..." -> label on the OLED
+    if (strncmp(s_pcResult, "JUICE=", 6) == 0)
+    {
+        char label[SPECTRO_CENTROID_LABEL_LEN];
+        size_t n = strcspn(&s_pcResult[6], ";");
+        if (n >= sizeof(label))
+            n = sizeof(label) - 1;
+        memcpy(label, &s_pcResult[6], n);
+        label[n] = '\0';
+        oled_show_result(label, "PC");
+    }
+    return true;
+}
+
+bool spectro_app_pc_configure(uint8_t window, uint16_t timeoutMs)
+{
+    return spectro_pc_configure(&s_pc, (window > 0) ? window : s_pc.window,
+                                (timeoutMs > 0) ? timeoutMs : s_pc.timeoutMs);
+}
+
+void spectro_app_pc_stats(void)
+{
+    const SpectroPcStats_t *st = &s_pc.stats;
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "PCSTAT,");
+    spectro_line_u32(&line, st->sent);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->replied);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->late);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->timeouts);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->skipped);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_pc.count);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, (st->replied > 0) ? st->rttSumMs / st->replied : 0);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st->rttMaxMs);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_pc.window);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_pc.timeoutMs);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+//==================== Batch measurement ====================//
+
+bool spectro_app_measure_start(uint8_t frames, SpectroPrecisionMode_t prec,
+                               SpectroBatchAgg_t agg, const char *label)
+{
+    if (s_batchPending || s_batchRunning ||
+        (frames == 0) || (frames > SPECTRO_BATCH_MAX_FRAMES) ||
+        (prec > SPECTRO_PRECISION_HIGH) || (spectro_batch_agg_name(agg) == NULL) ||
+        (label == NULL) || (strchr(label, ',') != NULL))
+        return false;
+
+    size_t len = strlen(label);
+    if ((len == 0) || (len >= SPECTRO_APP_MEASURE_LABEL_LEN))
+        return false;
+
+    memcpy(s_batchLabel, label, len + 1);
+    s_batchFrames = frames;
+    s_batchPrec = prec;
+    s_batchAgg = agg;
+    s_batchPending = true;
+    return true;
+}
+
+/*******************************************************
+ * @brief  Run the requested MEASURE batch
+ *
+ * @details
+ *  - The frame in progress when the batch starts may have begun
+ *    before the command (or at the old settings), so it is read and
+ *    discarded; the batch time starts at its end
+ *  - The idle callback still serves commands and the output queue,
+ *    but no frame is sent or processed until the batch is over, so
+ *    the frame period depends on the sensor settings only
+ *  - Afterwards the mode's own precision is restored and a partial
+ *    AVG group is restarted
+ *******************************************************/
+static void spectro_app_run_batch(void)
+{
+    SpectroMeasurement_t meas;
+    SpectroBatchResult_t res;
+    bool ok;
+
+    s_batchPending = false;
+    s_batchRunning = true;
+
+    ok = spectro_app_configure_sensor(s_batchPrec) && spectro_app_acquire(&meas);
+    spectro_batch_reset(&s_batch, ok ? meas.timestampUs : micros());   // meas unset on failure
+
+    for (uint8_t i = 0; ok && (i < s_batchFrames); i++)
+    {
+        ok = spectro_app_acquire(&meas);
+        if (ok)
+            spectro_batch_add(&s_batch, meas.sorted, meas.timestampUs);
+    }
+
+    spectro_app_restore_sensor();
+    s_batchRunning = false;
+
+    if (!ok || !spectro_batch_result(&s_batch, s_batchAgg, &res))
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to acquire measurement."));
+
+        SpectroLine_t line;
+        spectro_line_init(&line);
+        spectro_line_str(&line, "BATCHERR,");
+        spectro_line_u16(&line, s_batch.count);
+        spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+        spectro_mux_flush();
+        return;
+    }
+
+    spectro_app_print_batch(&res);
+}
+
+/*******************************************************
+ * @brief  Back to the mode's own sensor settings after a batch or script
+ *
+ * @details
+ *  - Progressive mode restarts at its preview precision
+ *  - A partial AVG group is restarted
+ *  - Hot standby stops the sensor again before waiting
+ *******************************************************/
+static void spectro_app_restore_sensor(void)
+{
+    if (s_appMode == SPECTRO_APP_MODE_PROGRESSIVE)
+        spectro_app_prog_restart();
+    else if (!spectro_app_configure_sensor(s_precMode))
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
+    s_avgCount = 0;
+    memset(s_avgSum, 0, sizeof(s_avgSum));
+    s_standbyArmed = false;
+}
+
+/*******************************************************
+ * @brief  Reply of a finished batch (see spectro_app_measure_start)
+ *
+ * @details
+ *  - Values with one decimal; variances of 1e6 and more without,
+ *    so even the largest possible BATCHVAR line fits
+ *******************************************************/
+static void spectro_app_print_batch(const SpectroBatchResult_t *res)
+{
+    SpectroLine_t line;
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, "BATCH,");
+    spectro_line_str(&line, s_batchLabel);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, res->frames);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, spectro_batch_agg_name(s_batchAgg));
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, s_precNames[s_batchPrec]);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, res->durationUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, res->periodUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, res->jitterUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_batch.endUs[res->frames - 1]);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, "BATCHVAL");
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+    {
+        spectro_line_char(&line, ',');
+        spectro_line_fixed(&line, res->value[i], 1);
+    }
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, "BATCHVAR");
+    for (int i = 0; i < AS7343_NUM_SORTED_CHANNELS; i++)
+    {
+        spectro_line_char(&line, ',');
+        spectro_line_fixed(&line, res->var[i], (res->var[i] < 1.0e6f) ? 1 : 0);
+    }
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+//==================== Register scripts ====================//
+
+static bool spectro_app_script_write(void *ctx, uint8_t reg, uint8_t value)
+{
+    (void)ctx;
+    return AS7343_i2c_write_reg(AS7343_I2C_ADDRESS, reg, &value);
+}
+
+static bool spectro_app_script_read(void *ctx, uint8_t reg, uint8_t *data, uint8_t len)
+{
+    (void)ctx;
+    return AS7343_i2c_read(AS7343_I2C_ADDRESS, reg, data, len);
+}
+
+static uint32_t spectro_app_script_millis(void *ctx)
+{
+    (void)ctx;
+    return millis();
+}
+
+/*******************************************************
+ * @brief  Script waits: serve commands and output, SCRIPT ABORT stops
+ *******************************************************/
+static bool spectro_app_script_idle(void *ctx)
+{
+    (void)ctx;
+    spectro_app_idle();
+    spectro_mux_poll();
+    return !s_scriptAbort;
+}
+
+/*******************************************************
+ * @brief  One EMIT: "SCRIPT,REC,<record>,<us>,<hex>" on RESULT
+ *
+ * @details
+ *  - Waits for room instead of letting the queue drop the record
+ *******************************************************/
+static bool spectro_app_script_emit(void *ctx, uint32_t record, const uint8_t *data, uint8_t len)
+{
+    SpectroLine_t line;
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, "SCRIPT,REC,");
+    spectro_line_u32(&line, record);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, micros());
+    spectro_line_char(&line, ',');
+    for (uint8_t i = 0; i < len; i++)
+        spectro_app_line_hex(&line, data[i], 2);
+
+    while (spectro_mux_space(SPECTRO_MUX_RESULT) < (size_t)line.len + 2)
+    {
+        if (!spectro_app_script_idle(ctx))
+            return false;
+    }
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+    spectro_mux_poll();
+    return true;
+}
+
+bool spectro_app_script_begin(uint16_t size)
+{
+    if (s_scriptRunning || (size == 0) || (size > SPECTRO_SCRIPT_MAX_SIZE))
+        return false;
+
+    s_scriptSize = size;
+    s_scriptLoaded = 0;
+    s_scriptPending = false;
+    return true;
+}
+
+bool spectro_app_script_data(uint16_t offset, const uint8_t *data, uint16_t len)
+{
+    if (s_scriptRunning || (offset != s_scriptLoaded) || (len == 0) || (len > s_scriptSize - offset))
+        return false;
+
+    memcpy(&s_script[offset], data, len);
+    s_scriptLoaded += len;
+    return true;
+}
+
+uint16_t spectro_app_script_next_offset(void)
+{
+    return s_scriptLoaded;
+}
+
+bool spectro_app_script_run(void)
+{
+    if (s_scriptRunning || s_scriptPending || (s_scriptSize == 0) || (s_scriptLoaded != s_scriptSize))
+        return false;
+
+    s_scriptPending = true;
+    return true;
+}
+
+void spectro_app_script_abort(void)
+{
+    s_scriptAbort = s_scriptRunning;
+    s_scriptPending = false;
+    s_scriptSize = 0;
+    s_scriptLoaded = 0;
+}
+
+/*******************************************************
+ * @brief  Run the requested register script
+ *
+ * @details
+ *  - The bus runs at SPECTRO_APP_SCRIPT_I2C_HZ for the script only
+ *  - The script may leave any register changed (bank, SMUX, power),
+ *    so the driver defaults are written again and its cached
+ *    configuration discarded before the mode's settings are restored
+ *******************************************************/
+static void spectro_app_run_script(void)
+{
+    const SpectroScriptIo_t io = {
+        spectro_app_script_write, spectro_app_script_read, spectro_app_script_millis,
+        spectro_app_script_idle, spectro_app_script_emit, NULL
+    };
+    SpectroScriptResult_t res;
+
+    s_scriptPending = false;
+    s_scriptRunning = true;
+    s_scriptAbort = false;
+
+    AS7343_i2c_set_clock(SPECTRO_APP_SCRIPT_I2C_HZ);
+    uint32_t startUs = micros();
+    spectro_script_run(s_script, s_scriptSize, &io, &res);
+    uint32_t durationUs = micros() - startUs;
+    AS7343_i2c_set_clock(SPECTRO_APP_I2C_HZ);
+
+    if (res.ops > 0)
+    {
+        AS7343_invalidate_config();
+        if (!AS7343_restore_defaults())
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
+        spectro_app_restore_sensor();
+    }
+    s_scriptRunning = false;
+    s_scriptAbort = false;
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "SCRIPT,END,");
+    spectro_line_str(&line, spectro_script_status_name(res.status));
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, res.pc);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, res.records);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, res.ops);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, durationUs);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+    spectro_mux_flush();
+}
+
+//==================== Hot standby ====================//
+
+bool spectro_app_standby(SpectroStandby_t mode)
+{
+    if (mode > SPECTRO_STANDBY_PRE)
+        return false;
+
+    if (mode != s_standby)
+    {
+        s_trigCount = 0;
+        s_trigIgnored = 0;
+        s_trigLastUs = 0;
+        s_trigMinUs = 0;
+        s_trigMaxUs = 0;
+        s_trigSumUs = 0;
+    }
+
+    // may run in the sensor idle callback: SP_EN is set in run_once()
+    if ((mode == SPECTRO_STANDBY_OFF) && (s_standby == SPECTRO_STANDBY_HOT))
+        s_standbyLeft = true;
+
+    s_standby = mode;
+    s_standbyArmed = false;
+    s_trigPending = false;
+    return true;
+}
+
+bool spectro_app_standby_threshold(int8_t channel, uint16_t low, uint16_t high)
+{
+    if ((channel < -1) || (channel >= AS7343_NUM_SORTED_CHANNELS) || (low > high))
+        return false;
+
+    s_thrChannel = channel;
+    s_thrLow = low;
+    s_thrHigh = high;
+    s_thrInside = false;
+    return true;
+}
+
+bool spectro_app_trigger(SpectroTrigger_t source, uint32_t us)
+{
+    if (s_standby == SPECTRO_STANDBY_OFF)
+        return false;
+
+    if (s_trigPending || s_trigActive)
+    {
+        s_trigIgnored++;
+        return false;
+    }
+
+    s_trigSource = source;
+    s_trigUs = us;
+    s_trigPending = true;
+    return true;
+}
+
+void spectro_app_standby_stats(void)
+{
+    static const char *const names[] = { "off", "hot", "pre" };
+    SpectroLine_t line;
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, "STANDBY,");
+    spectro_line_str(&line, names[s_standby]);
+    spectro_line_char(&line, ',');
+    if (s_thrChannel >= 0)
+        spectro_line_u16(&line, (uint16_t)s_thrChannel);
+    else
+        spectro_line_char(&line, '-');
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_thrLow);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, s_thrHigh);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_trigCount);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_trigIgnored);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_trigLastUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_trigMinUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, (s_trigCount > 0) ? (uint32_t)(s_trigSumUs / s_trigCount) : 0);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_trigMaxUs);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+/*******************************************************
+ * @brief  Trigger button edge (interrupt context)
+ *
+ * @details
+ *  - Only timestamps the press; spectro_app_run_standby() turns it
+ *    into a trigger. Edges within the debounce time are bounces
+ *******************************************************/
+static void spectro_app_button_isr(void)
+{
+    uint32_t now = micros();
+
+    if ((s_standby == SPECTRO_STANDBY_OFF) || s_buttonPending ||
+        ((now - s_buttonUs) < SPECTRO_APP_TRIGGER_DEBOUNCE_MS * 1000UL))
+        return;
+
+    s_buttonUs = now;
+    s_buttonPending = true;
+}
+
+/*******************************************************
+ * @brief  Wait for a trigger, then measure and send one result
+ *
+ * @details
+ *  - Arming sets SP_EN for the standby mode once (again after any
+ *    reconfiguration) and drops button presses from before
+ *  - HOT does nothing until a trigger; PRE reads one frame per call
+ *    and drops it unless it ended after the trigger
+ *  - The result runs to completion here (AVG frames, or a whole
+ *    PROGRESSIVE cycle whose preview frame starts after the trigger),
+ *    commands are served by the idle callback meanwhile
+ *  - The result is flushed before the latency is taken, so it covers
+ *    the sensor, the processing and the hand-over to the host link
+ *******************************************************/
+static void spectro_app_run_standby(void)
+{
+    SpectroMeasurement_t meas;
+    bool fresh = false;   // meas already holds the first frame of the result
+
+    if (!s_standbyArmed)
+    {
+        if (!AS7343_set_measurement(s_standby == SPECTRO_STANDBY_PRE))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to configure sensor."));
+        s_standbyArmed = true;
+        s_buttonPending = false;
+        s_thrInside = false;
+    }
+
+    if (s_buttonPending)
+    {
+        spectro_app_trigger(SPECTRO_TRIGGER_BUTTON, s_buttonUs);
+        s_buttonPending = false;
+    }
+
+    if (s_standby == SPECTRO_STANDBY_PRE)
+    {
+        if (!spectro_app_acquire(&meas))
+        {
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to acquire measurement."));
+            return;
+        }
+
+        if (!s_trigPending || ((int32_t)(meas.timestampUs - s_trigUs) <= 0))
+        {
+            spectro_app_check_threshold(&meas);
+            return;
+        }
+        fresh = true;
+    }
+    else if (!s_trigPending)
+    {
+        return;
+    }
+
+    s_trigPending = false;
+    s_trigActive = true;
+    s_avgCount = 0;
+    memset(s_avgSum, 0, sizeof(s_avgSum));
+
+    bool ok = true;
+    if (s_appMode == SPECTRO_APP_MODE_PROGRESSIVE)
+    {
+        spectro_app_prog_restart();   // restarts the frame at preview precision
+        fresh = false;
+    }
+    if (s_standby == SPECTRO_STANDBY_HOT)
+        ok = AS7343_set_measurement(true);
+
+    bool done = false;
+    while (ok && !done)
+    {
+        if (!fresh)
+            ok = spectro_app_acquire(&meas);
+        fresh = false;
+
+        if (ok && spectro_app_average(&meas))
+        {
+            spectro_app_process(&meas);
+            done = (s_appMode != SPECTRO_APP_MODE_PROGRESSIVE) || (s_progPhase == SPECTRO_PROG_PREVIEW);
+        }
+    }
+
+    spectro_app_drain_queue();
+    spectro_mux_flush();
+    uint32_t latencyUs = micros() - s_trigUs;
+
+    if ((s_standby == SPECTRO_STANDBY_HOT) && !AS7343_set_measurement(false))
+        ok = false;
+    s_trigActive = false;
+
+    if (!ok)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Failed to acquire measurement."));
+        return;
+    }
+
+    s_trigLastUs = latencyUs;
+    s_trigMinUs = ((s_trigCount == 0) || (latencyUs < s_trigMinUs)) ? latencyUs : s_trigMinUs;
+    s_trigMaxUs = (latencyUs > s_trigMaxUs) ? latencyUs : s_trigMaxUs;
+    s_trigSumUs += latencyUs;
+    s_trigCount++;
+    spectro_app_print_trigger(meas.timestampUs, latencyUs);
+}
+
+/*******************************************************
+ * @brief  Threshold trigger on a dropped PRE frame
+ *
+ * @details
+ *  - Fires on leaving the window only, so a cuvette left in the
+ *    holder triggers once; the channel has to come back inside to
+ *    re-arm, and a window set while outside waits for that too
+ *******************************************************/
+static void spectro_app_check_threshold(const SpectroMeasurement_t *meas)
+{
+    if (s_thrChannel < 0)
+        return;
+
+    uint16_t v = meas->sorted[s_thrChannel];
+    bool inside = (v >= s_thrLow) && (v <= s_thrHigh);
+
+    if (!inside && s_thrInside)
+        spectro_app_trigger(SPECTRO_TRIGGER_THRESHOLD, meas->timestampUs);
+    s_thrInside = inside;
+}
+
+static void spectro_app_print_trigger(uint32_t dataUs, uint32_t latencyUs)
+{
+    static const char *const sources[] = { "command", "button", "threshold" };
+    SpectroLine_t line;
+
+    spectro_line_init(&line);
+    spectro_line_str(&line, "TRIG,");
+    spectro_line_u32(&line, s_trigCount);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, sources[s_trigSource]);
+    spectro_line_char(&line, ',');
+    spectro_line_str(&line, (s_standby == SPECTRO_STANDBY_HOT) ? "hot" : "pre");
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_trigUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, dataUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, latencyUs);
+    spectro_mux_line(SPECTRO_MUX_RESULT, &line);
+    spectro_mux_flush();
 }
@@ -20,6 +20,30 @@
 
 #include <Arduino.h>
 #include "Pimoroni_AS7343.h"
+#include "spectro_queue.h"
+#include "spectro_batch.h"
+
+#define SPECTRO_APP_LEARN_DEFAULT_FRAMES   10    // frames enrolled per LEARN command
+#define SPECTRO_APP_LEARN_MAX_FRAMES       1000
+
+#define SPECTRO_APP_MAX_AVERAGE            64    // frames per AVG output
+#define SPECTRO_APP_GAIN_AUTO              (-1)  // gain of the precision table
+
+#define SPECTRO_APP_FW_MAJOR               1     // reported in the stream header
+#define SPECTRO_APP_FW_MINOR               0
+#define SPECTRO_APP_FW_PATCH               0
+
+#define SPECTRO_APP_PROG_STABLE_FRAMES     3     // refined label unchanged for this many frames
+#define SPECTRO_APP_PROG_MAX_FRAMES        10    // refinement frames before giving up
+
+#define SPECTRO_APP_MEASURE_DEFAULT_FRAMES 5     // frames per MEASURE command
+#define SPECTRO_APP_MEASURE_LABEL_LEN      24    // incl. terminator
+
+#define SPECTRO_APP_I2C_HZ                 100000   // sensor bus clock for frames
+#define SPECTRO_APP_SCRIPT_I2C_HZ          400000   // while a register script runs
+
+#define SPECTRO_APP_TRIGGER_PIN            2        // D2, push button to GND; -1 = no button
+#define SPECTRO_APP_TRIGGER_DEBOUNCE_MS    50
 
 //==================== Application modes ====================//
 
@@ -29,10 +53,23 @@
 typedef enum
 {
     SPECTRO_APP_MODE_DATA_LOG = 0,   ///< Pure data acquisition: print spectral channels
-    SPECTRO_APP_MODE_INFER_LOCAL,    ///< Run on-board ML model (e.g. Nano 33 BLE Sense)
-    SPECTRO_APP_MODE_INFER_PC        ///< Send data to host PC, wait for inference result
+    SPECTRO_APP_MODE_INFER_LOCAL,    ///< Run on-board nearest-centroid classifier
+    SPECTRO_APP_MODE_INFER_PC,       ///< Send data to host PC, pipelined inference results
+    SPECTRO_APP_MODE_UNMIX,          ///< Blend proportions by NNLS spectral unmixing
+    SPECTRO_APP_MODE_CONC_REG,       ///< Continuous concentration (%) regression
+    SPECTRO_APP_MODE_INFER_MODEL,    ///< Uploaded juice + concentration model package
+    SPECTRO_APP_MODE_PROGRESSIVE     ///< Low-precision preview, then high-precision refinement
 } SpectroAppMode_t;
 
+/**
+ * @brief Concentration regression model selection
+ */
+typedef enum
+{
+    SPECTRO_CONC_MODEL_LINEAR = 0,   ///< Per-juice Beer-Lambert ridge fit on selected bands
+    SPECTRO_CONC_MODEL_RIDGE         ///< Ridge over all bands + juice one-hot
+} SpectroConcModel_t;
+
 typedef enum
 {
     SPECTRO_PRECISION_LOW = 0,     
@@ -40,6 +77,46 @@ typedef enum
     SPECTRO_PRECISION_HIGH         
 } SpectroPrecisionMode_t;
 
+/**
+ * @brief Encoding of the DATA_LOG / INFER_PC measurement stream
+ */
+typedef enum
+{
+    SPECTRO_OUTPUT_TEXT = 0,   ///< "SORTED(405-855nm): ..." / "MEAS,..." lines
+    SPECTRO_OUTPUT_BINARY,     ///< COBS + CRC-16 frames (spectro_frame.h)
+    SPECTRO_OUTPUT_DELTA       ///< binary keyframes + delta frames (spectro_delta.h)
+} SpectroOutputFormat_t;
+
+/**
+ * @brief Hot standby: acquisition waits for a trigger (STANDBY command)
+ */
+typedef enum
+{
+    SPECTRO_STANDBY_OFF = 0,   ///< free-running (START / STOP)
+    SPECTRO_STANDBY_HOT,       ///< sensor powered and configured, not integrating
+    SPECTRO_STANDBY_PRE        ///< sensor integrating, frames read but not processed
+} SpectroStandby_t;
+
+typedef enum
+{
+    SPECTRO_TRIGGER_COMMAND = 0,   ///< TRIGGER (USB or BLE)
+    SPECTRO_TRIGGER_BUTTON,        ///< SPECTRO_APP_TRIGGER_PIN pulled low
+    SPECTRO_TRIGGER_THRESHOLD      ///< channel left the STANDBY THRESHOLD window
+} SpectroTrigger_t;
+
+/**
+ * @brief Runtime acquisition settings (serial commands, see spectro_cmd.h)
+ */
+typedef struct
+{
+    SpectroAppMode_t       mode;
+    SpectroPrecisionMode_t precision;
+    int8_t                 gain;          ///< AS7343_Gain_t or SPECTRO_APP_GAIN_AUTO
+    uint8_t                average;       ///< frames averaged into one (1..SPECTRO_APP_MAX_AVERAGE)
+    uint16_t               channelMask;   ///< sorted channels reported by DATA_LOG, bit i = channel i
+    bool                   running;       ///< false: acquisition stopped, commands still served
+} SpectroAppConfig_t;
+
 //==================== Measurement container ====================//
 
 /**
@@ -48,11 +125,14 @@ typedef enum
  * @details
  *  - raw[0..17]   : 18 hardware channels as read from device
  *  - sorted[0..11]: 12 spectral channels sorted by wavelength (405 → 855nm)
+ *  - timestampUs  : micros() at the end of the integration (last frame
+ *                   of an AVG group)
  */
 typedef struct
 {
     uint16_t raw[AS7343_NUM_CHANNELS];
     uint16_t sorted[AS7343_NUM_SORTED_CHANNELS];
+    uint32_t timestampUs;
 } SpectroMeasurement_t;
 
 //==================== Public API ====================//
@@ -82,6 +162,123 @@ void spectro_app_set_precision_mode(SpectroPrecisionMode_t prec);
  */
 SpectroPrecisionMode_t spectro_app_get_precision_mode(void);
 
+/**
+ * @brief Select text, binary or delta-compressed binary output for the
+ *        DATA_LOG / INFER_PC stream.
+ *
+ * @note Replies and other modes stay text; binary frames are delimited by
+ *       0x00, which never occurs in a text line.
+ */
+void spectro_app_set_output_format(SpectroOutputFormat_t format);
+
+/**
+ * @brief Get the measurement output format.
+ */
+SpectroOutputFormat_t spectro_app_get_output_format(void);
+
+/**
+ * @brief What the DATA_LOG stream does when the host reads too slowly.
+ *
+ * @details
+ *  - Frames wait in a SPECTRO_QUEUE_DEPTH queue until the USB port has
+ *    room; on overflow they are dropped (oldest / newest) or merged
+ *    into running averages, acquisition never waits
+ *  - The next frame sent reports the loss: text lines end with
+ *    ";merged=<n>;dropped=<n>", binary frames carry both fields
+ */
+void spectro_app_set_queue_policy(SpectroQueuePolicy_t policy);
+SpectroQueuePolicy_t spectro_app_get_queue_policy(void);
+
+/**
+ * @brief Print "QUEUE,<policy>,<queued>,<max queued>,<pushed>,<dropped>,<merged>".
+ */
+void spectro_app_queue_stats(void);
+
+/**
+ * @brief Frames between keyframes of FORMAT delta (1 = keyframes only).
+ */
+void spectro_app_set_key_interval(uint8_t frames);
+
+/**
+ * @brief Print "DELTA,<key interval>,<frames>,<keyframes>,<raw bytes>,
+ *        <coded bytes>,<ratio>": compression of FORMAT delta so far,
+ *        ratio = plain binary bytes / bytes sent.
+ */
+void spectro_app_delta_stats(void);
+
+/**
+ * @brief Send the stream header before the next measurement.
+ *
+ * @details
+ *  - The header describes every following frame: firmware version,
+ *    sensor ID, wavelength table, channel mask, gain, integration
+ *    time, averaging and units. Text: "HDR,<epoch>,<fw>,0x<id>,<rev>,
+ *    <units>,<precision>,<gain>,<atime>,<astep>,<avg>,<t_int us>,
+ *    0x<mask>,<nm;nm;...>", binary: a SPECTRO_FRAME_TYPE_HEADER frame
+ *  - Any settings change starts a new epoch; its header is sent on
+ *    the DATA channel ahead of the first frame of the epoch, and
+ *    binary frames carry the epoch ID
+ *  - Also repeated on connect (DTR), on SUB and on FORMAT
+ */
+void spectro_app_resend_header(void);
+
+/**
+ * @brief Send the header of the current settings now (HEADER command),
+ *        in any mode.
+ */
+void spectro_app_print_header(void);
+
+/**
+ * @brief Print "READY,<fw>,0x<sensor id>,<rev>,<uptime ms>,<mode>,
+ *        <precision>,<gain>,<avg>,0x<mask>,<RUN|STOP>,<format>".
+ *
+ * @details
+ *  - Sent once the sensor is initialised (from setup()), when a host
+ *    opens the port (DTR) and in reply to PING, so host tools wait
+ *    for it instead of sleeping after opening the port
+ *  - Commands are served from the first READY on
+ */
+void spectro_app_print_ready(void);
+
+/**
+ * @brief Current settings, including changes not applied yet.
+ */
+void spectro_app_get_config(SpectroAppConfig_t *cfg);
+
+/**
+ * @brief Request new settings; applied before the next frame.
+ *
+ * @details
+ *  - Safe to call from the command poll inside the AS7343 idle
+ *    callback: the sensor is only reconfigured between frames
+ *  - Once applied, the settings are echoed as a CONFIG line
+ *
+ * @return false if a value is out of range (nothing is changed)
+ */
+bool spectro_app_request_config(const SpectroAppConfig_t *cfg);
+
+/**
+ * @brief Print "CONFIG,<mode>,<precision>,<gain>,<avg>,<mask hex>,
+ *        <RUN|STOP>,<text|binary|delta>,<latency ms>,<queue policy>".
+ */
+void spectro_app_print_config(void);
+
+/**
+ * @brief Command name of a mode ("log", "local", ...), NULL if invalid.
+ */
+const char *spectro_app_mode_name(SpectroAppMode_t mode);
+
+/**
+ * @brief Gain name ("16x", "auto"), NULL if invalid.
+ */
+const char *spectro_app_gain_name(int8_t gain);
+
+/**
+ * @brief Mode from its command name or number.
+ * @return false if unknown
+ */
+bool spectro_app_mode_from_name(const char *name, SpectroAppMode_t *mode);
+
 /**
  * @brief Acquire one measurement from AS7343.
  *
@@ -94,14 +291,290 @@ bool spectro_app_acquire(SpectroMeasurement_t *meas);
  * @brief Perform one high-level application step.
  *
  * @details
- *  - Acquires one measurement from the sensor.
+ *  - Applies settings requested over serial since the last frame.
+ *  - Acquires one measurement from the sensor (averaged over AVG
+ *    frames); does nothing but serve commands while stopped.
  *  - Dispatches processing depending on current mode:
- *      * DATA_LOG     : print channels via Serial
- *      * INFER_LOCAL  : run on-board model (TODO stub)
- *      * INFER_PC     : send to PC and read back result (TODO stub)
+ *      * DATA_LOG     : print channels via Serial (text or binary frame)
+ *      * INFER_LOCAL  : classify with the on-board centroid model
+ *      * INFER_PC     : send to PC, replies arrive asynchronously
+ *      * UNMIX        : solve blend proportions against stored endmembers
+ *      * CONC_REG     : estimate the juice percentage with uncertainty
+ *      * INFER_MODEL  : run the model package from the active flash slot
+ *      * PROGRESSIVE  : quick preview frame, then refine until stable
+ *  - Feeds the frame to the centroid learner while a LEARN is armed.
+ *  - Runs a requested MEASURE batch instead, also while stopped.
+ *  - In hot standby only waits for a trigger (spectro_app_standby).
  *
  *  - Intended to be called from loop().
  */
 void spectro_app_run_once(void);
 
+//==================== On-device learning ====================//
+
+/**
+ * @brief Arm enrolment: the next frames update the class centroid.
+ *
+ * @param label   Class label (created if new, < SPECTRO_CENTROID_LABEL_LEN chars)
+ * @param frames  Number of frames to enrol (1..SPECTRO_APP_LEARN_MAX_FRAMES)
+ * @return true if accepted
+ *
+ * @note The model is saved to flash once the last frame is enrolled.
+ */
+bool spectro_app_learn_start(const char *label, uint16_t frames);
+
+/**
+ * @brief Remove an enrolled class; the model is saved before the next frame.
+ * @return true if the class existed
+ */
+bool spectro_app_learn_forget(const char *label);
+
+/**
+ * @brief Print enrolled classes and frame counts over Serial.
+ */
+void spectro_app_learn_list(void);
+
+//==================== Spectral unmixing ====================//
+
+/**
+ * @brief Record the next frame as the blank reference I0 (saved to flash).
+ */
+void spectro_app_unmix_capture_blank(void);
+
+/**
+ * @brief Record the absorbance of the next frame as an endmember (saved to flash).
+ *
+ * @param name  Endmember name: "apple", "grape", "orange" or "water"
+ * @return false if the name is unknown or no blank has been recorded
+ */
+bool spectro_app_unmix_capture_endmember(const char *name);
+
+//==================== Concentration regression ====================//
+
+/**
+ * @brief Select the juice type used by the concentration regression.
+ *
+ * @param name  Juice name of the exported model, or "auto" to take it
+ *              from the on-device centroid classifier
+ * @return false if the name is unknown
+ */
+bool spectro_app_conc_set_juice(const char *name);
+
+/**
+ * @brief Select the concentration regression model.
+ * @return false if the model was not exported
+ */
+bool spectro_app_conc_set_model(SpectroConcModel_t model);
+
+//==================== Model package hot-swap ====================//
+
+/**
+ * @brief Start a model package upload into the inactive flash slot.
+ *
+ * @param size  Package size in bytes
+ * @param crc   CRC-32 of the whole package
+ * @return false if the package does not fit
+ */
+bool spectro_app_model_begin(uint32_t size, uint32_t crc);
+
+/**
+ * @brief Write the next chunk of the upload.
+ *
+ * @param offset  Byte offset, chunks must arrive in order
+ * @param data    Chunk bytes
+ * @param len     Chunk length (<= SPECTRO_SLOT_CHUNK_MAX)
+ * @return false if the chunk was rejected (wrong offset, flash error,
+ *         page not erased yet)
+ */
+bool spectro_app_model_data(uint32_t offset, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief The flash page of a chunk is erased (between frames, one page
+ *        ahead of the upload); if not, the host resends it later.
+ */
+bool spectro_app_model_ready(uint32_t offset, uint32_t len);
+
+/**
+ * @brief Verify the uploaded package and switch to it.
+ *
+ * @note The running model stays active if verification fails.
+ */
+bool spectro_app_model_commit(void);
+
+/**
+ * @brief Cancel the upload in progress.
+ */
+void spectro_app_model_abort(void);
+
+/**
+ * @brief Next offset expected by the upload.
+ */
+uint32_t spectro_app_model_next_offset(void);
+
+/**
+ * @brief Print the active model package over Serial.
+ */
+void spectro_app_model_info(void);
+
+//==================== PC inference pipeline ====================//
+
+/**
+ * @brief Handle a PC reply "RES,<seq>,<result>" (text after "RES,").
+ *
+ * @details
+ *  - Matched replies update the latest result, are echoed as
+ *    "PCRES,<seq>,<rtt ms>,<result>" and shown on the OLED
+ *  - Late replies (timed out, duplicate, unknown) are only counted
+ *
+ * @return false if the line is malformed
+ */
+bool spectro_app_pc_response(const char *text);
+
+/**
+ * @brief Outstanding request window (1..SPECTRO_PC_MAX_WINDOW) and timeout.
+ * @note 0 keeps the current value.
+ */
+bool spectro_app_pc_configure(uint8_t window, uint16_t timeoutMs);
+
+/**
+ * @brief Print "PCSTAT,<sent>,<replied>,<late>,<timeouts>,<skipped>,
+ *        <in flight>,<avg rtt ms>,<max rtt ms>,<window>,<timeout ms>".
+ */
+void spectro_app_pc_stats(void);
+
+//==================== Batch measurement ====================//
+
+/**
+ * @brief Request a batch of back-to-back frames (MEASURE command).
+ *
+ * @details
+ *  - Runs at the start of the next spectro_app_run_once(): the sensor
+ *    is set to prec, one frame is discarded so the batch starts on a
+ *    frame boundary, then frames are read back-to-back; no frame is
+ *    processed or sent in between (AVG does not apply)
+ *  - The previous precision is restored afterwards
+ *  - Reply on the CONTROL channel:
+ *      "BATCH,<label>,<frames>,<mean|median>,<prec>,<duration us>,
+ *       <period us>,<jitter us>,<end us>"
+ *      "BATCHVAL,v0,...,v11"  mean or median counts
+ *      "BATCHVAR,v0,...,v11"  sample variance per channel
+ *    or "BATCHERR,<frames read>" if the sensor failed
+ *
+ * @param frames  Frames in the batch (1..SPECTRO_BATCH_MAX_FRAMES)
+ * @param prec    Precision of the batch
+ * @param agg     Mean or median
+ * @param label   Echoed in the reply (< SPECTRO_APP_MEASURE_LABEL_LEN
+ *                chars, no ',')
+ * @return false if a value is invalid or a batch is already running
+ */
+bool spectro_app_measure_start(uint8_t frames, SpectroPrecisionMode_t prec,
+                               SpectroBatchAgg_t agg, const char *label);
+
+//==================== Register scripts ====================//
+
+/**
+ * @brief Start a register script upload (SCRIPT BEGIN).
+ *
+ * @param size  Program size in bytes (1..SPECTRO_SCRIPT_MAX_SIZE)
+ * @return false if it does not fit or a script is running
+ */
+bool spectro_app_script_begin(uint16_t size);
+
+/**
+ * @brief Store the next chunk of the upload (SCRIPT DATA).
+ * @return false on a wrong offset or a chunk beyond the announced size
+ */
+bool spectro_app_script_data(uint16_t offset, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Next offset expected by the upload.
+ */
+uint16_t spectro_app_script_next_offset(void);
+
+/**
+ * @brief Run the uploaded script (SCRIPT RUN).
+ *
+ * @details
+ *  - Runs at the start of the next spectro_app_run_once(), like a
+ *    MEASURE batch, with the bus at SPECTRO_APP_SCRIPT_I2C_HZ; the
+ *    script stays loaded and can be run again
+ *  - Output on the RESULT channel:
+ *      "SCRIPT,REC,<record>,<us>,<hex>"  one per EMIT, micros() at
+ *                                        the EMIT
+ *      "SCRIPT,END,<ok|format|io|timeout|record|aborted>,<pc>,
+ *       <records>,<ops>,<duration us>"
+ *    a malformed script ends with "format" right away
+ *  - Records wait for room on RESULT (commands are still served), so
+ *    a slow host throttles the script instead of losing records
+ *  - Afterwards the driver defaults are written again and the mode's
+ *    precision restored
+ *
+ * @return false if no complete script is loaded, or one is running
+ */
+bool spectro_app_script_run(void);
+
+/**
+ * @brief Stop a running script (it ends "aborted") and drop the upload.
+ */
+void spectro_app_script_abort(void);
+
+//==================== Hot standby ====================//
+
+/**
+ * @brief Wait for a trigger instead of free-running (STANDBY command).
+ *
+ * @details
+ *  - HOT: the sensor stays powered and configured with SP_EN off, so
+ *    there is no integration and no bus traffic while waiting; a
+ *    trigger starts a new frame, which begins after the trigger.
+ *    Latency about one integration time
+ *  - PRE: the sensor keeps integrating and frames are read but neither
+ *    processed nor sent; the result starts with the first frame that
+ *    ends after the trigger (it may have begun before). Latency about
+ *    half an integration time on average. Only PRE checks the
+ *    threshold
+ *  - A trigger produces one result of the current mode: AVG frames,
+ *    or a full preview + refinement cycle in PROGRESSIVE; it is sent
+ *    at once, followed on the RESULT channel by
+ *      "TRIG,<n>,<command|button|threshold>,<hot|pre>,<trigger us>,
+ *       <end of integration us>,<latency us>"
+ *    latency = trigger to the result handed to the host link
+ *  - Triggers while a result is being measured are ignored (counted)
+ *  - OFF returns to START / STOP; MEASURE and SCRIPT still run
+ *  - Safe from the AS7343 idle callback: SP_EN is only switched
+ *    between frames
+ *
+ * @return false if the mode is invalid
+ */
+bool spectro_app_standby(SpectroStandby_t mode);
+
+/**
+ * @brief Threshold trigger of PRE standby.
+ *
+ * @details
+ *  - Fires when sorted channel ch leaves [low, high] after having been
+ *    inside, e.g. the 640 nm counts dropping as a cuvette blocks the
+ *    beam; the frame that crossed is not used, the next one is
+ *
+ * @param channel  Sorted channel 0..11, -1 = off
+ * @return false if a value is out of range
+ */
+bool spectro_app_standby_threshold(int8_t channel, uint16_t low, uint16_t high);
+
+/**
+ * @brief Trigger a standby measurement.
+ *
+ * @param source  What fired
+ * @param us      micros() of the event (command line arrival, button edge)
+ * @return false if not in standby or a trigger is already being served
+ */
+bool spectro_app_trigger(SpectroTrigger_t source, uint32_t us);
+
+/**
+ * @brief Print "STANDBY,<off|hot|pre>,<threshold ch|->,<low>,<high>,
+ *        <triggers>,<ignored>,<last us>,<min us>,<mean us>,<max us>"
+ *        (latencies since the standby mode was set).
+ */
+void spectro_app_standby_stats(void);
+
 #endif // SPECTRO_APP_H
@@ -0,0 +1,204 @@
+/********************************************************
+ * @file        	spectro_ble.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	BLE transport (Nordic UART service) for output and commands
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_ble.h"
+#include "spectro_ble_link.h"
+
+#if SPECTRO_BLE_ENABLE
+
+#include <ArduinoBLE.h>
+
+#define SPECTRO_BLE_SERVICE_UUID   "6E400001-B5A3-F393-E0A9-E50E24DCCA9E"
+#define SPECTRO_BLE_RX_UUID        "6E400002-B5A3-F393-E0A9-E50E24DCCA9E"
+#define SPECTRO_BLE_TX_UUID        "6E400003-B5A3-F393-E0A9-E50E24DCCA9E"
+
+//==================== Static state ====================//
+
+static BLEService s_service(SPECTRO_BLE_SERVICE_UUID);
+static BLECharacteristic s_tx(SPECTRO_BLE_TX_UUID, BLENotify, SPECTRO_BLE_MAX_PAYLOAD);
+static BLECharacteristic s_rx(SPECTRO_BLE_RX_UUID, BLEWrite | BLEWriteWithoutResponse, SPECTRO_BLE_MAX_PAYLOAD);
+
+static SpectroBleLink_t s_link;
+static bool s_started = false;
+static bool s_connected = false;
+static uint16_t s_mtu = SPECTRO_BLE_MIN_MTU;
+static uint32_t s_intervalUs = SPECTRO_BLE_INTERVAL_MAX * 1250UL;
+
+static uint8_t s_rxBuf[SPECTRO_BLE_RX_BUFFER];
+static uint16_t s_rxHead = 0;
+static uint16_t s_rxLen = 0;
+
+//==================== Internal helpers ====================//
+
+static bool spectro_ble_notify(void *ctx, const uint8_t *data, size_t len)
+{
+    (void)ctx;
+    return s_tx.writeValue(data, (int)len) != 0;
+}
+
+/**
+ * @brief RX write from the central: keep the bytes for spectro_cmd_poll()
+ */
+static void spectro_ble_on_rx(BLEDevice central, BLECharacteristic ch)
+{
+    (void)central;
+    const uint8_t *data = ch.value();
+    int len = ch.valueLength();
+
+    for (int i = 0; (i < len) && (s_rxLen < SPECTRO_BLE_RX_BUFFER); i++)
+    {
+        s_rxBuf[(s_rxHead + s_rxLen) % SPECTRO_BLE_RX_BUFFER] = data[i];
+        s_rxLen++;
+    }
+}
+
+//==================== Public API implementation ====================//
+
+bool spectro_ble_init(void)
+{
+    const SpectroBleLinkIo_t io = { spectro_ble_notify, NULL };
+    spectro_ble_link_init(&s_link, &io);
+
+    if (!BLE.begin())
+        return false;
+
+    char name[16];
+    snprintf(name, sizeof(name), "Spectro-%04X", (unsigned)(NRF_FICR->DEVICEADDR[0] & 0xFFFF));
+    BLE.setLocalName(name);
+    BLE.setDeviceName(name);
+    BLE.setConnectionInterval(SPECTRO_BLE_INTERVAL_MIN, SPECTRO_BLE_INTERVAL_MAX);
+    BLE.setAdvertisedService(s_service);
+    s_service.addCharacteristic(s_tx);
+    s_service.addCharacteristic(s_rx);
+    BLE.addService(s_service);
+    s_rx.setEventHandler(BLEWritten, spectro_ble_on_rx);
+    BLE.advertise();
+
+    s_started = true;
+    return true;
+}
+
+void spectro_ble_poll(void)
+{
+    if (!s_started)
+        return;
+
+    BLE.poll();
+
+    bool active = BLE.connected() && s_tx.subscribed();
+    if (active && !s_connected)
+    {
+        s_mtu = SPECTRO_BLE_MIN_MTU;
+        s_intervalUs = SPECTRO_BLE_INTERVAL_MAX * 1250UL;
+        spectro_ble_link_connect(&s_link, micros(), s_mtu, s_intervalUs, SPECTRO_BLE_DEFAULT_PER_EVENT);
+    }
+    else if (!active && s_connected)
+    {
+        spectro_ble_link_disconnect(&s_link);
+        s_rxLen = 0;
+    }
+    s_connected = active;
+
+    spectro_ble_link_poll(&s_link, micros());
+}
+
+bool spectro_ble_active(void)
+{
+    return s_connected;
+}
+
+size_t spectro_ble_space(void)
+{
+    return spectro_ble_link_space(&s_link);
+}
+
+bool spectro_ble_write(const uint8_t *data, size_t len)
+{
+    return spectro_ble_link_write(&s_link, data, len);
+}
+
+void spectro_ble_flush(void)
+{
+    spectro_ble_link_flush(&s_link, micros());
+}
+
+int spectro_ble_read(void)
+{
+    if (s_rxLen == 0)
+        return -1;
+
+    int c = s_rxBuf[s_rxHead];
+    s_rxHead = (uint16_t)((s_rxHead + 1) % SPECTRO_BLE_RX_BUFFER);
+    s_rxLen--;
+    return c;
+}
+
+bool spectro_ble_set_link(uint16_t mtu, uint16_t intervalMs)
+{
+    if (!s_connected || (mtu < SPECTRO_BLE_MIN_MTU) || (mtu > SPECTRO_BLE_MAX_MTU))
+        return false;
+    if ((intervalMs != 0) && ((intervalMs < SPECTRO_BLE_LINK_MIN_MS) || (intervalMs > SPECTRO_BLE_LINK_MAX_MS)))
+        return false;
+
+    s_mtu = mtu;
+    if (intervalMs > 0)
+        s_intervalUs = (uint32_t)intervalMs * 1000UL;
+    spectro_ble_link_update(&s_link, s_mtu, s_intervalUs);
+    return true;
+}
+
+void spectro_ble_stats_line(SpectroLine_t *line)
+{
+    const SpectroBleLinkStats_t *st = &s_link.stats;
+
+    spectro_line_init(line);
+    spectro_line_str(line, "BLE,");
+    if (!s_started)
+        spectro_line_str(line, "off");
+    else if (s_connected)
+        spectro_line_str(line, "streaming");
+    else
+        spectro_line_str(line, BLE.connected() ? "connected" : "idle");
+    spectro_line_char(line, ',');
+    spectro_line_u16(line, s_mtu);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, s_intervalUs);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st->bytes);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st->notifications);
+    spectro_line_char(line, ',');
+    spectro_line_fixed(line, (st->notifications > 0) ? 100.0f * (float)st->fullNotifications / (float)st->notifications : 0.0f, 1);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st->events);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st->stalls);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st->refused);
+}
+
+#else // !SPECTRO_BLE_ENABLE
+
+bool spectro_ble_init(void) { return false; }
+void spectro_ble_poll(void) {}
+bool spectro_ble_active(void) { return false; }
+size_t spectro_ble_space(void) { return 0; }
+bool spectro_ble_write(const uint8_t *data, size_t len) { (void)data; (void)len; return false; }
+void spectro_ble_flush(void) {}
+int spectro_ble_read(void) { return -1; }
+bool spectro_ble_set_link(uint16_t mtu, uint16_t intervalMs) { (void)mtu; (void)intervalMs; return false; }
+
+void spectro_ble_stats_line(SpectroLine_t *line)
+{
+    spectro_line_init(line);
+    spectro_line_str(line, "BLE,off,0,0,0,0,0.0,0,0,0");
+}
+
+#endif // SPECTRO_BLE_ENABLE
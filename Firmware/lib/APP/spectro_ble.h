@@ -0,0 +1,87 @@
+/********************************************************
+ * @file        	spectro_ble.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	BLE transport (Nordic UART service) for output and commands
+ *
+ * @details
+ *  - Advertises as "Spectro-<id>" with the Nordic UART service, so any
+ *    UART-over-BLE client works:
+ *      * TX 6E400003-... notify : the output stream, the same bytes as
+ *                                 on USB (text lines, binary frames)
+ *      * RX 6E400002-... write  : command lines, as typed on Serial
+ *  - While a central is subscribed to TX, spectro_mux sends to BLE
+ *    instead of USB; packing into notifications and the per-interval
+ *    schedule are in spectro_ble_link (Arduino-free)
+ *  - The stack does not report the negotiated MTU and connection
+ *    interval; the central sends them with "BLE LINK <mtu> <ms>"
+ *    (PC/ble_stream.py does), until then 23 bytes and the interval
+ *    requested at connection are assumed
+ *  - Received bytes are buffered here and read by spectro_cmd_poll(),
+ *    never executed from inside the stack's callbacks
+ *  - SPECTRO_BLE_ENABLE 0 builds stubs (no ArduinoBLE, no radio)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_BLE_H
+#define SPECTRO_BLE_H
+
+#include <Arduino.h>
+#include "spectro_format.h"
+
+#ifndef SPECTRO_BLE_ENABLE
+#define SPECTRO_BLE_ENABLE          1
+#endif
+
+#define SPECTRO_BLE_INTERVAL_MIN    6      // 1.25 ms units: 7.5 ms
+#define SPECTRO_BLE_INTERVAL_MAX    12     // 15 ms
+#define SPECTRO_BLE_LINK_MIN_MS     8      // BLE LINK interval: 7.5 ms rounded up
+#define SPECTRO_BLE_LINK_MAX_MS     4000   // 4 s, the spec maximum
+#define SPECTRO_BLE_RX_BUFFER       256    // received command bytes
+
+//==================== Public API ====================//
+
+/**
+ * @brief Start the radio and advertise.
+ * @return false if the BLE stack did not start (USB keeps working)
+ */
+bool spectro_ble_init(void);
+
+/**
+ * @brief Run the stack and the notification schedule. Cheap, call often.
+ */
+void spectro_ble_poll(void);
+
+/**
+ * @brief A central is connected and subscribed to the output stream.
+ */
+bool spectro_ble_active(void);
+
+/**
+ * @brief Output path used by spectro_mux while spectro_ble_active().
+ */
+size_t spectro_ble_space(void);
+bool spectro_ble_write(const uint8_t *data, size_t len);
+void spectro_ble_flush(void);
+
+/**
+ * @brief Next received command byte, -1 if none (like Serial.read()).
+ */
+int spectro_ble_read(void);
+
+/**
+ * @brief Link parameters reported by the central (BLE LINK).
+ * @param mtu         SPECTRO_BLE_MIN_MTU..SPECTRO_BLE_MAX_MTU
+ * @param intervalMs  SPECTRO_BLE_LINK_MIN_MS..SPECTRO_BLE_LINK_MAX_MS, 0 keeps the current one
+ */
+bool spectro_ble_set_link(uint16_t mtu, uint16_t intervalMs);
+
+/**
+ * @brief Render "BLE,<off|idle|connected|streaming>,<mtu>,<interval us>,
+ *        <bytes>,<notifications>,<full %>,<events>,<stalls>,<refused>".
+ */
+void spectro_ble_stats_line(SpectroLine_t *line);
+
+#endif // SPECTRO_BLE_H
@@ -0,0 +1,931 @@
+/********************************************************
+ * @file        	spectro_cmd.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Serial command interface of the spectrophotometer
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_cmd.h"
+#include "spectro_app.h"
+#include "spectro_model_slot.h"
+#include "spectro_out.h"
+#include "spectro_pc.h"
+#include "spectro_mux.h"
+#include "spectro_ble.h"
+#include "spectro_ble_link.h"
+#include "oled_ssd1306.h"
+
+//==================== Static state ====================//
+
+/**
+ * @brief Partial line of one transport: USB and BLE bytes never mix
+ */
+typedef struct
+{
+    char    buf[SPECTRO_CMD_LINE_MAX];
+    uint8_t len;
+    bool    overflow;
+} SpectroCmdLine_t;
+
+enum
+{
+    SPECTRO_CMD_SRC_USB = 0,
+    SPECTRO_CMD_SRC_BLE,
+    SPECTRO_CMD_SRC_COUNT
+};
+
+static SpectroCmdLine_t s_lines[SPECTRO_CMD_SRC_COUNT];
+static uint32_t s_lineRxUs = 0;   // micros() when the '\n' of the current line arrived
+
+//==================== Internal helpers ====================//
+
+/**
+ * @brief Split off the next space-separated token (modifies the string).
+ */
+static char *spectro_cmd_next_token(char **cursor)
+{
+    char *p = *cursor;
+
+    while (*p == ' ')
+        p++;
+    if (*p == '\0')
+        return NULL;
+
+    char *tok = p;
+    while ((*p != ' ') && (*p != '\0'))
+        p++;
+    if (*p == ' ')
+        *p++ = '\0';
+
+    *cursor = p;
+    return tok;
+}
+
+/**
+ * @brief Parse a whole token as an unsigned number no larger than max.
+ * @return false on a missing token, trailing characters, a sign or overflow
+ */
+static bool spectro_cmd_parse_uint(const char *tok, int base, uint32_t max, uint32_t *out)
+{
+    if ((tok == NULL) || (*tok == '\0') || (*tok == '-') || (*tok == '+'))
+        return false;
+
+    char *end;
+    unsigned long v = strtoul(tok, &end, base);
+    if ((*end != '\0') || (v > max))
+        return false;
+
+    *out = (uint32_t)v;
+    return true;
+}
+
+/**
+ * @brief Decode a hex string into bytes.
+ * @return number of bytes, -1 on a malformed string or overflow
+ */
+static int spectro_cmd_hex_decode(const char *hex, uint8_t *out, int maxLen)
+{
+    int n = 0;
+
+    while ((hex[0] != '\0') && (hex[1] != '\0'))
+    {
+        int v = 0;
+        for (int k = 0; k < 2; k++)
+        {
+            char c = hex[k];
+            v <<= 4;
+            if ((c >= '0') && (c <= '9'))
+                v |= c - '0';
+            else if ((c >= 'a') && (c <= 'f'))
+                v |= c - 'a' + 10;
+            else if ((c >= 'A') && (c <= 'F'))
+                v |= c - 'A' + 10;
+            else
+                return -1;
+        }
+        if (n >= maxLen)
+            return -1;
+        out[n++] = (uint8_t)v;
+        hex += 2;
+    }
+    return (hex[0] == '\0') ? n : -1;
+}
+
+/*******************************************************
+ * @brief  MODEL sub-commands
+ *
+ * @details
+ *  - Every BEGIN/DATA reply carries the next expected offset:
+ *      "MODEL,ACK,<offset>" or "MODEL,ERR,<offset>"
+ *    so the host can resume from the right chunk after an error
+ *  - "MODEL,WAIT,<offset>": the flash page of the chunk is still to be
+ *    erased between frames, the host resends it a little later
+ *  - COMMIT: "MODEL,OK" then the INFO line, or "MODEL,ERR,COMMIT"
+ *******************************************************/
+static void spectro_cmd_model(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+
+    if (sub == NULL)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: MODEL BEGIN|DATA|COMMIT|ABORT|INFO"));
+        return;
+    }
+
+    if (strcmp(sub, "BEGIN") == 0)
+    {
+        char *size = spectro_cmd_next_token(&cursor);
+        char *crc = spectro_cmd_next_token(&cursor);
+        bool ok = (size != NULL) && (crc != NULL) &&
+                  spectro_app_model_begin(strtoul(size, NULL, 10), strtoul(crc, NULL, 16));
+
+        Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+        out.print(ok ? F("MODEL,ACK,") : F("MODEL,ERR,"));
+        out.println(spectro_app_model_next_offset());
+    }
+    else if (strcmp(sub, "DATA") == 0)
+    {
+        char *offset = spectro_cmd_next_token(&cursor);
+        char *hex = spectro_cmd_next_token(&cursor);
+        uint8_t chunk[SPECTRO_SLOT_CHUNK_MAX];
+        int len = (hex != NULL) ? spectro_cmd_hex_decode(hex, chunk, sizeof(chunk)) : -1;
+        uint32_t at = (offset != NULL) ? strtoul(offset, NULL, 10) : 0;
+        bool valid = (offset != NULL) && (len > 0) && (at == spectro_app_model_next_offset());
+        bool wait = valid && !spectro_app_model_ready(at, (uint32_t)len);
+        bool ok = valid && !wait && spectro_app_model_data(at, chunk, (uint32_t)len);
+
+        Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+        out.print(ok ? F("MODEL,ACK,") : (wait ? F("MODEL,WAIT,") : F("MODEL,ERR,")));
+        out.println(spectro_app_model_next_offset());
+    }
+    else if (strcmp(sub, "COMMIT") == 0)
+    {
+        if (spectro_app_model_commit())
+        {
+            spectro_mux_print(SPECTRO_MUX_CONTROL).println(F("MODEL,OK"));
+            spectro_app_model_info();
+        }
+        else
+        {
+            spectro_mux_print(SPECTRO_MUX_CONTROL).println(F("MODEL,ERR,COMMIT"));
+        }
+    }
+    else if (strcmp(sub, "ABORT") == 0)
+    {
+        spectro_app_model_abort();
+        spectro_mux_print(SPECTRO_MUX_CONTROL).println(F("MODEL,ABORTED"));
+    }
+    else if (strcmp(sub, "INFO") == 0)
+    {
+        spectro_app_model_info();
+    }
+    else
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: MODEL BEGIN|DATA|COMMIT|ABORT|INFO"));
+    }
+}
+
+/*******************************************************
+ * @brief  OUT sub-commands (batched output)
+ *******************************************************/
+static void spectro_cmd_out(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+
+    if ((sub != NULL) && (strcmp(sub, "STATS") == 0))
+    {
+        SpectroLine_t line;
+        spectro_out_stats_line(&line);
+        spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    }
+    else if ((sub != NULL) && (strcmp(sub, "FLUSH") == 0))
+    {
+        spectro_mux_flush();
+    }
+    else if ((sub != NULL) && (strcmp(sub, "LATENCY") == 0))
+    {
+        char *ms = spectro_cmd_next_token(&cursor);
+        uint32_t value = 0;
+        if (spectro_cmd_parse_uint(ms, 10, UINT16_MAX, &value))
+            spectro_out_set_latency((uint16_t)value);
+        else
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: OUT LATENCY <ms>"));
+    }
+    else
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: OUT STATS|FLUSH|LATENCY <ms>"));
+    }
+}
+
+/*******************************************************
+ * @brief  Acquisition settings: MODE, PREC, GAIN, AVG, MASK,
+ *         START, STOP
+ *
+ * @details
+ *  - Changes are collected here and applied by spectro_app before
+ *    the next frame, which then echoes the CONFIG line
+ *  - Returns false if cmd is not a settings command
+ *******************************************************/
+static bool spectro_cmd_settings(const char *cmd, char *cursor)
+{
+    SpectroAppConfig_t cfg;
+    spectro_app_get_config(&cfg);
+
+    char *arg = spectro_cmd_next_token(&cursor);
+    bool ok = true;
+
+    if (strcmp(cmd, "MODE") == 0)
+    {
+        ok = (arg != NULL) && spectro_app_mode_from_name(arg, &cfg.mode);
+        if (!ok)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: MODE log|local|pc|unmix|conc|model|progressive"));
+    }
+    else if (strcmp(cmd, "PREC") == 0)
+    {
+        if ((arg != NULL) && (strcmp(arg, "low") == 0))
+            cfg.precision = SPECTRO_PRECISION_LOW;
+        else if ((arg != NULL) && (strcmp(arg, "medium") == 0))
+            cfg.precision = SPECTRO_PRECISION_MEDIUM;
+        else if ((arg != NULL) && (strcmp(arg, "high") == 0))
+            cfg.precision = SPECTRO_PRECISION_HIGH;
+        else
+            ok = false;
+        if (!ok)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: PREC low|medium|high"));
+    }
+    else if (strcmp(cmd, "GAIN") == 0)
+    {
+        ok = false;
+        for (int8_t g = SPECTRO_APP_GAIN_AUTO; (arg != NULL) && (spectro_app_gain_name(g) != NULL); g++)
+        {
+            if (strcmp(arg, spectro_app_gain_name(g)) == 0)
+            {
+                cfg.gain = g;
+                ok = true;
+                break;
+            }
+        }
+        if (!ok)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: GAIN auto|0.5x|1x|2x|...|2048x"));
+    }
+    else if (strcmp(cmd, "AVG") == 0)
+    {
+        int n = (arg != NULL) ? atoi(arg) : 0;
+        ok = (n >= 1) && (n <= SPECTRO_APP_MAX_AVERAGE);
+        cfg.average = (uint8_t)n;
+        if (!ok)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: AVG <1..64>"));
+    }
+    else if (strcmp(cmd, "MASK") == 0)
+    {
+        uint32_t mask = 0;
+        ok = spectro_cmd_parse_uint(arg, 16, 0xFFF, &mask) && (mask != 0);
+        cfg.channelMask = (uint16_t)mask;
+        if (!ok)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: MASK <hex>, 1..FFF"));
+    }
+    else if (strcmp(cmd, "START") == 0)
+    {
+        cfg.running = true;
+    }
+    else if (strcmp(cmd, "STOP") == 0)
+    {
+        cfg.running = false;
+    }
+    else
+    {
+        return false;
+    }
+
+    // every value is range-checked above
+    if (ok && !spectro_app_request_config(&cfg))
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Settings rejected."));
+    return true;
+}
+
+/*******************************************************
+ * @brief  PC sub-commands (pipelined PC inference)
+ *******************************************************/
+static void spectro_cmd_pc(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+    char *arg = spectro_cmd_next_token(&cursor);
+
+    uint32_t value = 0;
+    bool ok = false;
+
+    if ((sub != NULL) && (strcmp(sub, "STATS") == 0))
+    {
+        spectro_app_pc_stats();
+        ok = true;
+    }
+    else if ((sub != NULL) && (strcmp(sub, "WINDOW") == 0) &&
+             spectro_cmd_parse_uint(arg, 10, SPECTRO_PC_MAX_WINDOW, &value) && (value >= 1))
+    {
+        ok = spectro_app_pc_configure((uint8_t)value, 0);
+    }
+    else if ((sub != NULL) && (strcmp(sub, "TIMEOUT") == 0) &&
+             spectro_cmd_parse_uint(arg, 10, 0xFFFF, &value) && (value >= 1))
+    {
+        ok = spectro_app_pc_configure(0, (uint16_t)value);
+    }
+
+    if (!ok)
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: PC STATS|WINDOW <1..8>|TIMEOUT <ms>"));
+}
+
+/*******************************************************
+ * @brief  QUEUE [oldest|newest|merge]: DATA_LOG overflow policy
+ *******************************************************/
+static void spectro_cmd_queue(char *cursor)
+{
+    char *name = spectro_cmd_next_token(&cursor);
+    SpectroQueuePolicy_t policy;
+
+    if (name == NULL)
+        spectro_app_queue_stats();
+    else if (spectro_queue_policy_from_name(name, &policy))
+        spectro_app_set_queue_policy(policy);
+    else
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: QUEUE [oldest|newest|merge]"));
+}
+
+/*******************************************************
+ * @brief  DELTA [KEY <n>]: FORMAT delta statistics / keyframe interval
+ *******************************************************/
+static void spectro_cmd_delta(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+    char *n = spectro_cmd_next_token(&cursor);
+
+    if (sub == NULL)
+        spectro_app_delta_stats();
+    else if ((strcmp(sub, "KEY") == 0) && (n != NULL) && (atoi(n) >= 1) && (atoi(n) <= 255))
+        spectro_app_set_key_interval((uint8_t)atoi(n));
+    else
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: DELTA [KEY <1..255>]"));
+}
+
+/*******************************************************
+ * @brief  SUB [ch,ch,...|all]: output channels the host receives
+ *******************************************************/
+static void spectro_cmd_sub(char *cursor)
+{
+    char *list = spectro_cmd_next_token(&cursor);
+    uint8_t mask = 0;
+    bool ok = true;
+
+    if ((list != NULL) && (strcmp(list, "all") == 0))
+    {
+        mask = SPECTRO_MUX_ALL;
+    }
+    else if (list != NULL)
+    {
+        for (char *name = strtok(list, ","); ok && (name != NULL); name = strtok(NULL, ","))
+        {
+            SpectroMuxChannel_t ch;
+            ok = spectro_mux_from_name(name, &ch);
+            if (ok)
+                mask |= (uint8_t)(1U << ch);
+        }
+    }
+
+    if (!ok)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: SUB data,result,log,control|all"));
+        return;
+    }
+    if (list != NULL)
+    {
+        spectro_mux_subscribe(mask);
+        spectro_app_resend_header();   // a new reader of DATA needs the stream description
+    }
+
+    // "SUB,<name>,..." of the channels now subscribed
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "SUB");
+    for (int ch = 0; ch < SPECTRO_MUX_NUM_CHANNELS; ch++)
+    {
+        if (spectro_mux_subscribed() & (1U << ch))
+        {
+            spectro_line_char(&line, ',');
+            spectro_line_str(&line, spectro_mux_name((SpectroMuxChannel_t)ch));
+        }
+    }
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+}
+
+/*******************************************************
+ * @brief  MUX [PRIO <ch> <n>|RATE <ch> <bytes/s>]: channel scheduling
+ *******************************************************/
+static void spectro_cmd_mux(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+    char *name = spectro_cmd_next_token(&cursor);
+    char *arg = spectro_cmd_next_token(&cursor);
+
+    SpectroMuxChannel_t ch = SPECTRO_MUX_DATA;
+    long value = (arg != NULL) ? atol(arg) : -1;
+    bool ok = (name != NULL) && spectro_mux_from_name(name, &ch);
+
+    if (sub == NULL)
+        spectro_mux_print_stats();
+    else if (ok && (strcmp(sub, "PRIO") == 0) && (value >= 0) && (value <= 255))
+        spectro_mux_set_priority(ch, (uint8_t)value);
+    else if (ok && (strcmp(sub, "RATE") == 0) && (value >= 0) && (value <= 0xFFFF))
+        spectro_mux_set_rate(ch, (uint16_t)value);
+    else
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: MUX [PRIO <ch> <0..255>|RATE <ch> <bytes/s>]"));
+}
+
+/*******************************************************
+ * @brief  MEASURE [n=..] [prec=..] [avg=..] [label=..]: batch measurement
+ *
+ * @details
+ *  - key=value arguments in any order; defaults: n=5, the current
+ *    precision, avg=mean, label=-
+ *  - The reply comes from spectro_app once the batch has run
+ *******************************************************/
+static void spectro_cmd_measure(char *cursor)
+{
+    SpectroAppConfig_t cfg;
+    spectro_app_get_config(&cfg);
+
+    int frames = SPECTRO_APP_MEASURE_DEFAULT_FRAMES;
+    SpectroPrecisionMode_t prec = cfg.precision;
+    SpectroBatchAgg_t agg = SPECTRO_BATCH_MEAN;
+    const char *label = "-";
+    bool ok = true;
+
+    for (char *arg = spectro_cmd_next_token(&cursor); ok && (arg != NULL); arg = spectro_cmd_next_token(&cursor))
+    {
+        char *value = strchr(arg, '=');
+        if (value == NULL)
+        {
+            ok = false;
+            break;
+        }
+        *value++ = '\0';
+
+        if (strcmp(arg, "n") == 0)
+        {
+            frames = atoi(value);
+        }
+        else if (strcmp(arg, "prec") == 0)
+        {
+            if (strcmp(value, "low") == 0)
+                prec = SPECTRO_PRECISION_LOW;
+            else if (strcmp(value, "medium") == 0)
+                prec = SPECTRO_PRECISION_MEDIUM;
+            else if (strcmp(value, "high") == 0)
+                prec = SPECTRO_PRECISION_HIGH;
+            else
+                ok = false;
+        }
+        else if (strcmp(arg, "avg") == 0)
+        {
+            ok = spectro_batch_agg_from_name(value, &agg);
+        }
+        else if (strcmp(arg, "label") == 0)
+        {
+            label = value;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    ok = ok && (frames >= 1) && (frames <= SPECTRO_BATCH_MAX_FRAMES) &&
+         spectro_app_measure_start((uint8_t)frames, prec, agg, label);
+    if (!ok)
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: MEASURE [n=<1..64>] [prec=low|medium|high] [avg=mean|median] [label=<text>], one at a time"));
+}
+
+/*******************************************************
+ * @brief  SYNC <token>: one NTP-style clock sync exchange
+ *
+ * @details
+ *  - Reply "SYNC,<token>,<rx us>,<tx us>": micros() when the line
+ *    arrived and just before the reply is queued and flushed
+ *  - With the host send/receive times t0, t3 this gives
+ *    offset = ((rx - t0) + (tx - t3)) / 2 and
+ *    round trip = (t3 - t0) - (tx - rx), see PC/clock_sync.py
+ *******************************************************/
+static void spectro_cmd_sync(char *cursor)
+{
+    char *token = spectro_cmd_next_token(&cursor);
+
+    if (token == NULL)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: SYNC <token>"));
+        return;
+    }
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "SYNC,");
+    spectro_line_u32(&line, strtoul(token, NULL, 10));
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, s_lineRxUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, micros());
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+/*******************************************************
+ * @brief  SCRIPT sub-commands (register scripts)
+ *
+ * @details
+ *  - BEGIN/DATA reply "SCRIPT,ACK,<offset>" or "SCRIPT,ERR,<offset>"
+ *    with the next expected offset, as MODEL does
+ *  - RUN replies "SCRIPT,RUN,<size>"; records and the END line follow
+ *    on the RESULT channel (spectro_app_script_run)
+ *******************************************************/
+static void spectro_cmd_script(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+    Print &out = spectro_mux_print(SPECTRO_MUX_CONTROL);
+
+    if ((sub != NULL) && (strcmp(sub, "BEGIN") == 0))
+    {
+        char *size = spectro_cmd_next_token(&cursor);
+        uint32_t n = 0;
+        bool ok = spectro_cmd_parse_uint(size, 10, UINT16_MAX, &n) && spectro_app_script_begin((uint16_t)n);
+
+        out.print(ok ? F("SCRIPT,ACK,") : F("SCRIPT,ERR,"));
+        out.println(spectro_app_script_next_offset());
+    }
+    else if ((sub != NULL) && (strcmp(sub, "DATA") == 0))
+    {
+        char *offset = spectro_cmd_next_token(&cursor);
+        char *hex = spectro_cmd_next_token(&cursor);
+        uint8_t chunk[SPECTRO_SLOT_CHUNK_MAX];
+        int len = (hex != NULL) ? spectro_cmd_hex_decode(hex, chunk, sizeof(chunk)) : -1;
+        uint32_t at = 0;
+        bool ok = spectro_cmd_parse_uint(offset, 10, UINT16_MAX, &at) && (len > 0) &&
+                  spectro_app_script_data((uint16_t)at, chunk, (uint16_t)len);
+
+        out.print(ok ? F("SCRIPT,ACK,") : F("SCRIPT,ERR,"));
+        out.println(spectro_app_script_next_offset());
+    }
+    else if ((sub != NULL) && (strcmp(sub, "RUN") == 0))
+    {
+        if (spectro_app_script_run())
+        {
+            out.print(F("SCRIPT,RUN,"));
+            out.println(spectro_app_script_next_offset());
+        }
+        else
+        {
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: SCRIPT RUN needs a complete upload, one at a time"));
+        }
+    }
+    else if ((sub != NULL) && (strcmp(sub, "ABORT") == 0))
+    {
+        spectro_app_script_abort();
+        out.println(F("SCRIPT,ABORTED"));
+    }
+    else
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: SCRIPT BEGIN|DATA|RUN|ABORT"));
+    }
+}
+
+/*******************************************************
+ * @brief  BLE [LINK <mtu> [interval ms]]: transport statistics,
+ *         or the link parameters as negotiated by the central
+ *******************************************************/
+static void spectro_cmd_ble(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+
+    if ((sub != NULL) && (strcmp(sub, "LINK") == 0))
+    {
+        char *mtu = spectro_cmd_next_token(&cursor);
+        char *interval = spectro_cmd_next_token(&cursor);
+        uint32_t mtuValue = 0;
+        uint32_t intervalMs = 0;
+        bool ok = spectro_cmd_parse_uint(mtu, 10, SPECTRO_BLE_MAX_MTU, &mtuValue) &&
+                  (mtuValue >= SPECTRO_BLE_MIN_MTU);
+
+        if (ok && (interval != NULL))
+            ok = spectro_cmd_parse_uint(interval, 10, SPECTRO_BLE_LINK_MAX_MS, &intervalMs) &&
+                 ((intervalMs == 0) || (intervalMs >= SPECTRO_BLE_LINK_MIN_MS));
+
+        if (!ok || !spectro_ble_set_link((uint16_t)mtuValue, (uint16_t)intervalMs))
+        {
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: BLE LINK <mtu> [interval ms], while connected over BLE"));
+            return;
+        }
+    }
+    else if (sub != NULL)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: BLE [LINK <mtu> [interval ms]]"));
+        return;
+    }
+
+    SpectroLine_t line;
+    spectro_ble_stats_line(&line);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+/*******************************************************
+ * @brief  OLED: "OLED,<flushes>,<bytes>,<last bytes>,<last us>,<max us>,
+ *         <last bus us>,<deferred>", display flushes since boot (CPU
+ *         time per flush, bus time of the last one)
+ *******************************************************/
+static void spectro_cmd_oled(void)
+{
+    OledStats_t st;
+    oled_get_stats(&st);
+
+    SpectroLine_t line;
+    spectro_line_init(&line);
+    spectro_line_str(&line, "OLED,");
+    spectro_line_u32(&line, st.flushes);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st.bytes);
+    spectro_line_char(&line, ',');
+    spectro_line_u16(&line, st.lastBytes);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st.lastUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st.maxUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st.lastBusUs);
+    spectro_line_char(&line, ',');
+    spectro_line_u32(&line, st.deferred);
+    spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    spectro_mux_flush();
+}
+
+/*******************************************************
+ * @brief  STANDBY [hot|pre|off | THRESHOLD <ch> <low> <high> | THRESHOLD off]
+ *
+ * @details
+ *  - Every form replies with the STANDBY statistics line
+ *******************************************************/
+static void spectro_cmd_standby(char *cursor)
+{
+    char *sub = spectro_cmd_next_token(&cursor);
+    bool ok;
+
+    if (sub == NULL)
+        ok = true;   // statistics only
+    else if (strcmp(sub, "hot") == 0)
+        ok = spectro_app_standby(SPECTRO_STANDBY_HOT);
+    else if (strcmp(sub, "pre") == 0)
+        ok = spectro_app_standby(SPECTRO_STANDBY_PRE);
+    else if (strcmp(sub, "off") == 0)
+        ok = spectro_app_standby(SPECTRO_STANDBY_OFF);
+    else if (strcmp(sub, "THRESHOLD") == 0)
+    {
+        char *ch = spectro_cmd_next_token(&cursor);
+        char *low = spectro_cmd_next_token(&cursor);
+        char *high = spectro_cmd_next_token(&cursor);
+
+        uint32_t c = 0, lo = 0, hi = 0;
+
+        if ((ch != NULL) && (strcmp(ch, "off") == 0))
+            ok = spectro_app_standby_threshold(-1, 0, 0);
+        else
+            ok = spectro_cmd_parse_uint(ch, 10, AS7343_NUM_SORTED_CHANNELS - 1, &c) &&
+                 spectro_cmd_parse_uint(low, 10, UINT16_MAX, &lo) &&
+                 spectro_cmd_parse_uint(high, 10, UINT16_MAX, &hi) &&
+                 spectro_app_standby_threshold((int8_t)c, (uint16_t)lo, (uint16_t)hi);
+    }
+    else
+        ok = false;
+
+    if (!ok)
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: STANDBY [hot|pre|off] | STANDBY THRESHOLD <ch 0..11> <low> <high>|off"));
+        return;
+    }
+    spectro_app_standby_stats();
+}
+
+static void spectro_cmd_execute(char *line)
+{
+    // PC inference reply "RES,<seq>,<result>": not space separated
+    if (strncmp(line, "RES,", 4) == 0)
+    {
+        if (!spectro_app_pc_response(&line[4]))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: RES,<seq>,<result>"));
+        return;
+    }
+
+    char *cursor = line;
+    char *cmd = spectro_cmd_next_token(&cursor);
+
+    if (cmd == NULL)
+        return;
+
+    if (spectro_cmd_settings(cmd, cursor))
+        return;
+
+    if (strcmp(cmd, "CONFIG") == 0)
+    {
+        spectro_app_print_config();
+    }
+    else if (strcmp(cmd, "LEARN") == 0)
+    {
+        char *label = spectro_cmd_next_token(&cursor);
+        char *frames = spectro_cmd_next_token(&cursor);
+        uint32_t n = SPECTRO_APP_LEARN_DEFAULT_FRAMES;
+        bool ok = (frames == NULL) || (spectro_cmd_parse_uint(frames, 10, UINT16_MAX, &n) && (n >= 1));
+
+        if (!ok || (label == NULL) || !spectro_app_learn_start(label, (uint16_t)n))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: LEARN <label> [frames]"));
+    }
+    else if (strcmp(cmd, "FORGET") == 0)
+    {
+        char *label = spectro_cmd_next_token(&cursor);
+        if ((label == NULL) || !spectro_app_learn_forget(label))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: FORGET <label>, unknown class"));
+    }
+    else if (strcmp(cmd, "CLASSES") == 0)
+    {
+        spectro_app_learn_list();
+    }
+    else if (strcmp(cmd, "BLANK") == 0)
+    {
+        spectro_app_unmix_capture_blank();
+    }
+    else if (strcmp(cmd, "ENDMEMBER") == 0)
+    {
+        char *name = spectro_cmd_next_token(&cursor);
+        if ((name == NULL) || !spectro_app_unmix_capture_endmember(name))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: ENDMEMBER apple|grape|orange|water, after BLANK"));
+    }
+    else if (strcmp(cmd, "JUICE") == 0)
+    {
+        char *name = spectro_cmd_next_token(&cursor);
+        if ((name == NULL) || !spectro_app_conc_set_juice(name))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: JUICE <name>|auto, unknown juice"));
+    }
+    else if (strcmp(cmd, "CONCMODEL") == 0)
+    {
+        char *name = spectro_cmd_next_token(&cursor);
+        bool ok = false;
+
+        if ((name != NULL) && (strcmp(name, "linear") == 0))
+            ok = spectro_app_conc_set_model(SPECTRO_CONC_MODEL_LINEAR);
+        else if ((name != NULL) && (strcmp(name, "ridge") == 0))
+            ok = spectro_app_conc_set_model(SPECTRO_CONC_MODEL_RIDGE);
+
+        if (!ok)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: CONCMODEL linear|ridge"));
+    }
+    else if (strcmp(cmd, "FORMAT") == 0)
+    {
+        char *name = spectro_cmd_next_token(&cursor);
+
+        if ((name != NULL) && (strcmp(name, "text") == 0))
+            spectro_app_set_output_format(SPECTRO_OUTPUT_TEXT);
+        else if ((name != NULL) && (strcmp(name, "binary") == 0))
+            spectro_app_set_output_format(SPECTRO_OUTPUT_BINARY);
+        else if ((name != NULL) && (strcmp(name, "delta") == 0))
+            spectro_app_set_output_format(SPECTRO_OUTPUT_DELTA);
+        else
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: FORMAT text|binary|delta"));
+    }
+    else if (strcmp(cmd, "MODEL") == 0)
+    {
+        spectro_cmd_model(cursor);
+    }
+    else if (strcmp(cmd, "OUT") == 0)
+    {
+        spectro_cmd_out(cursor);
+    }
+    else if (strcmp(cmd, "PC") == 0)
+    {
+        spectro_cmd_pc(cursor);
+    }
+    else if (strcmp(cmd, "QUEUE") == 0)
+    {
+        spectro_cmd_queue(cursor);
+    }
+    else if (strcmp(cmd, "SUB") == 0)
+    {
+        spectro_cmd_sub(cursor);
+    }
+    else if (strcmp(cmd, "MUX") == 0)
+    {
+        spectro_cmd_mux(cursor);
+    }
+    else if (strcmp(cmd, "HEADER") == 0)
+    {
+        spectro_app_print_header();
+    }
+    else if (strcmp(cmd, "PING") == 0)
+    {
+        spectro_app_print_ready();
+    }
+    else if (strcmp(cmd, "SYNC") == 0)
+    {
+        spectro_cmd_sync(cursor);
+    }
+    else if (strcmp(cmd, "DELTA") == 0)
+    {
+        spectro_cmd_delta(cursor);
+    }
+    else if (strcmp(cmd, "MEASURE") == 0)
+    {
+        spectro_cmd_measure(cursor);
+    }
+    else if (strcmp(cmd, "SCRIPT") == 0)
+    {
+        spectro_cmd_script(cursor);
+    }
+    else if (strcmp(cmd, "BLE") == 0)
+    {
+        spectro_cmd_ble(cursor);
+    }
+    else if (strcmp(cmd, "OLED") == 0)
+    {
+        spectro_cmd_oled();
+    }
+    else if (strcmp(cmd, "STANDBY") == 0)
+    {
+        spectro_cmd_standby(cursor);
+    }
+    else if (strcmp(cmd, "TRIGGER") == 0)
+    {
+        // latency counts from the arrival of the line
+        if (!spectro_app_trigger(SPECTRO_TRIGGER_COMMAND, s_lineRxUs))
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: TRIGGER needs STANDBY hot|pre, one at a time"));
+    }
+    else
+    {
+        Print &out = spectro_mux_print(SPECTRO_MUX_LOG);
+        out.print(F("[spectro_app] ERROR: Unknown command: "));
+        out.println(cmd);
+    }
+}
+
+/**
+ * @brief One received byte of a transport's line: a complete line is
+ *        executed
+ */
+static void spectro_cmd_feed(SpectroCmdLine_t *line, char c)
+{
+    if (c == '\r')
+        return;
+
+    if (c == '\n')
+    {
+        s_lineRxUs = micros();
+        line->buf[line->len] = '\0';
+
+        if (line->overflow)
+            spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Command line too long."));
+        else
+            spectro_cmd_execute(line->buf);
+
+        // the reply goes out now, ahead of queued data (CONTROL
+        // has the highest priority by default)
+        spectro_mux_flush();
+
+        line->len = 0;
+        line->overflow = false;
+        return;
+    }
+
+    if (line->len < SPECTRO_CMD_LINE_MAX - 1)
+        line->buf[line->len++] = c;
+    else
+        line->overflow = true;
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_cmd_init(void)
+{
+    for (int i = 0; i < SPECTRO_CMD_SRC_COUNT; i++)
+    {
+        s_lines[i].len = 0;
+        s_lines[i].overflow = false;
+    }
+}
+
+void spectro_cmd_poll(void)
+{
+    while (Serial.available() > 0)
+    {
+        int c = Serial.read();
+        if (c < 0)
+            break;
+        spectro_cmd_feed(&s_lines[SPECTRO_CMD_SRC_USB], (char)c);
+    }
+
+    for (int c = spectro_ble_read(); c >= 0; c = spectro_ble_read())
+        spectro_cmd_feed(&s_lines[SPECTRO_CMD_SRC_BLE], (char)c);
+}
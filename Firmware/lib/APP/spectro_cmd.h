@@ -0,0 +1,79 @@
+/********************************************************
+ * @file        	spectro_cmd.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Serial command interface of the spectrophotometer
+ *
+ * @details
+ *  - Non-blocking: only consumes bytes already received
+ *  - Lines are assembled in a static buffer (no String, no heap), from
+ *    USB Serial and the BLE RX characteristic (one host at a time)
+ *  - Commands (one per line, '\n' terminated, case sensitive):
+ *      * MODE <name|number>      : log, local, pc, unmix, conc, model, progressive
+ *      * PREC low|medium|high    : precision (integration time)
+ *      * GAIN auto|0.5x..2048x   : sensor gain, auto = precision default
+ *      * AVG <n>                 : average n frames (1..64) per output
+ *      * MASK <hex>              : sorted channels reported by DATA_LOG (FFF = all)
+ *      * START | STOP            : run / pause acquisition
+ *      * CONFIG                  : print the current settings
+ *      * LEARN <label> [frames]  : enrol the next frames as <label>
+ *      * FORGET <label>          : remove an enrolled class
+ *      * CLASSES                 : list enrolled classes
+ *      * BLANK                   : record the next frame as unmixing blank
+ *      * ENDMEMBER <name>        : record the next frame as an endmember
+ *      * JUICE <name|auto>       : juice type for the concentration regression
+ *      * CONCMODEL linear|ridge  : concentration regression model
+ *      * FORMAT text|binary|delta : DATA_LOG output as text lines, binary frames
+ *                                  or delta-compressed binary frames
+ *      * DELTA [KEY <n>]         : delta compression ratio / keyframe interval
+ *      * MODEL BEGIN <size> <crc32 hex>  : start a model package upload
+ *      * MODEL DATA <offset> <hex bytes> : next chunk (<= 64 bytes)
+ *      * MODEL COMMIT | ABORT | INFO     : finish, cancel, show active package
+ *      * OUT STATS | FLUSH       : output statistics, flush the batch now
+ *      * OUT LATENCY <ms>        : max batching delay, 0 = write every frame
+ *      * PC STATS | WINDOW <n> | TIMEOUT <ms> : PC inference pipeline
+ *      * QUEUE [oldest|newest|merge] : DATA_LOG overflow policy / statistics
+ *      * SUB <ch,ch,...>|all     : output channels (data, result, log, control)
+ *      * MUX [PRIO|RATE <ch> <n>] : channel scheduling / statistics
+ *      * HEADER                  : send the stream header (DATA channel) now
+ *      * PING                    : answered with the READY line
+ *      * SYNC <token>            : clock sync, "SYNC,<token>,<rx us>,<tx us>"
+ *      * MEASURE [n=<1..64>] [prec=low|medium|high] [avg=mean|median] [label=<text>]
+ *                                : n back-to-back frames, one aggregated reply
+ *      * SCRIPT BEGIN <size> | DATA <offset> <hex bytes> : upload a register script
+ *      * SCRIPT RUN | ABORT      : run it (records on RESULT), stop it
+ *      * BLE [LINK <mtu> [ms]]   : BLE transport statistics / link parameters
+ *      * STANDBY [hot|pre|off]   : wait for triggers instead of free-running
+ *      * STANDBY THRESHOLD <ch> <low> <high>|off : threshold trigger (pre)
+ *      * TRIGGER                 : measure one result in standby
+ *      * OLED                    : display flush statistics
+ *      * RES,<seq>,<result>      : PC inference reply (INFER_PC mode)
+ *  - Also polled while the sensor integrates (AS7343 idle callback), so
+ *    uploads do not have to wait for frame boundaries; settings commands
+ *    only record the change, spectro_app applies it between frames and
+ *    answers with the CONFIG line
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_CMD_H
+#define SPECTRO_CMD_H
+
+#include <Arduino.h>
+
+#define SPECTRO_CMD_LINE_MAX   160  // longest accepted line (MODEL DATA with 64 bytes)
+
+/**
+ * @brief Reset the line assembler.
+ */
+void spectro_cmd_init(void);
+
+/**
+ * @brief Consume pending serial bytes and execute complete command lines.
+ *
+ * @note Intended to be called between frames from spectro_app_run_once().
+ */
+void spectro_cmd_poll(void);
+
+#endif // SPECTRO_CMD_H
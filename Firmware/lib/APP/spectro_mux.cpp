@@ -0,0 +1,318 @@
+/********************************************************
+ * @file        	spectro_mux.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Prioritised logical output channels over one host link
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_mux.h"
+#include "spectro_out.h"
+#include "spectro_ble.h"
+
+static_assert(SPECTRO_MUX_MSG_MAX <= 255, "message length is stored in one byte");
+static_assert(SPECTRO_MUX_MSG_MAX < SPECTRO_OUT_BUFFER, "a message must fit the output buffer");
+
+/**
+ * @brief Queue and scheduling state of one channel
+ */
+typedef struct
+{
+    uint8_t  buf[SPECTRO_MUX_QUEUE_SIZE];   ///< ring of <len><bytes> messages
+    uint16_t head;
+    uint16_t used;
+    uint8_t  priority;
+    uint16_t rate;                          ///< bytes/s, 0 = unlimited
+    uint32_t tokens;                        ///< bytes that may be sent now
+    uint32_t refillMs;
+    char     partial[SPECTRO_MUX_MSG_MAX];  ///< Print output up to '\n'
+    uint8_t  partialLen;
+    SpectroMuxStats_t stats;
+} SpectroMuxQueue_t;
+
+/**
+ * @brief Print adapter that feeds one channel
+ */
+class SpectroMuxPrint : public Print
+{
+public:
+    explicit SpectroMuxPrint(SpectroMuxChannel_t ch) : m_ch(ch) {}
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t *buf, size_t size) override;
+
+private:
+    SpectroMuxChannel_t m_ch;
+};
+
+static const char *const s_names[SPECTRO_MUX_NUM_CHANNELS] = { "data", "result", "log", "control" };
+static const uint8_t s_defaultPriority[SPECTRO_MUX_NUM_CHANNELS] = { 2, 1, 3, 0 };
+
+//==================== Static state ====================//
+
+static SpectroMuxQueue_t s_queue[SPECTRO_MUX_NUM_CHANNELS];
+static uint8_t s_subscribed = SPECTRO_MUX_ALL;
+
+static SpectroMuxPrint s_print[SPECTRO_MUX_NUM_CHANNELS] =
+{
+    SpectroMuxPrint(SPECTRO_MUX_DATA),
+    SpectroMuxPrint(SPECTRO_MUX_RESULT),
+    SpectroMuxPrint(SPECTRO_MUX_LOG),
+    SpectroMuxPrint(SPECTRO_MUX_CONTROL),
+};
+
+//==================== Internal helpers ====================//
+
+static uint8_t spectro_mux_byte(const SpectroMuxQueue_t *q, uint16_t i)
+{
+    return q->buf[(q->head + i) % SPECTRO_MUX_QUEUE_SIZE];
+}
+
+/**
+ * @brief Output port: BLE while a central streams, USB otherwise
+ */
+static size_t spectro_mux_port_space(void)
+{
+    return spectro_ble_active() ? spectro_ble_space() : spectro_out_space();
+}
+
+static bool spectro_mux_port_write(const uint8_t *data, size_t len)
+{
+    return spectro_ble_active() ? spectro_ble_write(data, len) : spectro_out_write(data, len);
+}
+
+/**
+ * @brief Token bucket: refill by elapsed time, at most one second's
+ *        worth (and never less than one full message)
+ */
+static void spectro_mux_refill(SpectroMuxQueue_t *q, uint32_t nowMs)
+{
+    if (q->rate == 0)
+        return;
+
+    uint32_t cap = (q->rate > SPECTRO_MUX_MSG_MAX) ? q->rate : SPECTRO_MUX_MSG_MAX;
+    uint32_t elapsed = nowMs - q->refillMs;
+    uint32_t add = (uint32_t)(((uint64_t)elapsed * q->rate) / 1000U);
+    if (add == 0)
+        return;
+
+    // keep the remainder of the millisecond for the next refill
+    q->refillMs += (uint32_t)(((uint64_t)add * 1000U) / q->rate);
+    q->tokens = (q->tokens + add > cap) ? cap : q->tokens + add;
+}
+
+size_t SpectroMuxPrint::write(const uint8_t *buf, size_t size)
+{
+    SpectroMuxQueue_t *q = &s_queue[m_ch];
+
+    for (size_t i = 0; i < size; i++)
+    {
+        q->partial[q->partialLen++] = (char)buf[i];
+        if ((buf[i] == '\n') || (q->partialLen == SPECTRO_MUX_MSG_MAX))
+        {
+            spectro_mux_write(m_ch, (const uint8_t *)q->partial, q->partialLen);
+            q->partialLen = 0;
+        }
+    }
+    return size;
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_mux_init(void)
+{
+    uint32_t now = millis();
+
+    for (int ch = 0; ch < SPECTRO_MUX_NUM_CHANNELS; ch++)
+    {
+        SpectroMuxQueue_t *q = &s_queue[ch];
+        memset(q, 0, sizeof(*q));
+        q->priority = s_defaultPriority[ch];
+        q->refillMs = now;
+    }
+    spectro_mux_set_rate(SPECTRO_MUX_LOG, SPECTRO_MUX_LOG_RATE);
+    s_subscribed = SPECTRO_MUX_ALL;
+}
+
+bool spectro_mux_write(SpectroMuxChannel_t ch, const uint8_t *data, size_t len)
+{
+    if ((unsigned)ch >= SPECTRO_MUX_NUM_CHANNELS)
+        return false;
+
+    SpectroMuxQueue_t *q = &s_queue[ch];
+
+    if ((s_subscribed & (1U << ch)) == 0)
+    {
+        q->stats.filtered++;
+        return false;
+    }
+    if ((len == 0) || (len > spectro_mux_space(ch)))
+    {
+        q->stats.dropped++;
+        return false;
+    }
+
+    uint16_t tail = (uint16_t)((q->head + q->used) % SPECTRO_MUX_QUEUE_SIZE);
+    q->buf[tail] = (uint8_t)len;
+    for (size_t i = 0; i < len; i++)
+        q->buf[(tail + 1 + i) % SPECTRO_MUX_QUEUE_SIZE] = data[i];
+    q->used = (uint16_t)(q->used + 1 + len);
+    return true;
+}
+
+bool spectro_mux_line(SpectroMuxChannel_t ch, SpectroLine_t *line)
+{
+    if (!spectro_line_end(line))
+    {
+        spectro_mux_print(SPECTRO_MUX_LOG).println(F("[spectro_app] ERROR: Output line too long."));
+        return false;
+    }
+    return spectro_mux_write(ch, (const uint8_t *)line->buf, line->len);
+}
+
+Print &spectro_mux_print(SpectroMuxChannel_t ch)
+{
+    return s_print[((unsigned)ch < SPECTRO_MUX_NUM_CHANNELS) ? ch : SPECTRO_MUX_LOG];
+}
+
+size_t spectro_mux_space(SpectroMuxChannel_t ch)
+{
+    size_t free = SPECTRO_MUX_QUEUE_SIZE - s_queue[ch].used;
+    free = (free > 1) ? free - 1 : 0;   // length byte
+    return (free > SPECTRO_MUX_MSG_MAX) ? SPECTRO_MUX_MSG_MAX : free;
+}
+
+void spectro_mux_poll(void)
+{
+    uint32_t now = millis();
+    uint8_t msg[SPECTRO_MUX_MSG_MAX];
+
+    for (int ch = 0; ch < SPECTRO_MUX_NUM_CHANNELS; ch++)
+        spectro_mux_refill(&s_queue[ch], now);
+
+    for (;;)
+    {
+        // highest priority channel whose next message is within its rate
+        SpectroMuxQueue_t *best = NULL;
+        for (int ch = 0; ch < SPECTRO_MUX_NUM_CHANNELS; ch++)
+        {
+            SpectroMuxQueue_t *q = &s_queue[ch];
+            if ((q->used == 0) || ((q->rate != 0) && (q->tokens < q->buf[q->head])))
+                continue;
+            if ((best == NULL) || (q->priority < best->priority))
+                best = q;
+        }
+
+        uint8_t len = (best != NULL) ? best->buf[best->head] : 0;
+        if ((best == NULL) || (len > spectro_mux_port_space()))
+            break;
+
+        for (uint8_t i = 0; i < len; i++)
+            msg[i] = spectro_mux_byte(best, (uint16_t)(1 + i));
+        if (!spectro_mux_port_write(msg, len))
+            break;
+
+        best->head = (uint16_t)((best->head + 1 + len) % SPECTRO_MUX_QUEUE_SIZE);
+        best->used = (uint16_t)(best->used - 1 - len);
+        if (best->rate != 0)
+            best->tokens -= len;
+        best->stats.messages++;
+        best->stats.bytes += len;
+    }
+
+    spectro_out_poll();
+    spectro_ble_poll();
+}
+
+void spectro_mux_flush(void)
+{
+    spectro_mux_poll();
+    spectro_out_flush();
+    spectro_ble_flush();
+}
+
+void spectro_mux_subscribe(uint8_t mask)
+{
+    s_subscribed = (uint8_t)(mask & SPECTRO_MUX_ALL);
+
+    // queued messages of dropped channels are not sent any more
+    for (int ch = 0; ch < SPECTRO_MUX_NUM_CHANNELS; ch++)
+    {
+        if ((s_subscribed & (1U << ch)) == 0)
+        {
+            s_queue[ch].head = 0;
+            s_queue[ch].used = 0;
+            s_queue[ch].partialLen = 0;
+        }
+    }
+}
+
+uint8_t spectro_mux_subscribed(void)
+{
+    return s_subscribed;
+}
+
+void spectro_mux_set_priority(SpectroMuxChannel_t ch, uint8_t priority)
+{
+    if ((unsigned)ch < SPECTRO_MUX_NUM_CHANNELS)
+        s_queue[ch].priority = priority;
+}
+
+void spectro_mux_set_rate(SpectroMuxChannel_t ch, uint16_t bytesPerSec)
+{
+    if ((unsigned)ch >= SPECTRO_MUX_NUM_CHANNELS)
+        return;
+
+    SpectroMuxQueue_t *q = &s_queue[ch];
+    q->rate = bytesPerSec;
+    q->tokens = (bytesPerSec > SPECTRO_MUX_MSG_MAX) ? bytesPerSec : SPECTRO_MUX_MSG_MAX;   // start full
+    q->refillMs = millis();
+}
+
+const char *spectro_mux_name(SpectroMuxChannel_t ch)
+{
+    return ((unsigned)ch < SPECTRO_MUX_NUM_CHANNELS) ? s_names[ch] : NULL;
+}
+
+bool spectro_mux_from_name(const char *name, SpectroMuxChannel_t *ch)
+{
+    for (int c = 0; c < SPECTRO_MUX_NUM_CHANNELS; c++)
+    {
+        if (strcmp(name, s_names[c]) == 0)
+        {
+            *ch = (SpectroMuxChannel_t)c;
+            return true;
+        }
+    }
+    return false;
+}
+
+void spectro_mux_print_stats(void)
+{
+    for (int ch = 0; ch < SPECTRO_MUX_NUM_CHANNELS; ch++)
+    {
+        const SpectroMuxQueue_t *q = &s_queue[ch];
+
+        SpectroLine_t line;
+        spectro_line_init(&line);
+        spectro_line_str(&line, "MUX,");
+        spectro_line_str(&line, s_names[ch]);
+        spectro_line_str(&line, (s_subscribed & (1U << ch)) ? ",1," : ",0,");
+        spectro_line_u16(&line, q->priority);
+        spectro_line_char(&line, ',');
+        spectro_line_u16(&line, q->rate);
+        spectro_line_char(&line, ',');
+        spectro_line_u16(&line, q->used);
+        spectro_line_char(&line, ',');
+        spectro_line_u32(&line, q->stats.messages);
+        spectro_line_char(&line, ',');
+        spectro_line_u32(&line, q->stats.bytes);
+        spectro_line_char(&line, ',');
+        spectro_line_u32(&line, q->stats.dropped);
+        spectro_line_char(&line, ',');
+        spectro_line_u32(&line, q->stats.filtered);
+        spectro_mux_line(SPECTRO_MUX_CONTROL, &line);
+    }
+    spectro_mux_flush();
+}
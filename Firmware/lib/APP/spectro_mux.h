@@ -0,0 +1,128 @@
+/********************************************************
+ * @file        	spectro_mux.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Prioritised logical output channels over one host link
+ *
+ * @details
+ *  - Every output message belongs to one logical channel:
+ *      * DATA    : measurement lines / binary frames, PC requests
+ *      * RESULT  : per-frame results of the inference modes
+ *      * LOG     : diagnostics ("[spectro_app] ERROR: ...", I2C errors)
+ *      * CONTROL : command replies (CONFIG, MODEL, stats, ...)
+ *  - Each channel has its own message queue; spectro_mux_poll() moves
+ *    whole messages into spectro_out, highest priority first, within
+ *    each channel's rate limit, so a burst of diagnostics neither
+ *    delays data nor fills the USB link
+ *  - The host subscribes to the channels it needs (SUB command);
+ *    messages of other channels are discarded before queueing
+ *  - A full queue drops the new message (counted per channel)
+ *  - The messages go to USB, or to BLE while a central is subscribed
+ *    to the output stream (spectro_ble)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_MUX_H
+#define SPECTRO_MUX_H
+
+#include <Arduino.h>
+#include "spectro_format.h"
+
+#define SPECTRO_MUX_QUEUE_SIZE      512   // bytes per channel, 1 length byte per message
+#define SPECTRO_MUX_MSG_MAX         255
+#define SPECTRO_MUX_LOG_RATE        1000  // default LOG limit, bytes/s
+
+typedef enum
+{
+    SPECTRO_MUX_DATA = 0,
+    SPECTRO_MUX_RESULT,
+    SPECTRO_MUX_LOG,
+    SPECTRO_MUX_CONTROL,
+    SPECTRO_MUX_NUM_CHANNELS
+} SpectroMuxChannel_t;
+
+#define SPECTRO_MUX_ALL     ((uint8_t)((1U << SPECTRO_MUX_NUM_CHANNELS) - 1))
+
+/**
+ * @brief Per-channel counters since spectro_mux_init()
+ */
+typedef struct
+{
+    uint32_t messages;    ///< messages sent
+    uint32_t bytes;       ///< bytes sent
+    uint32_t dropped;     ///< messages lost to a full queue
+    uint32_t filtered;    ///< messages discarded, channel not subscribed
+} SpectroMuxStats_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Empty all queues, default priorities (CONTROL > RESULT > DATA
+ *        > LOG) and rates, all channels subscribed.
+ */
+void spectro_mux_init(void);
+
+/**
+ * @brief Queue one complete message (a text line or a binary frame).
+ * @return false if it was dropped or filtered
+ */
+bool spectro_mux_write(SpectroMuxChannel_t ch, const uint8_t *data, size_t len);
+
+/**
+ * @brief Finish a line (\r\n) and queue it; too long lines are
+ *        reported on the LOG channel.
+ */
+bool spectro_mux_line(SpectroMuxChannel_t ch, SpectroLine_t *line);
+
+/**
+ * @brief Print-style access to a channel: bytes are collected until
+ *        '\n' and queued as one message, e.g.
+ *        spectro_mux_print(SPECTRO_MUX_LOG).println(F("..."))
+ */
+Print &spectro_mux_print(SpectroMuxChannel_t ch);
+
+/**
+ * @brief Free queue space of a channel, i.e. the largest message it
+ *        accepts now.
+ */
+size_t spectro_mux_space(SpectroMuxChannel_t ch);
+
+/**
+ * @brief Move queued messages to spectro_out by priority and rate. Cheap,
+ *        call often (it also runs spectro_out_poll()).
+ */
+void spectro_mux_poll(void);
+
+/**
+ * @brief spectro_mux_poll(), then send the output batch now.
+ */
+void spectro_mux_flush(void);
+
+/**
+ * @brief Subscribed channels, bit i = SpectroMuxChannel_t i.
+ */
+void spectro_mux_subscribe(uint8_t mask);
+uint8_t spectro_mux_subscribed(void);
+
+/**
+ * @brief Priority (0 = highest) and rate limit (bytes/s, 0 = none).
+ */
+void spectro_mux_set_priority(SpectroMuxChannel_t ch, uint8_t priority);
+void spectro_mux_set_rate(SpectroMuxChannel_t ch, uint16_t bytesPerSec);
+
+/**
+ * @brief Channel name ("data", "result", "log", "control") and its inverse.
+ */
+const char *spectro_mux_name(SpectroMuxChannel_t ch);
+bool spectro_mux_from_name(const char *name, SpectroMuxChannel_t *ch);
+
+/**
+ * @brief Print one line per channel on CONTROL:
+ *        "MUX,<name>,<sub 0|1>,<prio>,<rate>,<queued bytes>,<messages>,
+ *        <bytes>,<dropped>,<filtered>"
+ */
+void spectro_mux_print_stats(void);
+
+#endif // SPECTRO_MUX_H
@@ -0,0 +1,184 @@
+/********************************************************
+ * @file        	spectro_out.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Batched measurement output over USB CDC
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_out.h"
+
+//==================== Static state ====================//
+
+static uint8_t s_buf[SPECTRO_OUT_BUFFER];
+static uint16_t s_len = 0;
+static uint32_t s_oldestMs = 0;          // millis() when s_buf became non-empty
+static uint16_t s_latencyMs = SPECTRO_OUT_DEFAULT_LATENCY_MS;
+static bool s_stalled = false;           // last send found the port short of room
+
+static SpectroOutStats_t s_stats;
+static uint32_t s_statsStartMs = 0;
+
+//==================== Internal helpers ====================//
+
+/**
+ * @brief Bytes the port takes without blocking.
+ */
+static size_t spectro_out_port_space(void)
+{
+#if SPECTRO_OUT_CHECK_SPACE
+    int n = Serial.availableForWrite();
+    return (n > 0) ? (size_t)n : 0;
+#else
+    return SPECTRO_OUT_BUFFER;
+#endif
+}
+
+/**
+ * @brief Send the first len buffered bytes and shift the rest down.
+ *
+ * @details
+ *  - Sends less if the port has less room, in whole packets where
+ *    possible; the rest is retried by the next write or poll
+ */
+static void spectro_out_send(uint16_t len, uint32_t *counter)
+{
+    if (len == 0)
+        return;
+
+    size_t room = spectro_out_port_space();
+    if (!s_stalled && (room < len))
+        s_stats.stalls++;
+    s_stalled = (room < len);
+    if (room < len)
+    {
+        if (room >= SPECTRO_OUT_PACKET)
+            room -= room % SPECTRO_OUT_PACKET;
+        if (room == 0)
+            return;
+        len = (uint16_t)room;
+    }
+
+    Serial.write(s_buf, len);
+
+    s_stats.bytes += len;
+    s_stats.writes++;
+    s_stats.packets += (len + SPECTRO_OUT_PACKET - 1) / SPECTRO_OUT_PACKET;
+    s_stats.fullPackets += len / SPECTRO_OUT_PACKET;
+    (*counter)++;
+
+    s_len = (uint16_t)(s_len - len);
+    if (s_len > 0)
+    {
+        memmove(s_buf, &s_buf[len], s_len);
+        s_oldestMs = millis();   // the remainder belongs to the newest frame
+    }
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_out_init(void)
+{
+    s_len = 0;
+    s_stalled = false;
+    spectro_out_reset_stats();
+}
+
+bool spectro_out_write(const uint8_t *data, size_t len)
+{
+    if (len > spectro_out_space())
+    {
+        // try to make room first, then give up rather than block
+        spectro_out_send((uint16_t)(s_len - (s_len % SPECTRO_OUT_PACKET)), &s_stats.sizeFlushes);
+        if (len > spectro_out_space())
+        {
+            s_stats.refused++;
+            return false;
+        }
+    }
+
+    if (s_len == 0)
+        s_oldestMs = millis();
+    memcpy(&s_buf[s_len], data, len);
+    s_len = (uint16_t)(s_len + len);
+
+    // whole packets go out now, the tail waits for more data
+    uint16_t aligned = (uint16_t)(s_len - (s_len % SPECTRO_OUT_PACKET));
+    spectro_out_send(aligned, &s_stats.sizeFlushes);
+
+    if (s_latencyMs == 0)
+        spectro_out_flush();
+    return true;
+}
+
+size_t spectro_out_space(void)
+{
+    return SPECTRO_OUT_BUFFER - s_len;
+}
+
+void spectro_out_flush(void)
+{
+    spectro_out_send(s_len, &s_stats.explicitFlushes);
+}
+
+void spectro_out_poll(void)
+{
+    if ((s_len > 0) && ((uint32_t)(millis() - s_oldestMs) >= s_latencyMs))
+        spectro_out_send(s_len, &s_stats.deadlineFlushes);
+}
+
+void spectro_out_set_latency(uint16_t ms)
+{
+    s_latencyMs = ms;
+    spectro_out_poll();
+}
+
+uint16_t spectro_out_get_latency(void)
+{
+    return s_latencyMs;
+}
+
+void spectro_out_get_stats(SpectroOutStats_t *stats)
+{
+    *stats = s_stats;
+    stats->elapsedMs = millis() - s_statsStartMs;
+}
+
+void spectro_out_reset_stats(void)
+{
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_statsStartMs = millis();
+}
+
+void spectro_out_stats_line(SpectroLine_t *line)
+{
+    SpectroOutStats_t st;
+    spectro_out_get_stats(&st);
+
+    float seconds = (st.elapsedMs > 0) ? (float)st.elapsedMs * 1e-3f : 1e-3f;
+
+    spectro_line_init(line);
+    spectro_line_str(line, "OUT,");
+    spectro_line_u32(line, (uint32_t)((float)st.bytes / seconds));
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st.writes);
+    spectro_line_char(line, ',');
+    spectro_line_fixed(line, (st.writes > 0) ? (float)st.bytes / (float)st.writes : 0.0f, 1);
+    spectro_line_char(line, ',');
+    spectro_line_fixed(line, (st.packets > 0) ? 100.0f * (float)st.fullPackets / (float)st.packets : 0.0f, 1);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st.sizeFlushes);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st.deadlineFlushes);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st.explicitFlushes);
+    spectro_line_char(line, ',');
+    spectro_line_u16(line, s_latencyMs);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st.stalls);
+    spectro_line_char(line, ',');
+    spectro_line_u32(line, st.refused);
+    spectro_out_reset_stats();
+}
@@ -0,0 +1,109 @@
+/********************************************************
+ * @file        	spectro_out.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Batched measurement output over USB CDC
+ *
+ * @details
+ *  - Serial on the Nano 33 BLE is native USB CDC: every write ends up
+ *    as at least one USB transfer, so one short line per frame wastes
+ *    most of each 64-byte packet at high frame rates
+ *  - Frames are appended to a static buffer and written in whole
+ *    64-byte packets; the remainder waits for the next frame
+ *  - Flush policy:
+ *      * size     : as soon as one full packet is buffered
+ *      * deadline : the oldest buffered byte is older than the
+ *                   maximum latency (spectro_out_poll())
+ *      * explicit : spectro_out_flush(), e.g. before a command reply or
+ *                   after a request to the PC
+ *  - spectro_out_poll() runs in the AS7343 idle callback, so deadline
+ *    flushes happen while the sensor integrates, not in the frame path
+ *  - A latency of 0 writes every frame through at once (no batching)
+ *  - Never blocks: only as many bytes as the port reports free
+ *    (Serial.availableForWrite()) are written, the rest stays here.
+ *    A write that does not fit the buffer is refused, so a host that
+ *    stops reading cannot stall acquisition; measurement frames are
+ *    queued by the caller (spectro_queue) until spectro_out_space()
+ *    has room
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_OUT_H
+#define SPECTRO_OUT_H
+
+#include <Arduino.h>
+#include "spectro_format.h"
+
+#define SPECTRO_OUT_PACKET              64    // USB full-speed bulk packet
+#define SPECTRO_OUT_BUFFER              (8 * SPECTRO_OUT_PACKET)
+#define SPECTRO_OUT_DEFAULT_LATENCY_MS  20
+
+// 0 on a core without Serial.availableForWrite(): writes may then block
+#ifndef SPECTRO_OUT_CHECK_SPACE
+#define SPECTRO_OUT_CHECK_SPACE         1
+#endif
+
+/**
+ * @brief Output counters since the last spectro_out_reset_stats()
+ */
+typedef struct
+{
+    uint32_t bytes;            ///< bytes handed to Serial
+    uint32_t writes;           ///< Serial.write() calls
+    uint32_t packets;          ///< USB packets those writes need
+    uint32_t fullPackets;      ///< of which completely filled
+    uint32_t sizeFlushes;
+    uint32_t deadlineFlushes;
+    uint32_t explicitFlushes;
+    uint32_t stalls;           ///< times the port ran out of room
+    uint32_t refused;          ///< writes refused because the buffer was full
+    uint32_t elapsedMs;        ///< time covered by the counters
+} SpectroOutStats_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Empty the buffer and reset the statistics.
+ */
+void spectro_out_init(void);
+
+/**
+ * @brief Queue bytes for transmission (one frame or text line).
+ * @return false if they do not fit; nothing is queued then
+ */
+bool spectro_out_write(const uint8_t *data, size_t len);
+
+/**
+ * @brief Free buffer space, i.e. the largest write accepted now.
+ */
+size_t spectro_out_space(void);
+
+/**
+ * @brief Write everything buffered now (as far as the port accepts it).
+ */
+void spectro_out_flush(void);
+
+/**
+ * @brief Flush if the latency deadline has passed. Cheap, call often.
+ */
+void spectro_out_poll(void);
+
+/**
+ * @brief Maximum time a byte may wait in the buffer (0 = write-through).
+ */
+void spectro_out_set_latency(uint16_t ms);
+uint16_t spectro_out_get_latency(void);
+
+void spectro_out_get_stats(SpectroOutStats_t *stats);
+void spectro_out_reset_stats(void);
+
+/**
+ * @brief Render "OUT,<bytes/s>,<writes>,<avg bytes/write>,<full packet %>,
+ *        <size>,<deadline>,<explicit>,<latency ms>,<stalls>,<refused>"
+ *        and reset the counters.
+ */
+void spectro_out_stats_line(SpectroLine_t *line);
+
+#endif // SPECTRO_OUT_H
@@ -0,0 +1,120 @@
+/********************************************************
+ * @file        	spectro_batch.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Aggregate of a batch of back-to-back frames
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <string.h>
+
+#include "spectro_batch.h"
+
+#define NB             SPECTRO_BATCH_NUM_CHANNELS
+
+static const char *const s_aggNames[] = { "mean", "median" };
+
+//==================== Internal helpers ====================//
+
+/**
+ * @brief Median of one channel (insertion sort, n <= SPECTRO_BATCH_MAX_FRAMES)
+ */
+static float spectro_batch_median(const SpectroBatch_t *b, int ch)
+{
+    uint16_t v[SPECTRO_BATCH_MAX_FRAMES];
+    int n = b->count;
+
+    for (int i = 0; i < n; i++)
+    {
+        uint16_t x = b->frames[i][ch];
+        int j = i;
+        for (; (j > 0) && (v[j - 1] > x); j--)
+            v[j] = v[j - 1];
+        v[j] = x;
+    }
+
+    if (n & 1)
+        return (float)v[n / 2];
+    return 0.5f * ((float)v[n / 2 - 1] + (float)v[n / 2]);
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_batch_reset(SpectroBatch_t *b, uint32_t startUs)
+{
+    b->count = 0;
+    b->startUs = startUs;
+}
+
+bool spectro_batch_add(SpectroBatch_t *b, const uint16_t *sorted, uint32_t endUs)
+{
+    if (b->count >= SPECTRO_BATCH_MAX_FRAMES)
+        return false;
+
+    memcpy(b->frames[b->count], sorted, sizeof(b->frames[0]));
+    b->endUs[b->count] = endUs;
+    b->count++;
+    return true;
+}
+
+bool spectro_batch_result(const SpectroBatch_t *b, SpectroBatchAgg_t agg, SpectroBatchResult_t *r)
+{
+    int n = b->count;
+
+    if (n == 0)
+        return false;
+
+    memset(r, 0, sizeof(*r));
+    r->frames = (uint8_t)n;
+
+    for (int ch = 0; ch < NB; ch++)
+    {
+        // exact integer sums: 64 frames * 65535^2 fits easily in 64 bits
+        uint64_t sum = 0;
+        uint64_t sumSq = 0;
+        for (int i = 0; i < n; i++)
+        {
+            uint32_t x = b->frames[i][ch];
+            sum += x;
+            sumSq += (uint64_t)x * x;
+        }
+
+        r->value[ch] = (agg == SPECTRO_BATCH_MEDIAN) ? spectro_batch_median(b, ch) : (float)sum / (float)n;
+        if (n > 1)
+            r->var[ch] = (float)((double)(n * sumSq - sum * sum) / ((double)n * (n - 1)));
+    }
+
+    r->durationUs = b->endUs[n - 1] - b->startUs;
+    r->periodUs = r->durationUs / (uint32_t)n;
+
+    uint32_t prev = b->startUs;
+    for (int i = 0; i < n; i++)
+    {
+        uint32_t dt = b->endUs[i] - prev;
+        uint32_t dev = (dt > r->periodUs) ? dt - r->periodUs : r->periodUs - dt;
+        if (dev > r->jitterUs)
+            r->jitterUs = dev;
+        prev = b->endUs[i];
+    }
+    return true;
+}
+
+const char *spectro_batch_agg_name(SpectroBatchAgg_t agg)
+{
+    return ((unsigned)agg < sizeof(s_aggNames) / sizeof(s_aggNames[0])) ? s_aggNames[agg] : NULL;
+}
+
+bool spectro_batch_agg_from_name(const char *name, SpectroBatchAgg_t *agg)
+{
+    for (unsigned a = 0; a < sizeof(s_aggNames) / sizeof(s_aggNames[0]); a++)
+    {
+        if (strcmp(name, s_aggNames[a]) == 0)
+        {
+            *agg = (SpectroBatchAgg_t)a;
+            return true;
+        }
+    }
+    return false;
+}
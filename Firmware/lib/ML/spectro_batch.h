@@ -0,0 +1,96 @@
+/********************************************************
+ * @file        	spectro_batch.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Aggregate of a batch of back-to-back frames
+ *
+ * @details
+ *  - Collects up to SPECTRO_BATCH_MAX_FRAMES frames with their end
+ *    time, then reduces them to one result per channel:
+ *      * mean or median of the counts
+ *      * sample variance (n - 1), exact from integer sums
+ *  - Timing: batch duration, mean frame period and the largest
+ *    deviation of a single period from it (jitter)
+ *  - No Arduino dependency, also builds on the host
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_BATCH_H
+#define SPECTRO_BATCH_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//==================== Configuration ====================//
+
+#define SPECTRO_BATCH_NUM_CHANNELS   12     // = AS7343_NUM_SORTED_CHANNELS
+#define SPECTRO_BATCH_MAX_FRAMES     64
+
+//==================== Containers ====================//
+
+/**
+ * @brief Per-channel aggregate of a batch
+ */
+typedef enum
+{
+    SPECTRO_BATCH_MEAN = 0,
+    SPECTRO_BATCH_MEDIAN
+} SpectroBatchAgg_t;
+
+/**
+ * @brief Frames collected so far
+ */
+typedef struct
+{
+    uint16_t frames[SPECTRO_BATCH_MAX_FRAMES][SPECTRO_BATCH_NUM_CHANNELS];
+    uint32_t endUs[SPECTRO_BATCH_MAX_FRAMES];   ///< end of each frame's integration (us)
+    uint32_t startUs;                           ///< start of the first frame (us)
+    uint8_t  count;
+} SpectroBatch_t;
+
+/**
+ * @brief Reduced batch
+ */
+typedef struct
+{
+    float    value[SPECTRO_BATCH_NUM_CHANNELS];   ///< mean or median counts
+    float    var[SPECTRO_BATCH_NUM_CHANNELS];     ///< sample variance, 0 for one frame
+    uint32_t durationUs;                          ///< first frame start to last frame read
+    uint32_t periodUs;                            ///< mean time per frame
+    uint32_t jitterUs;                            ///< max |frame time - periodUs|
+    uint8_t  frames;
+} SpectroBatchResult_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Empty the batch; the first frame starts at startUs.
+ */
+void spectro_batch_reset(SpectroBatch_t *b, uint32_t startUs);
+
+/**
+ * @brief Add one frame of sorted channels, read at endUs.
+ * @return false if the batch is full
+ */
+bool spectro_batch_add(SpectroBatch_t *b, const uint16_t *sorted, uint32_t endUs);
+
+/**
+ * @brief Reduce the collected frames.
+ * @return false if the batch is empty
+ */
+bool spectro_batch_result(const SpectroBatch_t *b, SpectroBatchAgg_t agg, SpectroBatchResult_t *r);
+
+/**
+ * @brief Command name of an aggregate ("mean", "median"), NULL if invalid.
+ */
+const char *spectro_batch_agg_name(SpectroBatchAgg_t agg);
+
+/**
+ * @brief Aggregate from its command name.
+ * @return false if unknown
+ */
+bool spectro_batch_agg_from_name(const char *name, SpectroBatchAgg_t *agg);
+
+#endif // SPECTRO_BATCH_H
@@ -0,0 +1,160 @@
+/********************************************************
+ * @file        	spectro_centroid.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Incremental nearest-centroid classifier
+ *
+ * @details
+ *  - Welford update: mean += d / n ; m2 += d * (x - mean)
+ *  - Score = sum_i (x_i - mu_i)^2 / var_i + log(var_i)
+ *    (negative log-likelihood of a diagonal Gaussian, up to a constant)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <string.h>
+#include <math.h>
+
+#include "spectro_centroid.h"
+
+//==================== Public API implementation ====================//
+
+void spectro_centroid_reset(SpectroCentroidModel_t *model)
+{
+    if (model == NULL)
+        return;
+
+    memset(model, 0, sizeof(*model));
+    model->version = SPECTRO_CENTROID_VERSION;
+}
+
+bool spectro_centroid_is_valid(const SpectroCentroidModel_t *model)
+{
+    if (model == NULL)
+        return false;
+    if ((model->version != SPECTRO_CENTROID_VERSION) || (model->numClasses > SPECTRO_CENTROID_MAX_CLASSES))
+        return false;
+
+    for (uint32_t c = 0; c < model->numClasses; c++)
+    {
+        const SpectroCentroidClass_t *cls = &model->cls[c];
+        if ((cls->count == 0) || (memchr(cls->label, '\0', SPECTRO_CENTROID_LABEL_LEN) == NULL))
+            return false;
+    }
+    return true;
+}
+
+void spectro_centroid_features(const uint16_t *sorted, float *x)
+{
+    uint32_t sum = 0;
+
+    for (int i = 0; i < SPECTRO_CENTROID_NUM_FEATURES; i++)
+        sum += sorted[i];
+
+    // same guard as l1_normalise(): an all-zero frame stays all-zero
+    const float inv = (sum > 0) ? (1.0f / (float)sum) : 0.0f;
+
+    for (int i = 0; i < SPECTRO_CENTROID_NUM_FEATURES; i++)
+        x[i] = (float)sorted[i] * inv;
+}
+
+int spectro_centroid_find(const SpectroCentroidModel_t *model, const char *label)
+{
+    if ((model == NULL) || (label == NULL))
+        return -1;
+
+    for (uint32_t c = 0; c < model->numClasses; c++)
+    {
+        if (strncmp(model->cls[c].label, label, SPECTRO_CENTROID_LABEL_LEN) == 0)
+            return (int)c;
+    }
+    return -1;
+}
+
+int spectro_centroid_update(SpectroCentroidModel_t *model, const char *label, const float *x)
+{
+    if ((model == NULL) || (label == NULL) || (x == NULL))
+        return -1;
+
+    size_t labelLen = strlen(label);
+    if ((labelLen == 0) || (labelLen >= SPECTRO_CENTROID_LABEL_LEN))
+        return -1;
+
+    int idx = spectro_centroid_find(model, label);
+    if (idx < 0)
+    {
+        if (model->numClasses >= SPECTRO_CENTROID_MAX_CLASSES)
+            return -1;
+
+        idx = (int)model->numClasses++;
+        memset(&model->cls[idx], 0, sizeof(SpectroCentroidClass_t));
+        memcpy(model->cls[idx].label, label, labelLen + 1);
+    }
+
+    SpectroCentroidClass_t *cls = &model->cls[idx];
+    cls->count++;
+
+    const float invN = 1.0f / (float)cls->count;
+    for (int i = 0; i < SPECTRO_CENTROID_NUM_FEATURES; i++)
+    {
+        float d = x[i] - cls->mean[i];
+        cls->mean[i] += d * invN;
+        cls->m2[i] += d * (x[i] - cls->mean[i]);
+    }
+
+    return idx;
+}
+
+bool spectro_centroid_forget(SpectroCentroidModel_t *model, const char *label)
+{
+    int idx = spectro_centroid_find(model, label);
+    if (idx < 0)
+        return false;
+
+    for (uint32_t c = (uint32_t)idx; c + 1 < model->numClasses; c++)
+        model->cls[c] = model->cls[c + 1];
+
+    model->numClasses--;
+    memset(&model->cls[model->numClasses], 0, sizeof(SpectroCentroidClass_t));
+    return true;
+}
+
+float spectro_centroid_variance(const SpectroCentroidClass_t *cls, int feature)
+{
+    float var = (cls->count > 1) ? (cls->m2[feature] / (float)(cls->count - 1)) : 0.0f;
+    return (var > SPECTRO_CENTROID_VAR_FLOOR) ? var : SPECTRO_CENTROID_VAR_FLOOR;
+}
+
+int spectro_centroid_classify(const SpectroCentroidModel_t *model, const float *x, float *score)
+{
+    if ((model == NULL) || (x == NULL) || (model->numClasses == 0))
+        return -1;
+
+    int best = -1;
+    float bestScore = INFINITY;
+
+    for (uint32_t c = 0; c < model->numClasses; c++)
+    {
+        const SpectroCentroidClass_t *cls = &model->cls[c];
+        float s = 0.0f;
+
+        for (int i = 0; i < SPECTRO_CENTROID_NUM_FEATURES; i++)
+        {
+            float var = spectro_centroid_variance(cls, i);
+            float d = x[i] - cls->mean[i];
+            s += d * d / var + logf(var);
+        }
+
+        if (s < bestScore)
+        {
+            bestScore = s;
+            best = (int)c;
+        }
+    }
+
+    if (score != NULL)
+        *score = bestScore;
+
+    return best;
+}
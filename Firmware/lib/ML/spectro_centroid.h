@@ -0,0 +1,110 @@
+/********************************************************
+ * @file        	spectro_centroid.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Incremental nearest-centroid classifier
+ *
+ * @details
+ *  - Per-class running mean and variance (Welford), O(features) per update
+ *  - Classification by diagonal-Gaussian score (variance-weighted distance)
+ *  - Features are the L1-normalised 12-channel spectrum, the same
+ *    preprocessing as the PC-side juice model ("l1" in features.py)
+ *  - Plain-old-data model, can be persisted as a flash record as-is
+ *  - No Arduino dependency, also builds on the host
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_CENTROID_H
+#define SPECTRO_CENTROID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//==================== Configuration ====================//
+
+#define SPECTRO_CENTROID_NUM_FEATURES   12    // = AS7343_NUM_SORTED_CHANNELS
+#define SPECTRO_CENTROID_MAX_CLASSES    8
+#define SPECTRO_CENTROID_LABEL_LEN      16    // including '\0'
+#define SPECTRO_CENTROID_VAR_FLOOR      1e-7f // keeps 1-frame classes usable
+#define SPECTRO_CENTROID_VERSION        1
+
+//==================== Model container ====================//
+
+/**
+ * @brief Running statistics of one enrolled class
+ */
+typedef struct
+{
+    char     label[SPECTRO_CENTROID_LABEL_LEN];
+    uint32_t count;                                   ///< frames seen
+    float    mean[SPECTRO_CENTROID_NUM_FEATURES];     ///< running mean
+    float    m2[SPECTRO_CENTROID_NUM_FEATURES];       ///< sum of squared deviations
+} SpectroCentroidClass_t;
+
+/**
+ * @brief Complete classifier state
+ */
+typedef struct
+{
+    uint32_t version;
+    uint32_t numClasses;
+    SpectroCentroidClass_t cls[SPECTRO_CENTROID_MAX_CLASSES];
+} SpectroCentroidModel_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Clear all classes.
+ */
+void spectro_centroid_reset(SpectroCentroidModel_t *model);
+
+/**
+ * @brief Check that a model (e.g. loaded from flash) is self-consistent.
+ */
+bool spectro_centroid_is_valid(const SpectroCentroidModel_t *model);
+
+/**
+ * @brief Build the feature vector from the 12 sorted channels (L1 normalisation).
+ *
+ * @param[in]  sorted  12 raw channel counts
+ * @param[out] x       SPECTRO_CENTROID_NUM_FEATURES features
+ */
+void spectro_centroid_features(const uint16_t *sorted, float *x);
+
+/**
+ * @brief Find a class by label.
+ * @return class index, or -1 if not enrolled
+ */
+int spectro_centroid_find(const SpectroCentroidModel_t *model, const char *label);
+
+/**
+ * @brief Add one labelled feature vector, creating the class if needed.
+ *
+ * @return class index, or -1 if the label is invalid or the model is full
+ */
+int spectro_centroid_update(SpectroCentroidModel_t *model, const char *label, const float *x);
+
+/**
+ * @brief Remove a class (later classes shift down by one).
+ * @return true if the class existed
+ */
+bool spectro_centroid_forget(SpectroCentroidModel_t *model, const char *label);
+
+/**
+ * @brief Variance of one feature of one class (floored).
+ */
+float spectro_centroid_variance(const SpectroCentroidClass_t *cls, int feature);
+
+/**
+ * @brief Classify a feature vector.
+ *
+ * @param[in]  model  Classifier
+ * @param[in]  x      Feature vector
+ * @param[out] score  Optional: best diagonal-Gaussian score (lower is closer)
+ * @return best class index, or -1 if no class is enrolled
+ */
+int spectro_centroid_classify(const SpectroCentroidModel_t *model, const float *x, float *score);
+
+#endif // SPECTRO_CENTROID_H
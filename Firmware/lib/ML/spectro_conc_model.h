@@ -0,0 +1,52 @@
+/********************************************************
+ * @file        	spectro_conc_model.h
+ * @brief       	Concentration regression coefficients
+ *
+ * @details
+ *  - GENERATED by Data_analysis/train_concentration_regression.py
+ *  - Do not edit by hand, re-run the script instead
+ *  - Preprocessing spec: absorbance (checked against its hash at startup)
+ *  - Targets: low=25%, medium=50%, high=100%
+ *  - Hold-out beer-lambert: MAE=7.91%  RMSE=11.06%
+ *  - Hold-out ridge: MAE=18.70%  RMSE=23.64%
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_CONC_MODEL_H
+#define SPECTRO_CONC_MODEL_H
+
+#include "spectro_conc_reg.h"
+
+#define SPECTRO_CONC_MODEL_NUM_JUICES   3
+#define SPECTRO_CONC_MODEL_HAS_RIDGE    0
+#define SPECTRO_CONC_MODEL_PREFER_RIDGE 0   // lower hold-out MAE
+#define SPECTRO_CONC_MODEL_NUM_OPS      1
+#define SPECTRO_CONC_MODEL_SPEC_HASH    0x33F170F2UL
+
+static const SpectroModelFeatureOp_t spectro_conc_model_ops[SPECTRO_CONC_MODEL_NUM_OPS] =
+{
+    { SPECTRO_MODEL_OP_ABSORBANCE, 0, 0, 0 },
+};
+
+static const SpectroModelSpec_t spectro_conc_model_spec =
+{
+    spectro_conc_model_ops, SPECTRO_CONC_MODEL_NUM_OPS, 0, NULL, SPECTRO_CONC_MODEL_SPEC_HASH
+};
+
+static const char *const spectro_conc_model_juices[SPECTRO_CONC_MODEL_NUM_JUICES] =
+{
+    "apple", "grape", "orange"
+};
+
+// Per-juice Beer-Lambert ridge fit, penalised on standardised features and folded back to
+// the raw absorbance scale (bands differ by ~0.01 between samples, hence the large values),
+// zero coefficient = band not selected
+static const SpectroConcLinear_t spectro_conc_model_linear[SPECTRO_CONC_MODEL_NUM_JUICES] =
+{
+    { -1772.5438f, { 466.638083f, 148.511629f, 385.122826f, 988.820929f, 1553.91242f, 2417.77376f, -2070.63491f, 537.345569f, -3130.72064f, -2667.16721f, 248.799617f, 707.60017f } }, // apple, alpha 0.1, bands [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
+    { -429.517324f, { -326.393571f, 378.769722f, 313.975329f, -518.046673f, 245.529953f, -389.462341f, 351.144196f, -49.7165113f, -765.112563f, 35.0102439f, -643.888524f, 1157.00157f } }, // grape, alpha 0.001, bands [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
+    { -32.8722776f, { 3.10958115f, -33.9513534f, 16.0373399f, 98.101454f, 137.605637f, -23.2691781f, -4.99029785f, -66.9447684f, -76.0945823f, -62.8504558f, 9.88932528f, -21.3786487f } }, // orange, alpha 0.1, bands [0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11]
+};
+
+#endif // SPECTRO_CONC_MODEL_H
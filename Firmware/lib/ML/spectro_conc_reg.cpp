@@ -0,0 +1,125 @@
+/********************************************************
+ * @file        	spectro_conc_reg.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Continuous concentration regression
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <string.h>
+#include <math.h>
+
+#include "spectro_conc_reg.h"
+
+#define NB             SPECTRO_CONC_NUM_BANDS
+#define INV_LN10       0.43429448f
+#define EWMA_ALPHA     (1.0f / (float)(1 << SPECTRO_CONC_VAR_SHIFT))
+
+static_assert(NB == SPECTRO_MODEL_NUM_CHANNELS, "one regression feature per channel");
+
+//==================== Public API implementation ====================//
+
+bool spectro_conc_spec_valid(const SpectroModelSpec_t *spec)
+{
+    if ((spec->numOps != 1) || (spectro_model_spec_check(spec) != NB))
+        return false;
+
+    return (spec->ops[0].op == SPECTRO_MODEL_OP_ABSORBANCE) || (spec->ops[0].op == SPECTRO_MODEL_OP_RAW);
+}
+
+void spectro_conc_features(const SpectroModelSpec_t *spec, const uint16_t *sorted, float *f)
+{
+    double ch[NB];
+    for (int i = 0; i < NB; i++)
+        ch[i] = sorted[i];
+
+    // same kernel as the package models, so training and device agree
+    spectro_model_spec_features(spec, ch, -1, f);
+}
+
+void spectro_conc_stats_reset(SpectroConcStats_t *stats)
+{
+    memset(stats, 0, sizeof(*stats));
+}
+
+void spectro_conc_stats_update(SpectroConcStats_t *stats, const uint16_t *sorted)
+{
+    if (stats->frames == 0)
+    {
+        for (int i = 0; i < NB; i++)
+        {
+            stats->mean[i] = (float)sorted[i];
+            stats->var[i] = 0.0f;
+        }
+        stats->frames = 1;
+        return;
+    }
+
+    // incremental EWMA variance (West 1979)
+    for (int i = 0; i < NB; i++)
+    {
+        float d = (float)sorted[i] - stats->mean[i];
+        float incr = EWMA_ALPHA * d;
+        stats->mean[i] += incr;
+        stats->var[i] = (1.0f - EWMA_ALPHA) * (stats->var[i] + d * incr);
+    }
+    stats->frames++;
+}
+
+void spectro_conc_feature_variance(const SpectroModelSpec_t *spec, const SpectroConcStats_t *stats,
+                                   const uint16_t *sorted, float *fvar)
+{
+    bool absorbance = (spec->ops[0].op == SPECTRO_MODEL_OP_ABSORBANCE);
+
+    for (int i = 0; i < NB; i++)
+    {
+        if (stats->frames < 2)
+        {
+            fvar[i] = 0.0f;
+            continue;
+        }
+
+        float in = (sorted[i] > 0) ? (float)sorted[i] : 1.0f;
+        float k = absorbance ? (INV_LN10 / in) : 1.0f;   // d f / d I
+        fvar[i] = stats->var[i] * k * k;
+    }
+}
+
+void spectro_conc_predict_linear(const SpectroConcLinear_t *model, const float *f, const float *fvar,
+                                 SpectroConcResult_t *result)
+{
+    float c = model->intercept;
+    float var = 0.0f;
+
+    for (int i = 0; i < NB; i++)
+    {
+        float w = model->coef[i];
+        c += w * f[i];
+        var += w * w * fvar[i];
+    }
+
+    result->percent = c;
+    result->sigma = sqrtf(var);
+}
+
+void spectro_conc_predict_ridge(const SpectroConcRidge_t *model, int juice, const float *f, const float *fvar,
+                                SpectroConcResult_t *result)
+{
+    float c = model->intercept;
+    float var = 0.0f;
+
+    if ((juice >= 0) && (juice < SPECTRO_CONC_MAX_JUICES))
+        c += model->juiceCoef[juice];
+
+    for (int i = 0; i < NB; i++)
+    {
+        float w = model->coef[i] * model->invStd[i];
+        c += w * (f[i] - model->mean[i]);
+        var += w * w * fvar[i];
+    }
+
+    result->percent = c;
+    result->sigma = sqrtf(var);
+}
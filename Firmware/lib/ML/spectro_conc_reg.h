@@ -0,0 +1,130 @@
+/********************************************************
+ * @file        	spectro_conc_reg.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Continuous concentration regression
+ *
+ * @details
+ *  - Features from the preprocessing spec exported with the
+ *    coefficients (Data_analysis/preprocess_spec.py, run by the
+ *    spectro_model kernel), normally absorbance:
+ *    f_i = -log10(max(I_i, 1)) per band
+ *  - Per-juice linear fit over selected bands, or a ridge model over
+ *    all bands + juice one-hot, both exported by
+ *    Data_analysis/train_concentration_regression.py
+ *  - Uncertainty from the frame-to-frame channel variance, propagated
+ *    through the linear model: var(c) = sum_i w_i^2 var(f_i),
+ *    var(f_i) = var(I_i) / (I_i ln10)^2 (absorbance), var(I_i) (raw)
+ *  - No Arduino dependency, also builds on the host
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_CONC_REG_H
+#define SPECTRO_CONC_REG_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "spectro_model.h"
+
+//==================== Configuration ====================//
+
+#define SPECTRO_CONC_NUM_BANDS     12     // = AS7343_NUM_SORTED_CHANNELS
+#define SPECTRO_CONC_MAX_JUICES    4
+#define SPECTRO_CONC_VAR_SHIFT     3      // EWMA weight 1/8 for the frame statistics
+
+//==================== Model containers ====================//
+
+/**
+ * @brief Per-juice Beer-Lambert fit: c = intercept + sum coef_i * f_i
+ */
+typedef struct
+{
+    float intercept;
+    float coef[SPECTRO_CONC_NUM_BANDS];
+} SpectroConcLinear_t;
+
+/**
+ * @brief Ridge model: c = intercept + sum coef_i * (f_i - mean_i) * invStd_i + juiceCoef[j]
+ */
+typedef struct
+{
+    float intercept;
+    float mean[SPECTRO_CONC_NUM_BANDS];
+    float invStd[SPECTRO_CONC_NUM_BANDS];
+    float coef[SPECTRO_CONC_NUM_BANDS];
+    float juiceCoef[SPECTRO_CONC_MAX_JUICES];
+} SpectroConcRidge_t;
+
+/**
+ * @brief Running per-channel frame statistics (EWMA mean / variance)
+ */
+typedef struct
+{
+    float    mean[SPECTRO_CONC_NUM_BANDS];
+    float    var[SPECTRO_CONC_NUM_BANDS];
+    uint32_t frames;
+} SpectroConcStats_t;
+
+/**
+ * @brief One concentration estimate
+ */
+typedef struct
+{
+    float percent;   ///< estimated juice percentage
+    float sigma;     ///< 1-sigma uncertainty from frame variance (same unit)
+} SpectroConcResult_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief The exported spec can drive this regression: hash and
+ *        width match, one value per band, and every op is one whose
+ *        variance is propagated (absorbance, raw).
+ */
+bool spectro_conc_spec_valid(const SpectroModelSpec_t *spec);
+
+/**
+ * @brief Features of one frame (spec checked with spectro_conc_spec_valid()).
+ */
+void spectro_conc_features(const SpectroModelSpec_t *spec, const uint16_t *sorted, float *f);
+
+/**
+ * @brief Forget the frame statistics (e.g. after a cuvette change).
+ */
+void spectro_conc_stats_reset(SpectroConcStats_t *stats);
+
+/**
+ * @brief Add one frame to the running statistics.
+ */
+void spectro_conc_stats_update(SpectroConcStats_t *stats, const uint16_t *sorted);
+
+/**
+ * @brief Feature variances var(f_i) of the current frame.
+ *
+ * @param[in]  spec    Preprocessing spec of the features
+ * @param[in]  stats   Frame statistics
+ * @param[in]  sorted  Current frame
+ * @param[out] fvar    12 feature variances (0 until two frames were seen)
+ */
+void spectro_conc_feature_variance(const SpectroModelSpec_t *spec, const SpectroConcStats_t *stats,
+                                   const uint16_t *sorted, float *fvar);
+
+/**
+ * @brief Predict with a per-juice linear model.
+ */
+void spectro_conc_predict_linear(const SpectroConcLinear_t *model, const float *f, const float *fvar,
+                                 SpectroConcResult_t *result);
+
+/**
+ * @brief Predict with the ridge model.
+ *
+ * @param juice  Index into the juice one-hot (< SPECTRO_CONC_MAX_JUICES)
+ */
+void spectro_conc_predict_ridge(const SpectroConcRidge_t *model, int juice, const float *f, const float *fvar,
+                                SpectroConcResult_t *result);
+
+#endif // SPECTRO_CONC_REG_H
@@ -0,0 +1,409 @@
+/********************************************************
+ * @file        	spectro_model.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Versioned binary model package and its inference engine
+ *
+ * @details
+ *  - Validation bounds-checks everything the engine dereferences, so
+ *    predict() itself runs without checks
+ *  - Every tree child index is larger than its parent (validated), so
+ *    a traversal always terminates
+ *  - Preprocessing is done in double and rounded once to float, like
+ *    numpy (float64) followed by sklearn's float32 input conversion
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <stddef.h>
+#include <string.h>
+#include <math.h>
+
+#include "spectro_model.h"
+#include "spectro_crc.h"
+
+//==================== Internal helpers ====================//
+
+static const uint8_t *spectro_model_section_body(const SpectroModelSection_t *sec)
+{
+    return (const uint8_t *)sec + sizeof(SpectroModelSection_t);
+}
+
+/**
+ * @brief Spec view of a section
+ */
+static SpectroModelSpec_t spectro_model_section_spec(const SpectroModelSection_t *sec)
+{
+    SpectroModelSpec_t spec = { sec->ops, sec->numOps, sec->numContext, sec->contextLabels, sec->specHash };
+    return spec;
+}
+
+/**
+ * @brief Width of the feature vector of a spec, 0 if the firmware cannot run it.
+ */
+static uint32_t spectro_model_spec_width(const SpectroModelSpec_t *spec)
+{
+    if ((spec->numOps == 0) || (spec->numOps > SPECTRO_MODEL_MAX_OPS) ||
+        (spec->numContext > SPECTRO_MODEL_MAX_CONTEXT))
+        return 0;
+
+    uint32_t width = 0;
+    for (uint32_t k = 0; k < spec->numOps; k++)
+    {
+        const SpectroModelFeatureOp_t *op = &spec->ops[k];
+        switch (op->op)
+        {
+        case SPECTRO_MODEL_OP_RAW:
+        case SPECTRO_MODEL_OP_L1:
+        case SPECTRO_MODEL_OP_ABSORBANCE:
+            width += SPECTRO_MODEL_NUM_CHANNELS;
+            break;
+        case SPECTRO_MODEL_OP_MEAN:
+            width += 1;
+            break;
+        case SPECTRO_MODEL_OP_RATIO:
+            if ((op->a >= SPECTRO_MODEL_NUM_CHANNELS) || (op->b >= SPECTRO_MODEL_NUM_CHANNELS))
+                return 0;
+            width += 1;
+            break;
+        case SPECTRO_MODEL_OP_ONEHOT:
+            if (spec->numContext == 0)
+                return 0;
+            width += spec->numContext;
+            break;
+        default:
+            return 0;   // op added after this firmware was built
+        }
+    }
+    return (width <= SPECTRO_MODEL_MAX_INPUTS) ? width : 0;
+}
+
+static uint32_t spectro_model_spec_hash(const SpectroModelSpec_t *spec)
+{
+    uint32_t crc = SPECTRO_CRC32_INIT;
+    crc = spectro_crc32_update(crc, spec->ops, spec->numOps * sizeof(SpectroModelFeatureOp_t));
+    if (spec->numContext > 0)
+        crc = spectro_crc32_update(crc, spec->contextLabels, spec->numContext * SPECTRO_MODEL_LABEL_LEN);
+    return crc ^ 0xFFFFFFFFUL;
+}
+
+static bool spectro_model_labels_ok(const char labels[][SPECTRO_MODEL_LABEL_LEN], uint32_t n)
+{
+    for (uint32_t i = 0; i < n; i++)
+    {
+        if (memchr(labels[i], '\0', SPECTRO_MODEL_LABEL_LEN) == NULL)
+            return false;
+    }
+    return true;
+}
+
+static bool spectro_model_validate_linear(const SpectroModelSection_t *sec, uint32_t bodySize)
+{
+    uint32_t need = ((uint32_t)sec->numClasses * sec->numInputs + sec->numClasses) * sizeof(float);
+    return bodySize >= need;
+}
+
+static bool spectro_model_validate_forest(const SpectroModelSection_t *sec, uint32_t bodySize)
+{
+    if (bodySize < sizeof(SpectroModelForest_t))
+        return false;
+
+    const SpectroModelForest_t *f = (const SpectroModelForest_t *)spectro_model_section_body(sec);
+    if ((f->numTrees == 0) || (f->numNodes == 0) || (f->numLeaves == 0))
+        return false;
+
+    // 64-bit arithmetic: counts come from untrusted input
+    uint64_t need = sizeof(SpectroModelForest_t) +
+                    (uint64_t)f->numTrees * sizeof(uint32_t) +
+                    (uint64_t)f->numNodes * sizeof(SpectroModelNode_t) +
+                    (uint64_t)f->numLeaves * sec->numClasses * sizeof(float);
+    if (need > bodySize)
+        return false;
+
+    const uint32_t *root = (const uint32_t *)(f + 1);
+    const SpectroModelNode_t *node = (const SpectroModelNode_t *)(root + f->numTrees);
+
+    for (uint32_t t = 0; t < f->numTrees; t++)
+    {
+        if (root[t] >= f->numNodes)
+            return false;
+    }
+
+    for (uint32_t n = 0; n < f->numNodes; n++)
+    {
+        if (node[n].feature < 0)
+        {
+            if (node[n].leaf >= f->numLeaves)
+                return false;
+        }
+        else
+        {
+            if ((uint32_t)node[n].feature >= sec->numInputs)
+                return false;
+            if ((node[n].right < 2) || (n + node[n].right >= f->numNodes) || (n + 1 >= f->numNodes))
+                return false;
+        }
+    }
+    return true;
+}
+
+//==================== Public API implementation ====================//
+
+bool spectro_model_validate(const uint8_t *image, uint32_t size)
+{
+    if ((image == NULL) || (((uintptr_t)image & 3) != 0) || (size < sizeof(SpectroModelHeader_t)))
+        return false;
+
+    const SpectroModelHeader_t *hdr = (const SpectroModelHeader_t *)image;
+
+    if ((hdr->magic != SPECTRO_MODEL_MAGIC) || (hdr->formatVersion != SPECTRO_MODEL_FORMAT_VERSION) ||
+        (hdr->headerSize != sizeof(SpectroModelHeader_t)))
+        return false;
+    if (spectro_crc32(hdr, offsetof(SpectroModelHeader_t, headerCrc)) != hdr->headerCrc)
+        return false;
+    if ((hdr->numSections == 0) || (hdr->numSections > SPECTRO_MODEL_MAX_SECTIONS))
+        return false;
+    if ((hdr->payloadSize > size - sizeof(SpectroModelHeader_t)) || ((hdr->payloadSize & 3) != 0))
+        return false;
+    if (spectro_crc32(image + sizeof(SpectroModelHeader_t), hdr->payloadSize) != hdr->payloadCrc)
+        return false;
+
+    const uint8_t *p = image + sizeof(SpectroModelHeader_t);
+    uint32_t remaining = hdr->payloadSize;
+
+    for (uint32_t s = 0; s < hdr->numSections; s++)
+    {
+        if (remaining < sizeof(SpectroModelSection_t))
+            return false;
+
+        const SpectroModelSection_t *sec = (const SpectroModelSection_t *)p;
+        if ((sec->sectionSize < sizeof(SpectroModelSection_t)) || (sec->sectionSize > remaining) ||
+            ((sec->sectionSize & 3) != 0))
+            return false;
+
+        if ((sec->numClasses == 0) || (sec->numClasses > SPECTRO_MODEL_MAX_CLASSES) ||
+            (sec->numContext > SPECTRO_MODEL_MAX_CONTEXT))
+            return false;
+        if (!spectro_model_labels_ok(sec->classLabels, sec->numClasses) ||
+            !spectro_model_labels_ok(sec->contextLabels, sec->numContext))
+            return false;
+
+        // the spec must be the one the model was trained with, and runnable here
+        SpectroModelSpec_t spec = spectro_model_section_spec(sec);
+        uint32_t width = spectro_model_spec_check(&spec);
+        if ((width == 0) || (sec->numInputs != width))
+            return false;
+
+        uint32_t bodySize = sec->sectionSize - sizeof(SpectroModelSection_t);
+        bool ok;
+        switch (sec->type)
+        {
+        case SPECTRO_MODEL_TYPE_LINEAR:
+            ok = spectro_model_validate_linear(sec, bodySize);
+            break;
+        case SPECTRO_MODEL_TYPE_FOREST:
+            ok = spectro_model_validate_forest(sec, bodySize);
+            break;
+        default:
+            ok = false;
+            break;
+        }
+        if (!ok)
+            return false;
+
+        p += sec->sectionSize;
+        remaining -= sec->sectionSize;
+    }
+
+    return true;
+}
+
+const SpectroModelHeader_t *spectro_model_header(const uint8_t *image)
+{
+    return (const SpectroModelHeader_t *)image;
+}
+
+const SpectroModelSection_t *spectro_model_find(const uint8_t *image, SpectroModelRole_t role)
+{
+    if (image == NULL)
+        return NULL;
+
+    const SpectroModelHeader_t *hdr = spectro_model_header(image);
+    const uint8_t *p = image + sizeof(SpectroModelHeader_t);
+
+    for (uint32_t s = 0; s < hdr->numSections; s++)
+    {
+        const SpectroModelSection_t *sec = (const SpectroModelSection_t *)p;
+        if (sec->role == (uint8_t)role)
+            return sec;
+        p += sec->sectionSize;
+    }
+    return NULL;
+}
+
+int spectro_model_context_index(const SpectroModelSection_t *sec, const char *label)
+{
+    if ((sec == NULL) || (label == NULL))
+        return -1;
+
+    for (int i = 0; i < sec->numContext; i++)
+    {
+        if (strcmp(sec->contextLabels[i], label) == 0)
+            return i;
+    }
+    return -1;
+}
+
+uint32_t spectro_model_spec_check(const SpectroModelSpec_t *spec)
+{
+    uint32_t width = spectro_model_spec_width(spec);
+    if ((width == 0) || (spectro_model_spec_hash(spec) != spec->hash))
+        return 0;
+    return width;
+}
+
+void spectro_model_features(const SpectroModelSection_t *sec, const double *channels, int context, float *x)
+{
+    SpectroModelSpec_t spec = spectro_model_section_spec(sec);
+    spectro_model_spec_features(&spec, channels, context, x);
+}
+
+void spectro_model_spec_features(const SpectroModelSpec_t *spec, const double *channels, int context, float *x)
+{
+    uint32_t need = 0;
+    for (uint32_t k = 0; k < spec->numOps; k++)
+        need |= 1UL << spec->ops[k].op;
+
+    // single pass over the channels for everything the ops share
+    double absorb[SPECTRO_MODEL_NUM_CHANNELS];
+    if (need & (1UL << SPECTRO_MODEL_OP_ABSORBANCE))
+    {
+        for (int i = 0; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+            absorb[i] = -log10((channels[i] < 1.0) ? 1.0 : channels[i]);
+    }
+
+    // numpy pairwise_sum order for 8 <= n < 128: 8 partial sums, then the tail
+    const double *r = channels;
+    double sum = ((r[0] + r[1]) + (r[2] + r[3])) + ((r[4] + r[5]) + (r[6] + r[7]));
+    for (int i = 8; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+        sum += channels[i];
+
+    uint32_t n = 0;
+    for (uint32_t k = 0; k < spec->numOps; k++)
+    {
+        const SpectroModelFeatureOp_t *op = &spec->ops[k];
+        switch (op->op)
+        {
+        case SPECTRO_MODEL_OP_L1:
+        {
+            // same guard as preprocess_spec.py: a zero sum is replaced by eps
+            double s = (sum == 0.0) ? 1e-12 : sum;
+            for (int i = 0; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+                x[n++] = (float)(channels[i] / s);
+            break;
+        }
+
+        case SPECTRO_MODEL_OP_MEAN:
+            x[n++] = (float)(sum / (double)SPECTRO_MODEL_NUM_CHANNELS);
+            break;
+
+        case SPECTRO_MODEL_OP_ABSORBANCE:
+            for (int i = 0; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+                x[n++] = (float)absorb[i];
+            break;
+
+        case SPECTRO_MODEL_OP_RATIO:
+        {
+            double den = (channels[op->b] == 0.0) ? 1e-12 : channels[op->b];
+            x[n++] = (float)(channels[op->a] / den);
+            break;
+        }
+
+        case SPECTRO_MODEL_OP_ONEHOT:
+            for (int i = 0; i < spec->numContext; i++)
+                x[n++] = (i == context) ? 1.0f : 0.0f;
+            break;
+
+        case SPECTRO_MODEL_OP_RAW:
+        default:
+            for (int i = 0; i < SPECTRO_MODEL_NUM_CHANNELS; i++)
+                x[n++] = (float)channels[i];
+            break;
+        }
+    }
+}
+
+int spectro_model_predict(const SpectroModelSection_t *sec, const float *x, float *proba)
+{
+    const uint8_t *body = spectro_model_section_body(sec);
+    const int nc = sec->numClasses;
+    int best = 0;
+
+    if (sec->type == SPECTRO_MODEL_TYPE_LINEAR)
+    {
+        const float *w = (const float *)body;
+        const float *b = w + nc * sec->numInputs;
+
+        for (int c = 0; c < nc; c++)
+        {
+            float s = b[c];
+            for (int i = 0; i < sec->numInputs; i++)
+                s += w[c * sec->numInputs + i] * x[i];
+            proba[c] = s;
+        }
+
+        if (sec->flags & SPECTRO_MODEL_FLAG_SOFTMAX)
+        {
+            float mx = proba[0];
+            for (int c = 1; c < nc; c++)
+                mx = (proba[c] > mx) ? proba[c] : mx;
+
+            float z = 0.0f;
+            for (int c = 0; c < nc; c++)
+            {
+                proba[c] = expf(proba[c] - mx);
+                z += proba[c];
+            }
+            for (int c = 0; c < nc; c++)
+                proba[c] /= z;
+        }
+
+        // first maximum wins, like np.argmax
+        for (int c = 1; c < nc; c++)
+        {
+            if (proba[c] > proba[best])
+                best = c;
+        }
+    }
+    else
+    {
+        const SpectroModelForest_t *f = (const SpectroModelForest_t *)body;
+        const uint32_t *root = (const uint32_t *)(f + 1);
+        const SpectroModelNode_t *node = (const SpectroModelNode_t *)(root + f->numTrees);
+        const float *leaf = (const float *)(node + f->numNodes);
+
+        // double accumulator: sklearn averages the per-tree float64 probabilities
+        double acc[SPECTRO_MODEL_MAX_CLASSES] = {0};
+
+        for (uint32_t t = 0; t < f->numTrees; t++)
+        {
+            uint32_t n = root[t];
+            while (node[n].feature >= 0)
+                n += (x[node[n].feature] <= node[n].threshold) ? 1u : node[n].right;
+
+            const float *dist = leaf + node[n].leaf * nc;
+            for (int c = 0; c < nc; c++)
+                acc[c] += (double)dist[c];
+        }
+
+        for (int c = 0; c < nc; c++)
+        {
+            proba[c] = (float)(acc[c] / (double)f->numTrees);
+            if (acc[c] > acc[best])
+                best = c;
+        }
+    }
+
+    return best;
+}
@@ -0,0 +1,240 @@
+/********************************************************
+ * @file        	spectro_model.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Versioned binary model package and its inference engine
+ *
+ * @details
+ *  - A package holds up to SPECTRO_MODEL_MAX_SECTIONS models, e.g. the
+ *    juice classifier and the concentration classifier of the PC side
+ *  - Package = header + sections, every structure 4-byte aligned and
+ *    little-endian, so it is used in place from memory-mapped flash
+ *    (no RAM copy) or from a host buffer
+ *  - Header and payload are protected by CRC-32
+ *  - Each section carries its preprocessing spec (feature ops) and the
+ *    spec hash; validation rejects a spec the firmware cannot run or
+ *    whose hash does not match, so a mismatch fails at load time
+ *  - Model types: linear (logistic regression / linear SVM) and
+ *    tree ensemble (random forest, sklearn predict_proba semantics)
+ *  - Packages are written by Data_analysis/export_model.py
+ *  - No Arduino dependency, also builds on the host
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_MODEL_H
+#define SPECTRO_MODEL_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//==================== Format constants ====================//
+
+#define SPECTRO_MODEL_MAGIC            0x4C444D53UL   // "SMDL"
+#define SPECTRO_MODEL_FORMAT_VERSION   2
+#define SPECTRO_MODEL_MAX_SECTIONS     2
+#define SPECTRO_MODEL_MAX_CLASSES      8
+#define SPECTRO_MODEL_MAX_CONTEXT      4              // one-hot context inputs
+#define SPECTRO_MODEL_NUM_CHANNELS     12             // = AS7343_NUM_SORTED_CHANNELS
+#define SPECTRO_MODEL_MAX_OPS          8              // feature ops per section
+#define SPECTRO_MODEL_MAX_INPUTS       32             // features + context
+#define SPECTRO_MODEL_LABEL_LEN        12             // including '\0'
+
+/**
+ * @brief What a section is used for
+ */
+typedef enum
+{
+    SPECTRO_MODEL_ROLE_JUICE = 0,    ///< juice type from the spectrum
+    SPECTRO_MODEL_ROLE_CONC          ///< concentration class, juice one-hot as context
+} SpectroModelRole_t;
+
+typedef enum
+{
+    SPECTRO_MODEL_TYPE_LINEAR = 0,   ///< scores = W x + b
+    SPECTRO_MODEL_TYPE_FOREST        ///< averaged per-tree leaf class distributions
+} SpectroModelType_t;
+
+/**
+ * @brief Feature ops of the preprocessing spec (Data_analysis/preprocess_spec.py)
+ *
+ * @details Features are the concatenated outputs of the ops, in order.
+ */
+typedef enum
+{
+    SPECTRO_MODEL_OP_RAW = 0,        ///< 12 channels as-is
+    SPECTRO_MODEL_OP_L1,             ///< 12 values: channels / sum(channels)
+    SPECTRO_MODEL_OP_MEAN,           ///< 1 value: mean of the channels
+    SPECTRO_MODEL_OP_ABSORBANCE,     ///< 12 values: -log10(max(channel, 1))
+    SPECTRO_MODEL_OP_RATIO,          ///< 1 value: channel a / channel b
+    SPECTRO_MODEL_OP_ONEHOT,         ///< numContext values: context one-hot
+    SPECTRO_MODEL_NUM_OPS
+} SpectroModelOp_t;
+
+/**
+ * @brief One feature op (4 bytes)
+ */
+typedef struct
+{
+    uint8_t op;               ///< SpectroModelOp_t
+    uint8_t a;                ///< RATIO: numerator channel
+    uint8_t b;                ///< RATIO: denominator channel
+    uint8_t reserved;
+} SpectroModelFeatureOp_t;
+
+/**
+ * @brief A preprocessing spec: the ops of a package section, or of a
+ *        model compiled into the firmware (spectro_conc_model.h)
+ */
+typedef struct
+{
+    const SpectroModelFeatureOp_t *ops;
+    uint8_t numOps;
+    uint8_t numContext;
+    const char (*contextLabels)[SPECTRO_MODEL_LABEL_LEN];   ///< numContext labels, NULL if none
+    uint32_t hash;            ///< CRC-32 of ops[0..numOps) + contextLabels[0..numContext)
+} SpectroModelSpec_t;
+
+#define SPECTRO_MODEL_FLAG_SOFTMAX     0x01   // linear: probabilities = softmax(scores)
+
+//==================== Binary layout ====================//
+
+/**
+ * @brief Package header (64 bytes)
+ */
+typedef struct
+{
+    uint32_t magic;           ///< SPECTRO_MODEL_MAGIC
+    uint16_t formatVersion;   ///< SPECTRO_MODEL_FORMAT_VERSION
+    uint16_t headerSize;      ///< sizeof(SpectroModelHeader_t)
+    uint32_t packageVersion;  ///< user version, reported by MODEL INFO
+    uint32_t numSections;
+    uint32_t payloadSize;     ///< bytes following the header
+    uint32_t payloadCrc;      ///< CRC-32 of the payload
+    char     name[32];        ///< free text, '\0' terminated
+    uint32_t reserved;
+    uint32_t headerCrc;       ///< CRC-32 of all previous header bytes
+} SpectroModelHeader_t;
+
+/**
+ * @brief Section header, followed by the type-specific body
+ */
+typedef struct
+{
+    uint32_t sectionSize;     ///< bytes including this header, multiple of 4
+    uint8_t  role;            ///< SpectroModelRole_t
+    uint8_t  type;            ///< SpectroModelType_t
+    uint8_t  numOps;          ///< entries used in ops[]
+    uint8_t  flags;           ///< SPECTRO_MODEL_FLAG_*
+    uint8_t  numClasses;
+    uint8_t  numContext;      ///< one-hot inputs appended after the features
+    uint8_t  numInputs;       ///< total width of the ops
+    uint8_t  reserved;
+    char     classLabels[SPECTRO_MODEL_MAX_CLASSES][SPECTRO_MODEL_LABEL_LEN];
+    char     contextLabels[SPECTRO_MODEL_MAX_CONTEXT][SPECTRO_MODEL_LABEL_LEN];
+    SpectroModelFeatureOp_t ops[SPECTRO_MODEL_MAX_OPS];
+    uint32_t specHash;        ///< CRC-32 of ops[0..numOps) + contextLabels[0..numContext)
+} SpectroModelSection_t;
+
+/**
+ * @brief Linear body: float weight[numClasses][numInputs], float bias[numClasses]
+ */
+
+/**
+ * @brief Forest body header, followed by
+ *        uint32_t root[numTrees], SpectroModelNode_t node[numNodes],
+ *        float leaf[numLeaves][numClasses]
+ */
+typedef struct
+{
+    uint32_t numTrees;
+    uint32_t numNodes;
+    uint32_t numLeaves;
+} SpectroModelForest_t;
+
+/**
+ * @brief Tree node (8 bytes)
+ *
+ * @details
+ *  - Split:  go left (node + 1) if x[feature] <= threshold, else node + right
+ *  - Leaf:   feature < 0, leaf = index into the (deduplicated) leaf table
+ *  - Thresholds are the sklearn float64 thresholds rounded down to float32,
+ *    which keeps the float32 comparison identical to sklearn's
+ */
+typedef struct
+{
+    int16_t  feature;
+    uint16_t right;           ///< offset of the right child from this node
+    union
+    {
+        float    threshold;
+        uint32_t leaf;
+    };
+} SpectroModelNode_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Validate a complete package image (header, CRCs, section bounds).
+ *
+ * @param image  Package bytes (4-byte aligned)
+ * @param size   Available bytes
+ * @return true if the package can be executed safely
+ */
+bool spectro_model_validate(const uint8_t *image, uint32_t size);
+
+/**
+ * @brief Package header of a validated image.
+ */
+const SpectroModelHeader_t *spectro_model_header(const uint8_t *image);
+
+/**
+ * @brief Find the section for a role in a validated image.
+ * @return section, or NULL if the package has no model for this role
+ */
+const SpectroModelSection_t *spectro_model_find(const uint8_t *image, SpectroModelRole_t role);
+
+/**
+ * @brief Index of a context label (e.g. juice name) in a section, -1 if unknown.
+ */
+int spectro_model_context_index(const SpectroModelSection_t *sec, const char *label);
+
+/**
+ * @brief Build the input vector from the section's preprocessing spec.
+ *
+ * @details Fused kernel: one pass over the channels computes everything
+ *          the ops share (sum, absorbance), then the ops only copy/scale.
+ *
+ * @param[in]  sec       Model section
+ * @param[in]  channels  12 channel values (counts, or averaged counts as in
+ *                       the datasets; double so CSV values stay exact)
+ * @param[in]  context   Context index, -1 = all zeros (unknown)
+ * @param[out] x         numInputs values
+ */
+void spectro_model_features(const SpectroModelSection_t *sec, const double *channels, int context, float *x);
+
+/**
+ * @brief Check a spec: runnable by this firmware and matching its hash.
+ * @return feature width, 0 if the spec must not be used
+ */
+uint32_t spectro_model_spec_check(const SpectroModelSpec_t *spec);
+
+/**
+ * @brief spectro_model_features() for a spec outside a package
+ *        (checked with spectro_model_spec_check()).
+ */
+void spectro_model_spec_features(const SpectroModelSpec_t *spec, const double *channels, int context, float *x);
+
+/**
+ * @brief Run a model.
+ *
+ * @param[in]  sec    Model section
+ * @param[in]  x      Input vector from spectro_model_features()
+ * @param[out] proba  numClasses values: probabilities (forest / softmax)
+ *                    or raw decision scores (linear without softmax)
+ * @return predicted class index
+ */
+int spectro_model_predict(const SpectroModelSection_t *sec, const float *x, float *proba);
+
+#endif // SPECTRO_MODEL_H
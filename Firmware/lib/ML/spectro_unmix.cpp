@@ -0,0 +1,280 @@
+/********************************************************
+ * @file        	spectro_unmix.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Spectral unmixing of blends with a fixed-size NNLS solver
+ *
+ * @details
+ *  - min 0.5 * ||E^T x - a||^2  s.t. x >= 0
+ *  - Normal equations: G = E E^T (precomputed), c = E a (per frame)
+ *  - Lawson-Hanson: grow the passive set P by the largest dual
+ *    w = c - G x, step back along x -> z whenever z_P leaves the
+ *    feasible region
+ *  - Worst case per frame: 12*K (c) + MAX_ITER * K^3 multiply-adds
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <string.h>
+#include <math.h>
+
+#include "spectro_unmix.h"
+
+#define K   SPECTRO_UNMIX_NUM_ENDMEMBERS
+#define NB  SPECTRO_UNMIX_NUM_BANDS
+
+static const char *const s_endmemberNames[K] = { "apple", "grape", "orange", "water" };
+
+//==================== Public API implementation ====================//
+
+const char *spectro_unmix_name(int k)
+{
+    return ((k >= 0) && (k < K)) ? s_endmemberNames[k] : "?";
+}
+
+int spectro_unmix_find(const char *name)
+{
+    if (name == NULL)
+        return -1;
+
+    for (int k = 0; k < K; k++)
+    {
+        if (strcmp(name, s_endmemberNames[k]) == 0)
+            return k;
+    }
+    return -1;
+}
+
+void spectro_unmix_reset(SpectroUnmixLibrary_t *lib)
+{
+    if (lib == NULL)
+        return;
+
+    memset(lib, 0, sizeof(*lib));
+    lib->version = SPECTRO_UNMIX_VERSION;
+}
+
+bool spectro_unmix_is_valid(const SpectroUnmixLibrary_t *lib)
+{
+    return (lib != NULL) && (lib->version == SPECTRO_UNMIX_VERSION) &&
+           ((lib->validMask >> K) == 0);
+}
+
+bool spectro_unmix_has_blank(const SpectroUnmixLibrary_t *lib)
+{
+    for (int i = 0; i < NB; i++)
+    {
+        if (lib->blank[i] == 0)
+            return false;
+    }
+    return true;
+}
+
+void spectro_unmix_absorbance(const uint16_t *sorted, const uint16_t *blank, float *a)
+{
+    for (int i = 0; i < NB; i++)
+    {
+        float in = (sorted[i] > 0) ? (float)sorted[i] : 1.0f;
+        float i0 = (blank[i] > 0) ? (float)blank[i] : 1.0f;
+        a[i] = log10f(i0 / in);
+    }
+}
+
+bool spectro_unmix_prepare(const SpectroUnmixLibrary_t *lib, SpectroUnmixSolver_t *solver)
+{
+    if ((lib == NULL) || (solver == NULL))
+        return false;
+
+    float trace = 0.0f;
+
+    for (int r = 0; r < K; r++)
+    {
+        for (int c = 0; c < K; c++)
+        {
+            float g = 0.0f;
+            if ((lib->validMask & (1UL << r)) && (lib->validMask & (1UL << c)))
+            {
+                for (int i = 0; i < NB; i++)
+                    g += lib->endmember[r][i] * lib->endmember[c][i];
+            }
+            solver->gram[r][c] = g;
+        }
+        trace += solver->gram[r][r];
+    }
+
+    solver->ridge = 1e-6f * trace;
+    solver->ready = (trace > 0.0f);
+    return solver->ready;
+}
+
+/*******************************************************
+ * @brief  Unconstrained least squares on the passive set
+ *
+ * @details
+ *  - Solves G_PP z_P = c_P by Cholesky, z = 0 outside P
+ *  - G_PP is at most K x K, factorised in place on the stack
+ *******************************************************/
+static void spectro_unmix_solve_passive(const SpectroUnmixSolver_t *solver, const float *c,
+                                        const bool *passive, float *z)
+{
+    int idx[K];
+    int n = 0;
+    float l[K][K];
+    float y[K];
+
+    for (int k = 0; k < K; k++)
+    {
+        z[k] = 0.0f;
+        if (passive[k])
+            idx[n++] = k;
+    }
+
+    // Cholesky: G_PP = L L^T
+    for (int r = 0; r < n; r++)
+    {
+        for (int col = 0; col <= r; col++)
+        {
+            float sum = solver->gram[idx[r]][idx[col]];
+            for (int m = 0; m < col; m++)
+                sum -= l[r][m] * l[col][m];
+
+            if (r == col)
+            {
+                sum += solver->ridge;
+                l[r][r] = sqrtf((sum > 0.0f) ? sum : solver->ridge);
+            }
+            else
+            {
+                l[r][col] = sum / l[col][col];
+            }
+        }
+    }
+
+    // forward (L y = c_P) then backward (L^T z_P = y) substitution
+    for (int r = 0; r < n; r++)
+    {
+        float sum = c[idx[r]];
+        for (int m = 0; m < r; m++)
+            sum -= l[r][m] * y[m];
+        y[r] = sum / l[r][r];
+    }
+    for (int r = n - 1; r >= 0; r--)
+    {
+        float sum = y[r];
+        for (int m = r + 1; m < n; m++)
+            sum -= l[m][r] * z[idx[m]];
+        z[idx[r]] = sum / l[r][r];
+    }
+}
+
+void spectro_unmix_solve(const SpectroUnmixLibrary_t *lib, const SpectroUnmixSolver_t *solver,
+                         const float *a, SpectroUnmixResult_t *result)
+{
+    float c[K];
+    float x[K] = {0};
+    float z[K];
+    bool passive[K] = {false};
+
+    memset(result, 0, sizeof(*result));
+
+    // c = E a (unrecorded endmembers stay at zero and never enter P)
+    for (int k = 0; k < K; k++)
+    {
+        c[k] = 0.0f;
+        if (solver->ready && (lib->validMask & (1UL << k)))
+        {
+            for (int i = 0; i < NB; i++)
+                c[k] += lib->endmember[k][i] * a[i];
+        }
+    }
+
+    uint16_t it = 0;
+    while (solver->ready)
+    {
+        // dual w = c - G x, pick the most violated active constraint
+        int best = -1;
+        float bestW = SPECTRO_UNMIX_TOL;
+        for (int k = 0; k < K; k++)
+        {
+            if (passive[k] || !(lib->validMask & (1UL << k)))
+                continue;
+
+            float w = c[k];
+            for (int j = 0; j < K; j++)
+                w -= solver->gram[k][j] * x[j];
+
+            if (w > bestW)
+            {
+                bestW = w;
+                best = k;
+            }
+        }
+
+        if (best < 0)
+        {
+            result->converged = true;
+            break;
+        }
+        if (it >= SPECTRO_UNMIX_MAX_ITER)
+            break;
+
+        passive[best] = true;
+
+        // inner loop: step back towards x until z is feasible
+        while (it < SPECTRO_UNMIX_MAX_ITER)
+        {
+            it++;
+            spectro_unmix_solve_passive(solver, c, passive, z);
+
+            float alpha = 1.0f;
+            bool feasible = true;
+            for (int k = 0; k < K; k++)
+            {
+                if (passive[k] && (z[k] <= 0.0f))
+                {
+                    feasible = false;
+                    float t = x[k] / (x[k] - z[k]);
+                    if (t < alpha)
+                        alpha = t;
+                }
+            }
+
+            if (feasible)
+            {
+                for (int k = 0; k < K; k++)
+                    x[k] = z[k];
+                break;
+            }
+
+            for (int k = 0; k < K; k++)
+            {
+                x[k] += alpha * (z[k] - x[k]);
+                if (passive[k] && (x[k] <= SPECTRO_UNMIX_TOL))
+                {
+                    x[k] = 0.0f;
+                    passive[k] = false;
+                }
+            }
+        }
+    }
+
+    // residual || a - E^T x ||
+    float r2 = 0.0f;
+    for (int i = 0; i < NB; i++)
+    {
+        float model = 0.0f;
+        for (int k = 0; k < K; k++)
+        {
+            if (lib->validMask & (1UL << k))
+                model += x[k] * lib->endmember[k][i];
+        }
+        float r = a[i] - model;
+        r2 += r * r;
+    }
+
+    for (int k = 0; k < K; k++)
+        result->proportion[k] = x[k];
+    result->residual = sqrtf(r2);
+    result->iterations = it;
+}
@@ -0,0 +1,127 @@
+/********************************************************
+ * @file        	spectro_unmix.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Spectral unmixing of blends with a fixed-size NNLS solver
+ *
+ * @details
+ *  - Absorbance A = -log10(I / I0) against a recorded blank I0
+ *  - Linear mixing model: A = sum_k x_k * E_k, with x_k >= 0
+ *  - Solved with the Lawson-Hanson active-set method on the K x K
+ *    normal equations: each iteration is one small Cholesky solve
+ *    (O(K^3), K = 4), exact after at most a few iterations
+ *  - Sizes fixed at compile time (12 bands, K endmembers), no heap
+ *  - No Arduino dependency, also builds on the host
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_UNMIX_H
+#define SPECTRO_UNMIX_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+//==================== Configuration ====================//
+
+#define SPECTRO_UNMIX_NUM_BANDS         12     // = AS7343_NUM_SORTED_CHANNELS
+#define SPECTRO_UNMIX_NUM_ENDMEMBERS    4      // apple, grape, orange, water
+#define SPECTRO_UNMIX_MAX_ITER          (3 * SPECTRO_UNMIX_NUM_ENDMEMBERS)
+#define SPECTRO_UNMIX_TOL               1e-6f  // KKT tolerance on the dual (gradient)
+#define SPECTRO_UNMIX_VERSION           1
+
+/**
+ * @brief Endmember order, also the order of the reported proportions
+ */
+typedef enum
+{
+    SPECTRO_UNMIX_APPLE = 0,
+    SPECTRO_UNMIX_GRAPE,
+    SPECTRO_UNMIX_ORANGE,
+    SPECTRO_UNMIX_WATER
+} SpectroUnmixEndmember_t;
+
+//==================== Containers ====================//
+
+/**
+ * @brief Stored reference spectra (persisted as a flash record)
+ */
+typedef struct
+{
+    uint32_t version;
+    uint32_t validMask;                                                   ///< bit k: endmember k recorded
+    uint16_t blank[SPECTRO_UNMIX_NUM_BANDS];                              ///< I0, 0 = no blank yet
+    float    endmember[SPECTRO_UNMIX_NUM_ENDMEMBERS][SPECTRO_UNMIX_NUM_BANDS]; ///< absorbance
+} SpectroUnmixLibrary_t;
+
+/**
+ * @brief Precomputed solver state, rebuilt when the library changes
+ */
+typedef struct
+{
+    float gram[SPECTRO_UNMIX_NUM_ENDMEMBERS][SPECTRO_UNMIX_NUM_ENDMEMBERS]; ///< E E^T
+    float ridge;                                                          ///< diagonal load for Cholesky
+    bool  ready;
+} SpectroUnmixSolver_t;
+
+/**
+ * @brief Result of one frame
+ */
+typedef struct
+{
+    float    proportion[SPECTRO_UNMIX_NUM_ENDMEMBERS];  ///< x_k >= 0 (1.0 = pure endmember)
+    float    residual;                                 ///< ||A - E^T x||_2
+    uint16_t iterations;                               ///< least-squares solves used
+    bool     converged;                                ///< KKT conditions met before MAX_ITER
+} SpectroUnmixResult_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Endmember name for printing ("apple", ...).
+ */
+const char *spectro_unmix_name(int k);
+
+/**
+ * @brief Endmember index for a name, -1 if unknown.
+ */
+int spectro_unmix_find(const char *name);
+
+/**
+ * @brief Clear blank and endmembers.
+ */
+void spectro_unmix_reset(SpectroUnmixLibrary_t *lib);
+
+/**
+ * @brief Check that a library (e.g. loaded from flash) is self-consistent.
+ */
+bool spectro_unmix_is_valid(const SpectroUnmixLibrary_t *lib);
+
+/**
+ * @brief true once a blank reference has been recorded.
+ */
+bool spectro_unmix_has_blank(const SpectroUnmixLibrary_t *lib);
+
+/**
+ * @brief Absorbance of a frame against the blank (counts clamped to >= 1).
+ *
+ * @param[in]  sorted  12 raw channel counts
+ * @param[in]  blank   12 blank channel counts
+ * @param[out] a       12 absorbance values
+ */
+void spectro_unmix_absorbance(const uint16_t *sorted, const uint16_t *blank, float *a);
+
+/**
+ * @brief Precompute the Gram matrix.
+ * @return true if at least one endmember is recorded
+ */
+bool spectro_unmix_prepare(const SpectroUnmixLibrary_t *lib, SpectroUnmixSolver_t *solver);
+
+/**
+ * @brief Solve the NNLS problem for one absorbance spectrum.
+ */
+void spectro_unmix_solve(const SpectroUnmixLibrary_t *lib, const SpectroUnmixSolver_t *solver,
+                         const float *a, SpectroUnmixResult_t *result);
+
+#endif // SPECTRO_UNMIX_H
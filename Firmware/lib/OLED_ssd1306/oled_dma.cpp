@@ -0,0 +1,179 @@
+/********************************************************
+ * @file        	oled_dma.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Background flush of the SSD1306 framebuffer as a transfer list
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "oled_dma.h"
+
+#include <string.h>
+
+//==================== Internal helpers ====================//
+
+/***
+ * @brief Start transfers until one is left running in the background
+ *
+ * @details
+ *  - A transfer that completes inside start() (a blocking backend, or
+ *    the interrupt of a short transfer before start() returns) is
+ *    only recorded by oled_dma_complete(); the loop here continues
+ *  - Once start() has returned, the interrupt continues the list
+ ***/
+static void oled_dma_run(OledDma_t *dma)
+{
+    while (dma->next < dma->count)
+    {
+        const OledDmaTransfer_t *t = &dma->list[dma->next];
+
+        dma->deferred = false;
+        dma->starting = true;
+        dma->io.start(dma->io.ctx, t->data, t->len, t->dc);
+        dma->starting = false;
+        if (!dma->deferred)
+            return;   // oled_dma_complete() continues
+    }
+
+    dma->io.done(dma->io.ctx);
+    dma->busy = false;
+}
+
+/***
+ * @brief Column and page window commands (horizontal addressing):
+ *        the data that follows fills it row by row
+ ***/
+static void oled_dma_window(uint8_t *cmd, uint8_t colLo, uint8_t colHi, uint8_t pageLo, uint8_t pageHi)
+{
+    cmd[0] = 0x21;
+    cmd[1] = colLo;
+    cmd[2] = colHi;
+    cmd[3] = 0x22;
+    cmd[4] = pageLo;
+    cmd[5] = pageHi;
+}
+
+//==================== Public API implementation ====================//
+
+void oled_dma_init(OledDma_t *dma, const OledDmaIo_t *io)
+{
+    memset(dma, 0, sizeof(*dma));
+    dma->io = *io;
+}
+
+uint16_t oled_dma_start(OledDma_t *dma, OledFb_t *fb)
+{
+    uint8_t colLo[OLED_FB_PAGES], colHi[OLED_FB_PAGES];
+    bool dirty[OLED_FB_PAGES] = { false };
+    uint16_t best[OLED_FB_PAGES + 1];    // bus cost of the pages below i
+    int8_t from[OLED_FB_PAGES + 1];      // first page of the window ending at i - 1, -1: none
+    uint8_t page, col, len;
+
+    if (dma->busy || !oled_fb_dirty(fb))
+        return 0;
+
+    while (oled_fb_take_span(fb, &page, &col, &len))
+    {
+        dirty[page] = true;
+        colLo[page] = col;
+        colHi[page] = (uint8_t)(col + len - 1);
+    }
+
+    // windows over runs of pages: each costs its command bytes and
+    // transfers, and every byte of its rectangle, clean ones included
+    best[0] = 0;
+    for (uint8_t i = 1; i <= OLED_FB_PAGES; i++)
+    {
+        best[i] = best[i - 1];
+        from[i] = -1;
+        if (!dirty[i - 1])
+            continue;
+
+        best[i] = UINT16_MAX;
+        uint8_t lo = OLED_FB_COLUMNS - 1, hi = 0;
+        for (int8_t j = (int8_t)(i - 1); j >= 0; j--)
+        {
+            if (!dirty[j])
+                continue;
+            lo = (colLo[j] < lo) ? colLo[j] : lo;
+            hi = (colHi[j] > hi) ? colHi[j] : hi;
+
+            uint16_t cost = (uint16_t)(best[j] + OLED_DMA_WINDOW_BYTES + 2 * OLED_DMA_TRANSFER_COST +
+                                       (hi - lo + 1) * (i - j));
+            if (cost < best[i])
+            {
+                best[i] = cost;
+                from[i] = j;
+            }
+        }
+    }
+
+    // windows from the bottom up, then sent top down
+    uint8_t winLo[OLED_FB_PAGES], winHi[OLED_FB_PAGES];
+    uint8_t windows = 0;
+    for (int8_t i = OLED_FB_PAGES; i > 0;)
+    {
+        if (from[i] < 0)
+        {
+            i--;
+            continue;
+        }
+        winLo[windows] = (uint8_t)from[i];
+        winHi[windows] = (uint8_t)(i - 1);
+        windows++;
+        i = from[i];
+    }
+
+    uint16_t used = 0;
+    dma->count = 0;
+    for (int8_t w = (int8_t)(windows - 1); w >= 0; w--)
+    {
+        uint8_t lo = OLED_FB_COLUMNS - 1, hi = 0;
+        for (uint8_t p = winLo[w]; p <= winHi[w]; p++)
+        {
+            if (dirty[p])
+            {
+                lo = (colLo[p] < lo) ? colLo[p] : lo;
+                hi = (colHi[p] > hi) ? colHi[p] : hi;
+            }
+        }
+
+        // clean bytes inside the window equal the panel (no flush is
+        // running), resending them is harmless
+        uint8_t *addr = dma->addr[dma->count / 2];
+        uint16_t start = used;
+        oled_dma_window(addr, lo, hi, winLo[w], winHi[w]);
+        for (uint8_t p = winLo[w]; p <= winHi[w]; p++)
+        {
+            memcpy(&dma->back[used], &fb->buf[p][lo], hi - lo + 1);
+            used = (uint16_t)(used + hi - lo + 1);
+        }
+        dma->list[dma->count++] = { addr, OLED_DMA_WINDOW_BYTES, 0 };
+        dma->list[dma->count++] = { &dma->back[start], (uint16_t)(used - start), 1 };
+    }
+
+    dma->next = 0;
+    dma->busy = true;
+    dma->io.begin(dma->io.ctx);
+    oled_dma_run(dma);
+    return (uint16_t)(windows * OLED_DMA_WINDOW_BYTES + used);
+}
+
+bool oled_dma_busy(const OledDma_t *dma)
+{
+    return dma->busy;
+}
+
+void oled_dma_complete(OledDma_t *dma)
+{
+    if (!dma->busy)
+        return;
+
+    dma->next = (uint8_t)(dma->next + 1);
+    if (dma->starting)
+        dma->deferred = true;   // oled_dma_run() is still in start()
+    else
+        oled_dma_run(dma);
+}
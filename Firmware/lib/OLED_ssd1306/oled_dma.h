@@ -0,0 +1,105 @@
+/********************************************************
+ * @file        	oled_dma.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Background flush of the SSD1306 framebuffer as a transfer list
+ *
+ * @details
+ *  - oled_dma_start() takes the dirty spans of the drawing framebuffer
+ *    and copies them into its own back buffer, then returns: drawing
+ *    the next screen goes on in the framebuffer while the back buffer
+ *    is on the bus (double buffering, a span is never sent half-drawn)
+ *  - The controller runs in horizontal addressing mode: a column /
+ *    page window (0x21 / 0x22, six command bytes, DC low) is followed
+ *    by one data stream (DC high) that fills it row by row. Runs of
+ *    dirty pages share a window around their changed columns; the
+ *    split into windows costs the fewest bus bytes (a full screen is
+ *    one 1024 byte stream, far apart changes get a window each)
+ *  - The backend starts one transfer at a time; its transfer-complete
+ *    interrupt calls oled_dma_complete(), which starts the next one,
+ *    and done() after the last
+ *  - Changes drawn while a list runs stay dirty in the framebuffer
+ *    and go with the next oled_dma_start()
+ *  - A backend may also finish a transfer inside start() (blocking
+ *    SPI, the host simulation): the list then runs to the end before
+ *    oled_dma_start() returns
+ *  - Arduino-free, also built by the host tools (Firmware/host,
+ *    oled_bench simulates the SPI peripheral and the controller)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef OLED_DMA_H
+#define OLED_DMA_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "oled_framebuffer.h"
+
+#define OLED_DMA_WINDOW_BYTES   6                    // 0x21 first, last column, 0x22 first, last page
+#define OLED_DMA_TRANSFER_COST  2                    // bus bytes lost per transfer (interrupt, restart)
+#define OLED_DMA_MAX_TRANSFERS  (2 * OLED_FB_PAGES)
+
+/**
+ * @brief Bus access
+ *
+ * @details
+ *  - begin(): before the first transfer of a list (CS low)
+ *  - start(): one transfer, dc 0 = command, 1 = data; the buffer stays
+ *    untouched until oled_dma_complete()
+ *  - done(): after the last transfer (CS high), interrupt context
+ */
+typedef struct
+{
+    void (*begin)(void *ctx);
+    void (*start)(void *ctx, const uint8_t *data, uint16_t len, uint8_t dc);
+    void (*done)(void *ctx);
+    void *ctx;
+} OledDmaIo_t;
+
+typedef struct
+{
+    const uint8_t *data;
+    uint16_t len;
+    uint8_t  dc;
+} OledDmaTransfer_t;
+
+typedef struct
+{
+    OledDmaIo_t io;
+    uint8_t addr[OLED_FB_PAGES][OLED_DMA_WINDOW_BYTES];
+    uint8_t back[OLED_FB_PAGES * OLED_FB_COLUMNS];    ///< window or spans being sent
+    OledDmaTransfer_t list[OLED_DMA_MAX_TRANSFERS];
+    uint8_t count;
+    volatile uint8_t next;        ///< transfer running
+    volatile bool starting;       ///< inside io.start()
+    volatile bool deferred;       ///< completed inside io.start()
+    volatile bool busy;           ///< list not finished
+} OledDma_t;
+
+//==================== Public API ====================//
+
+void oled_dma_init(OledDma_t *dma, const OledDmaIo_t *io);
+
+/**
+ * @brief Copy the dirty spans out of fb and start sending them.
+ *
+ * @return Bytes queued (commands + data), 0 if a list is still
+ *         running (fb keeps its changes) or nothing is dirty
+ */
+uint16_t oled_dma_start(OledDma_t *dma, OledFb_t *fb);
+
+/**
+ * @brief A list is still on the bus.
+ */
+bool oled_dma_busy(const OledDma_t *dma);
+
+/**
+ * @brief The running transfer finished: start the next one or end the
+ *        list. Called by the backend, usually from its interrupt.
+ */
+void oled_dma_complete(OledDma_t *dma);
+
+#endif // OLED_DMA_H
@@ -0,0 +1,111 @@
+/********************************************************
+ * @file        	oled_framebuffer.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	RAM copy of the SSD1306 display with dirty ranges
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "oled_framebuffer.h"
+
+#include <string.h>
+
+//==================== Internal helpers ====================//
+
+static void oled_fb_mark(OledFb_t *fb, uint8_t page, uint8_t col)
+{
+    if (fb->dirtyHi[page] < fb->dirtyLo[page])
+    {
+        fb->dirtyLo[page] = col;
+        fb->dirtyHi[page] = col;
+    }
+    else if (col < fb->dirtyLo[page])
+        fb->dirtyLo[page] = col;
+    else if (col > fb->dirtyHi[page])
+        fb->dirtyHi[page] = col;
+}
+
+static void oled_fb_clean(OledFb_t *fb, uint8_t page)
+{
+    fb->dirtyLo[page] = OLED_FB_COLUMNS - 1;
+    fb->dirtyHi[page] = 0;
+}
+
+//==================== Public API implementation ====================//
+
+void oled_fb_init(OledFb_t *fb)
+{
+    memset(fb->buf, 0, sizeof(fb->buf));
+    oled_fb_invalidate(fb);
+}
+
+void oled_fb_invalidate(OledFb_t *fb)
+{
+    for (uint8_t p = 0; p < OLED_FB_PAGES; p++)
+    {
+        fb->dirtyLo[p] = 0;
+        fb->dirtyHi[p] = OLED_FB_COLUMNS - 1;
+    }
+}
+
+void oled_fb_write(OledFb_t *fb, uint8_t page, uint8_t col, const uint8_t *data, uint16_t len)
+{
+    if (page >= OLED_FB_PAGES)
+        return;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t c = (uint8_t)((col + i) % OLED_FB_COLUMNS);
+        if (fb->buf[page][c] != data[i])
+        {
+            fb->buf[page][c] = data[i];
+            oled_fb_mark(fb, page, c);
+        }
+    }
+}
+
+void oled_fb_fill(OledFb_t *fb, uint8_t pageStart, uint8_t pageEnd, uint8_t value)
+{
+    if (pageEnd > OLED_FB_PAGES)
+        pageEnd = OLED_FB_PAGES;
+
+    for (uint8_t p = pageStart; p < pageEnd; p++)
+    {
+        for (uint8_t c = 0; c < OLED_FB_COLUMNS; c++)
+        {
+            if (fb->buf[p][c] != value)
+            {
+                fb->buf[p][c] = value;
+                oled_fb_mark(fb, p, c);
+            }
+        }
+    }
+}
+
+bool oled_fb_dirty(const OledFb_t *fb)
+{
+    for (uint8_t p = 0; p < OLED_FB_PAGES; p++)
+    {
+        if (fb->dirtyHi[p] >= fb->dirtyLo[p])
+            return true;
+    }
+    return false;
+}
+
+bool oled_fb_take_span(OledFb_t *fb, uint8_t *page, uint8_t *col, uint8_t *len)
+{
+    for (uint8_t p = 0; p < OLED_FB_PAGES; p++)
+    {
+        if (fb->dirtyHi[p] < fb->dirtyLo[p])
+            continue;
+
+        *page = p;
+        *col = fb->dirtyLo[p];
+        *len = (uint8_t)(fb->dirtyHi[p] - fb->dirtyLo[p] + 1);
+        oled_fb_clean(fb, p);
+        return true;
+    }
+    return false;
+}
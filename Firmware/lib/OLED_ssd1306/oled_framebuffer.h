@@ -0,0 +1,78 @@
+/********************************************************
+ * @file        	oled_framebuffer.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	RAM copy of the SSD1306 display with dirty ranges
+ *
+ * @details
+ *  - 8 pages x 128 columns, one byte = 8 vertical pixels, the layout
+ *    of the controller's GDDRAM, so a span is sent as it is stored
+ *  - Drawing only changes RAM; each page remembers the first and last
+ *    column whose byte actually changed, so redrawing the same text
+ *    costs nothing on the bus
+ *  - A flush takes one span per dirty page (oled_fb_take_span())
+ *    and sends the spans in column / page windows (oled_dma.h)
+ *  - Arduino-free
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef OLED_FRAMEBUFFER_H
+#define OLED_FRAMEBUFFER_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OLED_FB_PAGES     8
+#define OLED_FB_COLUMNS   128
+
+typedef struct
+{
+    uint8_t buf[OLED_FB_PAGES][OLED_FB_COLUMNS];
+    uint8_t dirtyLo[OLED_FB_PAGES];   ///< first changed column
+    uint8_t dirtyHi[OLED_FB_PAGES];   ///< last changed column, < dirtyLo: page clean
+} OledFb_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief All pixels off, every page dirty (the panel RAM is unknown).
+ */
+void oled_fb_init(OledFb_t *fb);
+
+/**
+ * @brief Mark every page dirty, e.g. after the panel was reset.
+ */
+void oled_fb_invalidate(OledFb_t *fb);
+
+/**
+ * @brief Write a run of column bytes into one page.
+ *
+ * @details
+ *  - Columns past 127 wrap to 0 like the controller's page
+ *    addressing mode; pages past 7 are ignored
+ */
+void oled_fb_write(OledFb_t *fb, uint8_t page, uint8_t col, const uint8_t *data, uint16_t len);
+
+/**
+ * @brief Set pages [pageStart, pageEnd) to one byte value (0 = clear).
+ */
+void oled_fb_fill(OledFb_t *fb, uint8_t pageStart, uint8_t pageEnd, uint8_t value);
+
+/**
+ * @brief Any page waiting for a flush.
+ */
+bool oled_fb_dirty(const OledFb_t *fb);
+
+/**
+ * @brief Next dirty span, lowest page first, marked clean.
+ *
+ * @param[out] page  Page 0..7
+ * @param[out] col   First column
+ * @param[out] len   Bytes, from fb->buf[page][col]
+ * @return false once nothing is dirty
+ */
+bool oled_fb_take_span(OledFb_t *fb, uint8_t *page, uint8_t *col, uint8_t *len);
+
+#endif // OLED_FRAMEBUFFER_H
@@ -14,6 +14,8 @@
 
 #include "oled_ssd1306.h"
 #include "oled_font_picture.h"
+#include "oled_framebuffer.h"
+#include "oled_dma.h"
 
 
 //*******************************Initialize static function***************************************
@@ -79,8 +81,8 @@
         0x12,
         0xDB, // set vcomh
         0x40, // set VCOM Deselect Level 0x30 some programme
-        0x20, // set Page Addressing Mode (0x00/0x01/0x02)
-        0x02,
+        0x20, // set Horizontal Addressing Mode (0x00/0x01/0x02): flushes send windows
+        0x00,
         0x8D, // set Charge Pump enable/disable
         0x14, // set(0x10) disable
         0xA4, // disable Entire Display On (0xa4/0xa5)
@@ -112,6 +114,12 @@ static uint8_t oled_display_data[DISPLAY_DATA] = {
     0xAE
 }; 
 
+static OledFb_t s_fb;          // all drawing goes here, oled_flush() sends the changes
+static OledDma_t s_dma;        // back buffer and transfer list of the flush on the bus
+static OledStats_t s_stats;
+static uint32_t s_flushStartUs = 0;
+static bool s_flushInit = false;   // s_dma set up by oled_ssd1306_init()
+
 
 //*******************************Driver function***************************************
 
@@ -131,52 +139,109 @@ void oled_write_byte(unsigned char dat, unsigned char cmd)
 }
 
 /**
- * @brief clean the screen
-*/
-void oled_clear(void)
+ * @brief Column a glyph drawn at x starts in: the column the former
+ *        page mode position command addressed (low nibble | 1), so
+ *        text stays where it always was
+ */
+static unsigned char oled_column(unsigned char x)
 {
-    uint8_t i, j;
-    for (i = 0; i < 8; i++)
-    {
-        oled_write_byte(0xb0 + i, OLED_CMD);
-        oled_write_byte(0x00, OLED_CMD);
-        oled_write_byte(0x10, OLED_CMD);
-        for (j = 0; j < 128; j++)
-        {
-            oled_write_byte(0, OLED_DATA);
-        }
-    }
+    return x | 0x01;
 }
 
+static void oled_io_begin(void *ctx)
+{
+    (void)ctx;
+    oled_spi_select();
+}
 
+static void oled_io_start(void *ctx, const uint8_t *data, uint16_t len, uint8_t dc)
+{
+    (void)ctx;
+    oled_spi_start(data, len, dc);
+}
 
+/**
+ * @brief Last transfer of a flush done (END interrupt with OLED_SPI_DMA)
+ */
+static void oled_io_done(void *ctx)
+{
+    (void)ctx;
+    oled_spi_deselect();
+    s_stats.lastBusUs = micros() - s_flushStartUs;
+}
+
+static void oled_spi_done(void)
+{
+    oled_dma_complete(&s_dma);
+}
 
 /**
- * @brief clean the screen lines
-*/
-void oled_clear_lines(unsigned char lineStart, unsigned char lineEnd)
+ * @brief Send the changed spans of the framebuffer
+ *
+ * @details
+ *  - One CS assertion for the whole flush; one column / page window
+ *    and one data stream around the changes, or one per dirty page
+ *    if they are far apart (oled_dma.h)
+ *  - Nothing is sent when the drawing did not change any byte
+ *  - Returns once the spans are copied out and the first transfer
+ *    runs (OLED_SPI_DMA); drawing may go on at once. While the
+ *    previous flush is still on the bus the changes stay dirty and
+ *    oled_poll() sends them when it ends
+ */
+void oled_flush(void)
 {
-    uint8_t i, j;
-    for (i = lineStart; i < lineEnd; i++)
+    if (!s_flushInit || !oled_fb_dirty(&s_fb))
+        return;
+    if (oled_dma_busy(&s_dma))
     {
-        oled_write_byte(0xb0 + i, OLED_CMD);
-        oled_write_byte(0x00, OLED_CMD);
-        oled_write_byte(0x10, OLED_CMD);
-        for (j = 0; j < 128; j++)
-        {
-            oled_write_byte(0, OLED_DATA);
-        }
+        s_stats.deferred++;
+        return;
     }
+
+    uint32_t start = micros();
+    s_flushStartUs = start;
+    uint16_t bytes = oled_dma_start(&s_dma, &s_fb);
+
+    s_stats.lastUs = micros() - start;
+    if (s_stats.lastUs > s_stats.maxUs)
+        s_stats.maxUs = s_stats.lastUs;
+    s_stats.lastBytes = bytes;
+    s_stats.bytes += bytes;
+    s_stats.flushes++;
+}
+
+/**
+ * @brief Send changes a busy bus deferred, once the bus is free
+ * @note  Cheap; called from the loop and while the sensor integrates
+ */
+void oled_poll(void)
+{
+    if (s_flushInit && !oled_dma_busy(&s_dma) && oled_fb_dirty(&s_fb))
+        oled_flush();
+}
+
+void oled_get_stats(OledStats_t *stats)
+{
+    *stats = s_stats;
+}
+
+/**
+ * @brief clean the screen
+*/
+void oled_clear(void)
+{
+    oled_fb_fill(&s_fb, 0, 8, 0);
 }
 
+
+
+
 /**
- * @brief set the pixel position on the OLED
+ * @brief clean the screen lines
 */
-void oled_set_position(unsigned char x, unsigned char y)
+void oled_clear_lines(unsigned char lineStart, unsigned char lineEnd)
 {
-    oled_write_byte(0xb0 + y, OLED_CMD);
-    oled_write_byte(((x & 0xf0) >> 4) | 0x10, OLED_CMD);
-    oled_write_byte((x & 0x0f) | 0x01, OLED_CMD);
+    oled_fb_fill(&s_fb, lineStart, lineEnd, 0);
 }
 
 /**
@@ -258,8 +323,15 @@ void oled_ssd1306_init(void)
     {
         oled_write_byte(oled_init_data[i], OLED_CMD);
     }
-    oled_clear();
-    // oled_set_position(0, 0);
+    if (!s_flushInit)
+    {
+        const OledDmaIo_t io = { oled_io_begin, oled_io_start, oled_io_done, NULL };
+        oled_dma_init(&s_dma, &io);
+        oled_spi_set_done(oled_spi_done);
+        s_flushInit = true;
+    }
+    oled_fb_init(&s_fb);   // panel RAM unknown: the first flush writes all of it
+    oled_flush();
 }
 
 /**
@@ -281,41 +353,31 @@ void oled_ssd1306_setup(void)
  */
 void oled_show_char(unsigned char x, unsigned char y, const unsigned char chr, unsigned char sizey)
 {
-    unsigned char c = 0, sizex = sizey / 2, temp;
-    unsigned short i = 0, size1;
+    unsigned char c = chr - ' ', sizex = sizey / 2, col = oled_column(x);
+    unsigned short i, size1;
+    const unsigned char *glyph;
+
     if (sizey == 8)
-        size1 = 6;
+        glyph = asc2_0806[c]; // 6X8 size
+    else if (sizey == 12)
+        glyph = asc2_1206[c]; // 6x12 size
+    else if (sizey == 16)
+        glyph = asc2_1608[c]; // 8x16 size
+    else if (sizey == 32)
+        glyph = asc2_2412[c]; // 12x24 size
     else
-        size1 = (sizey / 8 + ((sizey % 8) ? 1 : 0)) * (sizey / 2);
-    c = chr - ' ';
-    oled_set_position(x, y);
-    for (i = 0; i < size1; i++)
+        return;
+
+    if (sizey == 8)
     {
-        if (i % sizex == 0 && sizey != 8)
-            oled_set_position(x, y++);
-        if (sizey == 8)
-        {
-            temp = asc2_0806[c][i];
-            oled_write_byte(temp, OLED_DATA); // 6X8 size
-        }        
-        else if (sizey == 12)
-        {
-            temp = asc2_1206[c][i];
-            oled_write_byte(temp, OLED_DATA); // 6x12 size
-        }
-        else if (sizey == 16)
-        {
-            temp = asc2_1608[c][i];
-            oled_write_byte(temp, OLED_DATA); // 8x16 size
-        }
-        else if (sizey == 32)
-        {
-            temp = asc2_2412[c][i];
-            oled_write_byte(temp, OLED_DATA); // 12x24 size
-        }
-        else
-            return;
+        oled_fb_write(&s_fb, y, col, glyph, 6);
+        return;
     }
+
+    // one row of sizex columns per page
+    size1 = (sizey / 8 + ((sizey % 8) ? 1 : 0)) * sizex;
+    for (i = 0; i < size1; i += sizex)
+        oled_fb_write(&s_fb, y++, col, &glyph[i], sizex);
 }
 
 /**
@@ -377,16 +439,12 @@ void oled_show_string(unsigned char x, unsigned char y, const char *chr, unsigne
 void oled_draw_diagram(unsigned char x, unsigned char y, unsigned char sizex, unsigned char sizey, const unsigned char BMP[])
 {
     unsigned short j = 0;
-    unsigned char i, m, temp;
+    unsigned char i;
     sizey = sizey / 8 + ((sizey % 8) ? 1 : 0);
     for (i = 0; i < sizey; i++)
     {
-        oled_set_position(x, i + y);
-        for (m = 0; m < sizex; m++)
-        {
-            temp = BMP[j++];
-            oled_write_byte(temp, OLED_DATA);
-        }
+        oled_fb_write(&s_fb, i + y, oled_column(x), &BMP[j], sizex);
+        j += sizex;
     }
 }
 
@@ -399,6 +457,7 @@ void oled_test(void)
     char show_time[60] = {0};
 
     oled_draw_diagram(0, 0, 128, 64, image_test);
+    oled_flush();
     delay(2000);
     oled_clear();
 
@@ -420,6 +479,7 @@ void oled_test(void)
             j = 0;
             oled_clear_lines(3,8);
         }
+        oled_flush();
         delay(1000);
     }
 }
@@ -429,6 +489,7 @@ void oled_draw_start_go(void)
 {
     oled_clear();
     oled_show_string(10, 0, "Program Starts", 16); 
+    oled_flush();
     delay(1500);
 
     // couting
@@ -436,16 +497,67 @@ void oled_draw_start_go(void)
     {
       oled_clear();
       oled_show_num(60, 3, num, 1, 16);  
+      oled_flush();
       delay(1000);
     }
 
     oled_clear();
     oled_show_string(52, 3, "GO!", 16); 
+    oled_flush();
     delay(1000);
     oled_clear();
+    oled_flush();
 }
 
 
+/**
+ * @brief Start screen without blocking: same sequence as
+ *        oled_draw_start_go(), one step per oled_start_go_poll() due
+ *
+ * @details
+ *  - Steps (ms from begin): "Program Starts" 0, "3" 1500, "2" 2500,
+ *    "1" 3500, "GO!" 4500, cleared 5500
+ *  - Serial commands and measurements run meanwhile
+ */
+static const uint16_t s_startGoStepMs[] = { 1500, 2500, 3500, 4500, 5500 };
+static uint32_t s_startGoMs = 0;
+static int8_t s_startGoStep = -1;   // -1: not running
+
+void oled_start_go_begin(void)
+{
+    oled_clear();
+    oled_show_string(10, 0, "Program Starts", 16);
+    oled_flush();
+    s_startGoMs = millis();
+    s_startGoStep = 0;
+}
+
+bool oled_start_go_poll(void)
+{
+    const int8_t numSteps = (int8_t)(sizeof(s_startGoStepMs) / sizeof(s_startGoStepMs[0]));
+
+    if ((s_startGoStep < 0) || ((millis() - s_startGoMs) < s_startGoStepMs[s_startGoStep]))
+        return false;
+
+    oled_clear();
+    if (s_startGoStep < 3)
+        oled_show_num(60, 3, 3 - s_startGoStep, 1, 16);
+    else if (s_startGoStep == 3)
+        oled_show_string(52, 3, "GO!", 16);
+    oled_flush();
+
+    if (++s_startGoStep < numSteps)
+        return false;
+
+    s_startGoStep = -1;
+    return true;
+}
+
+bool oled_start_go_active(void)
+{
+    return s_startGoStep >= 0;
+}
+
 void oled_show_mode(void){
   if (spectro_app_get_mode() == SPECTRO_APP_MODE_DATA_LOG) {
     oled_show_string(45, 0, "Mode", 16);
@@ -459,7 +571,37 @@ void oled_show_mode(void){
   } else if (spectro_app_get_mode() == SPECTRO_APP_MODE_INFER_PC) {
     oled_show_string(45, 0, "Mode", 16);
     oled_show_string(35, 2, "Infer PC", 16);
+  } else if (spectro_app_get_mode() == SPECTRO_APP_MODE_UNMIX) {
+    oled_show_string(45, 0, "Mode", 16);
+    oled_show_string(45, 2, "Unmix", 16);
+  } else if (spectro_app_get_mode() == SPECTRO_APP_MODE_CONC_REG) {
+    oled_show_string(45, 0, "Mode", 16);
+    oled_show_string(35, 2, "Conc %", 16);
+  } else if (spectro_app_get_mode() == SPECTRO_APP_MODE_INFER_MODEL) {
+    oled_show_string(45, 0, "Mode", 16);
+    oled_show_string(35, 2, "Infer Model", 16);
+  } else if (spectro_app_get_mode() == SPECTRO_APP_MODE_PROGRESSIVE) {
+    oled_show_string(45, 0, "Mode", 16);
+    oled_show_string(30, 2, "Progressive", 16);
   }
+  oled_flush();
+}
+
+
+/*******************************************************
+ * @brief  Show a result below the mode name
+ *
+ * @details
+ *  - line 4-5: label (16 px), line 7: status (8 px)
+ *******************************************************/
+void oled_show_result(const char *label, const char *status)
+{
+  if (oled_start_go_active())
+    return;   // the start screen keeps the display until it ends
+  oled_clear_lines(4, 8);
+  oled_show_string(20, 4, label, 16);
+  oled_show_string(20, 7, status, 8);
+  oled_flush();   // only the columns that changed, usually part of the label
 }
 
 
@@ -8,6 +8,11 @@
  * @details
  *  - Declaration of initialization and draw functions for ssd1306 OLED
  *  - 128x64 resolution
+ *  - Draw functions render into a RAM framebuffer (oled_framebuffer.h);
+ *    oled_flush() sends the changed spans. The screen functions
+ *    (start screen, mode, result) flush themselves
+ *  - With OLED_SPI_DMA the flush runs in the background (oled_dma.h);
+ *    oled_poll() sends what was drawn while the bus was busy
  * 
  * SPDX-License-Identifier: MIT
  ********************************************************/
@@ -24,8 +29,26 @@
 #define X_WIDTH     128
 #define Y_WIDTH     64 // UI coordinates (can be changed later)
 
+/**
+ * @brief Flush statistics (OLED command)
+ */
+typedef struct
+{
+    uint32_t flushes;     // flushes that sent something
+    uint32_t bytes;       // command + data bytes sent
+    uint16_t lastBytes;
+    uint32_t lastUs;      // CPU time of the last flush
+    uint32_t maxUs;
+    uint32_t lastBusUs;   // start to end of the last flush on the bus
+    uint32_t deferred;    // flushes postponed: the previous one was still on the bus
+} OledStats_t;
+
 extern void oled_ssd1306_setup(void);
 
+extern void oled_flush(void);
+extern void oled_poll(void);
+extern void oled_get_stats(OledStats_t *stats);
+
 extern void oled_clear(void);
 extern void oled_clear_lines(unsigned char lineStart, unsigned char lineEnd);
 
@@ -35,8 +58,6 @@ extern void oled_color_turn(bool status);
 extern void oled_display_turn(bool status);
 extern void oled_display_status(bool status);
 
-extern void oled_set_position(unsigned char x, unsigned char y);
-
 // Draw functions
 
 extern void oled_test(void); // Test function
@@ -47,6 +68,10 @@ extern void oled_draw_diagram(unsigned char x, unsigned char y, const unsigned c
 
 // Specific functions in this task
 extern void oled_draw_start_go(void);
+extern void oled_start_go_begin(void);   // non-blocking start screen, advanced by oled_start_go_poll()
+extern bool oled_start_go_poll(void);    // true once, when the start screen has just finished
+extern bool oled_start_go_active(void);
 extern void oled_show_mode(void);
+extern void oled_show_result(const char *label, const char *status); // lower half: result + status line
 
 #endif
\ No newline at end of file
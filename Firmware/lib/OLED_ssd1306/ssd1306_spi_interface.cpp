@@ -23,41 +23,274 @@
 #define OLED_DC A7    // DC
 #define OLED_CS A6    // CS
 
+// DC / CS through the GPIO OUTSET / OUTCLR registers: one store, where
+// digitalWrite() looks the pin up on every call (several us on mbed)
+typedef struct
+{
+    NRF_GPIO_Type *port;
+    uint32_t mask;
+} OledPin_t;
+
+static OledPin_t s_dc;
+static OledPin_t s_cs;
+
+static OledPin_t oled_pin(int pin)
+{
+    uint32_t n = (uint32_t)digitalPinToPinName(pin);
+    OledPin_t p = { (n >= 32) ? NRF_P1 : NRF_P0, 1U << (n & 31) };
+    return p;
+}
+
+static inline void oled_pin_write(const OledPin_t *pin, bool high)
+{
+    if (high)
+        pin->port->OUTSET = pin->mask;
+    else
+        pin->port->OUTCLR = pin->mask;
+}
+
+static void oled_gpio_init(void)
+{
+    pinMode(OLED_RES, OUTPUT);
+    pinMode(OLED_DC, OUTPUT);
+    pinMode(OLED_CS, OUTPUT);
+    digitalWrite(OLED_CS, HIGH);
+    s_dc = oled_pin(OLED_DC);
+    s_cs = oled_pin(OLED_CS);
+}
+
+
+#if OLED_SPI_DMA
+
+// SPIM2: SPIM0/1 share their peripheral IDs with the TWI instances Wire
+// may use; SPIM3 has data corruption errata (nRF52840 anomaly 198)
+// while the CPU writes the same RAM block, which the drawing does
+#define OLED_SPIM      NRF_SPIM2
+#define OLED_SPIM_IRQ  SPIM2_SPIS2_SPI2_IRQn
+
+static void (*s_done)(void) = NULL;
+static volatile bool s_busy = false;   // between oled_spi_select() and oled_spi_deselect()
+static uint8_t s_tx[OLED_SPI_BURST];  // EasyDMA reads RAM only, never flash
+
+/**
+ * @brief END event: the transfer left the shift register
+ */
+static void oled_spim_irq(void)
+{
+    if (OLED_SPIM->EVENTS_END)
+    {
+        OLED_SPIM->EVENTS_END = 0;
+        (void)OLED_SPIM->EVENTS_END;   // clear before return, no second entry
+        if (s_done)
+            s_done();
+    }
+}
+
+/**
+ * @brief One transfer with the END interrupt off, waiting for it
+ */
+static void oled_spim_blocking(const uint8_t *buf, unsigned int len)
+{
+    OLED_SPIM->INTENCLR = SPIM_INTENCLR_END_Msk;
+    OLED_SPIM->EVENTS_END = 0;
+    OLED_SPIM->TXD.PTR = (uint32_t)(uintptr_t)buf;
+    OLED_SPIM->TXD.MAXCNT = len;
+    OLED_SPIM->TASKS_START = 1;
+    while (OLED_SPIM->EVENTS_END == 0)
+    {
+    }
+    OLED_SPIM->EVENTS_END = 0;
+    NVIC_ClearPendingIRQ(OLED_SPIM_IRQ);
+    OLED_SPIM->INTENSET = SPIM_INTENSET_END_Msk;
+}
+
+static void oled_spi_byte(unsigned char dat, unsigned char dc)
+{
+    while (s_busy)
+    {
+        // a background flush holds the bus
+    }
+    s_tx[0] = dat;
+    oled_pin_write(&s_dc, dc == OLED_DATA);
+    oled_pin_write(&s_cs, false);
+    oled_spim_blocking(s_tx, 1);
+    oled_pin_write(&s_cs, true);
+}
 
 void write_byte_cmd(unsigned char dat)
 {
-    digitalWrite(OLED_DC, LOW);
-    digitalWrite(OLED_CS, LOW);
+    oled_spi_byte(dat, OLED_CMD);
+}
+
+void write_byte_data(unsigned char dat)
+{
+    oled_spi_byte(dat, OLED_DATA);
+}
+
+void oled_spi_select(void)
+{
+    s_busy = true;
+    oled_pin_write(&s_cs, false);
+}
+
+/**
+ * @remark Also called from the END interrupt at the end of a list
+ */
+void oled_spi_deselect(void)
+{
+    oled_pin_write(&s_cs, true);
+    s_busy = false;
+}
+
+void oled_spi_write(const unsigned char *buf, unsigned int len, unsigned char dc)
+{
+    oled_pin_write(&s_dc, dc == OLED_DATA);
+    while (len > 0)
+    {
+        unsigned int n = (len < OLED_SPI_BURST) ? len : OLED_SPI_BURST;
+        memcpy(s_tx, buf, n);
+        oled_spim_blocking(s_tx, n);
+        buf += n;
+        len -= n;
+    }
+}
+
+void oled_spi_set_done(void (*done)(void))
+{
+    s_done = done;
+}
+
+/**
+ * @brief Start one transfer and return; buf must be in RAM and stay
+ *        untouched until the done callback
+ * @note  DC only changes here, after the END of the previous transfer,
+ *        so the controller never latches a byte with the wrong DC
+ */
+void oled_spi_start(const unsigned char *buf, unsigned int len, unsigned char dc)
+{
+    oled_pin_write(&s_dc, dc == OLED_DATA);
+    OLED_SPIM->TXD.PTR = (uint32_t)(uintptr_t)buf;
+    OLED_SPIM->TXD.MAXCNT = len;
+    OLED_SPIM->TASKS_START = 1;
+}
+
+bool oled_spi_busy(void)
+{
+    return s_busy;
+}
+
+void oled_spi_init(void)
+{
+    // GPIO Initialisation: the SPIM drives SCK / MOSI only once
+    // enabled, their idle levels come from the GPIO settings
+    oled_gpio_init();
+    pinMode(PIN_SPI_SCK, OUTPUT);
+    digitalWrite(PIN_SPI_SCK, LOW);
+    pinMode(PIN_SPI_MOSI, OUTPUT);
+
+    // SPIM Initialisation: 8 MHz, mode 0, MSB first, TX only
+    OLED_SPIM->ENABLE = SPIM_ENABLE_ENABLE_Disabled << SPIM_ENABLE_ENABLE_Pos;
+    OLED_SPIM->PSEL.SCK = (uint32_t)digitalPinToPinName(PIN_SPI_SCK);
+    OLED_SPIM->PSEL.MOSI = (uint32_t)digitalPinToPinName(PIN_SPI_MOSI);
+    OLED_SPIM->PSEL.MISO = SPIM_PSEL_MISO_CONNECT_Disconnected << SPIM_PSEL_MISO_CONNECT_Pos;
+    OLED_SPIM->FREQUENCY = SPIM_FREQUENCY_FREQUENCY_M8;
+    OLED_SPIM->CONFIG = 0;
+    OLED_SPIM->ORC = 0;
+    OLED_SPIM->RXD.MAXCNT = 0;
+    OLED_SPIM->EVENTS_END = 0;
+    OLED_SPIM->INTENSET = SPIM_INTENSET_END_Msk;
+    NVIC_SetVector(OLED_SPIM_IRQ, (uint32_t)(uintptr_t)oled_spim_irq);
+    NVIC_EnableIRQ(OLED_SPIM_IRQ);
+    OLED_SPIM->ENABLE = SPIM_ENABLE_ENABLE_Enabled << SPIM_ENABLE_ENABLE_Pos;
+}
+
+#else // !OLED_SPI_DMA
+
+static void (*s_done)(void) = NULL;
+
+void write_byte_cmd(unsigned char dat)
+{
+    oled_pin_write(&s_dc, false);
+    oled_pin_write(&s_cs, false);
     SPI.transfer(dat);
-    digitalWrite(OLED_CS, HIGH);
+    oled_pin_write(&s_cs, true);
 }
 
 void write_byte_data(unsigned char dat)
 {
-    digitalWrite(OLED_DC, HIGH);
-    digitalWrite(OLED_CS, LOW);
+    oled_pin_write(&s_dc, true);
+    oled_pin_write(&s_cs, false);
     SPI.transfer(dat);
-    digitalWrite(OLED_CS, HIGH);
+    oled_pin_write(&s_cs, true);
+}
+
+void oled_spi_select(void)
+{
+    oled_pin_write(&s_cs, false);
+}
+
+void oled_spi_deselect(void)
+{
+    oled_pin_write(&s_cs, true);
+}
+
+/**
+ * @brief Send a run of bytes under the current CS, DC set once
+ * @note  SPI.transfer(buf, n) overwrites buf with the received bytes,
+ *        so the run is copied out first (the framebuffer must survive)
+ */
+void oled_spi_write(const unsigned char *buf, unsigned int len, unsigned char dc)
+{
+    static uint8_t s_tx[OLED_SPI_BURST];
+
+    oled_pin_write(&s_dc, dc == OLED_DATA);
+    while (len > 0)
+    {
+        unsigned int n = (len < OLED_SPI_BURST) ? len : OLED_SPI_BURST;
+        memcpy(s_tx, buf, n);
+        SPI.transfer(s_tx, n);
+        buf += n;
+        len -= n;
+    }
+}
+
+void oled_spi_set_done(void (*done)(void))
+{
+    s_done = done;
+}
+
+void oled_spi_start(const unsigned char *buf, unsigned int len, unsigned char dc)
+{
+    oled_spi_write(buf, len, dc);
+    if (s_done)
+        s_done();
+}
+
+bool oled_spi_busy(void)
+{
+    return false;
 }
 
 void oled_spi_init(void)
 {
     // GPIO Initialisation
-    pinMode(OLED_RES, OUTPUT);
-    pinMode(OLED_DC, OUTPUT);
-    pinMode(OLED_CS, OUTPUT);
+    oled_gpio_init();
 
     // SPI Initialisation
     SPI.begin();
     SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
 }
 
+#endif // OLED_SPI_DMA
+
 void oled_spi_reset(void)
 {
+    // RES# low for at least 3 us (SSD1306 datasheet); ms margins as in
+    // common drivers, the boot no longer waits 600 ms here
     digitalWrite(OLED_RES, HIGH);
-    delay(200);
+    delay(1);
     digitalWrite(OLED_RES, LOW);
-    delay(200);
+    delay(10);
     digitalWrite(OLED_RES, HIGH);
-    delay(200);
-}
\ No newline at end of file
+    delay(1);
+}
@@ -29,11 +29,31 @@
 #define OLED_CMD 0
 #define OLED_DATA 1
 
+#define OLED_SPI_BURST 128   // bytes copied per SPI.transfer() of a burst
+
+// 1: SPIM2 EasyDMA (nRF52840), oled_spi_start() returns at once and
+// the END interrupt calls the done callback; 0: Arduino SPI library,
+// oled_spi_start() blocks and calls it before returning
+#ifndef OLED_SPI_DMA
+#define OLED_SPI_DMA 1
+#endif
+
 extern void oled_spi_init(void);
 extern void write_byte_cmd(unsigned char dat);
 extern void write_byte_data(unsigned char dat);
 extern void oled_spi_reset(void);
 
+// Bursts: one CS assertion around any number of command / data runs
+extern void oled_spi_select(void);
+extern void oled_spi_deselect(void);
+extern void oled_spi_write(const unsigned char *buf, unsigned int len, unsigned char dc); // dc: OLED_CMD / OLED_DATA
+
+// Background transfers between select and deselect; the byte writes
+// above wait until deselect
+extern void oled_spi_set_done(void (*done)(void));
+extern void oled_spi_start(const unsigned char *buf, unsigned int len, unsigned char dc);
+extern bool oled_spi_busy(void);
+
 
 #endif
 
@@ -0,0 +1,155 @@
+/********************************************************
+ * @file        	spectro_ble_link.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Notification packing and scheduling of the BLE transport
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_ble_link.h"
+
+#include <string.h>
+
+//==================== Internal helpers ====================//
+
+static uint16_t spectro_ble_link_payload(uint16_t mtu)
+{
+    if (mtu < SPECTRO_BLE_MIN_MTU)
+        mtu = SPECTRO_BLE_MIN_MTU;
+    uint16_t n = (uint16_t)(mtu - SPECTRO_BLE_ATT_OVERHEAD);
+    return (n > SPECTRO_BLE_MAX_PAYLOAD) ? SPECTRO_BLE_MAX_PAYLOAD : n;
+}
+
+/**
+ * @brief Copy the first n buffered bytes out of the ring
+ */
+static void spectro_ble_link_peek(const SpectroBleLink_t *link, uint8_t *out, uint16_t n)
+{
+    uint16_t first = (uint16_t)(SPECTRO_BLE_LINK_BUFFER - link->head);
+    if (first > n)
+        first = n;
+    memcpy(out, &link->buf[link->head], first);
+    memcpy(&out[first], link->buf, n - first);
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_ble_link_init(SpectroBleLink_t *link, const SpectroBleLinkIo_t *io)
+{
+    memset(link, 0, sizeof(*link));
+    link->io = *io;
+    link->payload = spectro_ble_link_payload(SPECTRO_BLE_MIN_MTU);
+    link->intervalUs = SPECTRO_BLE_DEFAULT_INTERVAL;
+    link->perEvent = SPECTRO_BLE_DEFAULT_PER_EVENT;
+}
+
+void spectro_ble_link_connect(SpectroBleLink_t *link, uint32_t nowUs, uint16_t mtu, uint32_t intervalUs,
+                              uint8_t perEvent)
+{
+    link->connected = true;
+    link->head = 0;
+    link->len = 0;
+    link->flushPending = false;
+    link->perEvent = (perEvent > 0) ? perEvent : 1;
+    link->sentInEvent = 0;
+    link->partialSent = false;
+    spectro_ble_link_update(link, mtu, intervalUs);
+    link->eventUs = nowUs + link->intervalUs;
+    memset(&link->stats, 0, sizeof(link->stats));
+}
+
+void spectro_ble_link_update(SpectroBleLink_t *link, uint16_t mtu, uint32_t intervalUs)
+{
+    link->payload = spectro_ble_link_payload(mtu);
+    link->intervalUs = (intervalUs > 0) ? intervalUs : SPECTRO_BLE_DEFAULT_INTERVAL;
+}
+
+void spectro_ble_link_disconnect(SpectroBleLink_t *link)
+{
+    link->connected = false;
+    link->head = 0;
+    link->len = 0;
+    link->flushPending = false;
+}
+
+bool spectro_ble_link_write(SpectroBleLink_t *link, const uint8_t *data, size_t len)
+{
+    if (len > spectro_ble_link_space(link))
+    {
+        link->stats.refused++;
+        return false;
+    }
+
+    uint16_t tail = (uint16_t)((link->head + link->len) % SPECTRO_BLE_LINK_BUFFER);
+    size_t first = SPECTRO_BLE_LINK_BUFFER - tail;
+    if (first > len)
+        first = len;
+    memcpy(&link->buf[tail], data, first);
+    memcpy(link->buf, &data[first], len - first);
+    link->len = (uint16_t)(link->len + len);
+    return true;
+}
+
+size_t spectro_ble_link_space(const SpectroBleLink_t *link)
+{
+    return link->connected ? (size_t)(SPECTRO_BLE_LINK_BUFFER - link->len) : 0;
+}
+
+void spectro_ble_link_poll(SpectroBleLink_t *link, uint32_t nowUs)
+{
+    uint8_t packet[SPECTRO_BLE_MAX_PAYLOAD];
+
+    if (!link->connected)
+        return;
+
+    // a new interval: the stack has sent the previous event's notifications
+    if ((int32_t)(nowUs - link->eventUs) >= 0)
+    {
+        uint32_t behind = nowUs - link->eventUs;
+        link->eventUs += (behind / link->intervalUs + 1) * link->intervalUs;
+        link->sentInEvent = 0;
+        link->partialSent = false;
+    }
+
+    while ((link->len > 0) && (link->sentInEvent < link->perEvent))
+    {
+        uint16_t n = (link->len < link->payload) ? link->len : link->payload;
+        bool partial = (n < link->payload);
+        if (partial && link->partialSent && !link->flushPending)
+            break;
+
+        spectro_ble_link_peek(link, packet, n);
+        if (!link->io.notify(link->io.ctx, packet, n))
+        {
+            link->stats.stalls++;
+            link->sentInEvent = link->perEvent;   // retry at the next event
+            break;
+        }
+
+        if (link->sentInEvent++ == 0)
+            link->stats.events++;
+        link->head = (uint16_t)((link->head + n) % SPECTRO_BLE_LINK_BUFFER);
+        link->len = (uint16_t)(link->len - n);
+        link->stats.bytes += n;
+        link->stats.notifications++;
+        if (!partial)
+            link->stats.fullNotifications++;
+        else
+        {
+            link->partialSent = true;
+            link->flushPending = false;
+        }
+    }
+
+    if (link->len == 0)
+        link->flushPending = false;
+}
+
+void spectro_ble_link_flush(SpectroBleLink_t *link, uint32_t nowUs)
+{
+    if (link->len > 0)
+        link->flushPending = true;
+    spectro_ble_link_poll(link, nowUs);
+}
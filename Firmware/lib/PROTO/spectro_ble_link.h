@@ -0,0 +1,132 @@
+/********************************************************
+ * @file        	spectro_ble_link.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Notification packing and scheduling of the BLE transport
+ *
+ * @details
+ *  - The output byte stream (text lines and COBS frames, the same
+ *    bytes as on USB) is packed into GATT notifications of MTU - 3
+ *    bytes; messages are self-delimiting, so one notification carries
+ *    several frames and a frame may continue in the next one. The
+ *    receiver concatenates the notifications and parses them like the
+ *    serial stream (PC/spectro_frame.py FrameReader)
+ *  - Notifications only leave the radio at connection events. The
+ *    scheduler follows the connection interval:
+ *      * full notifications are handed to the stack at once
+ *      * one partial notification per interval goes out at once, so
+ *        a slow stream is not delayed; further partial data collects
+ *        until it fills a notification or the next interval starts
+ *        (spectro_ble_link_flush() sends it now)
+ *      * at most perEvent notifications per interval, the stack's TX
+ *        buffers, so sending never blocks in the stack
+ *  - The event phase is not reported by the stack, intervals are
+ *    counted from the connection time; data waits at most about one
+ *    interval either way
+ *  - The stack is reached through SpectroBleLinkIo_t only; Arduino-free,
+ *    also built by the host tools (Firmware/host, ble_bench simulates
+ *    the link)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_BLE_LINK_H
+#define SPECTRO_BLE_LINK_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SPECTRO_BLE_LINK_BUFFER        1024    // bytes waiting for notifications
+#define SPECTRO_BLE_ATT_OVERHEAD       3       // notification payload = MTU - 3
+#define SPECTRO_BLE_MAX_PAYLOAD        244     // MTU 247, one LL packet with DLE
+#define SPECTRO_BLE_MIN_MTU            23
+#define SPECTRO_BLE_MAX_MTU            (SPECTRO_BLE_MAX_PAYLOAD + SPECTRO_BLE_ATT_OVERHEAD)
+#define SPECTRO_BLE_DEFAULT_INTERVAL   15000   // us
+#define SPECTRO_BLE_DEFAULT_PER_EVENT  3
+
+/**
+ * @brief Stack access: notify() returns false if the stack has no room
+ */
+typedef struct
+{
+    bool (*notify)(void *ctx, const uint8_t *data, size_t len);
+    void *ctx;
+} SpectroBleLinkIo_t;
+
+/**
+ * @brief Counters since spectro_ble_link_connect()
+ */
+typedef struct
+{
+    uint32_t bytes;            ///< bytes notified
+    uint32_t notifications;
+    uint32_t fullNotifications;
+    uint32_t events;           ///< connection intervals with at least one notification
+    uint32_t stalls;           ///< notify() refused by the stack
+    uint32_t refused;          ///< writes refused because the buffer was full
+} SpectroBleLinkStats_t;
+
+typedef struct
+{
+    SpectroBleLinkIo_t io;
+    bool     connected;
+    uint16_t payload;          ///< bytes per notification
+    uint32_t intervalUs;
+    uint8_t  perEvent;
+    uint8_t  sentInEvent;
+    bool     partialSent;      ///< this interval already sent a partial notification
+    uint32_t eventUs;          ///< estimated time of the next connection event
+    bool     flushPending;     ///< spectro_ble_link_flush() waits for room
+    uint16_t head;
+    uint16_t len;
+    uint8_t  buf[SPECTRO_BLE_LINK_BUFFER];
+    SpectroBleLinkStats_t stats;
+} SpectroBleLink_t;
+
+//==================== Public API ====================//
+
+void spectro_ble_link_init(SpectroBleLink_t *link, const SpectroBleLinkIo_t *io);
+
+/**
+ * @brief A central subscribed: empty buffer, reset counters, intervals
+ *        counted from nowUs.
+ *
+ * @param mtu         Negotiated ATT MTU (SPECTRO_BLE_MIN_MTU if unknown)
+ * @param intervalUs  Connection interval
+ * @param perEvent    Notifications the stack buffers per interval
+ */
+void spectro_ble_link_connect(SpectroBleLink_t *link, uint32_t nowUs, uint16_t mtu, uint32_t intervalUs,
+                              uint8_t perEvent);
+
+/**
+ * @brief New MTU or interval during the connection (buffer kept).
+ */
+void spectro_ble_link_update(SpectroBleLink_t *link, uint16_t mtu, uint32_t intervalUs);
+
+void spectro_ble_link_disconnect(SpectroBleLink_t *link);
+
+/**
+ * @brief Queue bytes (one frame or text line), all or nothing.
+ * @return false if not connected or they do not fit
+ */
+bool spectro_ble_link_write(SpectroBleLink_t *link, const uint8_t *data, size_t len);
+
+/**
+ * @brief Free buffer space, 0 while not connected.
+ */
+size_t spectro_ble_link_space(const SpectroBleLink_t *link);
+
+/**
+ * @brief Send what the schedule allows at nowUs. Cheap, call often.
+ */
+void spectro_ble_link_poll(SpectroBleLink_t *link, uint32_t nowUs);
+
+/**
+ * @brief Send the partial notification without waiting for the next
+ *        interval (within the per-event limit), e.g. for a command reply.
+ */
+void spectro_ble_link_flush(SpectroBleLink_t *link, uint32_t nowUs);
+
+#endif // SPECTRO_BLE_LINK_H
@@ -0,0 +1,273 @@
+/********************************************************
+ * @file        	spectro_delta.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Delta / varint compression of the binary frame stream
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_delta.h"
+
+#include <string.h>
+
+// fixed part + seq step, time step, dropped, merged + residuals (3 bytes each at most)
+#define SPECTRO_DELTA_MAX_PAYLOAD   (5 + 3 + 5 + 3 + 2 + 3 * SPECTRO_FRAME_MAX_CHANNELS + SPECTRO_FRAME_CRC_SIZE)
+
+//==================== Internal helpers ====================//
+
+static int spectro_delta_popcount(uint16_t mask)
+{
+    int n = 0;
+    for (; mask != 0; mask &= (uint16_t)(mask - 1))
+        n++;
+    return n;
+}
+
+static uint32_t spectro_delta_zigzag(int32_t v)
+{
+    return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static int32_t spectro_delta_unzigzag(uint32_t z)
+{
+    return (int32_t)(z >> 1) ^ -(int32_t)(z & 1);
+}
+
+static size_t spectro_delta_varint_size(uint32_t v)
+{
+    size_t n = 1;
+    for (; v >= 0x80; v >>= 7)
+        n++;
+    return n;
+}
+
+static size_t spectro_delta_put_varint(uint8_t *p, uint32_t v)
+{
+    size_t n = 0;
+    for (; v >= 0x80; v >>= 7)
+        p[n++] = (uint8_t)(v | 0x80);
+    p[n++] = (uint8_t)v;
+    return n;
+}
+
+static bool spectro_delta_get_varint(const uint8_t *buf, size_t len, size_t *pos, uint32_t *v)
+{
+    *v = 0;
+    for (int shift = 0; (shift < 35) && (*pos < len); shift += 7)
+    {
+        uint8_t b = buf[(*pos)++];
+        *v |= (uint32_t)(b & 0x7F) << shift;
+        if ((b & 0x80) == 0)
+            return true;
+    }
+    return false;
+}
+
+static uint16_t spectro_delta_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Prediction of one channel from the reference frames
+ */
+static int32_t spectro_delta_predict(const SpectroDelta_t *d, int ch, bool linear)
+{
+    if (!linear)
+        return d->prev[ch];
+
+    int32_t p = 2 * (int32_t)d->prev[ch] - (int32_t)d->prev2[ch];
+    return (p < 0) ? 0 : ((p > 0xFFFF) ? 0xFFFF : p);
+}
+
+/**
+ * @brief The frame becomes the reference of the next one
+ */
+static void spectro_delta_advance(SpectroDelta_t *d, const SpectroFrameMeas_t *meas, bool key)
+{
+    memcpy(d->prev2, d->prev, sizeof(d->prev));
+    memcpy(d->prev, meas->channels, sizeof(d->prev));
+    d->periodUs = key ? 0 : meas->timestampUs - d->timestampUs;
+    d->hasPrev2 = !key;
+    d->sinceKey = key ? 0 : (uint8_t)(d->sinceKey + 1);
+    d->epoch = meas->epoch;
+    d->mask = meas->channelMask;
+    d->seq = meas->seq;
+    d->timestampUs = meas->timestampUs;
+    d->valid = true;
+}
+
+/**
+ * @brief Delta payload of a frame (without CRC), best predictor
+ * @return payload length
+ */
+static size_t spectro_delta_build(const SpectroDelta_t *d, const SpectroFrameMeas_t *meas, uint8_t *payload)
+{
+    uint32_t zStep[SPECTRO_FRAME_MAX_CHANNELS];
+    uint32_t zLinear[SPECTRO_FRAME_MAX_CHANNELS];
+    size_t sizeStep = 0;
+    size_t sizeLinear = 0;
+    int n = 0;
+
+    for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+    {
+        if ((meas->channelMask & (1U << ch)) == 0)
+            continue;
+        zStep[n] = spectro_delta_zigzag((int32_t)meas->channels[ch] - spectro_delta_predict(d, ch, false));
+        zLinear[n] = spectro_delta_zigzag((int32_t)meas->channels[ch] - spectro_delta_predict(d, ch, true));
+        sizeStep += spectro_delta_varint_size(zStep[n]);
+        sizeLinear += spectro_delta_varint_size(zLinear[n]);
+        n++;
+    }
+
+    bool linear = d->hasPrev2 && (sizeLinear < sizeStep);
+    bool counts = (meas->dropped > 0) || (meas->merged > 0);
+
+    payload[0] = SPECTRO_FRAME_TYPE_DELTA;
+    payload[1] = SPECTRO_FRAME_VERSION;
+    payload[2] = (uint8_t)(meas->seq & 0xFF);
+    payload[3] = (uint8_t)(meas->seq >> 8);
+    payload[4] = (uint8_t)((linear ? SPECTRO_DELTA_FLAG_LINEAR : 0) | (counts ? SPECTRO_DELTA_FLAG_COUNTS : 0));
+
+    size_t p = 5;
+    p += spectro_delta_put_varint(&payload[p], (uint16_t)(meas->seq - d->seq));
+    p += spectro_delta_put_varint(&payload[p],
+                                  spectro_delta_zigzag((int32_t)(meas->timestampUs - d->timestampUs - d->periodUs)));
+    if (counts)
+    {
+        p += spectro_delta_put_varint(&payload[p], meas->dropped);
+        p += spectro_delta_put_varint(&payload[p], meas->merged);
+    }
+    for (int i = 0; i < n; i++)
+        p += spectro_delta_put_varint(&payload[p], linear ? zLinear[i] : zStep[i]);
+    return p;
+}
+
+/**
+ * @brief Rebuild a frame from a delta payload (CRC already checked)
+ */
+static bool spectro_delta_parse(SpectroDelta_t *d, const uint8_t *payload, size_t len, SpectroFrameMeas_t *meas)
+{
+    uint32_t seqStep, jitter, dropped = 0, merged = 0;
+    size_t p = 5;
+
+    if (len < p)
+        return false;
+
+    uint16_t seq = spectro_delta_get16(&payload[2]);
+    uint8_t flags = payload[4];
+    bool linear = (flags & SPECTRO_DELTA_FLAG_LINEAR) != 0;
+
+    if (!spectro_delta_get_varint(payload, len, &p, &seqStep) ||
+        !spectro_delta_get_varint(payload, len, &p, &jitter))
+        return false;
+    if ((flags & SPECTRO_DELTA_FLAG_COUNTS) &&
+        (!spectro_delta_get_varint(payload, len, &p, &dropped) ||
+         !spectro_delta_get_varint(payload, len, &p, &merged)))
+        return false;
+
+    // the reference must be the frame right before this one on the wire
+    if ((uint16_t)(seq - seqStep) != d->seq || (linear && !d->hasPrev2))
+        return false;
+
+    memset(meas, 0, sizeof(*meas));
+    meas->seq = seq;
+    meas->timestampUs = d->timestampUs + d->periodUs + (uint32_t)spectro_delta_unzigzag(jitter);
+    meas->epoch = d->epoch;
+    meas->channelMask = d->mask;
+    meas->dropped = (dropped > 0xFFFF) ? 0xFFFF : (uint16_t)dropped;
+    meas->merged = (merged > 0xFF) ? 0xFF : (uint8_t)merged;
+
+    for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+    {
+        if ((d->mask & (1U << ch)) == 0)
+            continue;
+
+        uint32_t z;
+        if (!spectro_delta_get_varint(payload, len, &p, &z))
+            return false;
+        int32_t v = spectro_delta_predict(d, ch, linear) + spectro_delta_unzigzag(z);
+        if ((v < 0) || (v > 0xFFFF))
+            return false;
+        meas->channels[ch] = (uint16_t)v;
+    }
+    return p == len;
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_delta_init(SpectroDelta_t *d, uint8_t keyInterval)
+{
+    memset(d, 0, sizeof(*d));
+    d->keyInterval = (keyInterval > 0) ? keyInterval : SPECTRO_DELTA_KEY_INTERVAL;
+}
+
+void spectro_delta_reset(SpectroDelta_t *d)
+{
+    d->valid = false;
+}
+
+size_t spectro_delta_raw_size(int n)
+{
+    size_t payload = SPECTRO_FRAME_HEADER_SIZE + 2 * (size_t)n + SPECTRO_FRAME_CRC_SIZE;
+    return SPECTRO_COBS_MAX_ENCODED(payload) + 2;
+}
+
+size_t spectro_delta_encode(SpectroDelta_t *d, const SpectroFrameMeas_t *meas, uint8_t *out, size_t outSize)
+{
+    uint8_t payload[SPECTRO_DELTA_MAX_PAYLOAD];
+    size_t rawSize = spectro_delta_raw_size(spectro_delta_popcount(meas->channelMask));
+    size_t len = 0;
+
+    bool key = !d->valid || (d->epoch != meas->epoch) || (d->mask != meas->channelMask) ||
+               (d->sinceKey + 1 >= d->keyInterval);
+
+    if (!key)
+    {
+        size_t n = spectro_delta_build(d, meas, payload);
+        if (SPECTRO_COBS_MAX_ENCODED(n + SPECTRO_FRAME_CRC_SIZE) + 2 < rawSize)
+            len = spectro_frame_seal(payload, n, out, outSize);
+        else
+            key = true;   // noisy frame: the plain one is not longer
+    }
+    if (key)
+        len = spectro_frame_encode_meas(meas, out, outSize);
+    if (len == 0)
+        return 0;
+
+    spectro_delta_advance(d, meas, key);
+    d->stats.frames++;
+    d->stats.keyframes += key ? 1 : 0;
+    d->stats.rawBytes += (uint32_t)rawSize;
+    d->stats.codedBytes += (uint32_t)len;
+    return len;
+}
+
+bool spectro_delta_decode(SpectroDelta_t *d, const uint8_t *in, size_t len, const SpectroFrameHeader_t *hdr,
+                          SpectroFrameMeas_t *meas)
+{
+    uint8_t payload[SPECTRO_FRAME_MAX_PAYLOAD];
+    bool key = (spectro_frame_type(in, len) == SPECTRO_FRAME_TYPE_MEAS);
+    bool ok;
+
+    if (key)
+    {
+        ok = spectro_frame_decode_meas(in, len, hdr, meas);
+    }
+    else
+    {
+        size_t n = spectro_frame_open(in, len, SPECTRO_FRAME_TYPE_DELTA, payload);
+        ok = (n > 0) && d->valid && spectro_delta_parse(d, payload, n, meas);
+    }
+
+    // a damaged or unreferenced frame breaks the chain until the next keyframe
+    if (!ok)
+    {
+        d->valid = false;
+        return false;
+    }
+    spectro_delta_advance(d, meas, key);
+    return true;
+}
@@ -0,0 +1,120 @@
+/********************************************************
+ * @file        	spectro_delta.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Delta / varint compression of the binary frame stream
+ *
+ * @details
+ *  - Successive frames differ little, so after a keyframe (a plain
+ *    SPECTRO_FRAME_TYPE_MEAS frame) each frame is sent as the residual
+ *    of a prediction from the previous ones, zigzag-varint coded:
+ *    residuals within +-63 take one byte instead of two, and the
+ *    timestamp only costs the jitter of the frame period
+ *  - Two predictors, picked per frame by the encoder (whichever codes
+ *    shorter) and signalled in the flags:
+ *      * step   : x[k-1]
+ *      * linear : 2 x[k-1] - x[k-2], for drifting signals
+ *  - A keyframe is sent first, after every SPECTRO_DELTA_KEY_INTERVAL
+ *    frames, on an epoch change, after spectro_delta_reset() and
+ *    whenever the delta would not be shorter; a decoder that missed a
+ *    frame resynchronises at the next keyframe
+ *  - Arduino-free, also built by the host tools (Firmware/host)
+ *
+ *  Delta payload (before COBS, little-endian; varints are LEB128):
+ *
+ *    off  size  field
+ *      0     1  type = SPECTRO_FRAME_TYPE_DELTA
+ *      1     1  version (SPECTRO_FRAME_VERSION)
+ *      2     2  sequence number
+ *      4     1  flags: bit 0 linear predictor, bit 1 queue counts follow
+ *      5   var  sequence step from the reference frame (seq - ref seq)
+ *    ...   var  zigzag change of the frame period in us (timestamp step
+ *               minus the previous step, which is 0 after a keyframe)
+ *    ...   var  dropped, merged (only with flags bit 1)
+ *    ...   var  n zigzag residuals, the channels of the epoch's mask in
+ *               ascending index
+ *    ...     2  CRC-16 over all bytes above
+ *
+ *  The epoch is the one of the reference frame.
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_DELTA_H
+#define SPECTRO_DELTA_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#include "spectro_frame.h"
+
+#define SPECTRO_DELTA_KEY_INTERVAL   32    // default frames per keyframe
+#define SPECTRO_DELTA_FLAG_LINEAR    0x01
+#define SPECTRO_DELTA_FLAG_COUNTS    0x02
+
+/**
+ * @brief Encoder counters since spectro_delta_init()
+ */
+typedef struct
+{
+    uint32_t frames;         ///< frames encoded
+    uint32_t keyframes;      ///< of which sent as keyframes
+    uint32_t rawBytes;       ///< wire bytes as plain measurement frames
+    uint32_t codedBytes;     ///< wire bytes actually produced
+} SpectroDeltaStats_t;
+
+/**
+ * @brief Encoder or decoder state (one per stream direction)
+ */
+typedef struct
+{
+    bool     valid;          ///< reference frame present
+    bool     hasPrev2;       ///< two frames since the keyframe, linear predictor usable
+    uint16_t epoch;
+    uint16_t mask;
+    uint16_t seq;
+    uint32_t timestampUs;
+    uint32_t periodUs;       ///< last timestamp step, 0 after a keyframe
+    uint16_t prev[SPECTRO_FRAME_MAX_CHANNELS];    ///< indexed by channel
+    uint16_t prev2[SPECTRO_FRAME_MAX_CHANNELS];
+    uint8_t  sinceKey;       ///< frames since the last keyframe
+    uint8_t  keyInterval;
+    SpectroDeltaStats_t stats;
+} SpectroDelta_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Empty state and counters; keyInterval 0 = SPECTRO_DELTA_KEY_INTERVAL.
+ */
+void spectro_delta_init(SpectroDelta_t *d, uint8_t keyInterval);
+
+/**
+ * @brief Next encoded frame is a keyframe (new reader, lost frame, ...).
+ */
+void spectro_delta_reset(SpectroDelta_t *d);
+
+/**
+ * @brief Encode one frame as keyframe or delta frame, delimited.
+ * @return bytes to transmit, 0 if out is too small (state unchanged)
+ */
+size_t spectro_delta_encode(SpectroDelta_t *d, const SpectroFrameMeas_t *meas, uint8_t *out, size_t outSize);
+
+/**
+ * @brief Decode a keyframe or delta frame (COBS block without delimiters).
+ *
+ * @param hdr  Header of the stream's current epoch (used by keyframes)
+ * @return false on a damaged frame, or a delta frame without its
+ *         reference (decoding resumes at the next keyframe)
+ */
+bool spectro_delta_decode(SpectroDelta_t *d, const uint8_t *in, size_t len, const SpectroFrameHeader_t *hdr,
+                          SpectroFrameMeas_t *meas);
+
+/**
+ * @brief Wire size of a frame as plain measurement frame, n channels.
+ */
+size_t spectro_delta_raw_size(int n);
+
+#endif // SPECTRO_DELTA_H
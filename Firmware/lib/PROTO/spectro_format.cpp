@@ -0,0 +1,244 @@
+/********************************************************
+ * @file        	spectro_format.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Allocation-free text line formatter
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_format.h"
+
+#include <string.h>
+
+// "00" "01" ... "99"
+static const char s_digitPairs[200] =
+{
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static const uint32_t s_pow10[7] = { 1, 10, 100, 1000, 10000, 100000, 1000000 };
+
+#define SPECTRO_LINE_EOL_SIZE   2   // "\r\n", always kept free
+
+//==================== Internal helpers ====================//
+
+static inline char *spectro_fmt_pair(char *p, uint32_t v)
+{
+    memcpy(p, &s_digitPairs[2 * v], 2);
+    return p + 2;
+}
+
+/**
+ * @brief Reserve n characters at the end of the line.
+ * @return write pointer, NULL (and overflow set) if they do not fit
+ */
+static char *spectro_line_reserve(SpectroLine_t *line, size_t n)
+{
+    if (line->overflow || (line->len + n > SPECTRO_LINE_MAX - SPECTRO_LINE_EOL_SIZE))
+    {
+        line->overflow = true;
+        return NULL;
+    }
+    return &line->buf[line->len];
+}
+
+//==================== Number conversion ====================//
+
+char *spectro_fmt_u16(char *p, uint16_t v)
+{
+    uint32_t x = v;
+
+    // leading 1-2 digits, then fixed pairs: at most 2 divisions
+    if (x >= 10000)
+    {
+        uint32_t hi = x / 10000;
+        uint32_t lo = x - hi * 10000;
+        *p++ = (char)('0' + hi);
+        p = spectro_fmt_pair(p, lo / 100);
+        return spectro_fmt_pair(p, lo % 100);
+    }
+    if (x >= 100)
+    {
+        uint32_t hi = x / 100;
+        if (hi >= 10)
+            p = spectro_fmt_pair(p, hi);
+        else
+            *p++ = (char)('0' + hi);
+        return spectro_fmt_pair(p, x - hi * 100);
+    }
+    if (x >= 10)
+        return spectro_fmt_pair(p, x);
+
+    *p++ = (char)('0' + x);
+    return p;
+}
+
+char *spectro_fmt_u32(char *p, uint32_t v)
+{
+    if (v <= 0xFFFF)
+        return spectro_fmt_u16(p, (uint16_t)v);
+
+    // fill pairs from the right into a scratch buffer, then copy once
+    char tmp[SPECTRO_FMT_U32_MAX];
+    char *t = tmp + sizeof(tmp);
+
+    while (v >= 100)
+    {
+        uint32_t q = v / 100;
+        t -= 2;
+        memcpy(t, &s_digitPairs[2 * (v - q * 100)], 2);
+        v = q;
+    }
+    if (v >= 10)
+    {
+        t -= 2;
+        memcpy(t, &s_digitPairs[2 * v], 2);
+    }
+    else
+    {
+        *--t = (char)('0' + v);
+    }
+
+    size_t n = (size_t)(tmp + sizeof(tmp) - t);
+    memcpy(p, t, n);
+    return p + n;
+}
+
+//==================== Line builder ====================//
+
+void spectro_line_init(SpectroLine_t *line)
+{
+    line->len = 0;
+    line->overflow = false;
+}
+
+void spectro_line_str(SpectroLine_t *line, const char *s)
+{
+    size_t n = strlen(s);
+    char *p = spectro_line_reserve(line, n);
+
+    if (p != NULL)
+    {
+        memcpy(p, s, n);
+        line->len += (uint16_t)n;
+    }
+}
+
+void spectro_line_char(SpectroLine_t *line, char c)
+{
+    char *p = spectro_line_reserve(line, 1);
+
+    if (p != NULL)
+    {
+        *p = c;
+        line->len++;
+    }
+}
+
+void spectro_line_u16(SpectroLine_t *line, uint16_t v)
+{
+    char *p = spectro_line_reserve(line, SPECTRO_FMT_U16_MAX);
+
+    if (p != NULL)
+        line->len = (uint16_t)(spectro_fmt_u16(p, v) - line->buf);
+}
+
+void spectro_line_u32(SpectroLine_t *line, uint32_t v)
+{
+    char *p = spectro_line_reserve(line, SPECTRO_FMT_U32_MAX);
+
+    if (p != NULL)
+        line->len = (uint16_t)(spectro_fmt_u32(p, v) - line->buf);
+}
+
+void spectro_line_i32(SpectroLine_t *line, int32_t v)
+{
+    if (v < 0)
+    {
+        spectro_line_char(line, '-');
+        spectro_line_u32(line, 0U - (uint32_t)v);
+    }
+    else
+    {
+        spectro_line_u32(line, (uint32_t)v);
+    }
+}
+
+void spectro_line_fixed(SpectroLine_t *line, float v, uint8_t decimals)
+{
+    if (decimals > 6)
+        decimals = 6;
+
+    // same special cases and rounding as Print::printFloat()
+    if (v != v)
+    {
+        spectro_line_str(line, "nan");
+        return;
+    }
+    if ((v > 4294967040.0f) || (v < -4294967040.0f))
+    {
+        spectro_line_str(line, ((v - v) != (v - v)) ? "inf" : "ovf");
+        return;
+    }
+
+    double x = v;
+    if (x < 0.0)
+    {
+        spectro_line_char(line, '-');
+        x = -x;
+    }
+    x += 0.5 / (double)s_pow10[decimals];
+
+    uint32_t ipart = (uint32_t)x;
+    spectro_line_u32(line, ipart);
+    if (decimals == 0)
+        return;
+
+    uint32_t frac = (uint32_t)((x - (double)ipart) * (double)s_pow10[decimals]);
+    char *p = spectro_line_reserve(line, 1U + decimals);
+    if (p == NULL)
+        return;
+
+    *p++ = '.';
+    for (int d = decimals - 1; d >= 0; d--)
+    {
+        p[d] = (char)('0' + frac % 10);
+        frac /= 10;
+    }
+    line->len += (uint16_t)(1U + decimals);
+}
+
+void spectro_line_u16_list(SpectroLine_t *line, const uint16_t *v, int n, char sep)
+{
+    // worst case checked once for the whole list
+    char *p = spectro_line_reserve(line, (size_t)n * (SPECTRO_FMT_U16_MAX + 1));
+    if (p == NULL)
+        return;
+
+    for (int i = 0; i < n; i++)
+    {
+        if (i > 0)
+            *p++ = sep;
+        p = spectro_fmt_u16(p, v[i]);
+    }
+    line->len = (uint16_t)(p - line->buf);
+}
+
+bool spectro_line_end(SpectroLine_t *line)
+{
+    // spectro_line_reserve() always leaves room for the terminator
+    line->buf[line->len++] = '\r';
+    line->buf[line->len++] = '\n';
+    return !line->overflow;
+}
@@ -0,0 +1,82 @@
+/********************************************************
+ * @file        	spectro_format.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Allocation-free text line formatter
+ *
+ * @details
+ *  - A whole output line ("SORTED(...): ...", "INFER,...", ...) is
+ *    rendered into a SpectroLine_t on the stack and sent with one
+ *    Serial.write(), instead of one Print call per value and comma
+ *  - Integers are converted two digits at a time from a 200-byte
+ *    digit-pair table (one divide by 100 per pair, no reversal)
+ *  - Floats are printed like Arduino's Print::print(double, digits):
+ *    rounded to the given number of decimals, "nan" / "inf" / "ovf"
+ *  - A line that would overflow is flagged and must not be sent
+ *  - Arduino-free, also built by the host tools (Firmware/host)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_FORMAT_H
+#define SPECTRO_FORMAT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SPECTRO_LINE_MAX      160   // longest line incl. "\r\n" (SORTED line: <= 130, BATCHVAR: 142)
+#define SPECTRO_FMT_U16_MAX   5     // characters written by spectro_fmt_u16()
+#define SPECTRO_FMT_U32_MAX   10
+
+/**
+ * @brief Line under construction
+ */
+typedef struct
+{
+    char     buf[SPECTRO_LINE_MAX];
+    uint16_t len;
+    bool     overflow;   ///< something did not fit, the line is incomplete
+} SpectroLine_t;
+
+//==================== Number conversion ====================//
+
+/**
+ * @brief Write v in decimal at p (no terminator).
+ * @return pointer past the last character
+ */
+char *spectro_fmt_u16(char *p, uint16_t v);
+
+/**
+ * @brief Write v in decimal at p (no terminator).
+ * @return pointer past the last character
+ */
+char *spectro_fmt_u32(char *p, uint32_t v);
+
+//==================== Line builder ====================//
+
+void spectro_line_init(SpectroLine_t *line);
+void spectro_line_str(SpectroLine_t *line, const char *s);
+void spectro_line_char(SpectroLine_t *line, char c);
+void spectro_line_u16(SpectroLine_t *line, uint16_t v);
+void spectro_line_u32(SpectroLine_t *line, uint32_t v);
+void spectro_line_i32(SpectroLine_t *line, int32_t v);
+
+/**
+ * @brief Append a float with a fixed number of decimals (0..6).
+ */
+void spectro_line_fixed(SpectroLine_t *line, float v, uint8_t decimals);
+
+/**
+ * @brief Append n values separated by sep ("914,4652,...").
+ */
+void spectro_line_u16_list(SpectroLine_t *line, const uint16_t *v, int n, char sep);
+
+/**
+ * @brief Terminate the line with "\r\n", like Print::println().
+ * @return false if the line overflowed
+ */
+bool spectro_line_end(SpectroLine_t *line);
+
+#endif // SPECTRO_FORMAT_H
@@ -0,0 +1,261 @@
+/********************************************************
+ * @file        	spectro_frame.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Binary measurement and stream header frames (COBS + CRC-16)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_frame.h"
+#include "spectro_crc.h"
+
+#include <string.h>
+
+//==================== Internal helpers ====================//
+
+static void spectro_frame_put16(uint8_t *p, uint16_t v)
+{
+    p[0] = (uint8_t)(v & 0xFF);
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void spectro_frame_put32(uint8_t *p, uint32_t v)
+{
+    spectro_frame_put16(p, (uint16_t)(v & 0xFFFF));
+    spectro_frame_put16(p + 2, (uint16_t)(v >> 16));
+}
+
+static uint16_t spectro_frame_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t spectro_frame_get32(const uint8_t *p)
+{
+    return (uint32_t)spectro_frame_get16(p) | ((uint32_t)spectro_frame_get16(p + 2) << 16);
+}
+
+static int spectro_frame_popcount(uint16_t mask)
+{
+    int n = 0;
+    for (; mask != 0; mask &= (uint16_t)(mask - 1))
+        n++;
+    return n;
+}
+
+//==================== Public API implementation ====================//
+
+size_t spectro_cobs_encode(const uint8_t *in, size_t len, uint8_t *out)
+{
+    size_t codeIdx = 0;   // where the current block length goes
+    size_t o = 1;
+    uint8_t code = 1;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        if (in[i] != 0)
+        {
+            out[o++] = in[i];
+            code++;
+        }
+        if ((in[i] == 0) || (code == 0xFF))
+        {
+            out[codeIdx] = code;
+            codeIdx = o++;
+            code = 1;
+        }
+    }
+    out[codeIdx] = code;
+    return o;
+}
+
+size_t spectro_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t outSize)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len)
+    {
+        uint8_t code = in[i++];
+        if ((code == 0) || (i + code - 1 > len))
+            return 0;
+
+        for (uint8_t k = 1; k < code; k++)
+        {
+            if ((in[i] == 0) || (o >= outSize))
+                return 0;
+            out[o++] = in[i++];
+        }
+        // a short block implies a zero, except at the very end
+        if ((code < 0xFF) && (i < len))
+        {
+            if (o >= outSize)
+                return 0;
+            out[o++] = 0;
+        }
+    }
+    return o;
+}
+
+size_t spectro_frame_seal(uint8_t *payload, size_t n, uint8_t *out, size_t outSize)
+{
+    spectro_frame_put16(&payload[n], spectro_crc16_update(SPECTRO_CRC16_INIT, payload, n));
+    n += SPECTRO_FRAME_CRC_SIZE;
+
+    if (outSize < SPECTRO_COBS_MAX_ENCODED(n) + 2)
+        return 0;
+
+    out[0] = 0;
+    size_t len = 1 + spectro_cobs_encode(payload, n, &out[1]);
+    out[len++] = 0;
+    return len;
+}
+
+size_t spectro_frame_open(const uint8_t *in, size_t len, uint8_t type, uint8_t *payload)
+{
+    size_t n = spectro_cobs_decode(in, len, payload, SPECTRO_FRAME_MAX_PAYLOAD);
+
+    if (n < 2 + SPECTRO_FRAME_CRC_SIZE)
+        return 0;
+    if ((payload[0] != type) || (payload[1] != SPECTRO_FRAME_VERSION))
+        return 0;
+    n -= SPECTRO_FRAME_CRC_SIZE;
+    if (spectro_crc16_update(SPECTRO_CRC16_INIT, payload, n) != spectro_frame_get16(&payload[n]))
+        return 0;
+    return n;
+}
+
+size_t spectro_frame_encode_meas(const SpectroFrameMeas_t *meas, uint8_t *out, size_t outSize)
+{
+    uint8_t payload[SPECTRO_FRAME_MAX_PAYLOAD];
+    size_t n = SPECTRO_FRAME_HEADER_SIZE;
+
+    if ((meas == NULL) || (out == NULL))
+        return 0;
+
+    payload[0] = SPECTRO_FRAME_TYPE_MEAS;
+    payload[1] = SPECTRO_FRAME_VERSION;
+    spectro_frame_put16(&payload[2], meas->seq);
+    spectro_frame_put32(&payload[4], meas->timestampUs);
+    spectro_frame_put16(&payload[8], meas->epoch);
+    spectro_frame_put16(&payload[10], meas->dropped);
+    payload[12] = meas->merged;
+    payload[13] = (uint8_t)spectro_frame_popcount(meas->channelMask);
+
+    for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+    {
+        if (meas->channelMask & (1U << ch))
+        {
+            spectro_frame_put16(&payload[n], meas->channels[ch]);
+            n += 2;
+        }
+    }
+    return spectro_frame_seal(payload, n, out, outSize);
+}
+
+bool spectro_frame_decode_meas(const uint8_t *in, size_t len, const SpectroFrameHeader_t *hdr,
+                               SpectroFrameMeas_t *meas)
+{
+    uint8_t payload[SPECTRO_FRAME_MAX_PAYLOAD];
+    size_t n = spectro_frame_open(in, len, SPECTRO_FRAME_TYPE_MEAS, payload);
+
+    if ((hdr == NULL) || (meas == NULL) || (n < SPECTRO_FRAME_HEADER_SIZE))
+        return false;
+    if ((spectro_frame_get16(&payload[8]) != hdr->epoch) ||
+        (payload[13] != spectro_frame_popcount(hdr->channelMask)) ||
+        (n != SPECTRO_FRAME_HEADER_SIZE + 2 * (size_t)payload[13]))
+        return false;
+
+    meas->seq = spectro_frame_get16(&payload[2]);
+    meas->timestampUs = spectro_frame_get32(&payload[4]);
+    meas->epoch = hdr->epoch;
+    meas->dropped = spectro_frame_get16(&payload[10]);
+    meas->merged = payload[12];
+    meas->channelMask = hdr->channelMask;
+
+    size_t p = SPECTRO_FRAME_HEADER_SIZE;
+    for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+    {
+        meas->channels[ch] = 0;
+        if (hdr->channelMask & (1U << ch))
+        {
+            meas->channels[ch] = spectro_frame_get16(&payload[p]);
+            p += 2;
+        }
+    }
+    return true;
+}
+
+size_t spectro_frame_encode_header(const SpectroFrameHeader_t *hdr, uint8_t *out, size_t outSize)
+{
+    uint8_t payload[SPECTRO_FRAME_MAX_PAYLOAD];
+    size_t n = SPECTRO_FRAME_DESC_SIZE;
+
+    if ((hdr == NULL) || (out == NULL) || (hdr->numWavelengths > SPECTRO_FRAME_MAX_CHANNELS))
+        return 0;
+
+    payload[0] = SPECTRO_FRAME_TYPE_HEADER;
+    payload[1] = SPECTRO_FRAME_VERSION;
+    spectro_frame_put16(&payload[2], hdr->epoch);
+    memcpy(&payload[4], hdr->fwVersion, 3);
+    payload[7] = hdr->sensorId;
+    payload[8] = hdr->sensorRevision;
+    payload[9] = hdr->units;
+    payload[10] = hdr->precision;
+    payload[11] = hdr->gain;
+    payload[12] = hdr->atime;
+    payload[13] = hdr->average;
+    spectro_frame_put16(&payload[14], hdr->astep);
+    spectro_frame_put32(&payload[16], hdr->integrationUs);
+    spectro_frame_put16(&payload[20], hdr->channelMask);
+    payload[22] = hdr->numWavelengths;
+    payload[23] = 0;
+
+    for (int i = 0; i < hdr->numWavelengths; i++)
+    {
+        spectro_frame_put16(&payload[n], hdr->wavelengthNm[i]);
+        n += 2;
+    }
+    return spectro_frame_seal(payload, n, out, outSize);
+}
+
+bool spectro_frame_decode_header(const uint8_t *in, size_t len, SpectroFrameHeader_t *hdr)
+{
+    uint8_t payload[SPECTRO_FRAME_MAX_PAYLOAD];
+    size_t n = spectro_frame_open(in, len, SPECTRO_FRAME_TYPE_HEADER, payload);
+
+    if ((hdr == NULL) || (n < SPECTRO_FRAME_DESC_SIZE) ||
+        (payload[22] > SPECTRO_FRAME_MAX_CHANNELS) ||
+        (n != SPECTRO_FRAME_DESC_SIZE + 2 * (size_t)payload[22]))
+        return false;
+
+    memset(hdr, 0, sizeof(*hdr));
+    hdr->epoch = spectro_frame_get16(&payload[2]);
+    memcpy(hdr->fwVersion, &payload[4], 3);
+    hdr->sensorId = payload[7];
+    hdr->sensorRevision = payload[8];
+    hdr->units = payload[9];
+    hdr->precision = payload[10];
+    hdr->gain = payload[11];
+    hdr->atime = payload[12];
+    hdr->average = payload[13];
+    hdr->astep = spectro_frame_get16(&payload[14]);
+    hdr->integrationUs = spectro_frame_get32(&payload[16]);
+    hdr->channelMask = spectro_frame_get16(&payload[20]);
+    hdr->numWavelengths = payload[22];
+
+    for (int i = 0; i < hdr->numWavelengths; i++)
+        hdr->wavelengthNm[i] = spectro_frame_get16(&payload[SPECTRO_FRAME_DESC_SIZE + 2 * i]);
+    return true;
+}
+
+uint8_t spectro_frame_type(const uint8_t *in, size_t len)
+{
+    uint8_t payload[SPECTRO_FRAME_MAX_PAYLOAD];
+
+    if (spectro_cobs_decode(in, len, payload, sizeof(payload)) < 1)
+        return 0;
+    return payload[0];
+}
@@ -0,0 +1,207 @@
+/********************************************************
+ * @file        	spectro_frame.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Binary measurement and stream header frames (COBS + CRC-16)
+ *
+ * @details
+ *  - Fixed little-endian payload instead of ASCII lines: no number
+ *    formatting on the device, no float parsing on the host
+ *  - Payload is protected by a CRC-16/CCITT-FALSE and COBS-encoded, so
+ *    0x00 never occurs inside a frame and can be used as delimiter
+ *  - Each frame is sent as 0x00 <cobs bytes> 0x00: the leading zero
+ *    resynchronises the host after any text line printed in between
+ *  - Arduino-free, also built by the host tools (Firmware/host)
+ *  - Host decoder: PC/spectro_frame.py
+ *
+ *  - Acquisition settings are not repeated in every frame: a header
+ *    frame describes them once per epoch (a new epoch starts with every
+ *    settings change) and measurement frames carry its epoch ID
+ *
+ *  Measurement payload (before COBS, little-endian):
+ *
+ *    off  size  field
+ *      0     1  type = SPECTRO_FRAME_TYPE_MEAS
+ *      1     1  version (SPECTRO_FRAME_VERSION)
+ *      2     2  sequence number, wraps at 65535
+ *      4     4  timestamp, micros() at the end of the integration
+ *      8     2  epoch of the header describing this frame
+ *     10     2  dropped: frames discarded since the previous frame sent
+ *     12     1  merged: extra frames averaged into this one (saturates)
+ *     13     1  n = number of channel values
+ *     14   2*n  channel values: the channels of the header's mask,
+ *               ascending index
+ *    ...     2  CRC-16 over all bytes above
+ *
+ *  Header payload:
+ *
+ *    off  size  field
+ *      0     1  type = SPECTRO_FRAME_TYPE_HEADER
+ *      1     1  version (SPECTRO_FRAME_VERSION)
+ *      2     2  epoch
+ *      4     3  firmware version major, minor, patch
+ *      7     1  sensor ID register, 0xFF if unknown
+ *      8     1  sensor revision register, 0xFF if unknown
+ *      9     1  units (SpectroFrameUnits_t)
+ *     10     1  precision mode
+ *     11     1  gain code (AS7343_Gain_t), 0xFF if unknown
+ *     12     1  atime, 0xFF if unknown
+ *     13     1  frames averaged into each measurement (AVG)
+ *     14     2  astep, 0xFFFF if unknown
+ *     16     4  integration time in us, 0 if unknown
+ *     20     2  channel mask, bit i = channel i sent in measurements
+ *     22     1  w = number of wavelength table entries
+ *     23     1  reserved (0)
+ *     24   2*w  centre wavelength of channel i in nm
+ *    ...     2  CRC-16 over all bytes above
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_FRAME_H
+#define SPECTRO_FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SPECTRO_FRAME_VERSION       3
+#define SPECTRO_FRAME_MAX_CHANNELS  16
+#define SPECTRO_FRAME_HEADER_SIZE   14    // fixed part of a measurement
+#define SPECTRO_FRAME_DESC_SIZE     24    // fixed part of a stream header
+#define SPECTRO_FRAME_CRC_SIZE      2
+#define SPECTRO_FRAME_MAX_PAYLOAD   (SPECTRO_FRAME_DESC_SIZE + 2 * SPECTRO_FRAME_MAX_CHANNELS + SPECTRO_FRAME_CRC_SIZE)
+
+// COBS adds one byte per started 254-byte block, plus both delimiters
+#define SPECTRO_COBS_MAX_ENCODED(n) ((n) + ((n) / 254) + 1)
+#define SPECTRO_FRAME_MAX_ENCODED   (SPECTRO_COBS_MAX_ENCODED(SPECTRO_FRAME_MAX_PAYLOAD) + 2)
+
+#define SPECTRO_FRAME_UNKNOWN8      0xFF
+#define SPECTRO_FRAME_UNKNOWN16     0xFFFF
+
+/**
+ * @brief Frame type (payload byte 0)
+ */
+typedef enum
+{
+    SPECTRO_FRAME_TYPE_MEAS   = 0x01,   ///< one sensor frame (also the keyframe of delta streams)
+    SPECTRO_FRAME_TYPE_HEADER = 0x02,   ///< stream description of one epoch
+    SPECTRO_FRAME_TYPE_DELTA  = 0x03    ///< sensor frame relative to the previous one (spectro_delta.h)
+} SpectroFrameType_t;
+
+/**
+ * @brief Unit of the channel values
+ */
+typedef enum
+{
+    SPECTRO_UNITS_COUNTS = 0   ///< raw ADC counts (mean counts when averaging)
+} SpectroFrameUnits_t;
+
+/**
+ * @brief Stream header: everything needed to interpret the frames of one epoch
+ */
+typedef struct
+{
+    uint16_t epoch;
+    uint8_t  fwVersion[3];        ///< major, minor, patch
+    uint8_t  sensorId;
+    uint8_t  sensorRevision;
+    uint8_t  units;               ///< SpectroFrameUnits_t
+    uint8_t  precision;
+    uint8_t  gain;
+    uint8_t  atime;
+    uint8_t  average;
+    uint16_t astep;
+    uint32_t integrationUs;
+    uint16_t channelMask;
+    uint8_t  numWavelengths;
+    uint16_t wavelengthNm[SPECTRO_FRAME_MAX_CHANNELS];
+} SpectroFrameHeader_t;
+
+/**
+ * @brief Decoded content of a measurement frame
+ */
+typedef struct
+{
+    uint16_t seq;
+    uint32_t timestampUs;
+    uint16_t epoch;
+    uint8_t  merged;        ///< extra frames averaged in (output backpressure)
+    uint16_t dropped;       ///< frames discarded before this one (output backpressure)
+    uint16_t channelMask;   ///< from the epoch's header, selects the channels sent
+    uint16_t channels[SPECTRO_FRAME_MAX_CHANNELS];   // indexed by channel, absent ones unused
+} SpectroFrameMeas_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief COBS-encode a buffer (no delimiter is written).
+ *
+ * @param out  At least SPECTRO_COBS_MAX_ENCODED(len) bytes
+ * @return number of bytes written
+ */
+size_t spectro_cobs_encode(const uint8_t *in, size_t len, uint8_t *out);
+
+/**
+ * @brief Decode one COBS block (without delimiters).
+ *
+ * @param out     Output buffer, decoded data is never longer than len
+ * @param outSize Size of out
+ * @return decoded length, 0 on a malformed block or overflow
+ */
+size_t spectro_cobs_decode(const uint8_t *in, size_t len, uint8_t *out, size_t outSize);
+
+/**
+ * @brief Build a complete delimited measurement frame.
+ *
+ * @param out      Output buffer
+ * @param outSize  Size of out (SPECTRO_FRAME_MAX_ENCODED is always enough)
+ * @return bytes to transmit, 0 if out is too small
+ */
+size_t spectro_frame_encode_meas(const SpectroFrameMeas_t *meas, uint8_t *out, size_t outSize);
+
+/**
+ * @brief Parse a measurement frame (COBS block without delimiters).
+ *
+ * @param hdr  Header of the frame's epoch, gives the channel indices
+ * @return false on a CRC, version, type or length error, or if the
+ *         frame belongs to another epoch
+ */
+bool spectro_frame_decode_meas(const uint8_t *in, size_t len, const SpectroFrameHeader_t *hdr,
+                               SpectroFrameMeas_t *meas);
+
+/**
+ * @brief Build a complete delimited header frame.
+ * @return bytes to transmit, 0 if out is too small
+ */
+size_t spectro_frame_encode_header(const SpectroFrameHeader_t *hdr, uint8_t *out, size_t outSize);
+
+/**
+ * @brief Parse a header frame (COBS block without delimiters).
+ * @return false on a CRC, version, type or length error
+ */
+bool spectro_frame_decode_header(const uint8_t *in, size_t len, SpectroFrameHeader_t *hdr);
+
+/**
+ * @brief CRC-16, COBS and delimiters around a finished payload.
+ *
+ * @param payload  n payload bytes plus SPECTRO_FRAME_CRC_SIZE spare bytes
+ * @return bytes to transmit, 0 if out is too small
+ */
+size_t spectro_frame_seal(uint8_t *payload, size_t n, uint8_t *out, size_t outSize);
+
+/**
+ * @brief COBS-decode a block and check CRC, type and version.
+ *
+ * @param payload  At least SPECTRO_FRAME_MAX_PAYLOAD bytes
+ * @return payload length without the CRC, 0 on error
+ */
+size_t spectro_frame_open(const uint8_t *in, size_t len, uint8_t type, uint8_t *payload);
+
+/**
+ * @brief Frame type of a COBS block, 0 if it does not decode.
+ */
+uint8_t spectro_frame_type(const uint8_t *in, size_t len);
+
+#endif // SPECTRO_FRAME_H
@@ -0,0 +1,99 @@
+/********************************************************
+ * @file        	spectro_pc.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Request window of the PC inference mode
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_pc.h"
+
+#include <string.h>
+
+//==================== Internal helpers ====================//
+
+static void spectro_pc_remove(SpectroPcPipeline_t *pc, uint8_t idx)
+{
+    pc->count--;
+    memmove(&pc->req[idx], &pc->req[idx + 1], (size_t)(pc->count - idx) * sizeof(pc->req[0]));
+}
+
+static void spectro_pc_expire(SpectroPcPipeline_t *pc, uint32_t nowMs)
+{
+    // oldest first: stop at the first request still within its timeout
+    while ((pc->count > 0) && ((uint32_t)(nowMs - pc->req[0].sentMs) >= pc->timeoutMs))
+    {
+        spectro_pc_remove(pc, 0);
+        pc->stats.timeouts++;
+    }
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_pc_init(SpectroPcPipeline_t *pc, uint8_t window, uint16_t timeoutMs)
+{
+    memset(pc, 0, sizeof(*pc));
+    if (!spectro_pc_configure(pc, window, timeoutMs))
+        spectro_pc_configure(pc, SPECTRO_PC_DEFAULT_WINDOW, timeoutMs);
+}
+
+bool spectro_pc_configure(SpectroPcPipeline_t *pc, uint8_t window, uint16_t timeoutMs)
+{
+    if ((window < 1) || (window > SPECTRO_PC_MAX_WINDOW))
+        return false;
+
+    pc->window = window;
+    pc->timeoutMs = timeoutMs;
+    return true;
+}
+
+bool spectro_pc_try_send(SpectroPcPipeline_t *pc, uint32_t nowMs)
+{
+    spectro_pc_expire(pc, nowMs);
+
+    if (pc->count >= pc->window)
+    {
+        pc->stats.skipped++;
+        return false;
+    }
+    return true;
+}
+
+void spectro_pc_sent(SpectroPcPipeline_t *pc, uint16_t seq, uint32_t nowMs)
+{
+    if (pc->count >= SPECTRO_PC_MAX_WINDOW)
+    {
+        spectro_pc_remove(pc, 0);
+        pc->stats.timeouts++;
+    }
+
+    pc->req[pc->count].seq = seq;
+    pc->req[pc->count].sentMs = nowMs;
+    pc->count++;
+    pc->stats.sent++;
+}
+
+int32_t spectro_pc_reply(SpectroPcPipeline_t *pc, uint16_t seq, uint32_t nowMs)
+{
+    spectro_pc_expire(pc, nowMs);
+
+    for (uint8_t i = 0; i < pc->count; i++)
+    {
+        if (pc->req[i].seq != seq)
+            continue;
+
+        uint32_t rtt = nowMs - pc->req[i].sentMs;
+        spectro_pc_remove(pc, i);
+
+        pc->stats.replied++;
+        pc->stats.rttSumMs += rtt;
+        if (rtt > pc->stats.rttMaxMs)
+            pc->stats.rttMaxMs = rtt;
+        return (int32_t)rtt;
+    }
+
+    pc->stats.late++;
+    return -1;
+}
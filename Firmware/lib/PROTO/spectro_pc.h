@@ -0,0 +1,96 @@
+/********************************************************
+ * @file        	spectro_pc.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Request window of the PC inference mode
+ *
+ * @details
+ *  - Every measurement sent to the PC carries a sequence number; the
+ *    PC answers "RES,<seq>,<result>"
+ *  - Up to `window` requests may be outstanding; while the window is
+ *    full new frames are skipped instead of waiting for the PC
+ *  - Requests older than the timeout are dropped; a reply that
+ *    matches no outstanding request is counted as late
+ *  - Pure bookkeeping, time is passed in: Arduino-free, also built by
+ *    the host tools (Firmware/host)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_PC_H
+#define SPECTRO_PC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define SPECTRO_PC_MAX_WINDOW        8
+#define SPECTRO_PC_DEFAULT_WINDOW    4
+#define SPECTRO_PC_DEFAULT_TIMEOUT   2000   // ms
+
+/**
+ * @brief Pipeline counters
+ */
+typedef struct
+{
+    uint32_t sent;
+    uint32_t replied;     ///< replies matched to an outstanding request
+    uint32_t late;        ///< replies after their timeout, duplicates, unknown seq
+    uint32_t timeouts;    ///< requests dropped without a reply
+    uint32_t skipped;     ///< frames not sent because the window was full
+    uint32_t rttSumMs;    ///< sum of round-trip times of matched replies
+    uint32_t rttMaxMs;
+} SpectroPcStats_t;
+
+typedef struct
+{
+    uint16_t seq;
+    uint32_t sentMs;
+} SpectroPcRequest_t;
+
+/**
+ * @brief Outstanding requests, oldest first
+ */
+typedef struct
+{
+    SpectroPcRequest_t req[SPECTRO_PC_MAX_WINDOW];
+    uint8_t            count;
+    uint8_t            window;
+    uint16_t           timeoutMs;
+    SpectroPcStats_t   stats;
+} SpectroPcPipeline_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Empty the pipeline and reset the counters.
+ */
+void spectro_pc_init(SpectroPcPipeline_t *pc, uint8_t window, uint16_t timeoutMs);
+
+/**
+ * @brief Change the window (1..SPECTRO_PC_MAX_WINDOW) and timeout.
+ *
+ * @note Requests beyond a smaller window stay outstanding until they
+ *       are answered or time out.
+ * @return false if the window is out of range
+ */
+bool spectro_pc_configure(SpectroPcPipeline_t *pc, uint8_t window, uint16_t timeoutMs);
+
+/**
+ * @brief Drop timed-out requests, then reserve a slot for a new one.
+ * @return false (and counts a skipped frame) if the window is full
+ */
+bool spectro_pc_try_send(SpectroPcPipeline_t *pc, uint32_t nowMs);
+
+/**
+ * @brief Record a request sent after spectro_pc_try_send() returned true.
+ */
+void spectro_pc_sent(SpectroPcPipeline_t *pc, uint16_t seq, uint32_t nowMs);
+
+/**
+ * @brief Match a reply to its request.
+ * @return round-trip time in ms, -1 if late or unknown
+ */
+int32_t spectro_pc_reply(SpectroPcPipeline_t *pc, uint16_t seq, uint32_t nowMs);
+
+#endif // SPECTRO_PC_H
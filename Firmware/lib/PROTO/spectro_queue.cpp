@@ -0,0 +1,147 @@
+/********************************************************
+ * @file        	spectro_queue.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Bounded measurement queue with an overflow policy
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_queue.h"
+
+#include <string.h>
+
+static const char *const s_policyNames[] = { "oldest", "newest", "merge" };
+
+//==================== Internal helpers ====================//
+
+static SpectroQueueEntry_t *spectro_queue_at(SpectroQueue_t *q, uint8_t i)
+{
+    return &q->entry[(q->head + i) % SPECTRO_QUEUE_DEPTH];
+}
+
+static bool spectro_queue_has(uint16_t mask, int ch)
+{
+    return (mask & (1U << ch)) != 0;
+}
+
+static uint16_t spectro_queue_add_sat(uint16_t a, uint16_t b)
+{
+    return ((uint32_t)a + b > 0xFFFF) ? 0xFFFF : (uint16_t)(a + b);
+}
+
+//==================== Public API implementation ====================//
+
+void spectro_queue_init(SpectroQueue_t *q, SpectroQueuePolicy_t policy)
+{
+    memset(q, 0, sizeof(*q));
+    q->policy = policy;
+}
+
+void spectro_queue_set_policy(SpectroQueue_t *q, SpectroQueuePolicy_t policy)
+{
+    q->policy = policy;
+}
+
+bool spectro_queue_push(SpectroQueue_t *q, const SpectroFrameMeas_t *frame)
+{
+    q->stats.pushed++;
+
+    if (q->count == SPECTRO_QUEUE_DEPTH)
+    {
+        SpectroQueueEntry_t *last = spectro_queue_at(q, (uint8_t)(q->count - 1));
+
+        if (q->policy == SPECTRO_QUEUE_DROP_NEWEST)
+        {
+            // reported by the next frame that gets in
+            q->pendingDrops = spectro_queue_add_sat(q->pendingDrops, 1);
+            q->stats.dropped++;
+            return false;
+        }
+
+        // only frames with the same settings can be averaged, otherwise
+        // MERGE falls back to dropping the oldest
+        if ((q->policy == SPECTRO_QUEUE_MERGE) && (last->frame.epoch == frame->epoch) &&
+            (last->frame.channelMask == frame->channelMask) && (last->frames < 0xFFFF))
+        {
+            for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+                if (spectro_queue_has(frame->channelMask, ch))
+                    last->sum[ch] += frame->channels[ch];
+            last->frames++;
+
+            // newest seq / time, so the sequence stays monotonic
+            uint16_t dropped = last->frame.dropped;
+            last->frame = *frame;
+            last->frame.dropped = dropped;
+            q->stats.merged++;
+            return false;
+        }
+
+        // the new oldest frame reports the loss
+        uint16_t dropped = spectro_queue_add_sat(spectro_queue_at(q, 0)->frame.dropped, 1);
+        q->head = (uint8_t)((q->head + 1) % SPECTRO_QUEUE_DEPTH);
+        q->count--;
+        SpectroQueueEntry_t *next = spectro_queue_at(q, 0);
+        next->frame.dropped = spectro_queue_add_sat(next->frame.dropped, dropped);
+        q->stats.dropped++;
+    }
+
+    SpectroQueueEntry_t *e = spectro_queue_at(q, q->count);
+    e->frame = *frame;
+    e->frame.dropped = q->pendingDrops;
+    q->pendingDrops = 0;
+    e->frames = 1;
+    for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+        e->sum[ch] = spectro_queue_has(frame->channelMask, ch) ? frame->channels[ch] : 0;
+
+    q->count++;
+    if (q->count > q->stats.maxCount)
+        q->stats.maxCount = q->count;
+    return true;
+}
+
+bool spectro_queue_pop(SpectroQueue_t *q, SpectroFrameMeas_t *frame)
+{
+    if (q->count == 0)
+        return false;
+
+    SpectroQueueEntry_t *e = spectro_queue_at(q, 0);
+
+    *frame = e->frame;
+    for (int ch = 0; ch < SPECTRO_FRAME_MAX_CHANNELS; ch++)
+        frame->channels[ch] = (uint16_t)((e->sum[ch] + e->frames / 2) / e->frames);   // rounded mean
+    frame->merged = (e->frames > 256) ? 255 : (uint8_t)(e->frames - 1);
+
+    q->head = (uint8_t)((q->head + 1) % SPECTRO_QUEUE_DEPTH);
+    q->count--;
+    return true;
+}
+
+const SpectroFrameMeas_t *spectro_queue_peek(const SpectroQueue_t *q)
+{
+    return (q->count > 0) ? &q->entry[q->head].frame : NULL;
+}
+
+uint8_t spectro_queue_count(const SpectroQueue_t *q)
+{
+    return q->count;
+}
+
+const char *spectro_queue_policy_name(SpectroQueuePolicy_t policy)
+{
+    return ((unsigned)policy < sizeof(s_policyNames) / sizeof(s_policyNames[0])) ? s_policyNames[policy] : NULL;
+}
+
+bool spectro_queue_policy_from_name(const char *name, SpectroQueuePolicy_t *policy)
+{
+    for (unsigned p = 0; p < sizeof(s_policyNames) / sizeof(s_policyNames[0]); p++)
+    {
+        if (strcmp(name, s_policyNames[p]) == 0)
+        {
+            *policy = (SpectroQueuePolicy_t)p;
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,109 @@
+/********************************************************
+ * @file        	spectro_queue.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Bounded measurement queue with an overflow policy
+ *
+ * @details
+ *  - Sits between acquisition and the serial port: frames are queued
+ *    as they are measured and rendered only once the port has room,
+ *    so a host that stops reading never blocks the measurement loop
+ *  - When the queue is full a new frame is handled by the policy:
+ *      * DROP_OLDEST : discard the oldest queued frame (freshest data)
+ *      * DROP_NEWEST : discard the new frame (no gaps in the old data)
+ *      * MERGE       : average the new frame into the newest queued one
+ *                      (same epoch only, i.e. same settings)
+ *  - Each frame carries how many frames were averaged into it and how
+ *    many were dropped right before it, so the loss is reported by
+ *    the frame that follows the gap
+ *  - Arduino-free, also built by the host tools (Firmware/host)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_QUEUE_H
+#define SPECTRO_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spectro_frame.h"
+
+#define SPECTRO_QUEUE_DEPTH   8
+
+typedef enum
+{
+    SPECTRO_QUEUE_DROP_OLDEST = 0,
+    SPECTRO_QUEUE_DROP_NEWEST,
+    SPECTRO_QUEUE_MERGE
+} SpectroQueuePolicy_t;
+
+/**
+ * @brief One queued frame; channels are kept as sums while merging
+ */
+typedef struct
+{
+    SpectroFrameMeas_t frame;          ///< seq / time of the newest merged frame
+    uint32_t sum[SPECTRO_FRAME_MAX_CHANNELS];     ///< indexed by channel, like frame.channels
+    uint16_t frames;                   ///< frames averaged into this entry
+} SpectroQueueEntry_t;
+
+/**
+ * @brief Queue counters since spectro_queue_init()
+ */
+typedef struct
+{
+    uint32_t pushed;
+    uint32_t dropped;
+    uint32_t merged;
+    uint8_t  maxCount;       ///< highest fill level seen
+} SpectroQueueStats_t;
+
+typedef struct
+{
+    SpectroQueueEntry_t  entry[SPECTRO_QUEUE_DEPTH];
+    uint8_t              head;           ///< oldest entry
+    uint8_t              count;
+    SpectroQueuePolicy_t policy;
+    uint16_t             pendingDrops;   ///< newest frames dropped, reported by the next push
+    SpectroQueueStats_t  stats;
+} SpectroQueue_t;
+
+//==================== Public API ====================//
+
+void spectro_queue_init(SpectroQueue_t *q, SpectroQueuePolicy_t policy);
+
+/**
+ * @brief Overflow policy for the following pushes (queued frames are kept).
+ */
+void spectro_queue_set_policy(SpectroQueue_t *q, SpectroQueuePolicy_t policy);
+
+/**
+ * @brief Queue one frame (channels present in frame->channelMask). Never blocks.
+ * @return false if the frame was dropped or merged into another one
+ */
+bool spectro_queue_push(SpectroQueue_t *q, const SpectroFrameMeas_t *frame);
+
+/**
+ * @brief Take the oldest frame: merged channels averaged, `merged` and
+ *        `dropped` filled in.
+ * @return false if the queue is empty
+ */
+bool spectro_queue_pop(SpectroQueue_t *q, SpectroFrameMeas_t *frame);
+
+/**
+ * @brief Oldest frame without taking it (epoch, seq), NULL if empty.
+ * @note  Its channels are not averaged yet, use spectro_queue_pop() for them.
+ */
+const SpectroFrameMeas_t *spectro_queue_peek(const SpectroQueue_t *q);
+
+uint8_t spectro_queue_count(const SpectroQueue_t *q);
+
+/**
+ * @brief Policy name ("oldest", "newest", "merge") and its inverse.
+ */
+const char *spectro_queue_policy_name(SpectroQueuePolicy_t policy);
+bool spectro_queue_policy_from_name(const char *name, SpectroQueuePolicy_t *policy);
+
+#endif // SPECTRO_QUEUE_H
@@ -0,0 +1,234 @@
+/********************************************************
+ * @file        	spectro_script.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Register script interpreter (on-device sensor sequences)
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_script.h"
+
+// bytes of each op including the opcode, indexed by opcode
+static const uint8_t s_opSize[] = { 1, 3, 6, 3, 5, 3, 3, 1, 1 };
+
+static const char *const s_statusNames[] = { "ok", "format", "io", "timeout", "record", "aborted" };
+
+typedef struct
+{
+    uint16_t start;          // first op of the body
+    uint16_t count;
+    uint16_t index;          // current iteration
+} SpectroScriptLoop_t;
+
+//==================== Internal helpers ====================//
+
+static uint16_t spectro_script_get16(const uint8_t *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+/**
+ * @brief Wait until (reg & mask) != 0 or timeoutMs elapsed
+ */
+static SpectroScriptStatus_t spectro_script_wait(const SpectroScriptIo_t *io, uint8_t reg, uint8_t mask,
+                                                 uint16_t timeoutMs)
+{
+    uint32_t startMs = io->millis(io->ctx);
+
+    while (true)
+    {
+        uint8_t v;
+        if (!io->read(io->ctx, reg, &v, 1))
+            return SPECTRO_SCRIPT_ERR_IO;
+        if (v & mask)
+            return SPECTRO_SCRIPT_OK;
+        if ((uint32_t)(io->millis(io->ctx) - startMs) >= timeoutMs)
+            return SPECTRO_SCRIPT_ERR_TIMEOUT;
+        if (!io->idle(io->ctx))
+            return SPECTRO_SCRIPT_ERR_ABORTED;
+    }
+}
+
+static SpectroScriptStatus_t spectro_script_delay(const SpectroScriptIo_t *io, uint16_t ms)
+{
+    uint32_t startMs = io->millis(io->ctx);
+
+    while ((uint32_t)(io->millis(io->ctx) - startMs) < ms)
+    {
+        if (!io->idle(io->ctx))
+            return SPECTRO_SCRIPT_ERR_ABORTED;
+    }
+    return SPECTRO_SCRIPT_OK;
+}
+
+//==================== Public API implementation ====================//
+
+bool spectro_script_validate(const uint8_t *code, size_t len, uint16_t *errPc)
+{
+    int depth = 0;
+    size_t pc = 0;
+
+    if ((code == NULL) || (len == 0) || (len > SPECTRO_SCRIPT_MAX_SIZE))
+    {
+        if (errPc != NULL)
+            *errPc = 0;
+        return false;
+    }
+
+    while ((pc < len) && (code[pc] != SPECTRO_SCRIPT_OP_END))
+    {
+        const uint8_t *op = &code[pc];
+        bool ok = (op[0] < sizeof(s_opSize)) && (pc + s_opSize[op[0]] <= len);
+
+        if (ok)
+        {
+            switch (op[0])
+            {
+            case SPECTRO_SCRIPT_OP_SET:
+                ok = (op[5] < depth);
+                break;
+            case SPECTRO_SCRIPT_OP_READ:
+                ok = (op[2] >= 1) && (op[2] <= SPECTRO_SCRIPT_RECORD_MAX);
+                break;
+            case SPECTRO_SCRIPT_OP_WAIT:
+                ok = (op[2] != 0);
+                break;
+            case SPECTRO_SCRIPT_OP_LOOP:
+                ok = (spectro_script_get16(&op[1]) >= 1) && (++depth <= SPECTRO_SCRIPT_MAX_DEPTH);
+                break;
+            case SPECTRO_SCRIPT_OP_NEXT:
+                ok = (--depth >= 0);
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (!ok)
+        {
+            if (errPc != NULL)
+                *errPc = (uint16_t)pc;
+            return false;
+        }
+        pc += s_opSize[op[0]];
+    }
+
+    if (depth != 0)
+    {
+        if (errPc != NULL)
+            *errPc = (uint16_t)pc;
+        return false;
+    }
+    return true;
+}
+
+void spectro_script_run(const uint8_t *code, size_t len, const SpectroScriptIo_t *io, SpectroScriptResult_t *res)
+{
+    SpectroScriptLoop_t loops[SPECTRO_SCRIPT_MAX_DEPTH];
+    uint8_t record[SPECTRO_SCRIPT_RECORD_MAX];
+    uint8_t recordLen = 0;
+    int depth = 0;
+    size_t pc = 0;
+
+    res->status = SPECTRO_SCRIPT_OK;
+    res->pc = 0;
+    res->records = 0;
+    res->ops = 0;
+
+    if (!spectro_script_validate(code, len, &res->pc))
+    {
+        res->status = SPECTRO_SCRIPT_ERR_FORMAT;
+        return;
+    }
+
+    while ((pc < len) && (code[pc] != SPECTRO_SCRIPT_OP_END))
+    {
+        const uint8_t *op = &code[pc];
+        size_t next = pc + s_opSize[op[0]];
+        SpectroScriptStatus_t st = SPECTRO_SCRIPT_OK;
+
+        switch (op[0])
+        {
+        case SPECTRO_SCRIPT_OP_WRITE:
+            if (!io->write(io->ctx, op[1], op[2]))
+                st = SPECTRO_SCRIPT_ERR_IO;
+            break;
+
+        case SPECTRO_SCRIPT_OP_SET:
+        {
+            uint8_t v;
+            uint8_t field = (uint8_t)(op[3] + op[4] * loops[op[5]].index);
+            if (!io->read(io->ctx, op[1], &v, 1) ||
+                !io->write(io->ctx, op[1], (uint8_t)((v & ~op[2]) | (field & op[2]))))
+                st = SPECTRO_SCRIPT_ERR_IO;
+            break;
+        }
+
+        case SPECTRO_SCRIPT_OP_READ:
+            if (recordLen + op[2] > SPECTRO_SCRIPT_RECORD_MAX)
+                st = SPECTRO_SCRIPT_ERR_RECORD;
+            else if (!io->read(io->ctx, op[1], &record[recordLen], op[2]))
+                st = SPECTRO_SCRIPT_ERR_IO;
+            else
+                recordLen += op[2];
+            break;
+
+        case SPECTRO_SCRIPT_OP_WAIT:
+            st = spectro_script_wait(io, op[1], op[2], spectro_script_get16(&op[3]));
+            break;
+
+        case SPECTRO_SCRIPT_OP_DELAY:
+            st = spectro_script_delay(io, spectro_script_get16(&op[1]));
+            break;
+
+        case SPECTRO_SCRIPT_OP_LOOP:
+            loops[depth].start = (uint16_t)next;
+            loops[depth].count = spectro_script_get16(&op[1]);
+            loops[depth].index = 0;
+            depth++;
+            break;
+
+        case SPECTRO_SCRIPT_OP_NEXT:
+        {
+            SpectroScriptLoop_t *loop = &loops[depth - 1];
+            if (++loop->index < loop->count)
+                next = loop->start;
+            else
+                depth--;
+            if (!io->idle(io->ctx))
+                st = SPECTRO_SCRIPT_ERR_ABORTED;
+            break;
+        }
+
+        case SPECTRO_SCRIPT_OP_EMIT:
+            if (!io->emit(io->ctx, res->records, record, recordLen))
+                st = SPECTRO_SCRIPT_ERR_ABORTED;
+            else
+                res->records++;
+            recordLen = 0;
+            break;
+
+        default:
+            break;
+        }
+
+        res->ops++;
+        if (st != SPECTRO_SCRIPT_OK)
+        {
+            res->status = st;
+            res->pc = (uint16_t)pc;
+            return;
+        }
+        pc = next;
+    }
+    res->pc = (uint16_t)pc;
+}
+
+const char *spectro_script_status_name(SpectroScriptStatus_t status)
+{
+    if ((unsigned)status >= sizeof(s_statusNames) / sizeof(s_statusNames[0]))
+        return "unknown";
+    return s_statusNames[status];
+}
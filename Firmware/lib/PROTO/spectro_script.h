@@ -0,0 +1,120 @@
+/********************************************************
+ * @file        	spectro_script.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Register script interpreter (on-device sensor sequences)
+ *
+ * @details
+ *  - A register script is a short bytecode program uploaded once over
+ *    serial and run by the firmware: sequences such as a gain x ATIME
+ *    sweep then run at I2C speed instead of one serial round trip per
+ *    register access
+ *  - Bytes read by READ collect in a record; EMIT hands the record to
+ *    the caller (streamed back by spectro_app) and empties it
+ *  - spectro_script_validate() checks the whole program before it
+ *    runs, so a malformed upload never touches the sensor
+ *  - Hardware access goes through SpectroScriptIo_t; Arduino-free,
+ *    also built by the host tools (Firmware/host)
+ *
+ *  Opcodes (operands are bytes, u16 little-endian):
+ *
+ *    op    operands                 action
+ *    0x00  -                        END, also implied after the last op
+ *    0x01  reg val                  write val to reg
+ *    0x02  reg mask base step lvl   reg = (reg & ~mask) | ((base + step * i) & mask),
+ *                                   i = iteration of loop level lvl (0 = outermost)
+ *    0x03  reg n                    read n bytes from reg (burst) into the record
+ *    0x04  reg mask timeout(u16)    wait until (reg & mask) != 0, at most timeout ms
+ *    0x05  ms(u16)                  delay
+ *    0x06  count(u16)               LOOP: body up to the matching NEXT runs count times
+ *    0x07  -                        NEXT
+ *    0x08  -                        EMIT the record
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_SCRIPT_H
+#define SPECTRO_SCRIPT_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+#define SPECTRO_SCRIPT_MAX_SIZE      256   // bytes of bytecode
+#define SPECTRO_SCRIPT_MAX_DEPTH     4     // nested loops
+#define SPECTRO_SCRIPT_RECORD_MAX    48    // bytes read between two EMITs
+
+typedef enum
+{
+    SPECTRO_SCRIPT_OP_END   = 0x00,
+    SPECTRO_SCRIPT_OP_WRITE = 0x01,
+    SPECTRO_SCRIPT_OP_SET   = 0x02,
+    SPECTRO_SCRIPT_OP_READ  = 0x03,
+    SPECTRO_SCRIPT_OP_WAIT  = 0x04,
+    SPECTRO_SCRIPT_OP_DELAY = 0x05,
+    SPECTRO_SCRIPT_OP_LOOP  = 0x06,
+    SPECTRO_SCRIPT_OP_NEXT  = 0x07,
+    SPECTRO_SCRIPT_OP_EMIT  = 0x08
+} SpectroScriptOp_t;
+
+typedef enum
+{
+    SPECTRO_SCRIPT_OK = 0,
+    SPECTRO_SCRIPT_ERR_FORMAT,     ///< unknown opcode, truncated op, unbalanced loop, bad operand
+    SPECTRO_SCRIPT_ERR_IO,         ///< bus error
+    SPECTRO_SCRIPT_ERR_TIMEOUT,    ///< WAIT timed out
+    SPECTRO_SCRIPT_ERR_RECORD,     ///< READs beyond SPECTRO_SCRIPT_RECORD_MAX without EMIT
+    SPECTRO_SCRIPT_ERR_ABORTED     ///< cancelled, or the record was not taken
+} SpectroScriptStatus_t;
+
+/**
+ * @brief Hardware access of the interpreter
+ *
+ * @details
+ *  - idle() is called while WAIT and DELAY wait and once per loop
+ *    iteration; returning false cancels the script
+ *  - emit() returns false to cancel as well (e.g. the host went away)
+ */
+typedef struct
+{
+    bool     (*write)(void *ctx, uint8_t reg, uint8_t value);
+    bool     (*read)(void *ctx, uint8_t reg, uint8_t *data, uint8_t len);
+    uint32_t (*millis)(void *ctx);
+    bool     (*idle)(void *ctx);
+    bool     (*emit)(void *ctx, uint32_t record, const uint8_t *data, uint8_t len);
+    void     *ctx;
+} SpectroScriptIo_t;
+
+/**
+ * @brief Outcome of a run
+ */
+typedef struct
+{
+    SpectroScriptStatus_t status;
+    uint16_t pc;             ///< offset of the failing op (of END when OK)
+    uint32_t records;        ///< records emitted
+    uint32_t ops;            ///< ops executed
+} SpectroScriptResult_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Check a program without running it.
+ *
+ * @param errPc  Offset of the first bad op (may be NULL)
+ * @return false if the program is malformed
+ */
+bool spectro_script_validate(const uint8_t *code, size_t len, uint16_t *errPc);
+
+/**
+ * @brief Validate, then run a program to its end.
+ */
+void spectro_script_run(const uint8_t *code, size_t len, const SpectroScriptIo_t *io, SpectroScriptResult_t *res);
+
+/**
+ * @brief "ok", "format", "io", "timeout", "record", "aborted"
+ */
+const char *spectro_script_status_name(SpectroScriptStatus_t status);
+
+#endif // SPECTRO_SCRIPT_H
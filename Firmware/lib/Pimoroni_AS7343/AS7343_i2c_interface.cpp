@@ -17,11 +17,21 @@
 
 #define AS7343_INT A1
 
+static Print *s_log = &Serial;
+
 void AS7343_i2c_init(void) {
     Wire.begin(); // Arduino I2C init
     Wire.setClock(100000); // Set I2C frequency to 100kHz
 }
 
+void AS7343_i2c_set_clock(uint32_t hz) {
+    Wire.setClock(hz);
+}
+
+void AS7343_i2c_set_log(Print *out) {
+    s_log = out;
+}
+
 bool AS7343_i2c_write(uint8_t dev_address,uint8_t reg, uint8_t *data, size_t length) {
     Wire.beginTransmission(dev_address);
     Wire.write(reg);
@@ -42,11 +52,13 @@ bool AS7343_i2c_read(uint8_t dev_address, uint8_t reg, uint8_t *data, size_t len
     uint8_t n = Wire.requestFrom(dev_address, (uint8_t) length);
     
     if (n != (uint8_t) length){
-        Serial.print("Error: Requested ");
-        Serial.print(length);
-        Serial.print(" bytes but received ");
-        Serial.print(n);
-        Serial.println(" bytes");
+        if (s_log != NULL) {
+            s_log->print("Error: Requested ");
+            s_log->print(length);
+            s_log->print(" bytes but received ");
+            s_log->print(n);
+            s_log->println(" bytes");
+        }
         return false;
     }
 
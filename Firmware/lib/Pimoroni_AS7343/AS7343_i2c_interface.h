@@ -31,6 +31,12 @@
 
 extern void AS7343_i2c_init(void);
 
+// Bus clock in Hz (100 kHz after init, the AS7343 supports up to 400 kHz)
+extern void AS7343_i2c_set_clock(uint32_t hz);
+
+// Where bus errors are reported (default Serial), NULL for silent
+extern void AS7343_i2c_set_log(Print *out);
+
 // Read and write from register with one byte
 extern bool AS7343_i2c_write_reg(uint8_t dev_address, uint8_t reg, uint8_t *value);
 extern bool AS7343_i2c_read_reg(uint8_t dev_address, uint8_t reg, uint8_t *value);
@@ -23,6 +23,11 @@
 #define AS7343_STATUS2_AVALID_BIT   (1 << 6)
 
 static uint16_t s_dataReadyTimeoutMs = 100; // global wait time, controlled by spectro_app
+static void (*s_idleCallback)(void) = NULL;  // run while the integration is in progress
+static uint32_t s_dataReadyUs = 0;           // micros() at the last AVALID
+
+static AS7343_Config_t s_config;             // last configuration written by AS7343_apply_config()
+static bool s_configValid = false;           // false: register contents unknown, write everything
 
 /**
  * @brief wait until one time measurement (STATUS2.AVALID = 1)
@@ -42,11 +47,18 @@ static bool AS7343_wait_data_ready(void)
             return false;
 
         if (status2 & AS7343_STATUS2_AVALID_BIT)
+        {
+            s_dataReadyUs = micros();
             return true;
-    }
-    while ((uint16_t)(millis() - start) < s_dataReadyTimeoutMs);
+        }
+
+        if ((uint16_t)(millis() - start) >= s_dataReadyTimeoutMs)
+            return false; // timeout
 
-    return false; // timeout
+        if (s_idleCallback != NULL)
+            s_idleCallback();
+    }
+    while (true);
 }
 
 void AS7343_set_data_ready_timeout(uint16_t timeout_ms)
@@ -54,12 +66,103 @@ void AS7343_set_data_ready_timeout(uint16_t timeout_ms)
     s_dataReadyTimeoutMs = timeout_ms;
 }
 
+void AS7343_set_idle_callback(void (*cb)(void))
+{
+    s_idleCallback = cb;
+}
+
+uint32_t AS7343_data_ready_us(void)
+{
+    return s_dataReadyUs;
+}
+
+void AS7343_invalidate_config(void)
+{
+    s_configValid = false;
+}
+
+bool AS7343_apply_config(const AS7343_Config_t *cfg)
+{
+    if (cfg == NULL)
+        return false;
+
+    s_dataReadyTimeoutMs = cfg->timeout_ms;
+
+    bool atimeDirty = !s_configValid || (cfg->atime != s_config.atime);
+    bool astepDirty = !s_configValid || (cfg->astep != s_config.astep);
+    bool gainDirty  = !s_configValid || (cfg->gain != s_config.gain);
+
+    if (!atimeDirty && !astepDirty && !gainDirty)
+        return true;
+
+    s_configValid = false;
+
+    if (!AS7343_set_reg_bank(AS7343_REG_BANK_0))
+        return false;
+
+    // stop the running measurement (SP_EN=0) while the settings change
+    uint8_t enable = 0;
+    if (!AS7343_i2c_read_reg(AS7343_I2C_ADDRESS, AS7343_REG_ENABLE, &enable))
+        return false;
+
+    uint8_t stopped = enable & ~0x02;
+    if (!AS7343_i2c_write_reg(AS7343_I2C_ADDRESS, AS7343_REG_ENABLE, &stopped))
+        return false;
+
+    if (atimeDirty)
+    {
+        uint8_t atime = cfg->atime;
+        if (!AS7343_i2c_write_reg(AS7343_I2C_ADDRESS, AS7343_REG_ATIME, &atime))
+            return false;
+    }
+
+    if (astepDirty)
+    {
+        uint8_t astep[2] = { (uint8_t)(cfg->astep & 0xFF), (uint8_t)(cfg->astep >> 8) };
+        if (!AS7343_i2c_write(AS7343_I2C_ADDRESS, AS7343_REG_ASTEP_L, astep, 2))
+            return false;
+    }
+
+    if (gainDirty)
+    {
+        uint8_t cfg1 = 0;
+        if (!AS7343_i2c_read_reg(AS7343_I2C_ADDRESS, AS7343_REG_CFG1, &cfg1))
+            return false;
+
+        cfg1 = (cfg1 & ~0x1F) | (cfg->gain & 0x1F);
+        if (!AS7343_i2c_write_reg(AS7343_I2C_ADDRESS, AS7343_REG_CFG1, &cfg1))
+            return false;
+    }
+
+    // restart: the next AVALID belongs to a frame with the new settings
+    enable |= 0x02;
+    if (!AS7343_i2c_write_reg(AS7343_I2C_ADDRESS, AS7343_REG_ENABLE, &enable))
+        return false;
+
+    s_config = *cfg;
+    s_configValid = true;
+    return true;
+}
+
+bool AS7343_get_config(AS7343_Config_t *cfg)
+{
+    if ((cfg == NULL) || !s_configValid)
+        return false;
+
+    *cfg = s_config;
+    return true;
+}
+
 //==================== public API implementation ====================//
 
 bool AS7343_init(void)
 {
     AS7343_i2c_init();
+    return AS7343_restore_defaults();
+}
 
+bool AS7343_restore_defaults(void)
+{
     // Switch to Bank 0, most configurations are in the 0x80+ region
     if (!AS7343_set_reg_bank(AS7343_REG_BANK_0))
         return false;
@@ -100,6 +203,28 @@ bool AS7343_init(void)
     return true;
 }
 
+/*******************************************************
+ * Start / stop spectral measurement (SP_EN), PON kept
+ *******************************************************/
+bool AS7343_set_measurement(bool enable)
+{
+    if (!AS7343_set_reg_bank(AS7343_REG_BANK_0))
+        return false;
+
+    uint8_t reg = 0;
+    if (!AS7343_i2c_read_reg(AS7343_I2C_ADDRESS, AS7343_REG_ENABLE, &reg))
+        return false;
+
+    if (enable)
+        reg |= 0x02;    // bit1 = SP_EN, integration starts now
+    else
+        reg &= ~0x02;   // oscillator and configuration stay on
+    if (!AS7343_i2c_write_reg(AS7343_I2C_ADDRESS, AS7343_REG_ENABLE, &reg))
+        return false;
+
+    return true;
+}
+
 /*******************************************************
  * Check chip ID to verify connection
  *******************************************************/
@@ -120,6 +245,27 @@ bool AS7343_is_connected(void)
     return (id == AS7343_DEVICE_ID);
 }
 
+/*******************************************************
+ * Read part ID and revision (bank 1)
+ *******************************************************/
+bool AS7343_read_id(uint8_t *id, uint8_t *revision)
+{
+    if ((id == NULL) || (revision == NULL))
+        return false;
+
+    if (!AS7343_set_reg_bank(AS7343_REG_BANK_1))
+        return false;
+
+    bool ok = AS7343_i2c_read_reg(AS7343_I2C_ADDRESS, AS7343_REG_ID, id) &&
+              AS7343_i2c_read_reg(AS7343_I2C_ADDRESS, AS7343_REG_REVID, revision);
+
+    // back to Bank 0 even after a failed read
+    if (!AS7343_set_reg_bank(AS7343_REG_BANK_0))
+        return false;
+
+    return ok;
+}
+
 /*******************************************************
  * Set register bank
  *******************************************************/
@@ -147,6 +293,8 @@ bool AS7343_set_reg_bank(AS7343_RegBank_t bank)
  *******************************************************/
 bool AS7343_set_gain(AS7343_Gain_t gain)
 {
+    s_configValid = false;   // bypasses AS7343_apply_config()
+
     // gain set CFG1 (0xC6) lower 5 bits, ensure using Bank 0
     if (!AS7343_set_reg_bank(AS7343_REG_BANK_0))
         return false;
@@ -169,6 +317,8 @@ bool AS7343_set_gain(AS7343_Gain_t gain)
  *******************************************************/
 bool AS7343_set_integration_time(uint8_t atime, uint16_t astep)
 {
+    s_configValid = false;   // bypasses AS7343_apply_config()
+
     if (!AS7343_set_reg_bank(AS7343_REG_BANK_0))
         return false;
 
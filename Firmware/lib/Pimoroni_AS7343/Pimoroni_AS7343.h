@@ -90,6 +90,9 @@ typedef enum {
 #define AS7343_NUM_CHANNELS          18
 #define AS7343_NUM_SORTED_CHANNELS   12  // 11 VIS bands + 1 NIR
 
+// centre wavelength (nm) of each sorted channel, see AS7343_get_sorted_spectral_channels()
+#define AS7343_SORTED_WAVELENGTHS_NM { 405, 425, 450, 475, 515, 550, 555, 600, 640, 690, 745, 855 }
+
 //==================== bank choice ====================//
 
 typedef enum {
@@ -115,10 +118,36 @@ typedef enum {
     AS7343_GAIN_2048X
 } AS7343_Gain_t;
 
+//==================== measurement configuration ====================//
+
+/**
+ * @brief  Complete measurement configuration, applied with AS7343_apply_config()
+ */
+typedef struct {
+    uint8_t       atime;        // integration steps - 1
+    uint16_t      astep;        // step size (2.78 us units)
+    AS7343_Gain_t gain;
+    uint16_t      timeout_ms;   // data-ready timeout for this configuration
+} AS7343_Config_t;
+
 //==================== public API ====================//
 
 bool AS7343_init(void);
+/**
+ * @brief  Register setup of AS7343_init() without the bus init: bank 0,
+ *         PON, auto_smux 18 channels, 16x gain, SP_EN
+ */
+bool AS7343_restore_defaults(void);
 bool AS7343_is_connected(void);
+/**
+ * @brief  SP_EN only: false stops integrating with the sensor powered
+ *         and configured, true starts a new frame at once (hot standby)
+ */
+bool AS7343_set_measurement(bool enable);
+/**
+ * @brief  Part ID (0x81) and revision registers, for stream headers
+ */
+bool AS7343_read_id(uint8_t *id, uint8_t *revision);
 bool AS7343_set_reg_bank(AS7343_RegBank_t bank);
 bool AS7343_set_gain(AS7343_Gain_t gain);
 bool AS7343_read_all_channels(uint16_t *data, size_t length);
@@ -131,4 +160,31 @@ bool AS7343_get_sorted_spectral_channels(uint16_t *data11);
 
 bool AS7343_set_integration_time(uint8_t atime, uint16_t astep); // different resolution readout
 void AS7343_set_data_ready_timeout(uint16_t timeout_ms);
+/**
+ * @brief  Apply a full configuration in one coalesced register update
+ * @note   Only registers differing from the last applied configuration are
+ *         written (ASTEP as one 2-byte burst), inside a single SP_EN off/on
+ *         so the next frame is integrated entirely with the new settings
+ */
+bool AS7343_apply_config(const AS7343_Config_t *cfg);
+/**
+ * @brief  Configuration last written by AS7343_apply_config()
+ * @return false if unknown (never applied, or changed through the setters)
+ */
+bool AS7343_get_config(AS7343_Config_t *cfg);
+/**
+ * @brief  Registers were written behind the driver's back (register
+ *         scripts): the next AS7343_apply_config() writes everything
+ */
+void AS7343_invalidate_config(void);
+/**
+ * @brief  Hook called repeatedly while waiting for a measurement
+ * @note   Must not access the sensor; NULL disables it
+ */
+void AS7343_set_idle_callback(void (*cb)(void));
+/**
+ * @brief  micros() when the last measurement was seen complete (AVALID),
+ *         i.e. the end of its integration to within one STATUS2 poll
+ */
+uint32_t AS7343_data_ready_us(void);
 #endif // PIMORONI_AS7343_H
@@ -0,0 +1,57 @@
+/********************************************************
+ * @file        	spectro_crc.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Checksum helpers shared by storage and protocol code
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include "spectro_crc.h"
+
+// 4-bit lookup table for the reflected IEEE polynomial
+static const uint32_t s_crc32Nibble[16] =
+{
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+};
+
+// 4-bit lookup table for the CCITT polynomial (MSB first)
+static const uint16_t s_crc16Nibble[16] =
+{
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+uint32_t spectro_crc32_update(uint32_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= p[i];
+        crc = (crc >> 4) ^ s_crc32Nibble[crc & 0x0F];
+        crc = (crc >> 4) ^ s_crc32Nibble[crc & 0x0F];
+    }
+    return crc;
+}
+
+uint32_t spectro_crc32(const void *data, size_t len)
+{
+    return spectro_crc32_update(SPECTRO_CRC32_INIT, data, len) ^ 0xFFFFFFFFUL;
+}
+
+uint16_t spectro_crc16_update(uint16_t crc, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+
+    for (size_t i = 0; i < len; i++)
+    {
+        crc = (uint16_t)((crc << 4) ^ s_crc16Nibble[(crc >> 12) ^ (p[i] >> 4)]);
+        crc = (uint16_t)((crc << 4) ^ s_crc16Nibble[(crc >> 12) ^ (p[i] & 0x0F)]);
+    }
+    return crc;
+}
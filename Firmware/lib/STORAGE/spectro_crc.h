@@ -0,0 +1,51 @@
+/********************************************************
+ * @file        	spectro_crc.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Checksum helpers shared by storage and protocol code
+ *
+ * @details
+ *  - CRC-32 (IEEE 802.3, reflected, poly 0xEDB88320)
+ *  - CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) for short frames,
+ *    same as Python's binascii.crc_hqx(data, 0xFFFF)
+ *  - Table-free nibble implementation: 64 bytes of table, no heap
+ *  - No Arduino dependency, also builds on the host
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_CRC_H
+#define SPECTRO_CRC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define SPECTRO_CRC32_INIT   0xFFFFFFFFUL
+#define SPECTRO_CRC16_INIT   0xFFFFU
+
+/**
+ * @brief Update a running CRC-32 with a block of bytes.
+ *
+ * @param crc   Running value, start with SPECTRO_CRC32_INIT
+ * @param data  Input bytes
+ * @param len   Number of bytes
+ * @return updated running value (not yet finalised)
+ */
+uint32_t spectro_crc32_update(uint32_t crc, const void *data, size_t len);
+
+/**
+ * @brief One-shot CRC-32 of a buffer (init + update + final xor).
+ */
+uint32_t spectro_crc32(const void *data, size_t len);
+
+/**
+ * @brief Update a running CRC-16/CCITT-FALSE (no final xor).
+ *
+ * @param crc   Running value, start with SPECTRO_CRC16_INIT
+ * @param data  Input bytes
+ * @param len   Number of bytes
+ */
+uint16_t spectro_crc16_update(uint16_t crc, const void *data, size_t len);
+
+#endif // SPECTRO_CRC_H
@@ -0,0 +1,250 @@
+/********************************************************
+ * @file        	spectro_model_slot.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Double-buffered (A/B) flash slots for model packages
+ *
+ * @details
+ *  - Slot layout: [image ... ][0xFF ...][trailer record]
+ *  - Activation is a single 32-byte program of the trailer, the
+ *    active pointer in RAM is switched only after it succeeded
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "spectro_model_slot.h"
+#include "spectro_crc.h"
+
+//==================== Internal definitions ====================//
+
+#define SPECTRO_SLOT_MAGIC   0x544F4C53UL   // "SLOT"
+
+typedef struct
+{
+    uint32_t magic;
+    uint32_t generation;
+    uint32_t imageSize;
+    uint32_t imageCrc;
+    uint32_t reserved[3];
+    uint32_t recordCrc;    // CRC-32 of the previous fields
+} SpectroSlotRecord_t;
+
+static_assert(sizeof(SpectroSlotRecord_t) == SPECTRO_SLOT_RECORD_SIZE, "slot record size");
+
+static const uint32_t s_slotAddr[2] = { SPECTRO_SLOT_A_ADDR, SPECTRO_SLOT_B_ADDR };
+
+static int s_active = -1;                 // active slot index, -1 = none
+static uint32_t s_activeGeneration = 0;
+
+static SpectroSlotState_t s_state = SPECTRO_SLOT_IDLE;
+static int s_target = 0;                  // slot being written
+static uint32_t s_targetSize = 0;
+static uint32_t s_targetCrc = 0;
+static uint32_t s_nextOffset = 0;
+static uint32_t s_erasedUpTo = 0;         // bytes of the target slot already erased
+static bool s_recErased = false;          // trailer page ready (or part of the image)
+static bool s_slotsFree = false;          // firmware ends below slot A
+
+//==================== Internal helpers ====================//
+
+static const SpectroSlotRecord_t *spectro_slot_record(int slot)
+{
+    return (const SpectroSlotRecord_t *)(uintptr_t)(s_slotAddr[slot] + SPECTRO_SLOT_SIZE - SPECTRO_SLOT_RECORD_SIZE);
+}
+
+static const uint8_t *spectro_slot_image(int slot)
+{
+    return (const uint8_t *)(uintptr_t)s_slotAddr[slot];
+}
+
+static bool spectro_slot_is_valid(int slot, bool (*validate)(const uint8_t *, uint32_t))
+{
+    const SpectroSlotRecord_t *rec = spectro_slot_record(slot);
+
+    if (rec->magic != SPECTRO_SLOT_MAGIC)
+        return false;
+    if (spectro_crc32(rec, offsetof(SpectroSlotRecord_t, recordCrc)) != rec->recordCrc)
+        return false;
+    if ((rec->imageSize == 0) || (rec->imageSize > SPECTRO_SLOT_MAX_IMAGE))
+        return false;
+    if (spectro_crc32(spectro_slot_image(slot), rec->imageSize) != rec->imageCrc)
+        return false;
+
+    return (validate == NULL) || validate(spectro_slot_image(slot), rec->imageSize);
+}
+
+//==================== Public API implementation ====================//
+
+bool spectro_slot_init(bool (*validate)(const uint8_t *image, uint32_t size))
+{
+    s_active = -1;
+    s_activeGeneration = 0;
+    s_state = SPECTRO_SLOT_IDLE;
+
+    // a slot over the firmware would be erased under the running code
+    s_slotsFree = (spectro_storage_image_end() <= SPECTRO_SLOT_A_ADDR);
+    if (!s_slotsFree)
+        return false;
+
+    for (int slot = 0; slot < 2; slot++)
+    {
+        if (!spectro_slot_is_valid(slot, validate))
+            continue;
+
+        uint32_t gen = spectro_slot_record(slot)->generation;
+        if ((s_active < 0) || (gen > s_activeGeneration))
+        {
+            s_active = slot;
+            s_activeGeneration = gen;
+        }
+    }
+    return (s_active >= 0);
+}
+
+const uint8_t *spectro_slot_active(uint32_t *size, uint32_t *generation)
+{
+    if (s_active < 0)
+        return NULL;
+
+    if (size != NULL)
+        *size = spectro_slot_record(s_active)->imageSize;
+    if (generation != NULL)
+        *generation = s_activeGeneration;
+
+    return spectro_slot_image(s_active);
+}
+
+bool spectro_slot_begin(uint32_t size, uint32_t crc)
+{
+    if (!s_slotsFree || (size == 0) || (size > SPECTRO_SLOT_MAX_IMAGE))
+        return false;
+
+    s_target = (s_active == 0) ? 1 : 0;
+    s_targetSize = size;
+    s_targetCrc = crc;
+    s_nextOffset = 0;
+    s_erasedUpTo = 0;
+    s_recErased = false;
+    s_state = SPECTRO_SLOT_RECEIVING;
+    return true;
+}
+
+bool spectro_slot_write(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+    if ((s_state != SPECTRO_SLOT_RECEIVING) || (data == NULL) || (offset != s_nextOffset))
+        return false;
+    if ((len == 0) || (len > SPECTRO_SLOT_CHUNK_MAX) || (len > s_targetSize - offset))
+        return false;
+
+    bool last = (offset + len == s_targetSize);
+    if (!last && ((len & 3) != 0))
+        return false;
+
+    // pages are erased by spectro_slot_prepare(), never here
+    uint32_t end = offset + len;
+    if (!spectro_slot_erased(offset, len))
+        return false;
+
+    // pad the tail to the 4-byte program unit
+    uint32_t buf[SPECTRO_SLOT_CHUNK_MAX / 4];
+    uint32_t padded = (len + 3) & ~3UL;
+    memset(buf, 0xFF, sizeof(buf));
+    memcpy(buf, data, len);
+
+    if (!spectro_storage_flash_program(s_slotAddr[s_target] + offset, buf, padded))
+        return false;
+
+    s_nextOffset = end;
+    return true;
+}
+
+bool spectro_slot_erased(uint32_t offset, uint32_t len)
+{
+    return (s_state == SPECTRO_SLOT_RECEIVING) && (len <= s_erasedUpTo) && (offset <= s_erasedUpTo - len);
+}
+
+bool spectro_slot_prepare(void)
+{
+    if (s_state != SPECTRO_SLOT_RECEIVING)
+        return false;
+
+    const uint32_t recPage = SPECTRO_SLOT_SIZE - SPECTRO_STORAGE_PAGE_SIZE;   // offset of the trailer page
+    uint32_t addr;
+
+    if (!s_recErased)
+    {
+        // first the trailer page, if the image does not reach it
+        s_recErased = true;
+        if (s_targetSize > recPage)
+            return false;
+        addr = s_slotAddr[s_target] + recPage;
+    }
+    else
+    {
+        // one page ahead of the next chunk
+        uint32_t want = s_nextOffset + SPECTRO_STORAGE_PAGE_SIZE;
+        if (want > s_targetSize)
+            want = s_targetSize;
+        if (s_erasedUpTo >= want)
+            return false;
+        addr = s_slotAddr[s_target] + s_erasedUpTo;
+        s_erasedUpTo += SPECTRO_STORAGE_PAGE_SIZE;
+    }
+
+    if (!spectro_storage_flash_erase_page(addr))
+        s_state = SPECTRO_SLOT_IDLE;   // chunks are refused, the host sees ERR
+    return true;
+}
+
+uint32_t spectro_slot_next_offset(void)
+{
+    return s_nextOffset;
+}
+
+bool spectro_slot_commit(bool (*validate)(const uint8_t *image, uint32_t size))
+{
+    if ((s_state != SPECTRO_SLOT_RECEIVING) || (s_nextOffset != s_targetSize))
+        return false;
+
+    s_state = SPECTRO_SLOT_IDLE;
+
+    const uint8_t *image = spectro_slot_image(s_target);
+    if (spectro_crc32(image, s_targetSize) != s_targetCrc)
+        return false;
+    if ((validate != NULL) && !validate(image, s_targetSize))
+        return false;
+
+    // the trailer page was erased first by spectro_slot_prepare()
+    uint32_t recAddr = s_slotAddr[s_target] + SPECTRO_SLOT_SIZE - SPECTRO_SLOT_RECORD_SIZE;
+    if (!s_recErased)
+        return false;
+
+    SpectroSlotRecord_t rec;
+    memset(&rec, 0xFF, sizeof(rec));
+    rec.magic = SPECTRO_SLOT_MAGIC;
+    rec.generation = s_activeGeneration + 1;
+    rec.imageSize = s_targetSize;
+    rec.imageCrc = s_targetCrc;
+    rec.recordCrc = spectro_crc32(&rec, offsetof(SpectroSlotRecord_t, recordCrc));
+
+    if (!spectro_storage_flash_program(recAddr, &rec, sizeof(rec)))
+        return false;
+
+    s_active = s_target;
+    s_activeGeneration = rec.generation;
+    return true;
+}
+
+void spectro_slot_abort(void)
+{
+    s_state = SPECTRO_SLOT_IDLE;
+}
+
+SpectroSlotState_t spectro_slot_state(void)
+{
+    return s_state;
+}
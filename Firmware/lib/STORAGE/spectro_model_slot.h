@@ -0,0 +1,131 @@
+/********************************************************
+ * @file        	spectro_model_slot.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Double-buffered (A/B) flash slots for model packages
+ *
+ * @details
+ *  - Two fixed slots; the active one is the valid slot with the
+ *    highest generation number
+ *  - Uploads always go to the inactive slot, page by page, so the
+ *    active model keeps running during the whole transfer
+ *  - A slot becomes valid only when its trailer record is programmed,
+ *    after the image CRC has been verified in flash; a reset at any
+ *    point leaves the previous model active
+ *  - Images are executed in place (memory-mapped flash, no RAM copy)
+ *
+ * @note
+ *   Each page erase stalls the CPU for ~85 ms; erases are spread over
+ *   the transfer (one per 4 KB received) instead of up-front, and run
+ *   from spectro_slot_prepare() between frames, never while a chunk
+ *   is being received.
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_MODEL_SLOT_H
+#define SPECTRO_MODEL_SLOT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "spectro_storage.h"
+
+//==================== Flash layout ====================//
+
+#define SPECTRO_SLOT_SIZE         (SPECTRO_STORAGE_RAW_SIZE / 2)   // 192 KB per slot
+#define SPECTRO_SLOT_A_ADDR       SPECTRO_STORAGE_RAW_ADDR
+#define SPECTRO_SLOT_B_ADDR       (SPECTRO_STORAGE_RAW_ADDR + SPECTRO_SLOT_SIZE)
+#define SPECTRO_SLOT_RECORD_SIZE  32          // trailer at the end of the slot
+#define SPECTRO_SLOT_MAX_IMAGE    (SPECTRO_SLOT_SIZE - SPECTRO_SLOT_RECORD_SIZE)
+#define SPECTRO_SLOT_CHUNK_MAX    64          // largest accepted write chunk
+
+/**
+ * @brief Upload state
+ */
+typedef enum
+{
+    SPECTRO_SLOT_IDLE = 0,     ///< no transfer in progress
+    SPECTRO_SLOT_RECEIVING     ///< writing into the inactive slot
+} SpectroSlotState_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Scan both slots and select the active image.
+ *
+ * @param validate  Optional content check (e.g. spectro_model_validate),
+ *                  a slot failing it is ignored
+ * @return true if an active image was found; false, and uploads are
+ *         refused, if the firmware has grown into slot A
+ */
+bool spectro_slot_init(bool (*validate)(const uint8_t *image, uint32_t size));
+
+/**
+ * @brief Active image (memory-mapped), NULL if none.
+ *
+ * @param[out] size        Optional image size
+ * @param[out] generation  Optional generation number
+ */
+const uint8_t *spectro_slot_active(uint32_t *size, uint32_t *generation);
+
+/**
+ * @brief Start an upload into the inactive slot.
+ *
+ * @param size  Image size in bytes (<= SPECTRO_SLOT_MAX_IMAGE)
+ * @param crc   Expected CRC-32 of the complete image
+ */
+bool spectro_slot_begin(uint32_t size, uint32_t crc);
+
+/**
+ * @brief Write the next chunk. Chunks must arrive in order.
+ *
+ * @param offset  Byte offset, must equal spectro_slot_next_offset()
+ * @param data    Chunk bytes
+ * @param len     1..SPECTRO_SLOT_CHUNK_MAX; a multiple of 4 except for the last chunk
+ * @return false also if its page is not erased yet (spectro_slot_erased())
+ */
+bool spectro_slot_write(uint32_t offset, const uint8_t *data, uint32_t len);
+
+/**
+ * @brief The flash under a chunk is erased and can be programmed.
+ */
+bool spectro_slot_erased(uint32_t offset, uint32_t len);
+
+/**
+ * @brief Erase the next page the upload needs: the trailer page
+ *        first, then one page ahead of the next chunk.
+ *
+ * @details
+ *  - At most one erase (~85 ms) per call, call it between frames
+ *  - A failed erase cancels the upload
+ *
+ * @return true if a page was erased
+ */
+bool spectro_slot_prepare(void);
+
+/**
+ * @brief Offset the next chunk must start at.
+ */
+uint32_t spectro_slot_next_offset(void);
+
+/**
+ * @brief Verify the written image and activate it.
+ *
+ * @param validate  Optional content check run on the image in flash
+ * @return true if the new image is now active
+ */
+bool spectro_slot_commit(bool (*validate)(const uint8_t *image, uint32_t size));
+
+/**
+ * @brief Cancel an upload, the active image is unchanged.
+ */
+void spectro_slot_abort(void);
+
+/**
+ * @brief Current upload state.
+ */
+SpectroSlotState_t spectro_slot_state(void);
+
+#endif // SPECTRO_MODEL_SLOT_H
@@ -0,0 +1,173 @@
+/********************************************************
+ * @file        	spectro_storage.cpp
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Persistent record storage in the nRF52840 internal flash
+ *
+ * @details
+ *  - Page layout: [SpectroStoreHeader_t][payload][0xFF padding]
+ *  - The header is programmed last, so a reset in the middle of a
+ *    save leaves an erased (missing) record rather than a torn one
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#include <Arduino.h>
+#include <FlashIAP.h>
+
+#include "spectro_storage.h"
+#include "spectro_crc.h"
+
+//==================== Internal definitions ====================//
+
+#define SPECTRO_STORE_MAGIC   0x53504543UL   // "SPEC"
+
+typedef struct
+{
+    uint32_t magic;
+    uint16_t recordId;
+    uint16_t reserved;
+    uint32_t length;   // payload bytes
+    uint32_t crc;      // CRC-32 of payload
+} SpectroStoreHeader_t;
+
+// mbed GCC linker script: .data is loaded from flash right after the text
+extern "C" uint32_t __etext;
+extern "C" uint32_t __data_start__;
+extern "C" uint32_t __data_end__;
+
+static mbed::FlashIAP s_flash;
+static bool s_flashReady = false;
+
+// Staging buffer for one page so that the payload can be written
+// with a single program call (FlashIAP needs page-size aligned lengths)
+static uint8_t s_pageBuf[SPECTRO_STORAGE_PAGE_SIZE] __attribute__((aligned(4)));
+
+static uint32_t spectro_storage_addr(SpectroStoreRecord_t rec)
+{
+    return SPECTRO_STORAGE_BASE_ADDR + (uint32_t)rec * SPECTRO_STORAGE_PAGE_SIZE;
+}
+
+/***
+ * @brief The range lies inside the raw area, above the firmware
+ ***/
+static bool spectro_storage_raw_range(uint32_t addr, uint32_t len)
+{
+    if (spectro_storage_image_end() > SPECTRO_STORAGE_RAW_ADDR)
+        return false;
+
+    return (addr >= SPECTRO_STORAGE_RAW_ADDR) && (addr < SPECTRO_STORAGE_BASE_ADDR) &&
+           (len <= SPECTRO_STORAGE_BASE_ADDR - addr);
+}
+
+static bool spectro_storage_valid_id(SpectroStoreRecord_t rec)
+{
+    return ((int)rec >= 0) && (rec < SPECTRO_STORE_NUM_RECORDS) &&
+           ((int)rec < SPECTRO_STORAGE_MAX_RECORDS);
+}
+
+//==================== Public API implementation ====================//
+
+bool spectro_storage_init(void)
+{
+    if (s_flashReady)
+        return true;
+
+    s_flashReady = (s_flash.init() == 0);
+    return s_flashReady;
+}
+
+uint32_t spectro_storage_max_payload(void)
+{
+    return SPECTRO_STORAGE_PAGE_SIZE - sizeof(SpectroStoreHeader_t);
+}
+
+bool spectro_storage_save(SpectroStoreRecord_t rec, const void *data, uint32_t len)
+{
+    if (!s_flashReady || !spectro_storage_valid_id(rec) || (data == NULL))
+        return false;
+    if (len > spectro_storage_max_payload())
+        return false;
+
+    const uint32_t addr = spectro_storage_addr(rec);
+    const uint32_t progSize = s_flash.get_page_size();
+    const uint32_t hdrSize = sizeof(SpectroStoreHeader_t);
+
+    if (s_flash.erase(addr, SPECTRO_STORAGE_PAGE_SIZE) != 0)
+        return false;
+
+    // 1) payload, padded to the program unit
+    memset(s_pageBuf, 0xFF, sizeof(s_pageBuf));
+    memcpy(s_pageBuf, data, len);
+
+    uint32_t bodyLen = ((len + progSize - 1) / progSize) * progSize;
+    if ((bodyLen > 0) && (s_flash.program(s_pageBuf, addr + hdrSize, bodyLen) != 0))
+        return false;
+
+    // 2) header last: it is what marks the record as valid
+    SpectroStoreHeader_t hdr;
+    hdr.magic = SPECTRO_STORE_MAGIC;
+    hdr.recordId = (uint16_t)rec;
+    hdr.reserved = 0xFFFF;
+    hdr.length = len;
+    hdr.crc = spectro_crc32(data, len);
+
+    return (s_flash.program(&hdr, addr, hdrSize) == 0);
+}
+
+bool spectro_storage_load(SpectroStoreRecord_t rec, void *data, uint32_t len)
+{
+    if (!s_flashReady || !spectro_storage_valid_id(rec) || (data == NULL))
+        return false;
+
+    const uint32_t addr = spectro_storage_addr(rec);
+    SpectroStoreHeader_t hdr;
+
+    if (s_flash.read(&hdr, addr, sizeof(hdr)) != 0)
+        return false;
+
+    if ((hdr.magic != SPECTRO_STORE_MAGIC) || (hdr.recordId != (uint16_t)rec) || (hdr.length != len))
+        return false;
+
+    if (s_flash.read(data, addr + sizeof(hdr), len) != 0)
+        return false;
+
+    return (spectro_crc32(data, len) == hdr.crc);
+}
+
+bool spectro_storage_erase(SpectroStoreRecord_t rec)
+{
+    if (!s_flashReady || !spectro_storage_valid_id(rec))
+        return false;
+
+    return (s_flash.erase(spectro_storage_addr(rec), SPECTRO_STORAGE_PAGE_SIZE) == 0);
+}
+
+uint32_t spectro_storage_image_end(void)
+{
+    return (uint32_t)(uintptr_t)&__etext +
+           (uint32_t)((uintptr_t)&__data_end__ - (uintptr_t)&__data_start__);
+}
+
+bool spectro_storage_flash_erase_page(uint32_t addr)
+{
+    if (!s_flashReady || ((addr % SPECTRO_STORAGE_PAGE_SIZE) != 0))
+        return false;
+
+    // the record area is only written through the record API
+    if (!spectro_storage_raw_range(addr, SPECTRO_STORAGE_PAGE_SIZE))
+        return false;
+
+    return (s_flash.erase(addr, SPECTRO_STORAGE_PAGE_SIZE) == 0);
+}
+
+bool spectro_storage_flash_program(uint32_t addr, const void *data, uint32_t len)
+{
+    if (!s_flashReady || (data == NULL) || ((addr & 3) != 0) || ((len & 3) != 0))
+        return false;
+    if (!spectro_storage_raw_range(addr, len))
+        return false;
+
+    return (s_flash.program(data, addr, len) == 0);
+}
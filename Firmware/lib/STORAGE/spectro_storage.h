@@ -0,0 +1,111 @@
+/********************************************************
+ * @file        	spectro_storage.h
+ * @author      	Junjian Chi (jc2592@cam.ac.uk)
+ * @version     	V1.0.0
+ * @date        	17/10/2026
+ * @brief       	Persistent record storage in the nRF52840 internal flash
+ *
+ * @details
+ *  - Small fixed-id records (calibration, learned models, ...)
+ *  - One 4 KB flash page per record, header + payload + CRC-32
+ *  - A record that fails its CRC/size check is reported as missing
+ *  - Flash is erased/programmed through mbed::FlashIAP
+ *
+ * @note
+ *   A page erase stalls the CPU for ~85 ms, so saves should only be
+ *   triggered by explicit user actions, never from the frame loop.
+ *
+ * SPDX-License-Identifier: MIT
+ ********************************************************/
+
+#ifndef SPECTRO_STORAGE_H
+#define SPECTRO_STORAGE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
+//==================== Flash layout ====================//
+
+#define SPECTRO_STORAGE_PAGE_SIZE     0x1000UL      // nRF52840 erase unit
+#define SPECTRO_STORAGE_BASE_ADDR     0x000F0000UL  // last 64 KB of the 1 MB flash
+#define SPECTRO_STORAGE_MAX_RECORDS   16
+#define SPECTRO_STORAGE_RAW_SIZE      0x60000UL     // raw area (model slots) below the records
+#define SPECTRO_STORAGE_RAW_ADDR      (SPECTRO_STORAGE_BASE_ADDR - SPECTRO_STORAGE_RAW_SIZE)
+
+//==================== Record ids ====================//
+
+/**
+ * @brief Record slots, each one owns a single flash page
+ */
+typedef enum
+{
+    SPECTRO_STORE_CENTROID = 0,     ///< On-device nearest-centroid classifier
+    SPECTRO_STORE_UNMIX,            ///< Blank + endmember spectra for unmixing
+    SPECTRO_STORE_NUM_RECORDS
+} SpectroStoreRecord_t;
+
+//==================== Public API ====================//
+
+/**
+ * @brief Initialise the flash interface.
+ * @return true on success
+ */
+bool spectro_storage_init(void);
+
+/**
+ * @brief Largest payload a single record can hold.
+ */
+uint32_t spectro_storage_max_payload(void);
+
+/**
+ * @brief Erase the record page and write a new payload.
+ *
+ * @param rec   Record id
+ * @param data  Payload to persist
+ * @param len   Payload size in bytes (<= spectro_storage_max_payload())
+ * @return true on success
+ */
+bool spectro_storage_save(SpectroStoreRecord_t rec, const void *data, uint32_t len);
+
+/**
+ * @brief Load a record payload.
+ *
+ * @param rec   Record id
+ * @param data  Destination buffer
+ * @param len   Expected payload size; a stored record of another size is rejected
+ * @return true if a valid record of exactly len bytes was found
+ */
+bool spectro_storage_load(SpectroStoreRecord_t rec, void *data, uint32_t len);
+
+/**
+ * @brief Erase a record (it will then load as missing).
+ */
+bool spectro_storage_erase(SpectroStoreRecord_t rec);
+
+//==================== Raw flash access ====================//
+
+/**
+ * @brief End of the running firmware in flash (code and the load
+ *        image of the initialised data), from the linker script.
+ */
+uint32_t spectro_storage_image_end(void);
+
+/**
+ * @brief Erase one flash page of the raw area (model slots).
+ *
+ * @param addr  Page-aligned flash address
+ * @return false outside the raw area, or if the firmware reaches into it
+ */
+bool spectro_storage_flash_erase_page(uint32_t addr);
+
+/**
+ * @brief Program already-erased flash of the raw area.
+ *
+ * @param addr  4-byte aligned flash address
+ * @param data  4-byte aligned source
+ * @param len   Multiple of 4 bytes
+ */
+bool spectro_storage_flash_program(uint32_t addr, const void *data, uint32_t len);
+
+#endif // SPECTRO_STORAGE_H
@@ -10,10 +10,14 @@
  *  -High-level scheduling and application logic are located here.
  * 
  * @note 
- *   Three program modes name
+ *   Program modes name
  *  -SPECTRO_APP_MODE_DATA_LOG,       ///< Pure data acquisition: print spectral channels
  *  -SPECTRO_APP_MODE_INFER_LOCAL,    ///< Run on-board ML model (e.g. Nano 33 BLE Sense)
- *  -SPECTRO_APP_MODE_INFER_PC        ///< Send data to host PC, wait for inference result
+ *  -SPECTRO_APP_MODE_INFER_PC        ///< Send data to host PC, pipelined inference results
+ *  -SPECTRO_APP_MODE_UNMIX           ///< Blend proportions by NNLS spectral unmixing
+ *  -SPECTRO_APP_MODE_CONC_REG        ///< Continuous concentration (%) regression
+ *  -SPECTRO_APP_MODE_INFER_MODEL     ///< Run the uploaded juice + concentration model package
+ *  -SPECTRO_APP_MODE_PROGRESSIVE     ///< Low-precision preview, then high-precision refinement
  *
  * SPDX-License-Identifier: MIT
  ********************************************************/
@@ -41,16 +45,18 @@ void setup() {
   Serial.println("AS7343 Connected!");
 
   spectro_app_init();                         
-  spectro_app_set_mode(SPECTRO_APP_MODE_DATA_LOG); // Manually set program mode
-  spectro_app_set_precision_mode(SPECTRO_PRECISION_HIGH); // Manually set precision
+  spectro_app_set_mode(SPECTRO_APP_MODE_DATA_LOG); // Boot mode, MODE command at runtime
+  spectro_app_set_precision_mode(SPECTRO_PRECISION_HIGH); // Boot precision, PREC command at runtime
+  spectro_app_print_ready();  // host tools wait for this instead of sleeping
+
+  oled_start_go_begin();      // counts down while frames already flow
 }
 
 void loop() {
-  oled_draw_start_go();   
-  oled_show_mode();
-  while(1){
-    spectro_app_run_once();
-  }
+  if (oled_start_go_poll())
+    oled_show_mode();
+  oled_poll();
+  spectro_app_run_once();
 }
 
 
@@ -0,0 +1,104 @@
+"""
+Receives the device output over BLE instead of USB.
+
+The firmware advertises as "Spectro-<id>" with the Nordic UART service
+(Firmware/lib/APP/spectro_ble.h): notifications of the TX characteristic
+carry the same byte stream as the serial port, packed several frames per
+notification, and command lines are written to the RX characteristic.
+Notifications are concatenated into a FrameReader, so text and binary
+formats work as over USB.
+
+The device cannot read the negotiated MTU from its stack; this tool
+reports it with "BLE LINK <mtu> [interval ms]" after subscribing.
+
+Needs bleak (pip install bleak).
+"""
+from __future__ import annotations
+
+import argparse
+import asyncio
+import time
+
+from bleak import BleakClient, BleakScanner
+
+from spectro_frame import FrameReader, MeasFrame, StreamHeader
+
+
+NAME_PREFIX = "Spectro-"
+RX_UUID = "6e400002-b5a3-f393-e0a9-e50e24dcca9e"    # commands to the device
+TX_UUID = "6e400003-b5a3-f393-e0a9-e50e24dcca9e"    # output stream
+
+
+async def find_device(name: str | None, timeout_s: float):
+    devices = await BleakScanner.discover(timeout=timeout_s)
+    for d in devices:
+        if d.name and (d.name == name if name else d.name.startswith(NAME_PREFIX)):
+            return d
+    raise TimeoutError(f"No {name or NAME_PREFIX + '*'} device advertising")
+
+
+async def send(client: BleakClient, text: str):
+    await client.write_gatt_char(RX_UUID, (text + "\n").encode("ascii"), response=False)
+
+
+async def stream(args):
+    device = await find_device(args.name, args.scan)
+    reader = FrameReader()
+    items: asyncio.Queue = asyncio.Queue()
+    rx_bytes = 0
+    notifications = 0
+
+    def on_notify(_, data: bytearray):
+        nonlocal rx_bytes, notifications
+        rx_bytes += len(data)
+        notifications += 1
+        for item in reader.feed(bytes(data)):
+            items.put_nowait(item)
+
+    async with BleakClient(device) as client:
+        print(f"Connected to {device.name} ({device.address}), MTU {client.mtu_size}")
+        await client.start_notify(TX_UUID, on_notify)
+        link = f"BLE LINK {client.mtu_size}" + (f" {args.interval}" if args.interval else "")
+        await send(client, link)
+        for cmd in args.cmd:
+            await send(client, cmd)
+
+        t0 = time.monotonic()
+        frames = 0
+        while args.seconds <= 0 or time.monotonic() - t0 < args.seconds:
+            try:
+                item = await asyncio.wait_for(items.get(), timeout=0.5)
+            except asyncio.TimeoutError:
+                continue
+            if isinstance(item, MeasFrame):
+                frames += 1
+                print(f"#{item.seq} t={item.timestamp_us} {item.channels}")
+            elif isinstance(item, StreamHeader):
+                print(f"header epoch {item.epoch}: {item.precision}, {item.gain}, mask 0x{item.channel_mask:X}")
+            else:
+                print(item)
+
+        dt = time.monotonic() - t0
+        await send(client, "BLE")
+        await asyncio.sleep(0.5)
+        while not items.empty():
+            item = items.get_nowait()
+            if isinstance(item, str) and item.startswith("BLE,"):
+                print(item)
+        print(f"{frames} frames, {rx_bytes / dt:.0f} B/s, {notifications / dt:.1f} notifications/s, "
+              f"{rx_bytes / max(notifications, 1):.1f} B/notification, {reader.bad_frames} bad frames")
+
+
+def main():
+    ap = argparse.ArgumentParser("Stream the device output over BLE")
+    ap.add_argument("--name", type=str, help="device name, default: first Spectro-*")
+    ap.add_argument("--scan", type=float, default=5.0, help="scan time, s")
+    ap.add_argument("--interval", type=int, default=0, help="connection interval in ms, if known")
+    ap.add_argument("--seconds", type=float, default=30.0, help="0 = until interrupted")
+    ap.add_argument("--cmd", action="append", default=[], help="command to send first, e.g. --cmd 'FORMAT binary'")
+    args = ap.parse_args()
+    asyncio.run(stream(args))
+
+
+if __name__ == "__main__":
+    main()
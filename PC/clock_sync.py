@@ -0,0 +1,145 @@
+"""
+Maps device timestamps to wall-clock time.
+
+The firmware stamps every measurement with micros() at the end of its
+integration (binary frames, ";t=<us>" on SORTED lines, <end us> of
+BATCH). micros() is 32 bits, wraps every ~71.6 minutes and runs at the
+board crystal's rate, not the PC's.
+
+SYNC <token> is answered with "SYNC,<token>,<rx us>,<tx us>" (device
+receive / transmit times, Firmware/lib/APP/spectro_cmd.cpp). Together
+with the host send / receive times t0, t3 every exchange gives, like NTP:
+
+    round trip   = (t3 - t0) - (tx - rx)
+    device mid   = (rx + tx) / 2   <->   host mid = (t0 + t3) / 2
+
+ClockSync keeps the last exchanges and fits wall = a + b * device
+through those with the shortest round trips (the least delayed by USB
+batching or the PC scheduler). b - 1 is the crystal drift, so the mapping
+stays accurate between syncs.
+"""
+from __future__ import annotations
+
+import time
+from collections import deque
+from dataclasses import dataclass
+
+
+WRAP = 1 << 32            # device micros() wraps here
+DELAY_MARGIN_S = 0.002    # samples within min round trip + this are fitted
+
+
+@dataclass
+class SyncSample:
+    device_us: float      # (rx + tx) / 2, unwrapped
+    host_s: float         # (t0 + t3) / 2, time.time()
+    delay_s: float        # round trip without the device turnaround
+
+
+class ClockSync:
+    """
+    request()/handle_line() run exchanges alongside a stream, sync() runs
+    a burst of them and waits for the replies. to_wall() converts any
+    device timestamp seen within ~35 minutes of the last sample.
+    """
+
+    def __init__(self, window: int = 32):
+        self.samples: deque[SyncSample] = deque(maxlen=window)
+        self._pending: dict[int, float] = {}    # token -> t0
+        self._token = 0
+        self._last_us: int | None = None        # newest unwrapped device time
+        self._ref_us = 0.0                      # fit: wall = a + b * (device - ref) / 1e6
+        self._a = 0.0
+        self._b = 1.0
+
+    @property
+    def ready(self) -> bool:
+        return bool(self.samples)
+
+    @property
+    def drift_ppm(self) -> float:
+        """Device clock rate error relative to the PC, parts per million."""
+        return (1.0 / self._b - 1.0) * 1e6
+
+    @property
+    def min_delay_s(self) -> float:
+        return min(s.delay_s for s in self.samples) if self.samples else 0.0
+
+    def request(self, ser):
+        """Send one SYNC; the reply goes to handle_line()."""
+        self._token = (self._token + 1) & 0xFFFFFFFF
+        self._pending[self._token] = time.time()
+        ser.write(f"SYNC {self._token}\n".encode("ascii"))
+
+    def handle_line(self, line: str, t3: float | None = None) -> bool:
+        """Use a "SYNC,..." reply (t3 = its arrival, default now). False for other lines."""
+        t3 = time.time() if t3 is None else t3
+        f = line.strip().split(",")
+        if len(f) != 4 or f[0] != "SYNC":
+            return False
+        try:
+            token, rx, tx = int(f[1]), int(f[2]), int(f[3])
+        except ValueError:
+            return False
+        t0 = self._pending.pop(token, None)
+        if t0 is None:
+            return True                         # reply to an older session
+
+        rx = self.unwrap(rx)
+        tx = self.unwrap(tx)
+        delay = (t3 - t0) - (tx - rx) * 1e-6
+        self.samples.append(SyncSample((rx + tx) / 2, (t0 + t3) / 2, max(delay, 0.0)))
+        self._fit()
+        return True
+
+    def sync(self, ser, reader, n: int = 8, timeout_s: float = 1.0) -> ClockSync:
+        """
+        n exchanges, one at a time. Reads through reader (FrameReader):
+        items other than the replies are discarded, so run it before
+        the stream is needed. Raises TimeoutError if nothing comes back.
+        """
+        for _ in range(n):
+            self.request(ser)
+            deadline = time.monotonic() + timeout_s
+            while time.monotonic() < deadline:
+                item = reader.poll(ser)
+                if isinstance(item, str) and item.startswith("SYNC,"):
+                    self.handle_line(item)
+                    break
+        self._pending.clear()
+        if not self.samples:
+            raise TimeoutError("No SYNC reply from the device")
+        return self
+
+    def unwrap(self, device_us: int) -> int:
+        """32-bit micros() -> continuous count, taking the nearest wrap to the newest time seen."""
+        device_us &= WRAP - 1
+        if self._last_us is None:
+            self._last_us = device_us
+            return device_us
+        step = (device_us - self._last_us) % WRAP
+        if step >= WRAP // 2:
+            step -= WRAP                        # slightly older than the newest
+        t = self._last_us + step
+        self._last_us = max(self._last_us, t)
+        return t
+
+    def to_wall(self, device_us: int) -> float:
+        """Wall-clock time (time.time() scale) of a device timestamp."""
+        if not self.samples:
+            raise RuntimeError("ClockSync has no samples, call sync() first")
+        return self._a + self._b * (self.unwrap(device_us) - self._ref_us) * 1e-6
+
+    def _fit(self):
+        best = [s for s in self.samples if s.delay_s <= self.min_delay_s + DELAY_MARGIN_S]
+        self._ref_us = sum(s.device_us for s in best) / len(best)
+        self._a = sum(s.host_s for s in best) / len(best)
+        self._b = 1.0
+
+        # drift needs a time base: a burst of exchanges within a second
+        # cannot tell crystal error from jitter
+        sxx = sum((s.device_us - self._ref_us) ** 2 for s in best) * 1e-12
+        span_s = (max(s.device_us for s in best) - min(s.device_us for s in best)) * 1e-6
+        if len(best) >= 2 and span_s >= 10.0:
+            sxy = sum((s.device_us - self._ref_us) * 1e-6 * (s.host_s - self._a) for s in best)
+            self._b = sxy / sxx
@@ -1,12 +1,13 @@
 from __future__ import annotations
 
-import time
+from collections import deque
 from pathlib import Path
 import numpy as np
 import serial
 from joblib import load
 
-from features import make_features as make_juice_features  # 复用你 juice 的特征函数
+from spectro_frame import FrameReader, MeasFrame, StreamHeader, subscribe, wait_ready
+from preprocess_spec import bundle_spec, apply_spec, spec_text  # same preprocessing as training and firmware
 
 
 # -------- CONFIG --------
@@ -14,7 +15,7 @@ port = "COM3"        # Windows
 # port = "/dev/ttyUSB0"  # Linux
 # port = "/dev/tty.usbserial-XXXX"  # macOS
 baud = 115200        # MUST match Arduino Serial.begin(...)
-N_READS = 5          # Number of measurements to average in one sample
+N_READS = 5          # Rolling average over the last N_READS frames
 # ------------------------
 
 
@@ -51,29 +52,17 @@ def parse_12_floats(line: str) -> np.ndarray | None:
     return vals
 
 
-def make_conc_raw_features(X_raw: np.ndarray, preprocess: str) -> np.ndarray:
+def parse_meas(line: str) -> tuple[int, np.ndarray] | None:
     """
-    Must match your train_concentration.py:
-      - raw: use as-is
-      - mean: mean over channels (axis=1)
+    Device request "MEAS,<seq>,v0,...,v11" -> (seq, values), None otherwise.
     """
-    preprocess = str(preprocess).strip().lower()
-    X_raw = np.asarray(X_raw, dtype=float)
-    if X_raw.ndim == 1:
-        X_raw = X_raw.reshape(1, -1)
-
-    if preprocess == "raw":
-        return X_raw
-    if preprocess == "mean":
-        return X_raw.mean(axis=1, keepdims=True)
-
-    raise ValueError(f"Unknown concentration preprocess: {preprocess}")
-
-
-def make_conc_features(X_raw: np.ndarray, juice_label: str, juice_enc, preprocess: str) -> np.ndarray:
-    X_feat = make_conc_raw_features(X_raw, preprocess=preprocess)
-    juice_oh = juice_enc.transform(np.array([juice_label], dtype=object).reshape(-1, 1))
-    return np.hstack([X_feat, juice_oh])
+    if not line.startswith("MEAS,"):
+        return None
+    seq, _, rest = line[5:].partition(",")
+    vals = parse_12_floats(rest)
+    if vals is None or not seq.isdigit():
+        return None
+    return int(seq), vals
 
 
 def maybe_proba(model, X: np.ndarray):
@@ -97,55 +86,66 @@ def main():
 
     juice_model = juice_bundle["model"]
     juice_le = juice_bundle["label_encoder"]
-    juice_preprocess = juice_bundle.get("preprocess", "raw")
+    juice_spec = bundle_spec(juice_bundle, default="l1")   # raises on a spec/model mismatch
 
     conc_model = conc_bundle["model"]
     conc_le = conc_bundle["label_encoder"]
-    conc_juice_enc = conc_bundle["juice_encoder"]
-    conc_preprocess = conc_bundle.get("preprocess", "mean")
+    conc_spec = bundle_spec(conc_bundle, default="mean")
 
     print("Loaded models:")
-    print(" - Juice preprocess:", juice_preprocess)
-    print(" - Concentration preprocess:", conc_preprocess)
+    print(" - Juice preprocess:", spec_text(juice_spec))
+    print(" - Concentration preprocess:", spec_text(conc_spec))
 
     # ---- open serial ----
     ser = serial.Serial(port, baudrate=baud, timeout=1)
-    time.sleep(2.0)  # give Arduino time to reset
+    ready = wait_ready(ser)   # as soon as the device serves commands, no fixed sleep
+    subscribe(ser, "data", "log")   # requests and diagnostics only
     ser.reset_input_buffer()
-    print(f"Serial connected: {port} @ {baud}")
-    print("Waiting for 12-channel lines...")
+    print(f"Serial connected: {port} @ {baud}, firmware {ready.fw_version}, "
+          f"mode {ready.mode}, {ready.precision}, format {ready.format}")
+    print("Waiting for MEAS requests (text or binary frames)...")
 
     # ---- main loop ----
-    buf = []
+    # Every request is answered with "RES,<seq>,..." so the device can match
+    # replies to its outstanding requests (it keeps several in flight).
+    buf = deque(maxlen=N_READS)
+    reader = FrameReader()   # text lines or binary frames (FORMAT binary)
     while True:
+        seq = None
         try:
-            raw_line = ser.readline().decode("utf-8", errors="ignore").strip()
-            if not raw_line:
+            item = reader.poll(ser)
+            if item is None:
                 continue
 
-            vals = parse_12_floats(raw_line)
-            if vals is None:
-                # You can uncomment to debug unexpected lines:
-                # print("Skip line:", raw_line)
+            if isinstance(item, StreamHeader):
+                print(f"Stream header: epoch {item.epoch}, {item.precision}, gain {item.gain}, "
+                      f"avg {item.average}, {len(item.channels_nm)} channels")
                 continue
 
-            buf.append(vals)
-            if len(buf) < N_READS:
-                continue
+            if isinstance(item, MeasFrame):
+                if len(item.channels) != 12:
+                    continue
+                seq, vals = item.seq, np.array(item.channels, dtype=float)
+            else:
+                req = parse_meas(item)
+                if req is None:
+                    # You can uncomment to debug unexpected lines:
+                    # print("Skip line:", item)
+                    continue
+                seq, vals = req
 
-            # average N_READS measurements => one sample
+            buf.append(vals)
             sample = np.mean(np.stack(buf, axis=0), axis=0)  # shape (12,)
-            buf.clear()
 
             X_raw = sample.reshape(1, -1)
 
             # ---- JUICE inference ----
-            Xj = make_juice_features(X_raw, preprocess=juice_preprocess)
+            Xj = apply_spec(juice_spec, X_raw)
             j_id = int(juice_model.predict(Xj)[0])
             j_label = str(juice_le.inverse_transform([j_id])[0])
 
             # ---- CONCENTRATION inference (uses predicted juice) ----
-            Xc = make_conc_features(X_raw, juice_label=j_label, juice_enc=conc_juice_enc, preprocess=conc_preprocess)
+            Xc = apply_spec(conc_spec, X_raw, [j_label])
             c_id = int(conc_model.predict(Xc)[0])
             c_label = str(conc_le.inverse_transform([c_id])[0])
 
@@ -155,9 +155,9 @@ def main():
 
             # ---- format reply ----
             # Simple, Arduino-friendly one-line response:
-            #   JUICE=<label>;CONC=<label>
+            #   RES,<seq>,JUICE=<label>;CONC=<label>
             # If proba available, also send max confidence:
-            msg = f"JUICE={j_label};CONC={c_label}"
+            msg = f"RES,{seq},JUICE={j_label};CONC={c_label}"
 
             if j_p is not None:
                 j_conf = float(np.max(j_p[0]))
@@ -177,14 +177,17 @@ def main():
             break
         except Exception as e:
             # don't crash the loop on a single bad line / transient error
-            err = f"ERROR={type(e).__name__}:{e}\n"
+            # stay below the device line limit (SPECTRO_CMD_LINE_MAX)
+            err = f"RES,{seq},ERROR={type(e).__name__}:{e}"[:120] + "\n" if seq is not None else ""
             try:
-                ser.write(err.encode("utf-8"))
+                if err:
+                    ser.write(err.encode("utf-8"))
             except Exception:
                 pass
-            print(err.strip())
+            print(err.strip() or f"ERROR={type(e).__name__}:{e}")
             buf.clear()
 
+    subscribe(ser)
     ser.close()
 
 
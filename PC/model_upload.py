@@ -0,0 +1,151 @@
+from __future__ import annotations
+
+import argparse
+import time
+import zlib
+from pathlib import Path
+import serial
+
+from spectro_frame import subscribe, wait_ready
+
+
+# -------- CONFIG --------
+port = "COM3"        # Windows
+# port = "/dev/ttyUSB0"  # Linux
+# port = "/dev/tty.usbserial-XXXX"  # macOS
+baud = 115200        # MUST match Arduino Serial.begin(...)
+CHUNK = 64           # bytes per MODEL DATA line, = SPECTRO_SLOT_CHUNK_MAX
+WINDOW = 4           # chunks in flight before waiting for an ACK
+REPLY_TIMEOUT = 2.0  # seconds, covers a flash page erase (~85 ms) plus a frame
+WAIT_DELAY = 0.05    # seconds before resending a chunk whose flash page is not erased yet
+WAIT_LIMIT = 60.0    # seconds without progress on WAIT replies before giving up
+# ------------------------
+
+
+PACKAGE_PATH = Path("../Data_analysis/models/model_package.bin")
+
+
+def read_model_reply(ser: serial.Serial, timeout: float = REPLY_TIMEOUT) -> list[str]:
+    """
+    Next "MODEL,..." reply split on ','.
+    Other lines (e.g. from a tool that subscribed the device to more
+    channels) are skipped.
+    """
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        line = ser.readline().decode(errors="ignore").strip()
+        if line.startswith("MODEL,"):
+            return line.split(",")
+        if line.startswith("[spectro_app]"):
+            print("  device:", line)
+    raise TimeoutError("No MODEL reply from the device")
+
+
+def send(ser: serial.Serial, text: str):
+    ser.write((text + "\n").encode("ascii"))
+
+
+def upload(ser: serial.Serial, image: bytes):
+    crc = zlib.crc32(image) & 0xFFFFFFFF
+    send(ser, f"MODEL BEGIN {len(image)} {crc:08X}")
+    reply = read_model_reply(ser)
+    if reply[1] != "ACK":
+        raise RuntimeError(f"Upload refused: {','.join(reply)}")
+
+    # Sliding window: every DATA line gets exactly one reply carrying the
+    # offset the device expects next. On an error, drain the replies of the
+    # chunks still in flight and resend from the reported offset (go-back-N).
+    # WAIT: the device erases the next flash page between its frames, so the
+    # chunk is resent the same way after a short pause, without counting as
+    # an error.
+    next_send = 0
+    acked = 0
+    in_flight = 0
+    retries = 0      # total resends
+    stalled = 0      # errors since the last progress
+    waiting = None   # monotonic time of the first WAIT since the last progress
+    t0 = time.monotonic()
+
+    while acked < len(image):
+        while in_flight < WINDOW and next_send < len(image):
+            chunk = image[next_send:next_send + CHUNK]
+            send(ser, f"MODEL DATA {next_send} {chunk.hex().upper()}")
+            next_send += len(chunk)
+            in_flight += 1
+
+        reply = read_model_reply(ser)
+        if reply[1] not in ("ACK", "ERR", "WAIT"):
+            continue
+        in_flight -= 1
+        offset = int(reply[2])
+
+        if reply[1] == "ACK":
+            if offset // 4096 != acked // 4096 or offset == len(image):
+                print(f"\r  {offset}/{len(image)} bytes", end="", flush=True)
+            acked = max(acked, offset)
+            stalled = 0
+            waiting = None
+            continue
+
+        if reply[1] == "WAIT":
+            waiting = waiting if waiting is not None else time.monotonic()
+            if time.monotonic() - waiting > WAIT_LIMIT:
+                raise RuntimeError(f"Device never erased the page at offset {offset}")
+        else:
+            retries += 1
+            stalled += 1
+            if stalled > 10:
+                raise RuntimeError(f"Too many errors, device stuck at offset {offset}")
+        while in_flight > 0:
+            reply = read_model_reply(ser)
+            if reply[1] in ("ACK", "ERR", "WAIT"):
+                in_flight -= 1
+                offset = int(reply[2])
+        if waiting is not None:
+            time.sleep(WAIT_DELAY)
+        acked = next_send = offset
+
+    dt = time.monotonic() - t0
+    print(f"\n  transferred in {dt:.1f} s ({len(image) / max(dt, 1e-6) / 1024:.1f} KB/s), {retries} retries")
+
+    send(ser, "MODEL COMMIT")
+    reply = read_model_reply(ser, timeout=10.0)
+    if reply[1] != "OK":
+        raise RuntimeError("Device rejected the package (CRC or format check failed), previous model kept")
+
+    info = read_model_reply(ser)
+    print("Active model:", ",".join(info[2:]))
+
+
+def main():
+    ap = argparse.ArgumentParser("Upload a model package (export_model.py) to the device")
+    ap.add_argument("--port", type=str, default=port)
+    ap.add_argument("--package", type=str, default=str(PACKAGE_PATH))
+    ap.add_argument("--info", action="store_true", help="only print the active package")
+    args = ap.parse_args()
+
+    ser = serial.Serial(args.port, baud, timeout=0.1)
+    wait_ready(ser)   # as soon as the device serves commands, no fixed sleep
+    subscribe(ser, "control", "log")   # replies only, no measurement stream
+    ser.reset_input_buffer()
+
+    try:
+        if args.info:
+            send(ser, "MODEL INFO")
+            print(",".join(read_model_reply(ser)))
+            return
+
+        image = Path(args.package).read_bytes()
+        print(f"Uploading {args.package} ({len(image)} bytes) to {args.port}")
+        try:
+            upload(ser, image)
+        except Exception:
+            send(ser, "MODEL ABORT")
+            raise
+    finally:
+        subscribe(ser)
+        ser.close()
+
+
+if __name__ == "__main__":
+    main()
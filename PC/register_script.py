@@ -0,0 +1,211 @@
+"""
+Register scripts: sensor sequences run on the device at I2C speed.
+
+A script is assembled here, uploaded once (SCRIPT BEGIN/DATA) and run with
+SCRIPT RUN. Every EMIT comes back as "SCRIPT,REC,<n>,<us>,<hex>" on the
+result channel, the run ends with
+"SCRIPT,END,<status>,<pc>,<records>,<ops>,<duration us>"
+(bytecode in Firmware/lib/PROTO/spectro_script.h).
+
+Assembler syntax, one op per line, '#' starts a comment, numbers in any
+Python base, registers by number or by name (REGS):
+
+    write <reg> <val>
+    set   <reg> <mask> <base> <step> <loop level>   # base + step * i
+    read  <reg> [n]
+    wait  <reg> <mask> <timeout ms>
+    delay <ms>
+    loop  <count> ... next
+    emit
+
+Without a script file, runs the built-in gain x ATIME sweep and prints
+(or writes with --out) one row per setting.
+"""
+from __future__ import annotations
+
+import argparse
+import csv
+import time
+from pathlib import Path
+import serial
+
+from spectro_frame import subscribe, wait_ready
+
+
+# -------- CONFIG --------
+port = "COM3"        # Windows
+# port = "/dev/ttyUSB0"  # Linux
+# port = "/dev/tty.usbserial-XXXX"  # macOS
+baud = 115200        # MUST match Arduino Serial.begin(...)
+CHUNK = 64           # bytes per SCRIPT DATA line, = SPECTRO_SLOT_CHUNK_MAX
+MAX_SIZE = 256       # SPECTRO_SCRIPT_MAX_SIZE
+REPLY_TIMEOUT = 2.0  # seconds
+# ------------------------
+
+
+OPS = {"end": (0x00, 0), "write": (0x01, 2), "set": (0x02, 5), "read": (0x03, 2),
+       "wait": (0x04, 3), "delay": (0x05, 1), "loop": (0x06, 1), "next": (0x07, 0),
+       "emit": (0x08, 0)}
+U16_LAST = {"wait", "delay", "loop"}    # last operand is little-endian u16
+
+REGS = {"ENABLE": 0x80, "ATIME": 0x81, "WTIME": 0x83, "STATUS2": 0x90, "STATUS": 0x93,
+        "DATA0": 0x95, "CFG0": 0xBF, "CFG1": 0xC6, "ASTEP_L": 0xD4, "ASTEP_H": 0xD5,
+        "CFG20": 0xD6}
+
+GAINS_X = [0.5, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048]   # CFG1 AGAIN codes
+STEP_US = 2.78       # integration time per ASTEP count
+
+
+def assemble(text: str) -> bytes:
+    code = bytearray()
+    for n, raw in enumerate(text.splitlines(), 1):
+        words = raw.split("#", 1)[0].split()
+        if not words:
+            continue
+        name = words[0].lower()
+        if name not in OPS:
+            raise ValueError(f"line {n}: unknown op '{words[0]}'")
+        op, argc = OPS[name]
+        args = [REGS[w.upper()] if w.upper() in REGS else int(w, 0) for w in words[1:]]
+        if name == "read" and len(args) == 1:
+            args.append(1)
+        if len(args) != argc:
+            raise ValueError(f"line {n}: '{name}' takes {argc} operands")
+
+        code.append(op)
+        for i, a in enumerate(args):
+            if name in U16_LAST and i == argc - 1:
+                code += (a & 0xFFFF).to_bytes(2, "little")
+            else:
+                code.append(a & 0xFF)
+    code.append(OPS["end"][0])
+    if len(code) > MAX_SIZE:
+        raise ValueError(f"script is {len(code)} bytes, the device takes {MAX_SIZE}")
+    return bytes(code)
+
+
+def sweep_script(gains: list[int], atimes: list[int], astep: int = 999) -> str:
+    """
+    gain x ATIME grid: gains are CFG1 codes, atimes an arithmetic series.
+    Record: gain code, ATIME, then the 18 raw channels (36 bytes).
+    """
+    g_step = gains[1] - gains[0] if len(gains) > 1 else 0
+    a_step = atimes[1] - atimes[0] if len(atimes) > 1 else 0
+    return f"""
+        write ENABLE 0x01            # PON, measurement off
+        write ASTEP_L {astep & 0xFF}
+        write ASTEP_H {astep >> 8}
+        loop {len(gains)}
+          set CFG1 0x1F {gains[0]} {g_step} 0
+          loop {len(atimes)}
+            write ENABLE 0x01
+            set ATIME 0xFF {atimes[0]} {a_step} 1
+            write ENABLE 0x03        # SP_EN: first AVALID has the new settings
+            wait STATUS2 0x40 2000
+            read CFG1 1
+            read ATIME 1
+            read DATA0 36
+            emit
+          next
+        next
+    """
+
+
+def read_script_reply(ser: serial.Serial, timeout: float = REPLY_TIMEOUT) -> list[str]:
+    """Next "SCRIPT,..." line split on ','; device errors are printed."""
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        line = ser.readline().decode(errors="ignore").strip()
+        if line.startswith("SCRIPT,"):
+            return line.split(",")
+        if line.startswith("[spectro_app]"):
+            print("  device:", line)
+    raise TimeoutError("No SCRIPT reply from the device")
+
+
+def send(ser: serial.Serial, text: str):
+    ser.write((text + "\n").encode("ascii"))
+
+
+def upload(ser: serial.Serial, code: bytes):
+    send(ser, f"SCRIPT BEGIN {len(code)}")
+    for offset in range(0, len(code), CHUNK):
+        send(ser, f"SCRIPT DATA {offset} {code[offset:offset + CHUNK].hex().upper()}")
+    for _ in range(1 + (len(code) + CHUNK - 1) // CHUNK):
+        reply = read_script_reply(ser)
+        if reply[1] != "ACK":
+            raise RuntimeError(f"Upload refused: {','.join(reply)}")
+
+
+def run(ser: serial.Serial, timeout: float = 30.0):
+    """SCRIPT RUN; yields (record, device us, bytes), returns the END fields."""
+    send(ser, "SCRIPT RUN")
+    deadline = time.monotonic() + timeout
+    while time.monotonic() < deadline:
+        reply = read_script_reply(ser, timeout=deadline - time.monotonic())
+        if reply[1] == "REC":
+            yield int(reply[2]), int(reply[3]), bytes.fromhex(reply[4])
+        elif reply[1] == "END":
+            if reply[2] != "ok":
+                raise RuntimeError(f"Script failed: {reply[2]} at byte {reply[3]}")
+            print(f"  {reply[4]} records, {reply[5]} ops in {int(reply[6]) / 1000:.1f} ms")
+            return
+    raise TimeoutError("Script did not finish")
+
+
+def sweep_row(data: bytes, astep: int) -> dict:
+    gain, atime = data[0] & 0x1F, data[1]
+    counts = [int.from_bytes(data[2 + 2 * i:4 + 2 * i], "little") for i in range(18)]
+    row = {"gain_x": GAINS_X[gain], "atime": atime,
+           "t_int_ms": round((atime + 1) * (astep + 1) * STEP_US / 1000, 2)}
+    row.update({f"ch{i}": c for i, c in enumerate(counts)})
+    return row
+
+
+def main():
+    ap = argparse.ArgumentParser("Run a register script on the device")
+    ap.add_argument("script", nargs="?", help="assembler file; default: gain x ATIME sweep")
+    ap.add_argument("--port", type=str, default=port)
+    ap.add_argument("--gains", type=str, default="3:10", help="sweep: CFG1 gain codes start:stop (4x..256x)")
+    ap.add_argument("--atimes", type=str, default="9:50:10", help="sweep: ATIME start:stop:step")
+    ap.add_argument("--out", type=str, help="sweep: CSV file")
+    args = ap.parse_args()
+
+    astep = 999
+    if args.script:
+        code = assemble(Path(args.script).read_text())
+    else:
+        gains = list(range(*map(int, args.gains.split(":"))))
+        atimes = list(range(*map(int, args.atimes.split(":"))))
+        code = assemble(sweep_script(gains, atimes, astep))
+
+    ser = serial.Serial(args.port, baud, timeout=0.1)
+    wait_ready(ser)
+    subscribe(ser, "result", "control", "log")   # records and replies, no frames
+    ser.reset_input_buffer()
+
+    try:
+        print(f"Uploading {len(code)} bytes to {args.port}")
+        upload(ser, code)
+        rows = []
+        for n, us, data in run(ser):
+            if args.script:
+                print(f"{n},{us},{data.hex().upper()}")
+            else:
+                rows.append(sweep_row(data, astep))
+                print(rows[-1])
+        if args.out and rows:
+            with open(args.out, "w", newline="") as f:
+                w = csv.DictWriter(f, fieldnames=list(rows[0]))
+                w.writeheader()
+                w.writerows(rows)
+    except Exception:
+        send(ser, "SCRIPT ABORT")
+        raise
+    finally:
+        subscribe(ser)
+        ser.close()
+
+
+if __name__ == "__main__":
+    main()
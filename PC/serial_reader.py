@@ -6,64 +6,66 @@ from datetime import datetime
 
 import serial
 
+from spectro_frame import FrameReader, subscribe, wait_ready
+from clock_sync import ClockSync
 
-PREFIX = "SORTED(405-855nm):"
 
+BATCH_FRAMES = 5            # frames averaged on the device per sample
+BATCH_PREC = "high"         # precision of the batch (low/medium/high), high = boot default
+LEGACY_PREC = "high"        # files without a precision column were recorded at the boot default
+BATCH_AVG = "mean"          # mean or median
 
-def parse_sorted_line(line: str):
-    """
-    Parse: SORTED(405-855nm): 914,4652,6628,...
-    Return list[int] or None.
-    """
-    line = line.strip()
-    if not line.startswith(PREFIX):
-        return None
-    try:
-        data_part = line.split(":", 1)[1].strip()
-        vals = [int(x.strip()) for x in data_part.split(",") if x.strip() != ""]
-        return vals if vals else None
-    except Exception:
-        return None
 
-
-def read_one_measurement(ser: serial.Serial, timeout_s: float = 3.0):
+def request_batch(ser: serial.Serial, reader: FrameReader, label: str, timeout_s: float = 30.0):
     """
-    Read until one valid SORTED line is received or timeout.
+    Run one MEASURE batch on the device and wait for its reply:
+        BATCH,<label>,<frames>,<agg>,<prec>,<duration us>,<period us>,<jitter us>,<end us>
+        BATCHVAL,<v0>,...   mean or median counts
+        BATCHVAR,<v0>,...   per-channel sample variance
+    The frames are read back-to-back by the firmware, so the timing
+    does not depend on the host. <end us> is the device time at the end
+    of the last integration (see clock_sync.py).
+    Return dict or None (BATCHERR, timeout).
     """
+    ser.write(f"MEASURE n={BATCH_FRAMES} prec={BATCH_PREC} avg={BATCH_AVG} label={label}\n".encode("ascii"))
+
+    result = {}
     t0 = time.time()
     while time.time() - t0 < timeout_s:
-        raw = ser.readline()
-        if not raw:
+        item = reader.poll(ser)
+        if not isinstance(item, str):
             continue
-        line = raw.decode("utf-8", errors="ignore").strip()
-        vals = parse_sorted_line(line)
-        if vals is not None:
-            return vals, line
-    return None, None
-
-
-def sum_measurements(meas_list):
+        fields = item.strip().split(",")
+        if fields[0] == "BATCHERR":
+            print(f"Device error after {fields[1]} frames.")
+            return None
+        if fields[0] == "BATCH" and len(fields) == 9 and fields[1] == label:
+            result = {"frames": int(fields[2]), "agg": fields[3], "prec": fields[4],
+                      "duration_us": int(fields[5]), "period_us": int(fields[6]),
+                      "jitter_us": int(fields[7]), "end_us": int(fields[8])}
+        elif fields[0] == "BATCHVAL" and result:
+            result["values"] = [float(v) for v in fields[1:]]
+        elif fields[0] == "BATCHVAR" and "values" in result:
+            result["variance"] = [float(v) for v in fields[1:]]
+            return result
+    return None
+
+
+def ensure_csv_header(path: Path, n_channels: int) -> bool:
     """
-    Channel-wise exact sums (lossless).
+    Create the header of a new file.
+    Return True if the file has a precision column (older files do not).
     """
-    n = len(meas_list)
-    m = len(meas_list[0])
-    sums = [0] * m
-    for i in range(n):
-        for j in range(m):
-            sums[j] += meas_list[i][j]
-    return sums
-
-
-def ensure_csv_header(path: Path, n_channels: int):
     if path.exists():
-        return
+        with path.open(newline="", encoding="utf-8") as f:
+            return "precision" in next(csv.reader(f), [])
 
-    header = ["timestamp", "juice_type", "concentration"]
+    header = ["timestamp", "juice_type", "concentration", "precision"]
     header += [f"avg_ch{i+1}" for i in range(n_channels)]
 
     with path.open("w", newline="", encoding="utf-8") as f:
         csv.writer(f).writerow(header)
+    return True
 
 
 def append_row(path: Path, row):
@@ -77,7 +79,6 @@ def main():
     # port = '/dev/ttyUSB0'  # Linux
     # port = '/dev/tty.usbserial-XXXX'  # macOS 
     baud = 115200        # MUST match Arduino Serial.begin(...)
-    N_READS = 5          # Number of measurements to average in one sample
     # ------------------------
 
     # Dataset path: ../Data/dataset.csv
@@ -92,14 +93,24 @@ def main():
         print(f"Failed to open serial port: {e}")
         sys.exit(1)
 
-    print(f"Connected: {port} @ {baud}")
+    try:
+        ready = wait_ready(ser)   # as soon as the device serves commands, no fixed sleep
+    except TimeoutError as e:
+        print(e)
+        sys.exit(1)
+
+    print(f"Connected: {port} @ {baud}, firmware {ready.fw_version}")
     print(f"Dataset file: {out_csv}")
-    print("Commands: 'r' + Enter = record one sample (5 reads), 'q' + Enter = quit")
+    print(f"Commands: 'r' + Enter = record one sample ({BATCH_FRAMES} reads), 'q' + Enter = quit")
 
-    time.sleep(1.0)
+    subscribe(ser, "control", "log")   # MEASURE replies only, no stream
     ser.reset_input_buffer()
 
     n_channels = None
+    has_prec = True
+    reader = FrameReader()
+    clock = ClockSync().sync(ser, reader)   # device time -> wall time
+    print(f"Clock sync: round trip {clock.min_delay_s * 1000:.2f} ms")
 
     while True:
         cmd = input("\nCommand (r=record, q=quit): ").strip().lower()
@@ -114,47 +125,45 @@ def main():
 
          
         ser.reset_input_buffer()
-        time.sleep(0.05)
-
-        measurements = []
-        print(f"Sampling {N_READS} valid SORTED frames:")
-
-        while len(measurements) < N_READS:
-            
-            vals, line = read_one_measurement(ser, timeout_s=5.0)
-            if vals is None:
-                print("Timeout: no valid SORTED line. Sample aborted.")
-                break
-
-            if n_channels is None:
-                n_channels = len(vals)
-                ensure_csv_header(out_csv, n_channels)
-                print(f"Detected {n_channels} channels. CSV header created.")
-
-            if len(vals) != n_channels:
-                print("Discarded frame (channel count mismatch).")
-                continue
-
-            # Optional sanity check
-            if any(v < 0 or v > 65535 for v in vals):
-                print("Warning: value outside uint16 range detected.")
+        reader.reset()
+        clock.sync(ser, reader, n=4)   # more samples, tracks the crystal drift
+
+        # echoed by the device: no commas or spaces, at most 23 characters
+        label = f"{juice_type}_{concentration}".replace(",", "_").replace(" ", "_")[:23]
+        print(f"Sampling {BATCH_FRAMES} frames on the device ({BATCH_PREC}, {BATCH_AVG}):")
+        res = request_batch(ser, reader, label)
+        if res is None:
+            print("No MEASURE result. Sample aborted.")
+            continue
 
-            measurements.append(vals)
-            print(f"  {len(measurements)}/{N_READS}: {line}")
+        vals = res["values"]
+        if n_channels is None:
+            n_channels = len(vals)
+            has_prec = ensure_csv_header(out_csv, n_channels)
+            print(f"{n_channels} channels. CSV header ready.")
 
-        if len(measurements) != N_READS:
+        if len(vals) != n_channels:
+            print("Discarded sample (channel count mismatch).")
             continue
 
-        sums = sum_measurements(measurements)
-        ts = datetime.now().isoformat(timespec="seconds")
+        # raw counts scale with the integration time: never mix precisions in one file
+        if not has_prec and res["prec"] != LEGACY_PREC:
+            print(f"Discarded sample ({res['prec']} precision, {out_csv.name} holds {LEGACY_PREC} rows).")
+            continue
 
-        row = [ts, juice_type, concentration] + [s / N_READS for s in sums]
-        append_row(out_csv, row)
+        # middle of the batch on the device clock, not the time the reply was parsed
+        mid_us = (res["end_us"] - res["duration_us"] // 2) & 0xFFFFFFFF
+        ts = datetime.fromtimestamp(clock.to_wall(mid_us)).isoformat(timespec="milliseconds")
+        prec = [res["prec"]] if has_prec else []
+        append_row(out_csv, [ts, juice_type, concentration] + prec + vals)
 
-        means_preview = [s / N_READS for s in sums]
         print("Sample saved.")
-        print("Mean preview:", means_preview)
+        print(f"  {res['frames']} frames in {res['duration_us'] / 1000:.1f} ms, "
+              f"period {res['period_us']} us, jitter {res['jitter_us']} us, at {ts}")
+        print(f"{res['agg'].capitalize()} preview:", vals)
+        print("Variance:", res["variance"])
 
+    subscribe(ser)   # everything again, e.g. for a serial monitor
     ser.close()
     print("Exited.")
 
@@ -0,0 +1,499 @@
+"""
+Decoder for the firmware's binary measurement and header frames
+(Firmware/lib/PROTO/spectro_frame.h).
+
+On the wire every frame is 0x00 <COBS(payload + CRC-16)> 0x00; text lines
+(replies, errors) may be interleaved and never contain 0x00. FrameReader
+splits a byte stream back into frames and text lines, so tools work with
+either FORMAT text or FORMAT binary.
+
+FORMAT delta sends keyframes (plain measurement frames) followed by delta
+frames: zigzag-varint residuals of a step or linear prediction
+(Firmware/lib/PROTO/spectro_delta.h). FrameReader rebuilds them into
+MeasFrames and reports the achieved compression_ratio.
+
+Settings are described once per epoch by a stream header (binary header
+frame, or "HDR,..." line in text mode) sent before the first measurement
+of the epoch; binary measurements carry the epoch ID and FrameReader
+attaches the matching StreamHeader to each MeasFrame.
+
+The device sorts its output into logical channels (Firmware/lib/APP/spectro_mux.h);
+subscribe() asks it for only the channels a tool reads.
+
+wait_ready() replaces a fixed sleep after opening the port: it pings the
+device until it answers with its READY line (version and settings).
+"""
+from __future__ import annotations
+
+import binascii
+import struct
+import time
+from collections import deque
+from dataclasses import dataclass, field
+
+
+FRAME_VERSION = 3
+TYPE_MEAS = 0x01
+TYPE_HEADER = 0x02
+TYPE_DELTA = 0x03
+DELTA_FIXED = 5                         # type, version, seq, flags
+FLAG_LINEAR = 0x01
+FLAG_COUNTS = 0x02
+MEAS = struct.Struct("<BBHIHHBB")       # type, version, seq, t_us, epoch, dropped, merged, n
+DESC = struct.Struct("<BBH3BBBBBBBBHIHBB")  # type, version, epoch, fw x.y.z, id, rev, units, prec, gain,
+                                            # atime, avg, astep, t_int_us, mask, n_wavelengths, reserved
+CRC_SIZE = 2
+UNKNOWN8 = 0xFF
+UNKNOWN16 = 0xFFFF
+MAX_CHANNELS = 16
+MAX_ENCODED = DESC.size + 2 * MAX_CHANNELS + CRC_SIZE + 1   # COBS block, = SPECTRO_FRAME_MAX_ENCODED - 2
+
+UNITS = ("counts",)                     # SpectroFrameUnits_t
+PRECISIONS = ("low", "medium", "high")  # SpectroPrecisionMode_t
+GAINS = ("0.5x", "1x", "2x", "4x", "8x", "16x", "32x", "64x", "128x", "256x", "512x", "1024x", "2048x")
+
+# SpectroMuxChannel_t: data = measurements / PC requests, result = per-frame
+# results, log = diagnostics, control = command replies
+CHANNELS = ("data", "result", "log", "control")
+
+
+def subscribe(ser, *channels: str):
+    """Receive only these output channels ("SUB data,log"); no arguments = all."""
+    unknown = [c for c in channels if c not in CHANNELS]
+    if unknown:
+        raise ValueError(f"Unknown channels {unknown}, expected {CHANNELS}")
+    ser.write(f"SUB {','.join(channels) or 'all'}\n".encode("ascii"))
+
+
+@dataclass
+class DeviceReady:
+    """READY line: the device serves commands, sent at boot, on connect and for PING."""
+    fw_version: str                     # "major.minor.patch"
+    sensor_id: int                      # 0x81 for the AS7343, 0xFF if unknown
+    sensor_revision: int
+    uptime_ms: int                      # device millis() when the line was sent
+    mode: str
+    precision: str
+    gain: str
+    average: int
+    channel_mask: int
+    running: bool
+    format: str
+
+
+def parse_ready_line(line: str) -> DeviceReady | None:
+    """READY,<fw>,0x<id>,<rev>,<uptime ms>,<mode>,<prec>,<gain>,<avg>,0x<mask>,<RUN|STOP>,<format>"""
+    f = line.strip().split(",")
+    if len(f) != 12 or f[0] != "READY":
+        return None
+    try:
+        return DeviceReady(f[1], int(f[2], 16), int(f[3]), int(f[4]), f[5], f[6], f[7],
+                           int(f[8]), int(f[9], 16), f[10] == "RUN", f[11])
+    except ValueError:
+        return None
+
+
+def wait_ready(ser, timeout_s: float = 10.0, ping_s: float = 0.2) -> DeviceReady:
+    """
+    Wait until the device is up: PING every ping_s until READY arrives.
+    The control channel is subscribed so the reply gets through; call
+    subscribe() afterwards for the channels the tool reads.
+    Raises TimeoutError if the device does not answer.
+    """
+    reader = FrameReader()
+    ser.reset_input_buffer()
+    deadline = time.monotonic() + timeout_s
+    next_ping = 0.0
+    while time.monotonic() < deadline:
+        if time.monotonic() >= next_ping:
+            ser.write(b"SUB control\nPING\n")
+            next_ping = time.monotonic() + ping_s
+        if not ser.in_waiting:
+            time.sleep(0.002)
+            continue
+        for item in reader.feed(ser.read(ser.in_waiting)):
+            ready = parse_ready_line(item) if isinstance(item, str) else None
+            if ready is not None:
+                return ready
+    raise TimeoutError(f"No READY from the device within {timeout_s:.0f} s")
+
+
+def crc16(data: bytes) -> int:
+    """CRC-16/CCITT-FALSE, = spectro_crc16_update(SPECTRO_CRC16_INIT, ...)."""
+    return binascii.crc_hqx(data, 0xFFFF)
+
+
+def cobs_encode(data: bytes) -> bytes:
+    out = bytearray(b"\x00")
+    code_idx, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_idx] = code
+            code_idx, code = len(out), 1
+            out.append(0)
+    out[code_idx] = code
+    return bytes(out)
+
+
+def cobs_decode(data: bytes) -> bytes | None:
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        block = data[i:i + code - 1]
+        if 0 in block:
+            return None
+        out += block
+        i += code - 1
+        if code < 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+@dataclass
+class StreamHeader:
+    """Settings of one epoch: everything needed to interpret its measurements."""
+    epoch: int
+    fw_version: str                     # "major.minor.patch"
+    sensor_id: int                      # 0x81 for the AS7343, 0xFF if unknown
+    sensor_revision: int
+    units: str
+    precision: str
+    gain: str | None                    # None if unknown
+    atime: int
+    astep: int
+    average: int                        # frames averaged into each measurement
+    integration_us: int                 # 0 if unknown
+    channel_mask: int
+    wavelengths_nm: list[int] = field(default_factory=list)   # every sensor channel
+
+    @property
+    def channels_nm(self) -> list[int]:
+        """Wavelengths of the channels present in the measurements, ascending index."""
+        return [nm for i, nm in enumerate(self.wavelengths_nm) if self.channel_mask & (1 << i)]
+
+
+@dataclass
+class MeasFrame:
+    seq: int
+    timestamp_us: int
+    epoch: int
+    channels: list[int] = field(default_factory=list)   # present channels, ascending index
+    merged: int = 0     # extra frames averaged into this one (device queue full)
+    dropped: int = 0    # frames discarded by the device before this one
+    header: StreamHeader | None = None   # settings of the epoch, None if its header was missed
+
+
+def _open(block: bytes) -> bytes | None:
+    """COBS block -> payload without CRC, None if damaged or another version."""
+    payload = cobs_decode(block)
+    if payload is None or len(payload) < 2 + CRC_SIZE:
+        return None
+    body, crc = payload[:-CRC_SIZE], struct.unpack("<H", payload[-CRC_SIZE:])[0]
+    if crc16(body) != crc or body[1] != FRAME_VERSION:
+        return None
+    return body
+
+
+def _parse_meas(body: bytes) -> MeasFrame | None:
+    if len(body) < MEAS.size:
+        return None
+    _, _, seq, t_us, epoch, dropped, merged, n = MEAS.unpack_from(body)
+    if len(body) != MEAS.size + 2 * n:
+        return None
+    channels = list(struct.unpack_from(f"<{n}H", body, MEAS.size))
+    return MeasFrame(seq, t_us, epoch, channels, merged, dropped)
+
+
+def _parse_header(body: bytes) -> StreamHeader | None:
+    if len(body) < DESC.size:
+        return None
+    (_, _, epoch, major, minor, patch, sid, rev, units, prec, gain, atime, avg, astep, t_int, mask, n,
+     _) = DESC.unpack_from(body)
+    if n > MAX_CHANNELS or len(body) != DESC.size + 2 * n:
+        return None
+    wavelengths = list(struct.unpack_from(f"<{n}H", body, DESC.size))
+    return StreamHeader(epoch, f"{major}.{minor}.{patch}", sid, rev,
+                        UNITS[units] if units < len(UNITS) else str(units),
+                        PRECISIONS[prec] if prec < len(PRECISIONS) else str(prec),
+                        GAINS[gain] if gain < len(GAINS) else None,
+                        atime, astep, avg, t_int, mask, wavelengths)
+
+
+@dataclass
+class DeltaFrame:
+    """Undecoded delta frame, only meaningful relative to the frame before it."""
+    seq: int
+    seq_step: int
+    jitter_us: int                      # change of the frame period
+    linear: bool                        # predictor 2 x[k-1] - x[k-2] instead of x[k-1]
+    dropped: int
+    merged: int
+    residuals: list[int]
+
+
+def _varints(body: bytes, pos: int) -> list[int] | None:
+    """All LEB128 varints from pos to the end of body."""
+    values, v, shift = [], 0, 0
+    for b in body[pos:]:
+        v |= (b & 0x7F) << shift
+        shift += 7
+        if not b & 0x80:
+            values.append(v)
+            v, shift = 0, 0
+        elif shift >= 35:
+            return None
+    return values if shift == 0 else None
+
+
+def _unzigzag(z: int) -> int:
+    return (z >> 1) ^ -(z & 1)
+
+
+def _parse_delta(body: bytes) -> DeltaFrame | None:
+    if len(body) < DELTA_FIXED:
+        return None
+    seq, flags = struct.unpack_from("<HB", body, 2)
+    values = _varints(body, DELTA_FIXED)
+    counts = 2 if flags & FLAG_COUNTS else 0
+    if values is None or len(values) < 2 + counts:
+        return None
+    dropped, merged = values[2:2 + counts] if counts else (0, 0)
+    return DeltaFrame(seq, values[0], _unzigzag(values[1]), bool(flags & FLAG_LINEAR), dropped, merged,
+                      [_unzigzag(z) for z in values[2 + counts:]])
+
+
+def parse_frame(block: bytes) -> MeasFrame | StreamHeader | DeltaFrame | None:
+    """One COBS block (no delimiters) -> MeasFrame (header not attached), StreamHeader or DeltaFrame, None if damaged."""
+    body = _open(block)
+    if body is None:
+        return None
+    if body[0] == TYPE_MEAS:
+        return _parse_meas(body)
+    if body[0] == TYPE_HEADER:
+        return _parse_header(body)
+    if body[0] == TYPE_DELTA:
+        return _parse_delta(body)
+    return None
+
+
+def plain_size(n_channels: int) -> int:
+    """Wire bytes of a plain measurement frame, = spectro_delta_raw_size()."""
+    return MEAS.size + 2 * n_channels + CRC_SIZE + 1 + 2
+
+
+class DeltaDecoder:
+    """Mirror of the spectro_delta decoder: rebuilds delta frames from the frames before them."""
+
+    def __init__(self):
+        self.reset()
+
+    def reset(self):
+        """Wait for the next keyframe (a frame was lost or damaged)."""
+        self._ref: MeasFrame | None = None
+        self._prev2: list[int] = []
+        self._period = 0
+
+    def keyframe(self, frame: MeasFrame):
+        self._advance(frame, key=True)
+
+    def decode(self, d: DeltaFrame) -> MeasFrame | None:
+        """MeasFrame, or None (and reset) if the reference frame is missing."""
+        ref = self._ref
+        if (ref is None or (d.seq - d.seq_step) & 0xFFFF != ref.seq or len(d.residuals) != len(ref.channels)
+                or (d.linear and not self._prev2)):
+            self.reset()
+            return None
+        if d.linear:
+            pred = [min(max(2 * a - b, 0), 0xFFFF) for a, b in zip(ref.channels, self._prev2)]
+        else:
+            pred = ref.channels
+        channels = [p + r for p, r in zip(pred, d.residuals)]
+        if any(not 0 <= v <= 0xFFFF for v in channels):
+            self.reset()
+            return None
+        frame = MeasFrame(d.seq, (ref.timestamp_us + self._period + d.jitter_us) & 0xFFFFFFFF, ref.epoch, channels,
+                          min(d.merged, 0xFF), min(d.dropped, 0xFFFF))
+        self._advance(frame, key=False)
+        return frame
+
+    def _advance(self, frame: MeasFrame, key: bool):
+        self._period = 0 if key else (frame.timestamp_us - self._ref.timestamp_us) & 0xFFFFFFFF
+        self._prev2 = [] if key else self._ref.channels
+        self._ref = frame
+
+
+def parse_header_line(line: str) -> StreamHeader | None:
+    """
+    Parse: HDR,<epoch>,<fw>,0x<id>,<rev>,<units>,<precision>,<gain>,<atime>,
+    <astep>,<avg>,<t_int us>,0x<mask>,<nm;nm;...>. Return StreamHeader or None.
+    """
+    parts = line.strip().split(",")
+    if len(parts) != 14 or parts[0] != "HDR":
+        return None
+    try:
+        return StreamHeader(int(parts[1]), parts[2], int(parts[3], 16), int(parts[4]), parts[5], parts[6],
+                            None if parts[7] == "?" else parts[7], int(parts[8]), int(parts[9]),
+                            int(parts[10]), int(parts[11]), int(parts[12], 16),
+                            [int(x) for x in parts[13].split(";") if x])
+    except ValueError:
+        return None
+
+
+def _seal(body: bytes) -> bytes:
+    body += struct.pack("<H", crc16(body))
+    return b"\x00" + cobs_encode(body) + b"\x00"
+
+
+def encode_frame(frame: MeasFrame) -> bytes:
+    """Wire bytes of a frame, identical to spectro_frame_encode_meas() (for tests and simulators)."""
+    body = MEAS.pack(TYPE_MEAS, FRAME_VERSION, frame.seq & 0xFFFF, frame.timestamp_us & 0xFFFFFFFF,
+                     frame.epoch & 0xFFFF, frame.dropped, frame.merged, len(frame.channels))
+    body += struct.pack(f"<{len(frame.channels)}H", *frame.channels)
+    return _seal(body)
+
+
+def encode_header(hdr: StreamHeader) -> bytes:
+    """Wire bytes of a header, identical to spectro_frame_encode_header()."""
+    fw = [int(x) for x in hdr.fw_version.split(".")]
+    body = DESC.pack(TYPE_HEADER, FRAME_VERSION, hdr.epoch & 0xFFFF, *fw, hdr.sensor_id, hdr.sensor_revision,
+                     UNITS.index(hdr.units), PRECISIONS.index(hdr.precision),
+                     GAINS.index(hdr.gain) if hdr.gain is not None else UNKNOWN8,
+                     hdr.atime, hdr.average, hdr.astep, hdr.integration_us, hdr.channel_mask,
+                     len(hdr.wavelengths_nm), 0)
+    body += struct.pack(f"<{len(hdr.wavelengths_nm)}H", *hdr.wavelengths_nm)
+    return _seal(body)
+
+
+class FrameReader:
+    """
+    Incremental splitter for a mixed text / binary stream.
+
+    feed(bytes) returns a list of items, each a MeasFrame, a StreamHeader
+    (binary header frame or "HDR,..." line) or a decoded text line (str).
+    Damaged frames are counted in .bad_frames and dropped; a lost frame
+    shows up as a gap in .seq. Headers are kept by epoch (.headers, latest
+    in .header) and attached to the binary frames of their epoch; frames
+    whose header was missed keep header=None and are counted in
+    .orphan_frames. Delta frames (FORMAT delta) come out as MeasFrames;
+    those whose reference was lost are counted in .desync_frames and
+    dropped until the next keyframe.
+
+    After a 0x00 the reader expects a frame. If the block up to the next
+    0x00 is not a valid frame, that 0x00 is taken as the opener of the next
+    one, so a corrupted byte costs at most the frames it touches.
+    """
+
+    def __init__(self):
+        self._buf = bytearray()
+        self._in_frame = False
+        self._pending = deque()
+        self.frames = 0
+        self.bad_frames = 0
+        self.orphan_frames = 0
+        self.desync_frames = 0
+        self.wire_bytes = 0                  # measurement frames as received
+        self.plain_bytes = 0                 # the same as plain binary frames
+        self._delta = DeltaDecoder()
+        self.headers: dict[int, StreamHeader] = {}
+        self.header: StreamHeader | None = None
+
+    def reset(self):
+        """Forget partial data, e.g. after ser.reset_input_buffer(). Headers are kept."""
+        self._buf.clear()
+        self._in_frame = False
+        self._pending.clear()
+        self._delta.reset()
+
+    @property
+    def compression_ratio(self) -> float:
+        """Plain binary bytes / received bytes of the measurement frames so far (1.0 without FORMAT delta)."""
+        return self.plain_bytes / self.wire_bytes if self.wire_bytes else 1.0
+
+    def poll(self, ser) -> MeasFrame | StreamHeader | str | None:
+        """Next item from a pyserial port (reads whatever is waiting), None if nothing complete yet."""
+        if not self._pending:
+            self._pending.extend(self.feed(ser.read(max(1, ser.in_waiting))))
+        return self._pending.popleft() if self._pending else None
+
+    def feed(self, data: bytes) -> list[MeasFrame | StreamHeader | str]:
+        items = []
+        for b in data:
+            if not self._in_frame:
+                if b == 0:                   # opening delimiter
+                    self._flush_text(items)
+                    self._in_frame = True
+                elif b == ord("\n"):
+                    self._flush_text(items)
+                else:
+                    self._buf.append(b)
+                continue
+
+            if b != 0:
+                self._buf.append(b)
+                if len(self._buf) > MAX_ENCODED:   # no frame is that long: text after all
+                    self._in_frame = False
+                    data_left, self._buf = bytes(self._buf), bytearray()
+                    items += self.feed(data_left)
+                continue
+
+            if not self._buf:                # two zeros in a row
+                continue
+            frame = parse_frame(bytes(self._buf))
+            if frame is not None:
+                frame = self._resolve(frame, len(self._buf) + 2)
+                if frame is not None:
+                    items.append(self._attach(frame))
+                self._buf.clear()
+                self._in_frame = False
+            else:
+                self._delta.reset()          # the damaged block may have been a frame
+                for line in bytes(self._buf).split(b"\n"):
+                    self._buf = bytearray(line)
+                    self._flush_text(items)
+                # stay in frame state: this zero may open the next frame
+        return items
+
+    def _flush_text(self, items: list):
+        line = self._buf.decode(errors="ignore").strip()
+        self._buf.clear()
+        if not line:
+            return
+        if any(ord(c) < 0x20 and c != "\t" for c in line):
+            self.bad_frames += 1             # piece of a frame split by a corrupted byte
+        elif line.startswith("HDR,") and (hdr := parse_header_line(line)) is not None:
+            items.append(self._attach(hdr))
+        else:
+            items.append(line)
+
+    def _resolve(self, item: MeasFrame | StreamHeader | DeltaFrame, wire: int) -> MeasFrame | StreamHeader | None:
+        if isinstance(item, StreamHeader):
+            return item
+        if isinstance(item, DeltaFrame):
+            item = self._delta.decode(item)
+            if item is None:
+                self.desync_frames += 1
+                return None
+        else:
+            self._delta.keyframe(item)
+        self.wire_bytes += wire
+        self.plain_bytes += plain_size(len(item.channels))
+        return item
+
+    def _attach(self, item: MeasFrame | StreamHeader) -> MeasFrame | StreamHeader:
+        if isinstance(item, StreamHeader):
+            self.headers[item.epoch] = item
+            self.header = item
+            return item
+        self.frames += 1
+        item.header = self.headers.get(item.epoch)
+        if item.header is None or len(item.channels) != len(item.header.channels_nm):
+            item.header = None
+            self.orphan_frames += 1
+        return item